@@ -228,7 +228,7 @@ public:
 
 	/**
 	* \brief Return version number
-	* \return Version number (1 for CELBODY, 2 for CELBODY2)
+	* \return Version number (1 for CELBODY, 2 for CELBODY2, 3 for CELBODY3)
 	*/
 	inline int Version() const { return version; }
 
@@ -526,6 +526,48 @@ protected:
 };
 
 
+// ======================================================================
+/**
+* \class CELBODY3
+* \brief Extension to CELBODY2 class.
+* \details This class adds the evaluation of ephemerides for a list of dates
+*   in a single call. It is a separate class so that modules compiled against
+*   the CELBODY2 interface keep working unchanged: Orbiter only calls the
+*   methods introduced here if \ref CELBODY::Version returns 3 or higher, and
+*   evaluates the dates one by one with \ref CELBODY::clbkEphemeris otherwise.
+* \sa CELBODY2
+*/
+// ======================================================================
+
+class OAPIFUNC CELBODY3: public CELBODY2 {
+public:
+	/**
+	 * \brief Constructor. Creates a CELBODY3 instance for a celestial body.
+	 * \param hCBody body handle
+	 */
+	CELBODY3 (OBJHANDLE hCBody);
+
+	/**
+	 * \brief Called when ephemeris data for a list of dates are required, e.g.
+	 *   by trajectory planning instruments sampling a range of dates.
+	 * \param n number of dates
+	 * \param mjd array of n ephemeris dates (days, in Modified Julian Date format)
+	 * \param req data request bitflags (see \ref CELBODY::clbkEphemeris)
+	 * \param ret pointer to result array of 12*n doubles. The results for date mjd[j]
+	 *   are written to ret[12*j] to ret[12*j+11], in the format of
+	 *   \ref CELBODY::clbkEphemeris.
+	 * \return bitflags describing the returned data, which must be the same for all
+	 *   dates, or 0 if no data could be returned.
+	 * \default Calls \ref CELBODY::clbkEphemeris for each date. If the returned flags
+	 *   differ between dates, returns 0.
+	 * \note Modules using perturbation series should overload this method to evaluate
+	 *   the series for all dates together, e.g. by loading each term once for a group
+	 *   of dates.
+	 */
+	virtual int clbkEphemerisBatch (int n, const double *mjd, int req, double *ret);
+};
+
+
 // ======================================================================
 /**
 * \class ATMOSPHERE
@@ -620,8 +662,73 @@ public:
 	 */
 	virtual bool clbkParams (const PRM_IN *prm_in, PRM_OUT *prm_out);
 
+	/**
+	 * \brief Return the interface version of the atmosphere instance.
+	 * \return Version number (1 for ATMOSPHERE, 2 for ATMOSPHERE2)
+	 */
+	int Version() const;
+
+	/**
+	 * \brief Returns atmospheric parameters for a list of input parameter
+	 *   sets at the current simulation time, e.g. for ascent or entry planners
+	 *   sampling a density profile.
+	 * \param n number of parameter sets
+	 * \param prm_in array of n input parameter sets (see \ref PRM_IN)
+	 * \param prm_out array of n returned data sets (see \ref PRM_OUT)
+	 * \return \e true if atmospheric data were calculated and returned for
+	 *   all parameter sets, \e false otherwise.
+	 * \note Calls \ref ATMOSPHERE2::clbkParamsBatch if the model supports
+	 *   the version 2 interface, and \ref clbkParams for each parameter set
+	 *   otherwise.
+	 */
+	bool ParamsBatch (int n, const PRM_IN *prm_in, PRM_OUT *prm_out);
+
 protected:
 	CELBODY2 *cbody; ///< associated celestial body instance
 };
 
+
+// ======================================================================
+/**
+* \class ATMOSPHERE2
+* \brief Extension to ATMOSPHERE class.
+* \details This class adds the evaluation of atmospheric parameters for a
+*   list of input parameter sets in a single call. It is a separate class so
+*   that atmosphere modules compiled against the ATMOSPHERE interface keep
+*   working unchanged. Callers should use \ref ATMOSPHERE::ParamsBatch, which
+*   falls back to \ref ATMOSPHERE::clbkParams for older modules.
+* \sa ATMOSPHERE
+*/
+// ======================================================================
+
+class OAPIFUNC ATMOSPHERE2: public ATMOSPHERE {
+public:
+	/**
+	 * \brief Constructor. Creates an atmosphere instance for 'body'.
+	 * \param body pointer to celestial body
+	 */
+	ATMOSPHERE2 (CELBODY2 *body);
+
+	/**
+	 * \brief Destructor.
+	 */
+	virtual ~ATMOSPHERE2 ();
+
+	/**
+	 * \brief Called to obtain atmospheric parameters for a list of input
+	 *   parameter sets at the current simulation time.
+	 * \param n number of parameter sets
+	 * \param prm_in array of n input parameter sets (see \ref PRM_IN)
+	 * \param prm_out array of n returned data sets (see \ref PRM_OUT)
+	 * \return \e true if atmospheric data were calculated and returned for
+	 *   all parameter sets, \e false otherwise.
+	 * \default Calls \ref clbkParams for each parameter set. Returns \e false
+	 *   if any of the calls returns \e false.
+	 * \note Models should overload this method to evaluate the time-dependent
+	 *   terms once for all parameter sets, and to avoid a virtual call per
+	 *   point.
+	 */
+	virtual bool clbkParamsBatch (int n, const PRM_IN *prm_in, PRM_OUT *prm_out);
+};
+
 #endif // !__CELBODYAPI_H
\ No newline at end of file
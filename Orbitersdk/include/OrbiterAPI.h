@@ -4061,6 +4061,24 @@ OAPIFUNC DWORD oapiGetPlanetJCoeffCount (OBJHANDLE hPlanet);
 	* \sa oapiGetPlanetJCoeffCount
 	*/
 OAPIFUNC double oapiGetPlanetJCoeff (OBJHANDLE hPlanet, DWORD n);
+
+	/**
+	* \brief Returns the positions and velocities of a celestial body for a list of dates.
+	* \param hPlanet celestial body handle
+	* \param n number of dates
+	* \param mjd array of n dates [MJD]
+	* \param pos array of n vectors receiving the positions [<b>m</b>]
+	* \param vel array of n vectors receiving the velocities [<b>m/s</b>], or NULL if not required
+	* \return \e false if the body's state at arbitrary dates is not available (body
+	*   updated by dynamic propagation), \e true otherwise.
+	* \note The state vectors are returned in the ecliptic frame (J2000), relative to the
+	*   body's parent (e.g. relative to the sun for planets, relative to the planet for moons).
+	* \note For bodies controlled by an ephemeris module, the module evaluates all dates
+	*   together (see CELBODY3::clbkEphemerisBatch), which is much faster than a separate
+	*   query for each date. This is useful for trajectory planners sampling many
+	*   departure and arrival dates. Bodies without module use their osculating elements.
+	*/
+OAPIFUNC bool oapiGetPlanetEphemeris (OBJHANDLE hPlanet, int n, const double *mjd, VECTOR3 *pos, VECTOR3 *vel = 0);
 //@}
 
 
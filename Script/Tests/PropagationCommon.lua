@@ -0,0 +1,43 @@
+-- Concurrent vessel propagation test (Scenarios/Tests/Propagation)
+--
+-- The scenario mixes vessels that qualify for the concurrent update
+-- (Vessel::CanPropagateConcurrently) with vessels that don't: SH-03 is
+-- landed, and PB-05 orbits the Moon too low to pass the elevation margin.
+-- PropagationSerial records the vessel states after t_end seconds of a run
+-- with --propthreads=0. PropagationConcurrent repeats the run on worker
+-- threads (PlanetarySystem::PropagateVesselsConcurrent) and requires
+-- bit-identical states. Both runs need the same --fixedstep.
+
+t_end = 3600
+ref_file = "PropagationTest.ref"
+
+function add_line(line)
+	oapi.dbg_out(line)
+	oapi.write_log(line)
+end
+
+function fail(msg)
+	add_line(" - FAILED: "..msg)
+	oapi.exit(1)
+end
+
+-- Vessel states at t_end, one line per vessel, in full precision
+function vessel_states()
+	proc.wait_simtime(t_end)
+	local fmt = "%.17g"
+	local function vec(a)
+		return string.format(fmt.." "..fmt.." "..fmt, a.x, a.y, a.z)
+	end
+	local states = {}
+	for i = 0, vessel.get_count()-1 do
+		local v = vessel.get_interface(i)
+		local R = v:get_rotationmatrix()
+		states[#states+1] = v:get_name().." "..v:get_flightstatus()..
+			" "..vec(v:get_globalpos())..
+			" "..vec(v:get_globalvel())..
+			" "..vec(v:get_angvel())..
+			" "..vec({x=R.m11, y=R.m12, z=R.m13})..
+			" "..vec({x=R.m21, y=R.m22, z=R.m23})
+	end
+	return states
+end
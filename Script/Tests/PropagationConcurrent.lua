@@ -0,0 +1,25 @@
+-- Compare the vessel states of the concurrent update with the serial run
+-- (see PropagationCommon.lua)
+
+dofile("Script/Tests/PropagationCommon.lua")
+
+add_line("=== Concurrent propagation test: concurrent run ===")
+local states = vessel_states()
+local f = io.open(ref_file, "r")
+if f == nil then
+	fail(ref_file.." not found (run Scenario.Propagation.Serial first)")
+end
+local n = 0
+for line in f:lines() do
+	n = n + 1
+	if states[n] ~= line then
+		f:close()
+		fail("state differs from the serial run\n  serial:     "..line.."\n  concurrent: "..tostring(states[n]))
+	end
+end
+f:close()
+if n ~= #states then
+	fail("recorded "..n.." vessels, found "..#states)
+end
+add_line(" - passed ("..n.." vessels)")
+oapi.exit(0)
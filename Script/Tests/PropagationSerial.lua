@@ -0,0 +1,16 @@
+-- Record the vessel states of the serial update (see PropagationCommon.lua)
+
+dofile("Script/Tests/PropagationCommon.lua")
+
+add_line("=== Concurrent propagation test: serial run ===")
+local states = vessel_states()
+local f = io.open(ref_file, "w")
+if f == nil then
+	fail("cannot write "..ref_file)
+end
+for i = 1, #states do
+	f:write(states[i], "\n")
+end
+f:close()
+add_line("Recorded "..#states.." vessel states in "..ref_file)
+oapi.exit(0)
@@ -0,0 +1,228 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// ===========================================================
+// EphemFile: generic celestial body module serving the ephemeris
+// of a body from a precomputed binary ephemeris file (see
+// EphemFile.h and the ephemgen tool).
+// To use it, set in the body's configuration file
+//    Module = EphemFile
+//    EphemerisFile = <file>   (optional, default Config\Ephemeris.epb)
+// The body is looked up in the file by its name. Outside the date
+// range of the file, or if the file or the body's entry is invalid,
+// no ephemeris is returned, and Orbiter falls back to the body's
+// orbital elements.
+// ===========================================================
+
+#define ORBITER_MODULE
+
+#include "OrbiterAPI.h"
+#include "CelbodyAPI.h"
+#include "EphemFile.h"
+#include "MappedFile.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+static const double mjd2000 = 51544.5; // MJD date of epoch J2000
+static const char *default_file = "Config\\Ephemeris.epb";
+
+// ===========================================================
+// Mapped ephemeris files, shared by all bodies using them
+// ===========================================================
+
+#define MAXFILE 4
+
+static struct {
+	char path[256];
+	MappedFile file;
+	int nref;
+} epfile[MAXFILE];
+
+static MappedFile *AcquireFile (const char *path)
+{
+	int i;
+	for (i = 0; i < MAXFILE; i++)
+		if (epfile[i].nref && !_stricmp (epfile[i].path, path)) {
+			epfile[i].nref++;
+			return &epfile[i].file;
+		}
+	for (i = 0; i < MAXFILE; i++)
+		if (!epfile[i].nref) {
+			if (!epfile[i].file.Open (path)) return 0;
+			strncpy (epfile[i].path, path, 255);
+			epfile[i].nref = 1;
+			return &epfile[i].file;
+		}
+	return 0;
+}
+
+// Check a body table entry before its granules are used: Eval relies on
+// the channel count, mode and granule length, and reads the whole block
+static bool ValidBody (const EphemFileBody &b, uint64_t fsize)
+{
+	if (strnlen (b.name, sizeof(b.name)) == sizeof(b.name)) return false; // not terminated
+	if (b.nchannel == 0 || b.nchannel > 2) return false;
+	if (b.mode > EPHEM_MODE_BARY) return false;
+	if (b.mode == EPHEM_MODE_BARYOFS && b.nchannel != 2) return false;
+	if (!(b.len > 0.0) || !isfinite (b.len)) return false;
+	if (b.ofs % sizeof(double) || b.ofs > fsize) return false;
+	return (uint64_t)b.ngranule*b.nchannel*EPHEM_GRANULE_SIZE*sizeof(double) <= fsize - b.ofs;
+}
+
+static void ReleaseFile (MappedFile *file)
+{
+	for (int i = 0; i < MAXFILE; i++)
+		if (&epfile[i].file == file && epfile[i].nref) {
+			if (!--epfile[i].nref) epfile[i].file.Close();
+			return;
+		}
+}
+
+// ======================================================================
+// class EphemFile: interface
+// ======================================================================
+
+class EphemFile: public CELBODY2 {
+public:
+	EphemFile (OBJHANDLE hObj);
+	~EphemFile ();
+	void clbkInit (FILEHANDLE cfg);
+	bool bEphemeris () const { return body != 0; }
+	int clbkEphemeris (double mjd, int req, double *ret);
+	int clbkFastEphemeris (double simt, int req, double *ret);
+
+private:
+	int Eval (double t, double *ret);
+	// Ephemeris at t days from J2000, assembled according to the body's mode
+
+	MappedFile *file;            // mapped ephemeris file
+	const EphemFileBody *body;   // entry for this body, or NULL
+	const double *data;          // granule block of this body
+	double tref;                 // simulation time origin [days from J2000]
+};
+
+// ======================================================================
+// class EphemFile: implementation
+// ======================================================================
+
+EphemFile::EphemFile (OBJHANDLE hObj): CELBODY2 (hObj)
+{
+	file = 0;
+	body = 0;
+	data = 0;
+	tref = 0.0;
+}
+
+EphemFile::~EphemFile ()
+{
+	if (file) ReleaseFile (file);
+}
+
+void EphemFile::clbkInit (FILEHANDLE cfg)
+{
+	char path[256], name[256];
+	CELBODY2::clbkInit (cfg);
+
+	oapiGetObjectName (GetHandle(), name, 256);
+	if (!oapiReadItem_string (cfg, (char*)"EphemerisFile", path))
+		strcpy (path, default_file);
+	if (!(file = AcquireFile (path))) {
+		oapiWriteLogError("EphemFile %s: Ephemeris file not found: %s", name, path);
+		return;
+	}
+
+	const EphemFileHeader *hdr = (const EphemFileHeader*)file->Data();
+	if (file->Size() < sizeof(EphemFileHeader) || strncmp (hdr->magic, EPHEM_FILE_MAGIC, 8) ||
+		hdr->version != EPHEM_FILE_VERSION || hdr->degree != CHEBY_DEGREE ||
+		file->Size() < sizeof(EphemFileHeader) + (uint64_t)hdr->nbody*sizeof(EphemFileBody)) {
+		oapiWriteLogError("EphemFile %s: Invalid ephemeris file: %s", name, path);
+		return;
+	}
+	const EphemFileBody *tab = (const EphemFileBody*)(hdr+1);
+	for (DWORD i = 0; i < hdr->nbody; i++) {
+		if (!_strnicmp (tab[i].name, name, sizeof(tab[i].name)) && strlen (name) < sizeof(tab[i].name)) {
+			if (!ValidBody (tab[i], file->Size())) {
+				oapiWriteLogError("EphemFile %s: Invalid ephemeris entry in %s, using orbital elements", name, path);
+				return;
+			}
+			body = tab+i;
+			data = (const double*)(file->Data() + body->ofs);
+			break;
+		}
+	}
+	if (!body) {
+		oapiWriteLogError("EphemFile %s: No ephemeris for this body in %s", name, path);
+		return;
+	}
+	tref = oapiTime2MJD (0) - mjd2000;
+	oapiWriteLogV("EphemFile %s: %d granules of %0.2lf days, MJD %0.1lf-%0.1lf", name, body->ngranule,
+		body->len, hdr->mjd0, hdr->mjd1);
+}
+
+int EphemFile::clbkEphemeris (double mjd, int req, double *ret)
+{
+	return Eval (mjd - mjd2000, ret);
+}
+
+int EphemFile::clbkFastEphemeris (double simt, int req, double *ret)
+{
+	return Eval (tref + simt/86400.0, ret);
+}
+
+int EphemFile::Eval (double t, double *ret)
+{
+	if (!body) return 0;
+	double fidx = floor (t/body->len);
+	if (!(fidx >= (double)body->idx0 && fidx < (double)body->idx0 + body->ngranule)) return 0; // also rejects NaN
+	int idx = (int)fidx;
+	int k = idx - body->idx0;
+
+	double x = 2.0*(t - idx*body->len)/body->len - 1.0;
+	double r[2][6];
+	const double *g = data + (size_t)k*body->nchannel*EPHEM_GRANULE_SIZE;
+	for (DWORD ch = 0; ch < body->nchannel; ch++) {
+		ChebyCache::EvalCoeff ((const double(*)[CHEBY_NCOEFF])(g + ch*EPHEM_GRANULE_SIZE), x, body->len, r[ch]);
+		for (int i = 3; i < 6; i++) r[ch][i] /= 86400.0; // rates per second
+	}
+
+	int i;
+	switch (body->mode) {
+	case EPHEM_MODE_BARY0:
+		for (i = 0; i < 6; i++) ret[i] = r[0][i], ret[i+6] = 0.0;
+		break;
+	case EPHEM_MODE_BARYOFS:
+		Pol2Crt (r[0], ret+6);
+		for (i = 0; i < 6; i++) ret[i] = ret[i+6] + r[1][i];
+		break;
+	case EPHEM_MODE_BARY:
+		for (i = 0; i < 6; i++) ret[i+6] = r[0][i];
+		break;
+	default:
+		for (i = 0; i < 6; i++) ret[i] = r[0][i];
+		if (body->flags & EPHEM_BARYISTRUE)
+			for (i = 0; i < 6; i++) ret[i+6] = r[0][i];
+		break;
+	}
+	return body->flags;
+}
+
+// ===========================================================
+// DLL entry point
+// ===========================================================
+
+DLLCLBK void InitModule (HINSTANCE hModule)
+{}
+
+DLLCLBK void ExitModule (HINSTANCE hModule)
+{}
+
+DLLCLBK CELBODY *InitInstance (OBJHANDLE hBody)
+{
+	return new EphemFile (hBody);
+}
+
+DLLCLBK void ExitInstance (CELBODY *body)
+{
+	delete (EphemFile*)body;
+}
@@ -0,0 +1,63 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#ifndef __EPHEMFILE_H
+#define __EPHEMFILE_H
+
+#include <stdint.h>
+#include "ChebyCache.h"
+
+// ===========================================================
+// Precomputed binary ephemeris file (.epb)
+// Chebyshev approximations of the analytic ephemerides (VSOP87,
+// ELP2000-82, TASS1.7, Lieske E5) over a range of dates, written by
+// the ephemgen tool and served by the EphemFile celestial body
+// module, so that the series data don't have to be parsed and
+// summed at runtime.
+// The file is mapped into memory as a whole: a header, a table of
+// bodies, and for each body a block of granules. A granule of length
+// len [days] with index idx covers the times [idx*len, (idx+1)*len)
+// in days from J2000 (MJD 51544.5), and holds CHEBY_NCOEFF position
+// coefficients for each coordinate of each channel (rates are
+// obtained by differentiation). The coefficients are in the units
+// returned by the theory: [rad, rad, AU] for polar, [m] for
+// rectangular channels.
+// Block offsets are multiples of EPHEM_FILE_ALIGN. Values are stored
+// in native (little endian) byte order.
+// ===========================================================
+
+#define EPHEM_FILE_MAGIC "ORBEPHEM"
+#define EPHEM_FILE_VERSION 1
+#define EPHEM_FILE_ALIGN 64
+
+// Assembly of the clbkEphemeris result from the channels
+#define EPHEM_MODE_DIRECT  0 // ret[0..5] = channel 0 (also ret[6..11] with EPHEM_BARYISTRUE)
+#define EPHEM_MODE_BARY0   1 // ret[0..5] = channel 0, barycentre at the origin
+#define EPHEM_MODE_BARYOFS 2 // barycentre = channel 0 (polar), true = barycentre + channel 1 (rectangular)
+#define EPHEM_MODE_BARY    3 // ret[6..11] = channel 0
+
+struct EphemFileHeader {
+	char magic[8];           // EPHEM_FILE_MAGIC
+	uint32_t version;        // EPHEM_FILE_VERSION
+	uint32_t nbody;          // number of entries in the body table
+	uint32_t degree;         // CHEBY_DEGREE used for all granules
+	uint32_t reserved;
+	double mjd0, mjd1;       // date range covered [MJD]
+};
+
+struct EphemFileBody {
+	char name[32];           // body name, as in the planet configuration (Name)
+	uint32_t flags;          // EPHEM_xxx flags returned by clbkEphemeris
+	uint32_t mode;           // EPHEM_MODE_xxx
+	uint32_t nchannel;       // channels per granule (1 or 2)
+	uint32_t ngranule;       // number of granules
+	int32_t idx0;            // index of the first granule
+	uint32_t reserved;
+	double len;              // granule length [days]
+	uint64_t ofs;            // byte offset of the granule block
+};
+
+// Doubles per granule and channel
+#define EPHEM_GRANULE_SIZE (3*CHEBY_NCOEFF)
+
+#endif // !__EPHEMFILE_H
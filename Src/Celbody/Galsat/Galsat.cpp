@@ -85,7 +85,7 @@ void JupiterBaryFastEphemeris (double simt, double *ret, Sample *sp)
 
 void GalEphem (int ksat, double mjd, double *ret)
 {
-	static double r[6];
+	double r[6];
 
 	galsat (r, ret, mjd+2400000.5, ksat, 2);
 
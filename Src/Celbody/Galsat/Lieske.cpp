@@ -43,42 +43,56 @@ struct {
 } theory_1;
 
 struct {
-    double t, rb[6], angbx[14], angbz[10], cofbx[7], cofbz[5];
+    double angbx[14], angbz[10], cofbx[7], cofbz[5];
 } local_1;
 
 struct {
-    double tlast, tlastg, cj, sj, ci, si, cn, sn, cp, sp, phi, phidot,
-	p[9], q[9], qdot[9], qmat[9], tlastp;
+    double cj, sj, ci, si, cn, sn;
 } svtloc_1;
 
+// Multipliers of the correction dg to Jupiter's g in the term arguments
+// (see revizg). Same layout as the argx, argv, argz arrays in theory_1
+struct {
+    double gx1[10], gz1[7], gv1[41], gx2[24], gz2[11], gv2[66],
+		gx3[31], gz3[13], gv3[75], gx4[49], gz4[18], gv4[89];
+} gmul_1;
+
+// All of the above is set up by cd2com and chkgal, and is read-only
+// afterwards. galsat keeps its time-dependent quantities on the stack,
+// so it can be called concurrently from multiple threads.
+
 // Prototypes
 
-int qqdot (double t, double &qpsi11, double &qpsi21);
-void unkod (int *kode, int *kod, int *kmin);
-void barcor();
-void updat (double *argx, int *kodx, double *argv, int *kodv, double *argz,
-    int *kodz, int nmx, int nmv, int nmz);
-int samjay (int nx, int nv, int nz, double *cx, double *cv, double *cz,
-    int nmx, int nmv, int nmz, int nsat, double *ang, double *rat, int nflag);
+static void qqdot (double t, double *q, double *qdot);
+static void unkod (const int *kode, int *kod, int *kmin);
+static void barcor (double t, double *rb);
+static void setupg ();
+static double revizg (double t);
+static void updarg (const int *kode, double *arg, double *g);
+static void updat (double *argx, int *kodx, double *argv, int *kodv, double *argz,
+    int *kodz, int nmx, int nmv, int nmz, double *gx, double *gv, double *gz);
+static void samjay (int nx, int nv, int nz, const double *cx, const double *cv, const double *cz,
+    const double *gx, const double *gv, const double *gz, int nmx, int nmv, int nmz,
+    int nsat, const double *ang, const double *rat, double t, double dg, int nflag, double *rb);
 inline double d_mod (double x, double y)
 { return x - (int)(x/y) * y; }
 
+// multiple of jupiter's g represented by angle codes 86..92
+inline double gcod (int k)
+{ return k < 90 ? k - 90 : k - 89; }
+
 // Function galsat
 
 void galsat (double *r__, double *rorb, double tjd, int ksat, int kflag)
 {
     /* Initialized data */
 
-    static double tolt = 1e-4;
-    static double tolg = 50.;
-    //static int first = 1;
-    static double tref = 2443000.5;
+    static const double tref = 2443000.5;
 
     /* Local variables */
-    static int kflg, nsat;
-    static double qpsi11, qpsi21;
-    static int i, j, nflag;
-    extern int revizg_();
+    int nsat;
+    int i, j;
+    double t, dg, rb[6], q[9], qdot[9];
 
 
 /* **************************************************************** */
@@ -119,87 +133,62 @@ void galsat (double *r__, double *rorb, double tjd, int ksat, int kflag)
 /*                           and samjap, dekod, barcop in galsap */
 /*                           and updat, chkgal, revizg in satsap */
 /* local variables to be saved for galsat/galsap and chkgal, qqdot */
-/* tolt is tolerance for tlast updates, tolg is tolerance for tlastg updates */
 
 /* ..start computation */
-    nflag = kflag;
-	kflg = (ksat > 0 ? 1 : -1);
     nsat = abs(ksat);
-    local_1.t = tjd - tref;
-	/*  note that chkgal will re-set values for tlast, tlastg, tlastp. */
-	/*  galsap will check for previous use by galsat, but galsat won't check */
-	/*  for galsap. */
-	/*  hence, for rigorous check-out one should first call galsat before galsap or */
-	/*  else always update the ancillary angles by setting tolt and tolg equal to */
-	/*  zero. */
-
-	// **** MS: chkgal is now called up-front from the initialisation routine
-    //if (first) {
-	//	first = 0;
-	//	chkgal();
-    //}
-
-    if (fabs(local_1.t - svtloc_1.tlast) > tolt) {
-		svtloc_1.tlast = local_1.t;
-		/*  mark tlastp as being 'dirty' so can intermix galsat/galsap calls */
-		/*  because galsap uses 'q' in a different sense for partials */
-		/*  first call to galsap will initialize tlastp to -4.d20, so this */
-		/*  is our way of telling whether or not galsap has been initialized, */
-		/*  as well as being able to force a tlastg update */
-		svtloc_1.tlastp = -6e20;
-		qqdot (local_1.t, qpsi11, qpsi21);
-
-		// **** MS: remove rotation from ecliptic to earth equator
-		//mult3g_(svtloc_1.p, svtloc_1.qdot, svtloc_1.qmat);
-		//mult3g_(svtloc_1.p, svtloc_1.q, svtloc_1.qdot);
-		memcpy (svtloc_1.qmat, svtloc_1.qdot, 9*sizeof(double));
-		memcpy (svtloc_1.qdot, svtloc_1.q, 9*sizeof(double));
-    }
-	/* now pq is in qdot (for position) and pqdot is in qmat (for vel) */
-	/*  positions are r = qdot * rb, */
-	/*  velocities are rdot = qdot * rbdot + qmat * rb */
-	/* --revise g by adding dg now */
-	/* --these update arguments for dg every 50 days */
-    if (fabs(local_1.t - svtloc_1.tlastg) > tolg) {
-		svtloc_1.tlastg = local_1.t;
-		revizg_();
-    }
+    t = tjd - tref;
+
+	// The rotation matrices and the correction to Jupiter's g used to be
+	// cached between calls (updated when t moved by more than the tolerances
+	// tolt = 1e-4 days and tolg = 50 days). They are now evaluated for each
+	// call, so that galsat is re-entrant and its results don't depend on the
+	// sequence of previous calls.
+    qqdot (t, q, qdot);
+	/*  positions are r = q * rb, */
+	/*  velocities are rdot = q * rbdot + qdot * rb */
+	/* --revise g by adding dg */
+    dg = revizg (t);
+
 	/* now compute satellite coordinates */
 	/*   since do not have args subscripted, set up subr */
     for (i = 0; i < 6; ++i) {
-		local_1.rb[i] = 0.;
+		rb[i] = 0.;
 		r__[i] = 0.;
     }
 	switch (nsat) {
 	case 0:         // Jupiter w.r.t. barycentre
-		barcor();
+		barcor (t, rb);
 		break;
 	case 1:
 		samjay (theory_1.nxi1t, theory_1.nv1t, theory_1.nz1t, theory_1.cxi1, theory_1.cv1,
-			theory_1.cz1, 10, 41, 7, nsat, angblk_1.ang, angblk_1.rat, nflag);
+			theory_1.cz1, gmul_1.gx1, gmul_1.gv1, gmul_1.gz1, 10, 41, 7, nsat,
+			angblk_1.ang, angblk_1.rat, t, dg, kflag, rb);
 		break;
 	case 2:
 		samjay (theory_1.nxi2t, theory_1.nv2t, theory_1.nz2t, theory_1.cxi2, theory_1.cv2,
-			theory_1.cz2, 24, 66, 11, nsat, angblk_1.ang, angblk_1.rat, nflag);
+			theory_1.cz2, gmul_1.gx2, gmul_1.gv2, gmul_1.gz2, 24, 66, 11, nsat,
+			angblk_1.ang, angblk_1.rat, t, dg, kflag, rb);
 		break;
 	case 3:
 		samjay (theory_1.nxi3t, theory_1.nv3t, theory_1.nz3t, theory_1.cxi3, theory_1.cv3,
-			theory_1.cz3, 31, 75, 13, nsat, angblk_1.ang, angblk_1.rat, nflag);
+			theory_1.cz3, gmul_1.gx3, gmul_1.gv3, gmul_1.gz3, 31, 75, 13, nsat,
+			angblk_1.ang, angblk_1.rat, t, dg, kflag, rb);
 		break;
 	case 4:
 		samjay (theory_1.nxi4t, theory_1.nv4t, theory_1.nz4t, theory_1.cxi4, theory_1.cv4,
-			theory_1.cz4, 49, 89, 18, nsat, angblk_1.ang, angblk_1.rat, nflag);
+			theory_1.cz4, gmul_1.gx4, gmul_1.gv4, gmul_1.gz4, 49, 89, 18, nsat,
+			angblk_1.ang, angblk_1.rat, t, dg, kflag, rb);
 		break;
     }
 
 #ifdef UNDEF
 	// MS: no longer needed
-    if (kflg < 0) {
-		barcor();
+    if (ksat < 0) {
+		barcor (t, rb);
     }
 	/* ..return the orbital plane state vector */
     for (i = 0; i < 6; ++i) {
-		rorb[i] = local_1.rb[i];
+		rorb[i] = rb[i];
     }
 #endif
 
@@ -208,10 +197,10 @@ void galsat (double *r__, double *rorb, double tjd, int ksat, int kflag)
 	// rotation matrices
     for (i = 0; i < 3; ++i) {
 		for (j = 0; j < 3; ++j) {
-			r__[i] += svtloc_1.qdot[i + j*3] * local_1.rb[j];
+			r__[i] += q[i + j*3] * rb[j];
 			if (kflag != 1) {
-				r__[i + 3] += svtloc_1.qdot[i + j*3] * local_1.rb[j + 3] +
-					          svtloc_1.qmat[i + j*3] * local_1.rb[j];
+				r__[i + 3] += q[i + j*3] * rb[j + 3] +
+					          qdot[i + j*3] * rb[j];
 			}
 		}
     }
@@ -219,16 +208,17 @@ void galsat (double *r__, double *rorb, double tjd, int ksat, int kflag)
 
 
 /* = = = = = = = = = = = = = = = = = = = = = = = = = = = */
-int samjay (int nx, int nv, int nz, double *cx, double *cv, double *cz,
-    int nmx, int nmv, int nmz, int nsat, double *ang, double *rat, int nflag)
+void samjay (int nx, int nv, int nz, const double *cx, const double *cv, const double *cz,
+    const double *gx, const double *gv, const double *gz, int nmx, int nmv, int nmz,
+    int nsat, const double *ang, const double *rat, double t, double dg, int nflag, double *rb)
 {
     /* System generated locals */
     double d__1;
 
     /* Local variables */
-    static double angl, sdot, vdot, sdfac, s, v;
-    static int k;
-    static double xidot, q1, q2, q3, q4, ca, sa, dt, xi;
+    double angl, sdot, vdot, sdfac, s, v;
+    int k;
+    double xidot, q1, q2, q3, q4, ca, sa, dt, xi;
 
 /* **************************************************** */
 /* >> note:  the q1..q4 variables are employed for consistency with samjap in galsap */
@@ -257,6 +247,9 @@ int samjay (int nx, int nv, int nz, double *cx, double *cv, double *cz,
     cx -= (1+nmx);
     cv -= (1+nmv);
     cz -= (1+nmz);
+    --gx;
+    --gv;
+    --gz;
     --ang;
     --rat;
 
@@ -268,7 +261,7 @@ int samjay (int nx, int nv, int nz, double *cx, double *cv, double *cz,
     vdot = 0.;
     sdot = 0.;
     for (k = 1; k <= nx; ++k) {
-		d__1 = cx[k + (nmx << 1)] + cx[k + nmx * 3] * local_1.t;
+		d__1 = cx[k + (nmx << 1)] + gx[k] * dg + cx[k + nmx * 3] * t;
 		angl = d_mod(d__1, TWOPI);
 		ca = cos(angl);
 		q1 = cx[k + nmx] * ca;
@@ -280,7 +273,7 @@ int samjay (int nx, int nv, int nz, double *cx, double *cv, double *cz,
 		}
     }
     for (k = 1; k <= nv; ++k) {
-		d__1 = cv[k + (nmv << 1)] + cv[k + nmv * 3] * local_1.t;
+		d__1 = cv[k + (nmv << 1)] + gv[k] * dg + cv[k + nmv * 3] * t;
 		angl = d_mod(d__1, TWOPI);
 		sa = sin(angl);
 		q2 = cv[k + nmv] * sa;
@@ -295,7 +288,7 @@ int samjay (int nx, int nv, int nz, double *cx, double *cv, double *cz,
     sdfac = vdot / rat[nsat] + 1.;
 /* >>  sdfac is irrelevant (its value will be 1) when nflag=1 (position-only) */
     for (k = 1; k <= nz; ++k) {
-		d__1 = cz[k + (nmz << 1)] + cz[k + nmz * 3] * (local_1.t + dt);
+		d__1 = cz[k + (nmz << 1)] + gz[k] * dg + cz[k + nmz * 3] * (t + dt);
 		angl = d_mod(d__1, TWOPI);
 		sa = sin(angl);
 		q2 = cz[k + nmz] * sa;
@@ -308,37 +301,36 @@ int samjay (int nx, int nv, int nz, double *cx, double *cv, double *cz,
 		}
     }
 /* --this is l-psi+v */
-    d__1 = ang[nsat] - ang[15] + (rat[nsat] - rat[15]) * local_1.t;
+    d__1 = ang[nsat] - ang[15] + (rat[nsat] - rat[15]) * t;
     angl = d_mod(d__1, TWOPI) + v;
     q1 = theory_1.axis[nsat - 1] * cos(angl);
     q2 = theory_1.axis[nsat - 1] * sin(angl);
     q3 = theory_1.axis[nsat - 1] * s;
     q4 = xi + 1.;
-    local_1.rb[0] = q1 * q4;
-    local_1.rb[1] = q2 * q4;
-    local_1.rb[2] = q3 * q4;
+    rb[0] = q1 * q4;
+    rb[1] = q2 * q4;
+    rb[2] = q3 * q4;
     if (nflag == 1) {
-		return 0;
+		return;
     }
 /* >> now correct for the sdot factor in time-completed: */
     sdot *= sdfac;
     ca = rat[nsat] - rat[15] + vdot;
-    local_1.rb[3] = q1 * xidot - local_1.rb[1] * ca;
-    local_1.rb[4] = q2 * xidot + local_1.rb[0] * ca;
-    local_1.rb[5] = q3 * xidot + theory_1.axis[nsat - 1] * q4 * sdot;
-    return 0;
+    rb[3] = q1 * xidot - rb[1] * ca;
+    rb[4] = q2 * xidot + rb[0] * ca;
+    rb[5] = q3 * xidot + theory_1.axis[nsat - 1] * q4 * sdot;
 } /* samjay_ */
 
 /* = = = = = = = = = = = = = = = = = = = = = = = = = = = */
-void barcor()
+void barcor (double t, double *rb)
 {
     /* System generated locals */
     double d__1;
 
     /* Local variables */
-    static double angl;
-    static int i1;
-    static double t1, t2, ca, sa;
+    double angl;
+    int i1;
+    double t1, t2, ca, sa;
 
 /* ************************************************** */
 /* --calculate barycenter-to-jupiter vector */
@@ -370,26 +362,26 @@ void barcor()
 /* >> */
 /* -- */
     for (i1 = 1; i1 <= 7; ++i1) {
-		d__1 = local_1.angbx[i1 - 1] + local_1.angbx[i1 + 6] * local_1.t;
+		d__1 = local_1.angbx[i1 - 1] + local_1.angbx[i1 + 6] * t;
 		angl = d_mod(d__1, TWOPI);
 		t1 = local_1.cofbx[i1 - 1];
 		t2 = local_1.angbx[i1 + 6];
 		ca = t1 * cos(angl) * 1e-10;
 		sa = t1 * sin(angl) * 1e-10;
-		local_1.rb[0] += ca;
-		local_1.rb[1] += sa;
-		local_1.rb[3] -= sa * t2;
-		local_1.rb[4] += ca * t2;
+		rb[0] += ca;
+		rb[1] += sa;
+		rb[3] -= sa * t2;
+		rb[4] += ca * t2;
     }
     for (i1 = 1; i1 <= 5; ++i1) {
-		d__1 = local_1.angbz[i1 - 1] + local_1.angbz[i1 + 4] * local_1.t;
+		d__1 = local_1.angbz[i1 - 1] + local_1.angbz[i1 + 4] * t;
 		angl = d_mod(d__1, TWOPI);
 		t1 = local_1.cofbz[i1 - 1];
 		t2 = local_1.angbz[i1 + 4];
 		ca = t1 * cos(angl) * 1e-10;
 		sa = t1 * sin(angl) * 1e-10;
-		local_1.rb[2] += sa;
-		local_1.rb[5] += ca * t2;
+		rb[2] += sa;
+		rb[5] += ca * t2;
     }
 }
 
@@ -397,8 +389,8 @@ void barcor()
 void chkgal (void)
 {
     /* Local variables */
-    static int k;
-    static double orbecl, orbequ;
+    int k;
+    double orbecl, orbequ;
 
 
 /* ********************************************** */
@@ -470,16 +462,16 @@ void chkgal (void)
     rotg_(&c__1, &obl, svtloc_1.p);
 #endif
 
-    svtloc_1.tlast = -2e20;
-    svtloc_1.tlastp = -4e20;
-    svtloc_1.tlastg = -6e20;
+	/* --set up the arguments that depend on jupiter's g */
+    setupg ();
 }
 
 /* = = = = = = = = = = = = = = = = = = = = = = = = = = = */
-int qqdot (double t, double &qpsi11, double &qpsi21)
+void qqdot (double t, double *q, double *qdot)
 {
     /* Local variables */
-    static int l;
+    int l;
+    double phi, phidot, cp, sp, qpsi11, qpsi21;
 
 /* **************************************************** */
 /* >> calculate q and qdot matrices where */
@@ -495,42 +487,42 @@ int qqdot (double t, double &qpsi11, double &qpsi21)
 /* >> */
 /* ****************************************** */
 /* -- */
-    svtloc_1.phidot = angblk_1.rat[14];
-    svtloc_1.phi = svtloc_1.phidot * t + angblk_1.ang[14] - angblk_1.ang[21];
-    svtloc_1.cp = cos(svtloc_1.phi);
-    svtloc_1.sp = sin(svtloc_1.phi);
+    phidot = angblk_1.rat[14];
+    phi = phidot * t + angblk_1.ang[14] - angblk_1.ang[21];
+    cp = cos(phi);
+    sp = sin(phi);
 /* --set up matrix to go from jup equ to 1950 ecl */
-    svtloc_1.q[0] = svtloc_1.cn * svtloc_1.cp - svtloc_1.sn * svtloc_1.cj * 
-	    svtloc_1.sp;
-    qpsi11 = -svtloc_1.cn * svtloc_1.sp - svtloc_1.sn * svtloc_1.cj * 
-	    svtloc_1.cp;
-    svtloc_1.q[3] = qpsi11 * svtloc_1.ci + svtloc_1.sn * svtloc_1.sj * 
+    q[0] = svtloc_1.cn * cp - svtloc_1.sn * svtloc_1.cj * 
+	    sp;
+    qpsi11 = -svtloc_1.cn * sp - svtloc_1.sn * svtloc_1.cj * 
+	    cp;
+    q[3] = qpsi11 * svtloc_1.ci + svtloc_1.sn * svtloc_1.sj * 
 	    svtloc_1.si;
-    svtloc_1.q[6] = -qpsi11 * svtloc_1.si + svtloc_1.sn * svtloc_1.sj * 
+    q[6] = -qpsi11 * svtloc_1.si + svtloc_1.sn * svtloc_1.sj * 
 	    svtloc_1.ci;
-    svtloc_1.q[1] = svtloc_1.sn * svtloc_1.cp + svtloc_1.cn * svtloc_1.cj * 
-	    svtloc_1.sp;
-    svtloc_1.qdot[0] = qpsi11 * svtloc_1.phidot;
-    qpsi21 = -svtloc_1.sn * svtloc_1.sp + svtloc_1.cn * svtloc_1.cj * 
-	    svtloc_1.cp;
-    svtloc_1.qdot[1] = qpsi21 * svtloc_1.phidot;
-    svtloc_1.q[4] = qpsi21 * svtloc_1.ci - svtloc_1.cn * svtloc_1.sj * 
+    q[1] = svtloc_1.sn * cp + svtloc_1.cn * svtloc_1.cj * 
+	    sp;
+    qdot[0] = qpsi11 * phidot;
+    qpsi21 = -svtloc_1.sn * sp + svtloc_1.cn * svtloc_1.cj * 
+	    cp;
+    qdot[1] = qpsi21 * phidot;
+    q[4] = qpsi21 * svtloc_1.ci - svtloc_1.cn * svtloc_1.sj * 
 	    svtloc_1.si;
-    svtloc_1.q[7] = -qpsi21 * svtloc_1.si - svtloc_1.cn * svtloc_1.sj * 
+    q[7] = -qpsi21 * svtloc_1.si - svtloc_1.cn * svtloc_1.sj * 
 	    svtloc_1.ci;
-    svtloc_1.q[2] = svtloc_1.sp * svtloc_1.sj;
-    svtloc_1.q[5] = svtloc_1.cp * svtloc_1.sj * svtloc_1.ci + svtloc_1.cj * 
+    q[2] = sp * svtloc_1.sj;
+    q[5] = cp * svtloc_1.sj * svtloc_1.ci + svtloc_1.cj * 
 	    svtloc_1.si;
-    svtloc_1.q[8] = -(svtloc_1.cp * svtloc_1.sj) * svtloc_1.si + svtloc_1.cj *
+    q[8] = -(cp * svtloc_1.sj) * svtloc_1.si + svtloc_1.cj *
 	     svtloc_1.ci;
     for (l = 1; l <= 3; ++l) {
-	svtloc_1.qdot[l + 2] = -(svtloc_1.q[l - 1] * svtloc_1.phidot) * 
+	qdot[l + 2] = -(q[l - 1] * phidot) * 
 		svtloc_1.ci;
 /* L3: */
-	svtloc_1.qdot[l + 5] = svtloc_1.q[l - 1] * svtloc_1.phidot * 
+	qdot[l + 5] = q[l - 1] * phidot * 
 		svtloc_1.si;
     }
-    svtloc_1.qdot[2] = svtloc_1.cp * svtloc_1.sj * svtloc_1.phidot;
+    qdot[2] = cp * svtloc_1.sj * phidot;
 /* --note if node rate .ne. 0, then place cn and sn after stat 1 */
 /* -- and define phidot=rat(15)-rat(22) (rad/day), and add */
 /* --increments  qdot(1,1)=qdot(1,1)-q(2,1)*rat(22) */
@@ -540,151 +532,104 @@ int qqdot (double t, double &qpsi11, double &qpsi21)
 /* --            qdot(1,3)=qdot(1,3)-q(2,3)*rat(22) */
 /* --            qdot(2,3)=qdot(2,3)+q(1,3)*rat(22) */
 /* -- */
-    return 0;
 }
 
 /* = = = = = = = = = = = = = = = = = = = = = = = = = = = */
-/* Subroutine */ int revizg_()
+double revizg (double t)
 {
     /* Local variables */
-    static int k;
-    static double dg, qx;
+    double dg, qx;
 
 /* ********************************************** */
 /* >> revise angles that depend on jupiter's g for jupiter/saturn inequality */
 /*   see lieske, astronomy & astrophysics 56,333-352 (1977) table 3 footnote. */
-/* ****************************************** */
-/* ****************************************** */
-/* ****************************************** */
-/* >> for galsat/galsap local communication */
-/* j*      double precision twopi,degrad,t */
-/* j*c--local common block for subroutines */
-/* j*      common /local/ twopi,degrad,t */
-/* >  only twopi, degrad, t are needed, but we include all to meet f77 standard */
-/* ****************************************** */
-/* --local common block for subroutines */
-/* >> */
-/* ****************************************** */
-/* >> */
 /* -- */
-/* j*      tlastg=t */
+/*   returns the correction dg at time t. the term arguments are */
+/*   arg = arg(dg=0) + gmul*dg, see setupg */
     qx = angblk_1.ang[15] * 2. - angblk_1.ang[16] + (float).76699 / 
-	    DEGRAD + (angblk_1.rat[15] * 2. - angblk_1.rat[16]) * local_1.t;
+	    DEGRAD + (angblk_1.rat[15] * 2. - angblk_1.rat[16]) * t;
     qx = d_mod(qx, TWOPI);
     dg = sin(qx) * .03439;
     qx = angblk_1.ang[15] * 5. - angblk_1.ang[16] * 2. + (float)64.26288 / 
 	    DEGRAD + (angblk_1.rat[15] * 5. - angblk_1.rat[16] * 2.) *
-	     local_1.t - .02276946941 / DEGRAD * local_1.t / 365.25;
+	     t - .02276946941 / DEGRAD * t / 365.25;
     qx = d_mod(qx, TWOPI);
     dg = (dg + sin(qx) * .33033) / DEGRAD;
+    return dg;
+} /* revizg_ */
+
+/* = = = = = = = = = = = = = = = = = = = = = = = = = = = */
+void setupg ()
+{
+    /* Local variables */
+    int k;
+
+/* ********************************************** */
+/* >> set up the arguments of the terms that depend on jupiter's g, at */
+/*   dg = 0, and their multipliers of dg (angle codes 86..92 are */
+/*   multiples of g) */
     for (k = 86; k <= 92; ++k) {
-		qx = (double) (k - 90);
-		if (qx >= 0.) {
-			qx += 1.;
-		}
-		angblk_1.angcod[k - 1] = qx * (angblk_1.ang[16] + dg);
+		angblk_1.angcod[k - 1] = gcod(k) * angblk_1.ang[16];
     }
     updat (theory_1.argx1, theory_1.kodx1, theory_1.argv1, theory_1.kodv1, 
-	    theory_1.argz1, theory_1.kodz1, 10, 41, 7);
+	    theory_1.argz1, theory_1.kodz1, 10, 41, 7,
+	    gmul_1.gx1, gmul_1.gv1, gmul_1.gz1);
     updat (theory_1.argx2, theory_1.kodx2, theory_1.argv2, theory_1.kodv2, 
-	    theory_1.argz2, theory_1.kodz2, 24, 66, 11);
+	    theory_1.argz2, theory_1.kodz2, 24, 66, 11,
+	    gmul_1.gx2, gmul_1.gv2, gmul_1.gz2);
     updat (theory_1.argx3, theory_1.kodx3, theory_1.argv3, theory_1.kodv3, 
-	    theory_1.argz3, theory_1.kodz3, 31, 75, 13);
+	    theory_1.argz3, theory_1.kodz3, 31, 75, 13,
+	    gmul_1.gx3, gmul_1.gv3, gmul_1.gz3);
     updat (theory_1.argx4, theory_1.kodx4, theory_1.argv4, theory_1.kodv4, 
-	    theory_1.argz4, theory_1.kodz4, 49, 89, 18);
-    return 0;
-} /* revizg_ */
+	    theory_1.argz4, theory_1.kodz4, 49, 89, 18,
+	    gmul_1.gx4, gmul_1.gv4, gmul_1.gz4);
+}
 
 /* = = = = = = = = = = = = = = = = = = = = = = = = = = = */
-void updat (double *argx, int *kodx, double *argv, int *kodv, double *argz, int *kodz, int nmx, int nmv, int nmz)
+void updarg (const int *kode, double *arg, double *g)
 {
     /* Local variables */
-    static int kmin;
-    static int kl, km, km1, kod[8], kmz;
+    int kmin, km, kmz, kod[8];
 
 /* **************************************************** */
-/*  called by revizg to update jupiter's mean anomaly for inequalities. */
-/* --updates angles for dg changes */
-/* **************************************************** */
-/* >> for galsat/galsap local communication */
-/* j*      double precision twopi */
-/* j*      common /local/ twopi */
-/* > only twopi is needed, but we include all to meet f77 standard */
-/* ****************************************** */
-/* --local common block for subroutines */
-/* >> */
-/* ****************************************** */
-/* >> */
-/* **************************************************** */
-/* j*      double precision angcod */
-/* j*      common /angblk/ angcod(99) */
-/* >  only angcod is needed, but we include all for f77 standard. */
-/* > */
-/* ****************************************** */
-/* ****************************************** */
-/* > */
-/* **************************************************** */
-/* -- */
-    /* Parameter adjustments */
-    kodx -= 3;
-    --argx;
-    kodv -= 3;
-    --argv;
-    kodz -= 3;
-    --argz;
-
-    /* Function Body */
-    for (kl = 1; kl <= nmx; ++kl) {
-		if (kodx[(kl << 1) + 1] != 0 || kodx[(kl << 1) + 2] != 0) {
-			unkod (&kodx[(kl << 1) + 1], kod, &kmin);
-			for (km = kmin; km <= 8; ++km) {
-				if (kod[km - 1] >= 86 && kod[km - 1] <= 92) {
-					argx[kl] = 0.;
-					for (km1 = kmin; km1 <= 8; ++km1) {
-						kmz = kod[km1 - 1];
-						argx[kl] += angblk_1.angcod[kmz - 1];
-					}
-					argx[kl] = d_mod(argx[kl], TWOPI);
-				}
-		    }
-		}
+/*  argument arg and dg multiplier g of one term: if any of its angle */
+/*  codes refers to jupiter's g, the argument is the sum of the coded */
+/*  angles, otherwise it is left as read from the data file */
+    *g = 0.;
+    if (kode[0] == 0 && kode[1] == 0) return;
+    unkod (kode, kod, &kmin);
+    for (km = kmin; km <= 8; ++km)
+		if (kod[km - 1] >= 86 && kod[km - 1] <= 92) break;
+    if (km > 8) return;
+    *arg = 0.;
+    for (km = kmin; km <= 8; ++km) {
+		kmz = kod[km - 1];
+		*arg += angblk_1.angcod[kmz - 1];
+		if (kmz >= 86 && kmz <= 92) *g += gcod(kmz);
     }
+    *arg = d_mod(*arg, TWOPI);
+}
 
-    for (kl = 1; kl <= nmv; ++kl) {
-		if (kodv[(kl << 1) + 1] != 0 || kodv[(kl << 1) + 2] != 0) {
-			unkod (&kodv[(kl << 1) + 1], kod, &kmin);
-			for (km = kmin; km <= 8; ++km) {
-				if (kod[km - 1] >= 86 && kod[km - 1] <= 92) {
-					argv[kl] = 0.;
-					for (km1 = kmin; km1 <= 8; ++km1) {
-						kmz = kod[km1 - 1];
-						argv[kl] += angblk_1.angcod[kmz - 1];
-					}
-					argv[kl] = d_mod(argv[kl], TWOPI);
-				}
-		    }
-		}
-    }
+/* = = = = = = = = = = = = = = = = = = = = = = = = = = = */
+void updat (double *argx, int *kodx, double *argv, int *kodv, double *argz, int *kodz, int nmx, int nmv, int nmz,
+    double *gx, double *gv, double *gz)
+{
+    int kl;
 
-    for (kl = 1; kl <= nmz; ++kl) {
-		if (kodz[(kl << 1) + 1] != 0 || kodz[(kl << 1) + 2] != 0) {
-			unkod (&kodz[(kl << 1) + 1], kod, &kmin);
-			for (km = kmin; km <= 8; ++km) {
-				if (kod[km - 1] >= 86 && kod[km - 1] <= 92) {
-					argz[kl] = 0.;
-					for (km1 = kmin; km1 <= 8; ++km1) {
-						kmz = kod[km1 - 1];
-						argz[kl] += angblk_1.angcod[kmz - 1];
-					}
-					argz[kl] = d_mod(argz[kl], TWOPI);
-				}
-		    }
-		}
-    }
+/* **************************************************** */
+/*  called by setupg to update jupiter's mean anomaly for inequalities. */
+/* --updates angles for dg changes */
+/* **************************************************** */
+    for (kl = 0; kl < nmx; ++kl)
+		updarg (kodx + 2*kl, argx + kl, gx + kl);
+    for (kl = 0; kl < nmv; ++kl)
+		updarg (kodv + 2*kl, argv + kl, gv + kl);
+    for (kl = 0; kl < nmz; ++kl)
+		updarg (kodz + 2*kl, argz + kl, gz + kl);
 }
 
 /* = = = = = = = = = = = = = = = = = = = = = = = = = = = */
-void unkod (int *kode, int *kod, int *kmin)
+void unkod (const int *kode, int *kod, int *kmin)
 {
     int kb, kx;
 
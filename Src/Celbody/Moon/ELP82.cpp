@@ -1,7 +1,9 @@
 #include <math.h>
 #include <fstream>
+#include <atomic>
+#include <mutex>
 
-#include "OrbiterAPI.h"
+#include "TrigSeries.h"
 
 using namespace std;
 
@@ -15,7 +17,6 @@ using namespace std;
 // Global variables
 // ===========================================================
 typedef double SEQ3[3];
-typedef double SEQ6[6];
 
 static const double cpi     = 3.141592653589793;
 static const double cpi2    = 2.0*cpi;
@@ -33,15 +34,23 @@ static const double mjd2000 = 51544.5; // mjd->dj2000 offset
 static const double sc      = 36525.0;
 static const double precess = 5029.0966/rad;
 
-static       bool need_terms = true; // need to read terms?
+// The term tables are read once (by ELP82_read or lazily by the first
+// ELP82 call) and are read-only afterwards, so ELP82 can be called from
+// multiple threads. Changing the precision with ELP82_read while another
+// thread evaluates ELP82 is not supported.
+static std::atomic<bool> have_terms(false); // terms have been read
+static std::mutex term_lock;                // serialises reading the terms
 static const double def_prec = 1e-5; // default precision
 static       double cur_prec = -1.0; // current precision
+static       int    cur_nused = 0;    // number of terms used
+static       int    cur_ntot = 0;     // number of terms available
 
 static double delnu, dele, delg, delnp, delep;
 static double p1, p2, p3, p4, p5, q1, q2, q3, q4, q5;
 static double w[3][5], p[8][2], eart[5], peri[5], del[4][5], zeta[2];
 static int    nterm[3][12], nrang[3][12];    // current length of term sequences
-static SEQ6 *pc[3]  = {0,0,0};               // main term sequences
+static double *pcx[3] = {0,0,0};             // main term sequences: amplitudes
+static double *pcy[3][5];                    // main term sequences: argument polynomials
 static SEQ3 *per[3] = {0,0,0};               // perturbation term sequences
 
 // ===========================================================
@@ -140,22 +149,25 @@ void ELP82_init ()
 
 void ELP82_exit ()
 {
+	std::lock_guard<std::mutex> lock (term_lock);
 	if (cur_prec >= 0.0) {
 		for (int i = 0; i < 3; i++) {
-			if (pc[i])  { delete []pc[i];  pc[i]  = 0; }
+			if (pcx[i]) { delete []pcx[i]; delete []pcy[i][0]; pcx[i] = 0; }
 			if (per[i]) { delete []per[i]; per[i] = 0; }
 		}
 	}
 	cur_prec = -1.0;
+	have_terms.store (false);
 }
 
 // ===========================================================
 // ELP82_read ()
 // Read the perturbation terms from file and store in global
 // parameters. The number of terms read depends on requested precision.
+// Returns -1 if the data file was not found.
 // ===========================================================
 
-int ELP82_read (double prec)
+static int ReadTerms (double prec)
 {
 	// Term structure interfaces
 	typedef struct {
@@ -178,7 +190,7 @@ int ELP82_read (double prec)
 	if (cur_prec >= 0.0) {
 		if (prec == cur_prec) return 0;   // nothing to do
 		for (int i = 0; i < 3; i++) {
-			if (pc[i])  { delete []pc[i];  pc[i]  = 0; }  // remove existing terms
+			if (pcx[i]) { delete []pcx[i]; delete []pcy[i][0]; pcx[i] = 0; }  // remove existing terms
 			if (per[i]) { delete []per[i]; per[i] = 0; }
 		}
 	}
@@ -193,10 +205,7 @@ int ELP82_read (double prec)
 
 	const char *datf = "Config\\Moon\\Data\\ELP82.dat";
 	ifstream ifs (datf);  // term data stream
-	if (!ifs) {
-		oapiWriteLogError("ELP82: Data file not found: %s", datf);
-		return -1;
-	}
+	if (!ifs) return -1;
 
 	// Read terms for main problem
 	for (ific = 0; ific < 3; ific++) {
@@ -213,7 +222,12 @@ int ELP82_read (double prec)
 		}
 		ntot += mm;
 		mtot += m;
-		if (mm) pc[ific] = new SEQ6[mm];
+		if (mm) {
+			// separate arrays for each term parameter, for the vectorised summation
+			pcx[ific] = new double[mm];
+			pcy[ific][0] = new double[5*mm];
+			for (k = 1; k < 5; k++) pcy[ific][k] = pcy[ific][0] + k*mm;
+		}
 		itab = 0;
 
 		for (im = ir = 0; im < m; im++) {
@@ -233,7 +247,8 @@ int ELP82_read (double prec)
 				zone[k+1] = y;
 			}
 			if (ific == 2) zone[1] += pis2;
-			for (i = 0; i < 6; i++) pc[ific][ir][i] = zone[i];
+			pcx[ific][ir] = zone[0];
+			for (k = 0; k < 5; k++) pcy[ific][k][ir] = zone[k+1];
 			ir++;
 		}
 		nterm[ific][0] = ir;
@@ -289,87 +304,80 @@ int ELP82_read (double prec)
 	// Add: PlanetaryPerturbations
 	// Add: FiguresTides
 
-	oapiWriteLogV("ELP82: Precision %0.1le, Terms %d/%d", prec, ntot, mtot);
-
-	need_terms = false;
 	cur_prec   = prec;
+	cur_nused  = ntot;
+	cur_ntot   = mtot;
+	have_terms.store (true, std::memory_order_release);
 
 	return 0;
 }
 
+int ELP82_read (double prec)
+{
+	std::lock_guard<std::mutex> lock (term_lock);
+	return ReadTerms (prec);
+}
 
 // ===========================================================
-// ELP82 ()
-// Calculate lunar ephemeris using ELP2000-82 perturbation solutions
-// MS modifications:
-// - Time input is MJD instead of JD
-// - Added time derivatives (output in r[3] to r[5])
+// ELP82_terms ()
+// Number of terms used for the current precision, and the
+// number of terms available in the data file
 // ===========================================================
 
-int ELP82 (double mjd, double *r)
+void ELP82_terms (int &nused, int &ntot)
 {
-	int k, iv, nt;
-	double t[5];
-	double x, y, x1, x2, x3, pw, qw, ra, pwqw, pw2, qw2;
-	double x_dot, y_dot, x1_dot, x2_dot, x3_dot, pw_dot, qw_dot;
-	double ra_dot, pwqw_dot, pw2_dot, qw2_dot;
-	double cosr0, sinr0, cosr1, sinr1;
-
-	// Initialisation
-
-	if (need_terms) ELP82_read (def_prec);
+	nused = cur_nused;
+	ntot  = cur_ntot;
+}
 
-	// substitution of time
 
-	t[0] = 1.0;
-    t[1] = (mjd-mjd2000)/sc;
-    t[2] = t[1]*t[1];
-    t[3] = t[2]*t[1];
-    t[4] = t[3]*t[1];
+#ifdef INCLUDE_TIDAL_PERT
 
-	for (iv = 0; iv < 3; iv++) {
-		r[iv] = r[iv+3] = 0.0;
-		SEQ6 *pciv = pc[iv];
+// ===========================================================
+// PertSum ()
+// Add the perturbation sequences of coordinate iv at time
+// powers t to r
+// ===========================================================
 
-		// main sequence (itab=0)
-		for (nt = 0; nt < nterm[iv][0]; nt++) {
-			x = pciv[nt][0];     x_dot = 0.0;
-			y = pciv[nt][1];     y_dot = 0.0;
-			for (k = 1; k <= 4; k++) {
-				y     += pciv[nt][k+1] * t[k];
-				y_dot += pciv[nt][k+1] * t[k-1] * k;
+static void PertSum (int iv, const double *t, double *r)
+{
+	int itab, j, nt;
+	double x, y, x_dot, y_dot = 0.0;
+
+	// perturbation sequences (itab>0)
+	for (itab = 1; itab < 2/*12*/; itab++) {
+		for (nt = 0; nt < nterm[iv][itab]; nt++) {
+			j = nrang[iv][itab-1] + nt;
+			x = per[iv][0][j];
+			y = per[iv][1][j] + per[iv][2][j] * t[1];
+
+			if (itab == 2 || itab == 4 || itab == 6 || itab == 8) {
+				x_dot = x;
+				x    *= t[1];
+			}
+			if (itab == 11) {
+				x_dot = x * t[1] * 2.0;
+				x    *= t[2];
 			}
 			r[iv]   += x*sin(y);
 			r[iv+3] += x_dot*sin(y) + x*cos(y)*y_dot;
 		}
-
-#ifdef INCLUDE_TIDAL_PERT
-
-		int itab, j;
-
-		// perturbation sequences (itab>0)
-		for (itab = 1; itab < 2/*12*/; itab++) {
-			for (nt = 0; nt < nterm[iv][itab]; nt++) {
-				j = nrang[iv][itab-1] + nt;
-				x = per[iv][0][j];
-				y = per[iv][1][j] + per[iv][2][j] * t[1];
-
-				if (itab == 2 || itab == 4 || itab == 6 || itab == 8) {
-					x_dot = x;
-					x    *= t[1];
-				}
-				if (itab == 11) {
-					x_dot = x * t[1] * 2.0;
-					x    *= t[2];
-				}
-				r[iv]   += x*sin(y);
-				r[iv+3] += x_dot*sin(y) + x*cos(y)*y_dot;
-			}
-		}
+	}
+}
 
 #endif // INCLUDE_TIDAL_PERT
 
-	}
+// ===========================================================
+// Transform ()
+// Map the series sums r at time powers t to the orbiter frame
+// ===========================================================
+
+static void Transform (const double *t, double *r)
+{
+	double x1, x2, x3, pw, qw, ra, pwqw, pw2, qw2;
+	double x1_dot, x2_dot, x3_dot, pw_dot, qw_dot;
+	double ra_dot, pwqw_dot, pw2_dot, qw2_dot;
+	double cosr0, sinr0, cosr1, sinr1;
 
 	// Change of coordinates
 
@@ -419,8 +427,8 @@ int ELP82 (double mjd, double *r)
 	// Below is conversion to Orbiter format
 
 	// convert to m and m/s
-	static double pscale = 1e3;
-	static double vscale = 1e3/(86400.0*sc);
+	static const double pscale = 1e3;
+	static const double vscale = 1e3/(86400.0*sc);
 	r[0] *= pscale;
 	r[1] *= pscale;
 	r[2] *= pscale;
@@ -428,5 +436,95 @@ int ELP82 (double mjd, double *r)
 	r[4] *= vscale;
 	r[5] *= vscale;
 
+}
+
+// ===========================================================
+// NeedTerms ()
+// Read the terms at default precision if not done yet
+// ===========================================================
+
+static void NeedTerms ()
+{
+	if (!have_terms.load (std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> lock (term_lock);
+		if (!have_terms.load (std::memory_order_relaxed))
+			ReadTerms (def_prec);
+	}
+}
+
+// ===========================================================
+// ELP82 ()
+// Calculate lunar ephemeris using ELP2000-82 perturbation solutions
+// MS modifications:
+// - Time input is MJD instead of JD
+// - Added time derivatives (output in r[3] to r[5])
+// ===========================================================
+
+int ELP82 (double mjd, double *r)
+{
+	int iv;
+	double t[5];
+
+	// Initialisation
+
+	NeedTerms ();
+
+	// substitution of time
+
+	t[0] = 1.0;
+	t[1] = (mjd-mjd2000)/sc;
+	t[2] = t[1]*t[1];
+	t[3] = t[2]*t[1];
+	t[4] = t[3]*t[1];
+
+	for (iv = 0; iv < 3; iv++) {
+		// main sequence (itab=0)
+		TrigSumSinPoly4 (nterm[iv][0], pcx[iv], pcy[iv], t[1], r[iv], r[iv+3]);
+#ifdef INCLUDE_TIDAL_PERT
+		PertSum (iv, t, r);
+#endif
+	}
+
+	Transform (t, r);
+	return 0;
+}
+
+// ===========================================================
+// ELP82N ()
+// ELP82 for the n dates mjd[0..n-1], with the results for
+// mjd[j] in r[6*j..6*j+5]. The main sequences are summed for
+// chunks of dates together, loading each term once per block
+// of dates.
+// ===========================================================
+
+int ELP82N (int n, const double *mjd, double *r)
+{
+	const int nchunk = 64;
+	double t[nchunk][5], t1[nchunk], sum[nchunk], dsum[nchunk];
+	int iv, j, m;
+
+	NeedTerms ();
+
+	for (; n > 0; n -= m, mjd += m, r += 6*m) {
+		m = (n < nchunk ? n : nchunk);
+		for (j = 0; j < m; j++) {
+			t[j][0] = 1.0;
+			t[j][1] = t1[j] = (mjd[j]-mjd2000)/sc;
+			t[j][2] = t[j][1]*t[j][1];
+			t[j][3] = t[j][2]*t[j][1];
+			t[j][4] = t[j][3]*t[j][1];
+		}
+		for (iv = 0; iv < 3; iv++) {
+			TrigSumSinPoly4N (nterm[iv][0], pcx[iv], pcy[iv], m, t1, sum, dsum);
+			for (j = 0; j < m; j++) {
+				r[6*j+iv] = sum[j], r[6*j+iv+3] = dsum[j];
+#ifdef INCLUDE_TIDAL_PERT
+				PertSum (iv, t[j], r+6*j);
+#endif
+			}
+		}
+		for (j = 0; j < m; j++)
+			Transform (t[j], r+6*j);
+	}
 	return 0;
 }
\ No newline at end of file
@@ -13,7 +13,9 @@
 void ELP82_init ();
 void ELP82_exit ();
 int  ELP82_read (double prec);
+void ELP82_terms (int &nused, int &ntot);
 int  ELP82 (double mjd, double *r);
+int  ELP82N (int n, const double *mjd, double *r);
 void Interpolate (double t, double *data, const Sample *s0, const Sample *s1);
 inline double Radius (double *data)
 { return sqrt (data[0]*data[0] + data[1]*data[1] + data[2]*data[2]); }
@@ -23,12 +25,13 @@ inline double Radius (double *data)
 // class Moon: interface
 // ======================================================================
 
-class Moon: public CELBODY2 {
+class Moon: public CELBODY3 {
 public:
 	Moon (OBJHANDLE hObj);
 	void clbkInit (FILEHANDLE cfg);
 	bool bEphemeris () const { return true; }
 	int clbkEphemeris (double mjd, int req, double *ret);
+	int clbkEphemerisBatch (int n, const double *mjd, int req, double *ret);
 	int clbkFastEphemeris (double simt, int req, double *ret);
 
 private:
@@ -41,7 +44,7 @@ private:
 // class Moon: implementation
 // ======================================================================
 
-Moon::Moon (OBJHANDLE hObj): CELBODY2 (hObj)
+Moon::Moon (OBJHANDLE hObj): CELBODY3 (hObj)
 {
 	prec = 1e-6;
 	interval = 71.0;     // sample interval [s] => interpolation error ~0.1m
@@ -50,8 +53,14 @@ Moon::Moon (OBJHANDLE hObj): CELBODY2 (hObj)
 
 void Moon::clbkInit (FILEHANDLE cfg)
 {
+	int nused, ntot;
 	oapiReadItem_float (cfg, (char*)"ErrorLimit", prec);
-	ELP82_read (prec);
+	if (ELP82_read (prec)) {
+		oapiWriteLogError("ELP82: Data file not found: Config\\Moon\\Data\\ELP82.dat");
+	} else {
+		ELP82_terms (nused, ntot);
+		oapiWriteLogV("ELP82: Precision %0.1le, Terms %d/%d", prec, nused, ntot);
+	}
 	CELBODY2::clbkInit (cfg);
 
 	// Initialise the sampling points
@@ -71,6 +80,25 @@ int Moon::clbkEphemeris (double mjd, int req, double *ret)
 	return req | (EPHEM_TRUEPOS | EPHEM_TRUEVEL | EPHEM_BARYISTRUE);
 }
 
+int Moon::clbkEphemerisBatch (int n, const double *mjd, int req, double *ret)
+{
+	const int nchunk = 64;
+	double r[6*nchunk];
+	int i, j, k, m;
+
+	for (i = 0; i < n; i += m) {
+		m = (n-i < nchunk ? n-i : nchunk);
+		ELP82N (m, mjd+i, r);
+		for (j = 0; j < m; j++) {
+			double *rj = ret+12*(i+j);
+			for (k = 0; k < 6; k++) rj[k] = r[6*j+k];
+			if (req & (EPHEM_BARYPOS | EPHEM_BARYVEL))
+				for (k = 6; k < 12; k++) rj[k] = rj[k-6];
+		}
+	}
+	return req | (EPHEM_TRUEPOS | EPHEM_TRUEVEL | EPHEM_BARYISTRUE);
+}
+
 int Moon::clbkFastEphemeris (double simt, int req, double *ret)
 {
 	Sample *s0, *s1;
@@ -14,18 +14,21 @@ using namespace std;
 // ===========================================================
 
 static void SatEphem (int ksat, double mjd, double *ret);
-static void SampleEphem (int ksat, double simt, double *ret);
+static void SatFrame (const double *r, double *ret);
+static void SampleEphem (int ksat, double simt, double interval, double *ret, Sample *sp);
 
 static const char *satname[NSAT] = {
 	"Mimas", "Enceladus", "Tethys", "Dione", "Rhea", "Titan", "Hyperion", "Iapetus"
 };
 
-static double sample_dt[NSAT];   // sampling intervals
-static Sample sample[NSAT][2];   // interpolation samples
-static double pEphemT[NSAT];     // time of last full solution
-static double pEphemP[NSAT][6];  // last full solution
-static double pInterpT[NSAT];    // time of last interpolated solution
-static double pInterpP[NSAT][6]; // last interpolated solution
+// Sample intervals used for the barycentre offset [s]
+static const double dt_titan = 349.0;
+static const double dt_iapetus = 721.0;
+
+// The TASS1.7 data are read once in InitModule and are read-only
+// afterwards. All time-dependent state (the interpolation samples) is
+// kept by the caller, so the ephemerides of different bodies can be
+// evaluated concurrently.
 
 // ===========================================================
 // class SATOBJ
@@ -33,12 +36,14 @@ static double pInterpP[NSAT][6]; // last interpolated solution
 // TASS17 solutions
 // ===========================================================
 
-SATOBJ::SATOBJ (OBJHANDLE hObj, int is, double dt): CELBODY2 (hObj)
+SATOBJ::SATOBJ (OBJHANDLE hObj, int is, double dt): CELBODY3 (hObj)
 {
-	ksat = is;                                     // body id
-	sample_dt[ksat] = dt;                          // sampling interval
-	sample[ksat][0].t = sample[ksat][1].t = -1e20; // invalidate
-	pInterpT[ksat] = -1;                           // invalidate
+	ksat = is;                         // body id
+	sample_dt = dt;                    // sampling interval
+	sample[0].t = sample[1].t = -1e20; // invalidate
+	sample[0].rad = sample[1].rad = 1;
+	for (int i = 0; i < 6; i++)
+		sample[0].param[i] = sample[1].param[i] = 0.0;
 
 	// write some statistics to the orbiter log
 	oapiWriteLogV("SATSAT %s: Terms %d", satname[ksat], nterm(ksat));
@@ -56,9 +61,28 @@ int SATOBJ::clbkEphemeris (double mjd, int req, double *ret)
 	return 0x1F;
 }
 
+int SATOBJ::clbkEphemerisBatch (int n, const double *mjd, int req, double *ret)
+{
+	const int nchunk = 32;
+	double dj[nchunk], xyz[nchunk*3], vxyz[nchunk*3], r[6];
+	int i, j, m;
+
+	for (; n > 0; n -= m, mjd += m) {
+		m = (n < nchunk ? n : nchunk);
+		for (j = 0; j < m; j++) dj[j] = mjd[j]+2400000.5;
+		posiredN (m, dj, ksat, xyz, vxyz);
+		for (j = 0; j < m; j++, ret += 12) {
+			for (i = 0; i < 3; i++) r[i] = xyz[j*3+i], r[i+3] = vxyz[j*3+i];
+			SatFrame (r, ret);
+			for (i = 0; i < 6; i++) ret[i+6] = ret[i];
+		}
+	}
+	return 0x1F;
+}
+
 int SATOBJ::clbkFastEphemeris (double simt, int req, double *ret)
 {
-	SampleEphem (ksat, simt, ret);
+	SampleEphem (ksat, simt, sample_dt, ret, sample);
 	for (int i = 0; i < 6; i++) ret[i+6] = ret[i];
 
 #ifdef UNDEF
@@ -69,7 +93,7 @@ int SATOBJ::clbkFastEphemeris (double simt, int req, double *ret)
 		SatEphem (ksat, oapiTime2MJD(simt), r2);
 		double dst = sqrt ((r2[0]-ret[0])*(r2[0]-ret[0]) + (r2[1]-ret[1])*(r2[1]-ret[1]) + (r2[2]-ret[2])*(r2[2]-ret[2]));
 		if (dst > resmax) resmax = dst;
-		sprintf (oapiDebugString(), "dt=%f, residual=%g m", sample_dt[ksat], resmax);
+		sprintf (oapiDebugString(), "dt=%f, residual=%g m", sample_dt, resmax);
 	}
 #endif
 
@@ -88,34 +112,30 @@ int SATOBJ::clbkFastEphemeris (double simt, int req, double *ret)
 
 void SatEphem (int ksat, double mjd, double *ret)
 {
-	int i;
-
-	if (mjd == pEphemT[ksat]) {
-
-		for (i = 0; i < 6; i++) ret[i] = pEphemP[ksat][i];
-
-	} else {
-
-		static double r[6];
-
-		posired (mjd+2400000.5, ksat, r, r+3);
-
-		// map from default to orbiter frame of reference: xyz -> xzy
-		// and change units from AU and AU/year to m and m/s
+	double r[6];
 
-		static const double AU = 299792458.0 * 499.004783806;
-		static const double AUy = AU / (86400.0 * 365.25);
-		ret[0] = r[0] * AU;
-		ret[1] = r[2] * AU;
-		ret[2] = r[1] * AU;
-		ret[3] = r[3] * AUy;
-		ret[4] = r[5] * AUy;
-		ret[5] = r[4] * AUy;
+	posired (mjd+2400000.5, ksat, r, r+3);
+	SatFrame (r, ret);
+}
 
-		pEphemT[ksat] = mjd;
-		for (i = 0; i < 6; i++) pEphemP[ksat][i] = ret[i];
+// -----------------------------------------------------------
+// SatFrame:
+// Maps a TASS1.7 state vector to Orbiter coordinates and units
+// -----------------------------------------------------------
 
-	}
+void SatFrame (const double *r, double *ret)
+{
+	// map from default to orbiter frame of reference: xyz -> xzy
+	// and change units from AU and AU/year to m and m/s
+
+	static const double AU = 299792458.0 * 499.004783806;
+	static const double AUy = AU / (86400.0 * 365.25);
+	ret[0] = r[0] * AU;
+	ret[1] = r[2] * AU;
+	ret[2] = r[1] * AU;
+	ret[3] = r[3] * AUy;
+	ret[4] = r[5] * AUy;
+	ret[5] = r[4] * AUy;
 }
 
 inline double Radius (double *data)
@@ -140,56 +160,42 @@ static void Interpolate (double t, double *data, const Sample *s0, const Sample
 	// Warning: velocities are not corrected here!
 }
 
-void SampleEphem (int ksat, double simt, double *ret)
+void SampleEphem (int ksat, double simt, double interval, double *ret, Sample *sp)
 {
-	int i;
-
-	if (simt == pInterpT[ksat]) {
-
-		for (i = 0; i < 6; i++) ret[i] = pInterpP[ksat][i];
-
+	Sample *s0, *s1;
+
+	if (sp[0].t < sp[1].t) s0 = sp+0, s1 = sp+1;
+	else                   s0 = sp+1, s1 = sp+0;
+
+	if (simt >= s0->t && simt <= s1->t) { // interpolate
+		Interpolate (simt, ret, s0, s1);
+	} else if (simt > s1->t) {
+		if (simt <= s1->t + interval) {
+			s0->t = s1->t + interval;
+			SatEphem (ksat, oapiTime2MJD (s0->t), s0->param);
+			s0->rad = Radius (s0->param);
+			Interpolate (simt, ret, s1, s0);
+		} else {
+			s0->t = simt;
+			SatEphem (ksat, oapiTime2MJD (s0->t), s0->param);
+			s0->rad = Radius (s0->param);
+			for (int i = 0; i < 6; i++) ret[i] = s0->param[i];
+		}
 	} else {
-
-		Sample *s0, *s1;
-		Sample *sp = sample[ksat];
-		double interval = sample_dt[ksat];
-
-		if (sp[0].t < sp[1].t) s0 = sp+0, s1 = sp+1;
-		else                   s0 = sp+1, s1 = sp+0;
-
-		if (simt >= s0->t && simt <= s1->t) { // interpolate
-			Interpolate (simt, ret, s0, s1);
-		} else if (simt > s1->t) {
-			if (simt <= s1->t + interval) {
-				s0->t = s1->t + interval;
-				SatEphem (ksat, oapiTime2MJD (s0->t), s0->param);
-				s0->rad = Radius (s0->param);
-				Interpolate (simt, ret, s1, s0);
-			} else {
-				s0->t = simt;
-				SatEphem (ksat, oapiTime2MJD (s0->t), s0->param);
-				s0->rad = Radius (s0->param);
-				for (i = 0; i < 6; i++) ret[i] = s0->param[i];
-			}
+		if (simt >= s0->t - interval) {
+			s1->t = s0->t - interval;
+			SatEphem (ksat, oapiTime2MJD (s1->t), s1->param);
+			s1->rad = Radius (s1->param);
+			Interpolate (simt, ret, s1, s0);
 		} else {
-			if (simt >= s0->t - interval) {
-				s1->t = s0->t - interval;
-				SatEphem (ksat, oapiTime2MJD (s1->t), s1->param);
-				s1->rad = Radius (s1->param);
-				Interpolate (simt, ret, s1, s0);
-			} else {
-				s1->t = simt;
-				SatEphem (ksat, oapiTime2MJD (s1->t), s1->param);
-				s1->rad = Radius (s1->param);
-				s1->t = simt + interval;
-				SatEphem (ksat, oapiTime2MJD (s0->t), s0->param);
-				s0->rad = Radius (s0->param);
-				for (i = 0; i < 6; i++) ret[i] = s1->param[i];
-			}
+			s1->t = simt;
+			SatEphem (ksat, oapiTime2MJD (s1->t), s1->param);
+			s1->rad = Radius (s1->param);
+			s0->t = simt + interval;
+			SatEphem (ksat, oapiTime2MJD (s0->t), s0->param);
+			s0->rad = Radius (s0->param);
+			for (int i = 0; i < 6; i++) ret[i] = s1->param[i];
 		}
-		pInterpT[ksat] = simt;
-		for (i = 0; i < 6; i++) pInterpP[ksat][i] = ret[i];
-
 	}
 }
 
@@ -213,15 +219,15 @@ void SaturnEphemeris (double mjd, double *ret)
 	for (i = 0; i < 6; i++) ret[i] -= r[i]*M_iapetus;
 }
 
-void SaturnFastEphemeris (double simt, double *ret)
+void SaturnFastEphemeris (double simt, double *ret, Sample *sp)
 {
 	double r[6];
 	int i;
 
 	for (i = 0; i < 6; i++) ret[i] = 0.0;
-	SampleEphem (SAT_TITAN, simt, r);
+	SampleEphem (SAT_TITAN, simt, dt_titan, r, sp);
 	for (i = 0; i < 6; i++) ret[i] -= r[i]*M_titan;
-	SampleEphem (SAT_IAPETUS, simt, r);
+	SampleEphem (SAT_IAPETUS, simt, dt_iapetus, r, sp+2);
 	for (i = 0; i < 6; i++) ret[i] -= r[i]*M_iapetus;
 
 #ifdef UNDEF
@@ -242,11 +248,4 @@ DLLCLBK void InitModule (HINSTANCE hModule)
 	// into global data structures
 
 	ReadData ("Config\\Saturn\\Data\\tass17.dat", 0);
-
-	// invalidate all data structures
-	int i;
-	for (i = 0; i < NSAT; i++) {
-		pInterpT[i] = -1;
-		sample[i][0].t = sample[i][1].t = -1e20; // invalidate
-	}
 }
@@ -23,29 +23,34 @@
 // TASS17 solutions
 // ===========================================================
 
-class DLLEXPORT SATOBJ: public CELBODY2 {
+class DLLEXPORT SATOBJ: public CELBODY3 {
 public:
 	SATOBJ (OBJHANDLE hObj, int is, double dt);
 	bool bEphemeris() const;
 	int  clbkEphemeris (double mjd, int req, double *ret);
 	int  clbkFastEphemeris (double simt, int req, double *ret);
+	int  clbkEphemerisBatch (int n, const double *mjd, int req, double *ret);
 
 protected:
-	int ksat;     // object id
+	int ksat;         // object id
+	double sample_dt; // sample interval
+	Sample sample[2]; // interpolation samples
 };
 
 DLLEXPORT void SaturnEphemeris (double mjd, double *ret);
-DLLEXPORT void SaturnFastEphemeris (double simt, double *ret);
+DLLEXPORT void SaturnFastEphemeris (double simt, double *ret, Sample *sp);
 // Returns Saturn's true position w.r.t. the barycentre of the
 // Saturn system (full and interpolated solutions)
-// Only Titan is used for barycentre calculation. Contributions
-// from other moons are considered negligible
+// Only Titan and Iapetus are used for barycentre calculation.
+// Contributions from other moons are considered negligible.
+// sp: interpolation samples of the caller (4 entries: Titan, Iapetus)
 
 // ===========================================================
 // TASS17 driver functions
 // ===========================================================
 
 int posired (double dj, int is, double *xyz, double *vxyz);
+int posiredN (int n, const double *dj, int is, double *xyz, double *vxyz);
 int nterm (int is);
 void ReadData (const char *fname, int res);
 
@@ -44,6 +44,9 @@ static struct {
 static int calclon (double dj, const SeriesData *sd, double *dlo);
 static int calcelem (double dj, int is, double *elem, const SeriesData *sd,
     double *dlo);
+static void calclonN (int n, const double *t, const SeriesData *sd, double (*dlo)[8]);
+static void calcelemN (int n, const double *t, int is, double (*elem)[6],
+    const SeriesData *sd, const double (*dlo)[8]);
 static int edered (double *elem, double *xyz, double *vxyz, int isat);
 static void lithyp (FILE *f);
 static int elemhyp (double dj, double *elem);
@@ -94,6 +97,34 @@ int posired (double dj, int is, double *xyz, double *vxyz)
     return 0;
 }
 
+// ==========================================================
+// posiredN: posired for the n dates dj[0..n-1], with the results for
+// dj[j] in xyz[3*j..3*j+2] and vxyz[3*j..3*j+2]. The series are summed
+// for chunks of dates together, so that each term is loaded once per
+// chunk. The sum for each date is accumulated in the same order as in
+// posired, so the results are identical.
+
+int posiredN (int n, const double *dj, int is, double *xyz, double *vxyz)
+{
+    const int nchunk = 32;
+    double t[nchunk], elem[nchunk][6], dlo[nchunk][8];
+    int j, m;
+
+    for (; n > 0; n -= m, dj += m, xyz += 3*m, vxyz += 3*m) {
+		m = (n < nchunk ? n : nchunk);
+		if (is == 6) {
+			for (j = 0; j < m; j++) elemhyp (dj[j], elem[j]);
+		} else {
+			for (j = 0; j < m; j++) t[j] = (dj[j] - 2444240.) / 365.25;
+			calclonN (m, t, sdata, dlo);
+			calcelemN (m, t, is, elem, sdata+is, dlo);
+		}
+		for (j = 0; j < m; j++)
+			edered (elem[j], xyz+3*j, vxyz+3*j, is);
+    }
+    return 0;
+}
+
 // ==========================================================
 
 int calcelem (double dj, int is, double *elem, const SeriesData *sd,
@@ -175,6 +206,95 @@ int calclon (double dj, const SeriesData *sd, double *dlo)
     return 0;
 }
 
+// ==========================================================
+// calcelemN, calclonN: calcelem and calclon for the n times
+// t[0..n-1] [years from JD 2444240]
+
+void calcelemN (int n, const double *t, int is, double (*elem)[6],
+    const SeriesData *sd, const double (*dlo)[8])
+{
+    int i, j, jk;
+    double phas, arg, s[32], s1[32], s2[32];
+    const Term *tm;
+    const Iks *ik;
+
+    for (j = 0; j < n; j++) s[j] = 0.;
+    tm = sd->term[0];
+    ik = sd->iks[0];
+    for (i = 0; i < sd->ntr[0]; ++i) {
+		for (j = 0; j < n; j++) {
+			phas = tm[i][1];
+			for (jk = 0; jk < 8; ++jk) phas += ik[i][jk] * dlo[j][jk];
+			s[j] += tm[i][0] * cos (phas + t[j] * tm[i][2]);
+		}
+    }
+    for (j = 0; j < n; j++) {
+		elem[j][0] = s[j];
+		s[j] = dlo[j][is] + sd->al0;
+    }
+    tm = sd->term[1];
+    ik = sd->iks[1];
+    for (i = sd->ntr[4]; i < sd->ntr[1]; ++i) {
+		for (j = 0; j < n; j++) {
+			phas = tm[i][1];
+			for (jk = 0; jk < 8; ++jk) phas += ik[i][jk] * dlo[j][jk];
+			s[j] += tm[i][0] * sin (phas + t[j] * tm[i][2]);
+		}
+    }
+    for (j = 0; j < n; j++) {
+		s[j] += sd->an0 * t[j];
+		elem[j][1] = atan2 (sin (s[j]), cos (s[j]));
+		s1[j] = s2[j] = 0.;
+    }
+    tm = sd->term[2];
+    ik = sd->iks[2];
+    for (i = 0; i < sd->ntr[2]; ++i) {
+		for (j = 0; j < n; j++) {
+			phas = tm[i][1];
+			for (jk = 0; jk < 8; ++jk) phas += ik[i][jk] * dlo[j][jk];
+			arg = phas + t[j] * tm[i][2];
+			s1[j] += tm[i][0] * cos (arg);
+			s2[j] += tm[i][0] * sin (arg);
+		}
+    }
+    for (j = 0; j < n; j++) {
+		elem[j][2] = s1[j];
+		elem[j][3] = s2[j];
+		s1[j] = s2[j] = 0.;
+    }
+    tm = sd->term[3];
+    ik = sd->iks[3];
+    for (i = 0; i < sd->ntr[3]; ++i) {
+		for (j = 0; j < n; j++) {
+			phas = tm[i][1];
+			for (jk = 0; jk < 8; ++jk) phas += ik[i][jk] * dlo[j][jk];
+			arg = phas + t[j] * tm[i][2];
+			s1[j] += tm[i][0] * cos (arg);
+			s2[j] += tm[i][0] * sin (arg);
+		}
+    }
+    for (j = 0; j < n; j++) {
+		elem[j][4] = s1[j];
+		elem[j][5] = s2[j];
+    }
+}
+
+void calclonN (int n, const double *t, const SeriesData *sd, double (*dlo)[8])
+{
+    int i, j, is;
+
+    for (is = 0; is < 8; ++is) {
+		for (j = 0; j < n; j++) dlo[j][is] = 0.;
+		if (is != 6) {
+			const SeriesData *sdi = sd+is;
+			const Term *tm = sdi->term[1];
+			for (i = 0; i < sdi->ntr[4]; ++i)
+				for (j = 0; j < n; j++)
+					dlo[j][is] += tm[i][0] * sin (tm[i][1] + t[j] * tm[i][2]);
+		}
+    }
+}
+
 // ==========================================================
 // Read perturbation terms
 
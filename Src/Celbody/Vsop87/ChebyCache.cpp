@@ -0,0 +1,236 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#include "ChebyCache.h"
+#include <math.h>
+
+static const double Pi = 3.14159265358979323846;
+
+// Sum of c[j]*T_j(x), j = 0..n-1 (Clenshaw recurrence)
+static inline double Clenshaw (const double *c, int n, double x)
+{
+	double b0 = 0.0, b1 = 0.0, b2;
+	for (int j = n-1; j > 0; j--) {
+		b2 = b1, b1 = b0;
+		b0 = 2.0*x*b1 - b2 + c[j];
+	}
+	return x*b0 - b1 + c[0];
+}
+
+// Registers a lookup in progress for the lifetime of the object
+struct ReadGuard {
+	std::atomic<int> &n;
+	ReadGuard (std::atomic<int> &_n): n(_n) { n++; }
+	~ReadGuard () { n--; }
+};
+
+// ===========================================================
+// class ChebyCache
+// ===========================================================
+
+ChebyCache::ChebyCache ()
+{
+	func = 0;
+	context = 0;
+	len = lenmin = 1.0;
+	tol[0] = tol[1] = tol[2] = 0.0;
+	slot = 0;
+	nslot = 0;
+	tick = 0;
+	nfit = 0;
+	nreader = 0;
+}
+
+ChebyCache::~ChebyCache ()
+{
+	if (slot) {
+		for (int i = 0; i < nslot; i++)
+			delete slot[i].load();
+		delete []slot;
+	}
+	for (size_t i = 0; i < retired.size(); i++)
+		delete retired[i];
+}
+
+void ChebyCache::Setup (Func _func, void *_context, double _len, const double *_tol, int _nslot)
+{
+	func = _func;
+	context = _context;
+	len = _len;
+	lenmin = _len/64.0;
+	for (int i = 0; i < 3; i++) tol[i] = _tol[i];
+	if (slot) {
+		Clear();
+		delete []slot;
+	}
+	slot = new std::atomic<Granule*>[nslot = _nslot];
+	for (int i = 0; i < nslot; i++) slot[i] = 0;
+}
+
+void ChebyCache::Clear ()
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	for (int i = 0; i < nslot; i++)
+		if (Granule *g = slot[i].exchange (0)) Retire (g);
+	Reclaim (0);
+}
+
+void ChebyCache::Eval (double t, double *ret)
+{
+	ReadGuard guard(nreader);
+	const Granule *g = Find (t);
+	double x = 2.0*(t - g->t0)/g->len - 1.0;
+	for (int i = 0; i < 3; i++) {
+		ret[i]   = Clenshaw (g->c[i], CHEBY_NCOEFF, x);
+		ret[i+3] = Clenshaw (g->d[i], CHEBY_DEGREE, x);
+	}
+}
+
+int ChebyCache::GetGranule (double t, double c[3][CHEBY_NCOEFF])
+{
+	ReadGuard guard(nreader);
+	const Granule *g = Find (t);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < CHEBY_NCOEFF; j++)
+			c[i][j] = g->c[i][j];
+	return g->idx;
+}
+
+void ChebyCache::EvalCoeff (const double c[3][CHEBY_NCOEFF], double x, double len, double *ret)
+{
+	const int N = CHEBY_DEGREE;
+	double h = 0.5*len;
+	for (int i = 0; i < 3; i++) {
+		// position, and the derivative series evaluated along with its
+		// coefficients (same recurrence as in Fit)
+		double d[CHEBY_NCOEFF], b0, b1 = 0.0, b2 = 0.0;
+		for (int j = N; j > 0; j--) {
+			b0 = b2 + 2.0*j*c[i][j];
+			d[j-1] = b0;
+			b2 = b1, b1 = b0;
+		}
+		d[0] *= 0.5;
+		ret[i]   = Clenshaw (c[i], CHEBY_NCOEFF, x);
+		ret[i+3] = Clenshaw (d, N, x)/h;
+	}
+}
+
+const ChebyCache::Granule *ChebyCache::Find (double t)
+{
+	double l = len.load();
+	int idx = (int)floor (t/l);
+	for (int i = 0; i < nslot; i++) {
+		Granule *g = slot[i].load();
+		if (g && g->idx == idx && g->len == l) {
+			unsigned int now = tick.load (std::memory_order_relaxed);
+			if (g->lastuse.load (std::memory_order_relaxed) != now) // avoid writing the shared line on every access
+				g->lastuse.store (now, std::memory_order_relaxed);
+			return g;
+		}
+	}
+	return Fill (t);
+}
+
+const ChebyCache::Granule *ChebyCache::Fill (double t)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	for (;;) {
+		// another thread may have fitted the granule in the meantime
+		double l = len.load();
+		int i, idx = (int)floor (t/l);
+		for (i = 0; i < nslot; i++) {
+			Granule *g = slot[i].load();
+			if (g && g->idx == idx && g->len == l) return g;
+		}
+
+		Granule *g = new Granule;
+		if (Fit (g, idx, l) || l <= lenmin) {
+			// publish in a free or the least recently used slot
+			int j = 0;
+			for (i = 0; i < nslot; i++) {
+				Granule *gi = slot[i].load();
+				if (!gi) { j = i; break; }
+				if (gi->lastuse.load (std::memory_order_relaxed) < slot[j].load()->lastuse.load (std::memory_order_relaxed)) j = i;
+			}
+			g->lastuse.store (++tick, std::memory_order_relaxed);
+			if (Granule *old = slot[j].exchange (g)) Retire (old);
+			Reclaim (1);
+			return g;
+		}
+
+		// tolerance missed: shorter granules for everything
+		delete g;
+		len = l*0.5;
+		for (i = 0; i < nslot; i++)
+			if (Granule *gi = slot[i].exchange (0)) Retire (gi);
+	}
+}
+
+void ChebyCache::Retire (Granule *g)
+{
+	retired.push_back (g);
+}
+
+void ChebyCache::Reclaim (int nself)
+{
+	// A lookup registered after this check can't find a retired granule,
+	// because the granules were unpublished before
+	if (retired.size() && nreader.load() == nself) {
+		for (size_t i = 0; i < retired.size(); i++)
+			delete retired[i];
+		retired.clear();
+	}
+}
+
+bool ChebyCache::Fit (Granule *g, int idx, double len)
+{
+	const int N = CHEBY_DEGREE;
+	double f[CHEBY_NCOEFF][6], fc[6], x, s;
+	int i, j, k;
+
+	// sample the function at the Chebyshev-Lobatto nodes x_k = cos(k pi/N).
+	// The boundary nodes are computed like the neighbours' so that they
+	// are evaluated at identical times
+	double h = 0.5*len;
+	g->idx = idx;
+	g->t0 = idx*len;
+	g->len = len;
+	func (context, (idx+1)*len, f[0]);
+	for (k = 1; k < N; k++)
+		func (context, g->t0 + h*(1.0 + cos (k*Pi/N)), f[k]);
+	func (context, g->t0, f[N]);
+	nfit++;
+
+	for (i = 0; i < 3; i++) {
+		// position coefficients (discrete cosine transform)
+		for (j = 0; j <= N; j++) {
+			s = 0.5*(f[0][i] + (j & 1 ? -f[N][i] : f[N][i]));
+			for (k = 1; k < N; k++)
+				s += f[k][i] * cos ((j*k % (2*N)) * Pi/N);
+			g->c[i][j] = s*2.0/N;
+		}
+		g->c[i][0] *= 0.5;
+		g->c[i][N] *= 0.5;
+
+		// derivative coefficients, scaled to units of t
+		double b0, b1 = 0.0, b2 = 0.0;
+		for (j = N; j > 0; j--) {
+			b0 = b2 + 2.0*j*g->c[i][j];
+			g->d[i][j-1] = b0/h;
+			b2 = b1, b1 = b0;
+		}
+		g->d[i][0] *= 0.5;
+	}
+
+	// check position and rate between the nodes, close to the boundary
+	// and in the centre of the granule
+	for (k = 0; k < 2; k++) {
+		x = cos ((k*(N/2) + 0.5)*Pi/N);
+		func (context, g->t0 + h*(1.0+x), fc);
+		for (i = 0; i < 3; i++) {
+			if (fabs (Clenshaw (g->c[i], CHEBY_NCOEFF, x) - fc[i]) > tol[i]) return false;
+			if (fabs (Clenshaw (g->d[i], N, x) - fc[i+3]) > tol[i]*N*N/h) return false;
+		}
+	}
+	return true;
+}
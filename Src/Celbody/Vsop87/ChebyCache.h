@@ -0,0 +1,110 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#ifndef __CHEBYCACHE_H
+#define __CHEBYCACHE_H
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#define CHEBY_DEGREE 16                 // polynomial degree per granule
+#define CHEBY_NCOEFF (CHEBY_DEGREE+1)   // coefficients per coordinate
+
+// ===========================================================
+// class ChebyCache
+// Piecewise Chebyshev approximation of an ephemeris function,
+// in the style of the JPL ephemeris files: time is divided into
+// fixed-length segments ("granules"), and each granule holds a
+// polynomial fit of the three position coordinates. Granules are
+// fitted on demand at the epochs that are queried, and a limited
+// number of them is kept in memory (least recently used are
+// replaced).
+// Eval and GetGranule may be called concurrently. A granule is not
+// modified once it is published, so lookups don't lock; fits are
+// serialised by a mutex. Replaced granules are deleted once no
+// lookup is in progress.
+// Positions are interpolated at the Chebyshev-Lobatto nodes, which
+// include the granule boundaries, so adjacent granules join without
+// a jump in position. Rates are the derivatives of the position
+// polynomials. Each fit is checked against the function between the
+// nodes; if it misses the tolerance, the granule length is halved.
+// ===========================================================
+
+class ChebyCache {
+public:
+	typedef void (*Func)(void *context, double t, double *ret);
+	// Function to approximate. Returns position ret[0..2] and rate of
+	// change ret[3..5] (per unit of t) at time t
+
+	ChebyCache ();
+	~ChebyCache ();
+
+	void Setup (Func func, void *context, double len, const double *tol, int nslot = 32);
+	// func, context: ephemeris function and its first argument
+	// len: initial granule length (units of t)
+	// tol: fit tolerance for each position coordinate
+	// nslot: max. number of granules kept in memory
+
+	void Clear ();
+	// Discard all granules (must not be called concurrently with Setup)
+
+	void Eval (double t, double *ret);
+	// Position ret[0..2] and rate ret[3..5] at time t
+
+	int GetGranule (double t, double c[3][CHEBY_NCOEFF]);
+	// Copy the position coefficients of the granule containing time t
+	// (fitting it if required). Returns the granule index idx; the
+	// granule covers [idx*Length(), (idx+1)*Length()).
+
+	static void EvalCoeff (const double c[3][CHEBY_NCOEFF], double x, double len, double *ret);
+	// Position ret[0..2] and rate ret[3..5] from the position coefficients
+	// c of a granule of length len, at normalised time x (-1..1)
+
+	inline double Length () const { return len.load(); }
+	// Current granule length
+
+	inline int nFit () const { return nfit.load(); }
+	// Number of granule fits performed so far (for diagnostics)
+
+private:
+	struct Granule {
+		double t0, len;                   // start time, length
+		int idx;                          // granule index (t0 = idx*len)
+		std::atomic<unsigned int> lastuse;// fill count at last access, for replacement
+		double c[3][CHEBY_NCOEFF];        // position coefficients
+		double d[3][CHEBY_NCOEFF];        // rate coefficients (per unit of t)
+	};
+
+	const Granule *Find (double t);
+	// Return the granule containing time t, fitting it if required.
+	// The caller must be registered in nreader while it uses the granule
+
+	const Granule *Fill (double t);
+	// Fit and publish the granule containing time t (locks mtx)
+
+	bool Fit (Granule *g, int idx, double len);
+	// Fit granule idx of length len. Returns false if the tolerance was not met
+
+	void Retire (Granule *g);
+	// Queue a replaced granule for deletion (mtx locked)
+
+	void Reclaim (int nself);
+	// Delete the retired granules if no lookups other than the caller's
+	// nself are in progress (mtx locked)
+
+	Func func;
+	void *context;
+	std::atomic<double> len;  // granule length
+	double lenmin;            // lower limit for halving
+	double tol[3];            // fit tolerance per coordinate
+	std::atomic<Granule*> *slot; // published granules (NULL: empty)
+	int nslot;                // storage size
+	std::atomic<unsigned int> tick; // fill counter
+	std::atomic<int> nfit;    // fits performed
+	std::atomic<int> nreader; // lookups in progress
+	std::vector<Granule*> retired; // replaced granules, deleted by Reclaim
+	std::mutex mtx;           // serialises fits
+};
+
+#endif // !__CHEBYCACHE_H
@@ -24,10 +24,9 @@ const char *EarthAtmosphere_2006::clbkName () const
 	return "2006 Edition model";
 }
 
-bool EarthAtmosphere_2006::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
+// Parameters at geometric altitude alt [m]
+static inline void AtmParams (double alt, ATMOSPHERE::PRM_OUT *prm)
 {
-	double alt = (prm_in->flag & PRM_ALT ? prm_in->alt : 0.0);
-
 	const double g0R = 0.0341643;
 	// g0/R, where g0 is gravitational acceleration at sea level,
 	// and R is specific gas constant for air
@@ -89,7 +88,18 @@ bool EarthAtmosphere_2006::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
 			prm->rho = 1.2250 * e / t;
 		}
 	}
+}
 
+bool EarthAtmosphere_2006::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
+{
+	AtmParams (prm_in->flag & PRM_ALT ? prm_in->alt : 0.0, prm);
+	return true;
+}
+
+bool EarthAtmosphere_2006::clbkParamsBatch (int n, const PRM_IN *prm_in, PRM_OUT *prm)
+{
+	for (int i = 0; i < n; i++)
+		AtmParams (prm_in[i].flag & PRM_ALT ? prm_in[i].alt : 0.0, prm+i);
 	return true;
 }
 
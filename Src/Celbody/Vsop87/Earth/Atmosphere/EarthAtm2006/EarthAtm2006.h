@@ -12,12 +12,13 @@
 // Legacy atmospheric model
 // ======================================================================
 
-class EarthAtmosphere_2006: public ATMOSPHERE {
+class EarthAtmosphere_2006: public ATMOSPHERE2 {
 public:
-	EarthAtmosphere_2006 (CELBODY2 *body): ATMOSPHERE (body) {}
+	EarthAtmosphere_2006 (CELBODY2 *body): ATMOSPHERE2 (body) {}
 	const char *clbkName () const;
 	bool clbkConstants (ATMCONST *atmc) const;
 	bool clbkParams (const PRM_IN *prm_in, PRM_OUT *prm);
+	bool clbkParamsBatch (int n, const PRM_IN *prm_in, PRM_OUT *prm);
 };
 
 #endif // !__EARTHATM2006_H
\ No newline at end of file
@@ -25,10 +25,12 @@ double molweight_fit (double Z, double Tinf);
 // ===========================================================================
 // Constructor
 
-EarthAtmosphere_J71G::EarthAtmosphere_J71G (CELBODY2 *body): ATMOSPHERE (body)
+EarthAtmosphere_J71G::EarthAtmosphere_J71G (CELBODY2 *body): ATMOSPHERE2 (body)
 {
 	hBody = body->GetHandle();
+	atmSeq = 0;
 	atmprm.mjd = -1e10; // invalidate
+	atmprm.Slng = atmprm.Slat = 0.0;
 }
 
 // ===========================================================================
@@ -57,108 +59,148 @@ bool EarthAtmosphere_J71G::clbkConstants (ATMCONST *atmc) const
 // in "Orbiter Technical Reference")
 
 bool EarthAtmosphere_J71G::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
+{
+	return clbkParamsBatch (1, prm_in, prm);
+}
+
+bool EarthAtmosphere_J71G::clbkParamsBatch (int n, const PRM_IN *prm_in, PRM_OUT *prm_out)
 {
 	const double c    = 6.02257e26;    // Avogadro constant
 	const double k    = 1.38066e-23;   // Boltzmann constant
 	const double ck   = c*k;
 	const double m_He = 4.002;         // Helium mass
 
-	double Z = (prm_in->flag & PRM_ALT ? prm_in->alt*1e-3 : 0.0);
-	double lng = (prm_in->flag & PRM_LNG ? prm_in->lng : 0.0);                lng=0;
-	double lat = (prm_in->flag & PRM_LAT ? prm_in->lat : 0.0);                lat=0;
-	double Fbar = (prm_in->flag & PRM_FBR ? prm_in->f107bar : 140.0);
-	double Kp = (prm_in->flag & PRM_AP ? prm_in->ap : 3.0);
+	// Time-dependent terms, shared by all points of the batch
 
 	double mjd = oapiGetSimMJD();
-	if (fabs (mjd - atmprm.mjd) > 0.0417) {
-		// Update sun's geographic position once an hour
-		VECTOR3 gsun;
-		double r;
-		oapiGetGlobalPos (hBody, &gsun);
-		oapiGlobalToEqu (hBody, -gsun, &atmprm.Slng, &atmprm.Slat, &r);
-		atmprm.mjd = mjd;
-	}	
-	double Slat = atmprm.Slat;
-	double Slng = atmprm.Slng - PI2*(mjd-atmprm.mjd)*86400.0/cbody->SidRotPeriod();
+	double Slng, Slat, Smjd;
+	SunPosition (mjd, Slng, Slat, Smjd);
+	Slng -= PI2*(mjd-Smjd)*86400.0/cbody->SidRotPeriod();
 	if (Slng < -PI) Slng += PI2;
 
-	double mw;
+	// phase of semi-annual variation
+	double phi = fmod ((mjd-36204.0)/365.2422, 1.0);
+	double sphi = sin(PI2*phi+1.72);
 
-	if (Z < 90.0) {
+	for (int i = 0; i < n; i++) {
+		const PRM_IN &in = prm_in[i];
+		PRM_OUT *prm = prm_out+i;
 
-		// use US standard atmosphere
-		prm->T   = J77_Temp (Z, 0);
-		prm->rho = J77_Dens_low (Z);
-		mw  = J77_MW_low (Z);
+		double Z = (in.flag & PRM_ALT ? in.alt*1e-3 : 0.0);
+		double lng = (in.flag & PRM_LNG ? in.lng : 0.0);                lng=0;
+		double lat = (in.flag & PRM_LAT ? in.lat : 0.0);                lat=0;
+		double Fbar = (in.flag & PRM_FBR ? in.f107bar : 140.0);
+		double Kp = (in.flag & PRM_AP ? in.ap : 3.0);
 
-	} else {
+		double mw;
 
-		// night-time global exospheric temperature
-		double Tc = 379.0 + 3.24*Fbar;
+		if (Z < 90.0) {
+
+			// use US standard atmosphere
+			prm->T   = J77_Temp (Z, 0);
+			prm->rho = J77_Dens_low (Z);
+			mw  = J77_MW_low (Z);
+
+		} else {
+
+			// night-time global exospheric temperature
+			double Tc = 379.0 + 3.24*Fbar;
 	
-		// modified hour angle of the sun
-		double H = lng - Slng;
-		double tau = H - 0.64577 + 0.10472*sin (H+0.7505) + 3.0*PI;
-
-		tau = fmod (tau, PI2) - PI;    // tau in [-pi,+pi]
-
-		// daily varying temperature
-		double R = 0.3;
-		double stheta = pow((0.5*(1.0-cos(Slat+lat))),1.1);
-		double ceta   = pow((0.5*(1.0+cos(Slat-lat))),1.1);
-		double TL     = Tc*(1.0+R*(stheta+(ceta-stheta)*pow(cos(0.5*tau),3.0)));
-
-		// temperature delta from geomagnetic activity
-		double expKp = exp(Kp);
-		double d_Tg18 = 28.0*Kp + 0.03*expKp;
-
-		// temperature and density delta from geomagnetic activity
-		double d_Tg20 = 14.0*Kp + 0.02*expKp;
-		double d_Gm20 = 0.012*Kp + 1.2e-5*expKp;
-
-		// continuous transition at height 350km
-		double F = 0.5*(tanh(0.04*(Z-350.0))+1.0);
-		double d_Gm = d_Gm20*(1.0-F);
-		double d_Tg = d_Tg20*(1.0-F) + d_Tg18*F;
-
-		// exospheric temp [K]
-		double Tinf = TL+d_Tg;
-
-		// phase of semi-annual variation
-		double phi = fmod ((mjd-36204.0)/365.2422, 1.0);
-
-		// corrected phase, time and altitude contributions of semi-annual
-		// variation
-		double tauc = phi +
-			0.09544*(pow(0.5+0.5*sin(PI2*phi+6.035),1.65)-0.5);
-		double gt   = 0.02835 + 0.3817*(1.0+
-			0.4671*sin(PI2*Tc+4.137))*sin(4.0*PI*Tc+4.259);
-		double fz   = (5.876e-7*pow(Z,2.33) + 0.06328)*exp(-2.868e-3*Z);
-
-		// semi-annual density correction
-		double d_Sa = fz*gt;
-
-		// seasonal-latitudinal correction
-		double d_Sl = 0.014*(Z-90)*exp(-0.0013*pow(Z-90,2)) *
-			(lat>=0?1:-1)*sin(PI2*phi+1.72)*pow(sin(lat),2);
-
-		// Seasonal-latitudinal Helium correction
-		double d_He = 0.65*fabs(Slat)/0.4091609 *
-			(pow(sin(0.25*PI-0.5*lat*(Slat>=0?1:-1)),3) - 0.3535534);
-		d_He = pow10(helium_fit(Z,Tinf) + (d_He-1.0)) * m_He/c;
+			// modified hour angle of the sun
+			double H = lng - Slng;
+			double tau = H - 0.64577 + 0.10472*sin (H+0.7505) + 3.0*PI;
+
+			tau = fmod (tau, PI2) - PI;    // tau in [-pi,+pi]
+
+			// daily varying temperature
+			double R = 0.3;
+			double stheta = pow((0.5*(1.0-cos(Slat+lat))),1.1);
+			double ceta   = pow((0.5*(1.0+cos(Slat-lat))),1.1);
+			double TL     = Tc*(1.0+R*(stheta+(ceta-stheta)*pow(cos(0.5*tau),3.0)));
+
+			// temperature delta from geomagnetic activity
+			double expKp = exp(Kp);
+			double d_Tg18 = 28.0*Kp + 0.03*expKp;
+
+			// temperature and density delta from geomagnetic activity
+			double d_Tg20 = 14.0*Kp + 0.02*expKp;
+			double d_Gm20 = 0.012*Kp + 1.2e-5*expKp;
+
+			// continuous transition at height 350km
+			double F = 0.5*(tanh(0.04*(Z-350.0))+1.0);
+			double d_Gm = d_Gm20*(1.0-F);
+			double d_Tg = d_Tg20*(1.0-F) + d_Tg18*F;
+
+			// exospheric temp [K]
+			double Tinf = TL+d_Tg;
+
+			// time and altitude contributions of semi-annual variation
+			double gt   = 0.02835 + 0.3817*(1.0+
+				0.4671*sin(PI2*Tc+4.137))*sin(4.0*PI*Tc+4.259);
+			double fz   = (5.876e-7*pow(Z,2.33) + 0.06328)*exp(-2.868e-3*Z);
+
+			// semi-annual density correction
+			double d_Sa = fz*gt;
+
+			// seasonal-latitudinal correction
+			double d_Sl = 0.014*(Z-90)*exp(-0.0013*pow(Z-90,2)) *
+				(lat>=0?1:-1)*sphi*pow(sin(lat),2);
+
+			// Seasonal-latitudinal Helium correction
+			double d_He = 0.65*fabs(Slat)/0.4091609 *
+				(pow(sin(0.25*PI-0.5*lat*(Slat>=0?1:-1)),3) - 0.3535534);
+			d_He = pow10(helium_fit(Z,Tinf) + (d_He-1.0)) * m_He/c;
 	
-		prm->T = J77_Temp (Z, Tinf);  // temperature at altitude
-		prm->rho = pow10(dens_fit (Z, Tinf)+d_Gm+d_Sa+d_Sl) + d_He;
-		// density at altitude
+			prm->T = J77_Temp (Z, Tinf);  // temperature at altitude
+			prm->rho = pow10(dens_fit (Z, Tinf)+d_Gm+d_Sa+d_Sl) + d_He;
+			// density at altitude
 
-		mw = molweight_fit (Z, Tinf);
-	}
+			mw = molweight_fit (Z, Tinf);
+		}
 
-	prm->p = prm->rho*ck/mw*prm->T;
+		prm->p = prm->rho*ck/mw*prm->T;
+	}
 
 	return true;
 }
 
+// ===========================================================================
+// Sun's position, cached for an hour. The lookup only takes the lock when the
+// cached values are out of date.
+
+void EarthAtmosphere_J71G::SunPosition (double mjd, double &Slng, double &Slat, double &Smjd)
+{
+	const std::memory_order relaxed = std::memory_order_relaxed;
+	unsigned int seq = atmSeq.load (std::memory_order_acquire);
+	if (!(seq & 1)) {
+		Smjd = atmprm.mjd.load (relaxed);
+		Slng = atmprm.Slng.load (relaxed);
+		Slat = atmprm.Slat.load (relaxed);
+		std::atomic_thread_fence (std::memory_order_acquire);
+		if (atmSeq.load (relaxed) == seq && fabs (mjd - Smjd) <= 0.0417)
+			return;
+	}
+
+	std::lock_guard<std::mutex> lock(atmMutex);
+	if (fabs (mjd - atmprm.mjd.load (relaxed)) > 0.0417) { // not updated by another thread in the meantime
+		// Update sun's geographic position once an hour
+		VECTOR3 gsun;
+		double lng, lat, r;
+		oapiGetGlobalPos (hBody, &gsun);
+		oapiGlobalToEqu (hBody, -gsun, &lng, &lat, &r);
+		seq = atmSeq.load (relaxed);
+		atmSeq.store (seq+1, relaxed);
+		std::atomic_thread_fence (std::memory_order_release);
+		atmprm.mjd.store (mjd, relaxed);
+		atmprm.Slng.store (lng, relaxed);
+		atmprm.Slat.store (lat, relaxed);
+		atmSeq.store (seq+2, std::memory_order_release);
+	}
+	Smjd = atmprm.mjd.load (relaxed);
+	Slng = atmprm.Slng.load (relaxed);
+	Slat = atmprm.Slat.load (relaxed);
+}
+
 
 
 // ===========================================================================
@@ -6,26 +6,39 @@
 
 #include "OrbiterAPI.h"
 #include "CelbodyAPI.h"
+#include <atomic>
+#include <mutex>
 
 // ======================================================================
 // class EarthAtmosphere_J71G
 // Implementation of Jacchia71-Gill atmosphere model
 // ======================================================================
 
-class EarthAtmosphere_J71G: public ATMOSPHERE {
+class EarthAtmosphere_J71G: public ATMOSPHERE2 {
 public:
 	EarthAtmosphere_J71G (CELBODY2 *body);
 	const char *clbkName () const;
 	bool clbkConstants (ATMCONST *atmc) const;
 	bool clbkParams (const PRM_IN *prm_in, PRM_OUT *prm);
+	bool clbkParamsBatch (int n, const PRM_IN *prm_in, PRM_OUT *prm_out);
+	// The time-dependent terms are evaluated once for the batch. Both variants
+	// may be called concurrently from several threads.
 
 private:
+	void SunPosition (double mjd, double &Slng, double &Slat, double &Smjd);
+	// Sun's equatorial position in the rotating Earth frame, updated once an
+	// hour, and the time it refers to
+
 	OBJHANDLE hBody;   // handle for the associated celestial body
 
-	// Time-dependent atmospheric parameters at last evaluation
+	// Time-dependent atmospheric parameters at last evaluation. They are read
+	// without a lock, and are consistent if atmSeq (odd during an update) is
+	// unchanged across the read. Updates are serialised by atmMutex.
+	std::mutex atmMutex;
+	std::atomic<unsigned int> atmSeq;
 	struct {
-		double mjd;        // evaluation time
-		double Slng, Slat; // sun's equatorial position in rotating Earth frame
+		std::atomic<double> mjd;        // evaluation time
+		std::atomic<double> Slng, Slat; // sun's equatorial position in rotating Earth frame
 	} atmprm;
 };
 
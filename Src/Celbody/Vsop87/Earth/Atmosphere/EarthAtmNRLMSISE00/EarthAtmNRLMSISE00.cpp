@@ -4,16 +4,44 @@
 // ======================================================================
 // class EarthAtmosphere_NRLMSISE00
 // MSIS atmosphere model implementation
+// The model can be tabulated for faster evaluation (see MsisTable.h).
+// The table is configured in the planet's configuration file:
+//    AtmTableTol = <tol>   interpolation error of the density (relative),
+//                          0 (default) for direct evaluation of the model
+//    AtmTableAlt = <alt>   upper altitude limit of the table [m]
+//                          (default 1000e3). Direct evaluation above.
+//    AtmTableMem = <mem>   memory budget of the table [MB] (default 64)
 // ======================================================================
 
 #define ORBITER_MODULE
 #include "EarthAtmNRLMSISE00.h"
-#include "nrlmsise-00.h"
+#include "MsisTable.h"
+#include <stdio.h>
 
-EarthAtmosphere_NRLMSISE00::EarthAtmosphere_NRLMSISE00 (CELBODY2 *body): ATMOSPHERE (body)
+EarthAtmosphere_NRLMSISE00::EarthAtmosphere_NRLMSISE00 (CELBODY2 *body): ATMOSPHERE2 (body)
 {
-	pmjd = -1000000;  // invalidate
-	doy = 0;
+	table = 0;
+
+	char name[256], cfgname[256];
+	double tol = 0.0, altmax = 1000e3, mem = 64.0;
+	oapiGetObjectName (body->GetHandle(), name, 256);
+	sprintf (cfgname, "%s.cfg", name);
+	FILEHANDLE hFile = oapiOpenFile (cfgname, FILE_IN_ZEROONFAIL, CONFIG);
+	if (hFile) {
+		oapiReadItem_float (hFile, (char*)"AtmTableTol", tol);
+		oapiReadItem_float (hFile, (char*)"AtmTableAlt", altmax);
+		oapiReadItem_float (hFile, (char*)"AtmTableMem", mem);
+		oapiCloseFile (hFile, FILE_IN_ZEROONFAIL);
+	}
+	if (tol > 0.0) {
+		table = new MsisTable (tol, altmax*1e-3, (size_t)(mem*1024.0*1024.0));
+		oapiWriteLogV ("NRLMSISE00 %s: Tabulated up to %0.0lf km, tolerance %g", name, altmax*1e-3, tol);
+	}
+}
+
+EarthAtmosphere_NRLMSISE00::~EarthAtmosphere_NRLMSISE00 ()
+{
+	if (table) delete table;
 }
 
 const char *EarthAtmosphere_NRLMSISE00::clbkName () const
@@ -33,8 +61,13 @@ bool EarthAtmosphere_NRLMSISE00::clbkConstants (ATMCONST *atmc) const
 
 bool EarthAtmosphere_NRLMSISE00::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
 {
-	static struct nrlmsise_output output = {0};
-	static struct nrlmsise_input input = {
+	return clbkParamsBatch (1, prm_in, prm);
+}
+
+bool EarthAtmosphere_NRLMSISE00::clbkParamsBatch (int n, const PRM_IN *prm_in, PRM_OUT *prm)
+{
+	// All state is local, so that the model can be evaluated concurrently
+	struct nrlmsise_input input = {
 		0,    // year, currently ignored
 		172,  // day of year
 		29000,// second in day
@@ -47,58 +80,60 @@ bool EarthAtmosphere_NRLMSISE00::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
 		3.0,  // magnetic index(daily)
 		NULL  // pointer to detailed magnetic values
 	};
-	static struct nrlmsise_flags flags = {0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1};
+	struct nrlmsise_flags flags = {0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1};
 
 	double mjd = oapiGetSimMJD();
 
 	// second in the day calculation
 	double h, ijd;
 	h = 24.0 * modf (mjd, &ijd); // hour in the day
-	
-	// day in year calculation
-	if ((int)mjd != pmjd) { // do this only when the day number changes
-		double c, e, mjd2;
-		int a, b, f, m, y;
-		if (ijd < -100840) {
-			c = ijd + 2401525.0;
-		} else {
-			b = (int)((ijd + 532784.75) / 36524.25);
-			c = ijd + 2401526.0 + (b - b/4);
-		}
-		a = (int)((c-122.1)/365.25);
-		e = 365.0 * a + a/4;
-		f = (int)((c-e)/30.6001);
-		m = f-1 - 12 * (f/14);
-		y = a-4715 - ((7 + m)/10) - 1;
-		double a2 = (double)(10000*y + 1231);
-		if (a2 <= 15821004.1) b = (y+4716)/4 - 1181;
-		else                  b = y/400 - y/100 + y/4;
-		mjd2 = 365.0*y + b - 678576.0;
-		doy = (int)(mjd-mjd2);
-		pmjd = (int)mjd;
-	}
 
-	input.doy    = doy;
+	input.doy    = DayOfYear (mjd, ijd);
 	input.sec    = h*3600.0;
 
-	input.alt    = (prm_in->flag & PRM_ALT ? prm_in->alt*1e-3 : 0.0);
-	input.g_long = (prm_in->flag & PRM_LNG ? prm_in->lng*DEG : 0.0);
-	input.g_lat  = (prm_in->flag & PRM_LAT ? prm_in->lat*DEG : 0.0);
-	input.lst    = h+input.g_long/15.0;
-	input.f107A  = (prm_in->flag & PRM_FBR ? prm_in->f107bar : 140.0);
-	input.f107   = (prm_in->flag & PRM_F   ? prm_in->f107 : input.f107A);
-	input.ap     = (prm_in->flag & PRM_AP  ? prm_in->ap : 3.0);
-
-	gtd7 (&input, &flags, &output);
-	double n = output.d[0]+output.d[1]+output.d[2]+output.d[3]+output.d[4]+output.d[6]+output.d[7]; // total number density [1/cm^3]
-	static double k = 1.38066e-23*1e6; // Boltzmann constant and scale from cm^-3 to m^-3
-	prm->T = output.t[1];
-	prm->p = n*k*prm->T;
-	prm->rho = output.d[5]*1e3;
-
+	for (int i = 0; i < n; i++) {
+		const PRM_IN *pi = prm_in+i;
+		input.alt    = (pi->flag & PRM_ALT ? pi->alt*1e-3 : 0.0);
+		input.g_long = (pi->flag & PRM_LNG ? pi->lng*DEG : 0.0);
+		input.g_lat  = (pi->flag & PRM_LAT ? pi->lat*DEG : 0.0);
+		input.lst    = h+input.g_long/15.0;
+		input.f107A  = (pi->flag & PRM_FBR ? pi->f107bar : 140.0);
+		input.f107   = (pi->flag & PRM_F   ? pi->f107 : input.f107A);
+		input.ap     = (pi->flag & PRM_AP  ? pi->ap : 3.0);
+
+		bool tabulated = false;
+		if (table) {
+			table->SetKey (input.doy, input.f107A, input.f107, input.ap);
+			tabulated = table->Eval (input.alt, input.g_lat, input.g_long, input.lst, prm[i].T, prm[i].p, prm[i].rho);
+		}
+		if (!tabulated) // direct evaluation
+			MsisParams (&input, &flags, prm[i].T, prm[i].p, prm[i].rho);
+	}
 	return true;
 }
 
+int EarthAtmosphere_NRLMSISE00::DayOfYear (double mjd, double ijd)
+{
+	double c, e, mjd2;
+	int a, b, f, m, y;
+	if (ijd < -100840) {
+		c = ijd + 2401525.0;
+	} else {
+		b = (int)((ijd + 532784.75) / 36524.25);
+		c = ijd + 2401526.0 + (b - b/4);
+	}
+	a = (int)((c-122.1)/365.25);
+	e = 365.0 * a + a/4;
+	f = (int)((c-e)/30.6001);
+	m = f-1 - 12 * (f/14);
+	y = a-4715 - ((7 + m)/10) - 1;
+	double a2 = (double)(10000*y + 1231);
+	if (a2 <= 15821004.1) b = (y+4716)/4 - 1181;
+	else                  b = y/400 - y/100 + y/4;
+	mjd2 = 365.0*y + b - 678576.0;
+	return (int)(mjd-mjd2);
+}
+
 
 // ======================================================================
 // API interface
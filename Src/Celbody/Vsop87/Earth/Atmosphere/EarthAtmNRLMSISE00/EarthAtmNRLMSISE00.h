@@ -7,21 +7,29 @@
 #include "OrbiterAPI.h"
 #include "CelbodyAPI.h"
 
+class MsisTable;
+
 // ======================================================================
 // class EarthAtmosphere_NRLMSISE00
 // MSIS atmosphere model implementation
 // ======================================================================
 
-class EarthAtmosphere_NRLMSISE00: public ATMOSPHERE {
+class EarthAtmosphere_NRLMSISE00: public ATMOSPHERE2 {
 public:
 	EarthAtmosphere_NRLMSISE00 (CELBODY2 *body);
+	~EarthAtmosphere_NRLMSISE00 ();
 	const char *clbkName () const;
 	bool clbkConstants (ATMCONST *atmc) const;
 	bool clbkParams (const PRM_IN *prm_in, PRM_OUT *prm);
+	bool clbkParamsBatch (int n, const PRM_IN *prm_in, PRM_OUT *prm);
+	// The date terms are evaluated once for the batch. Both variants may be
+	// called concurrently from several threads.
 
 private:
-	int pmjd; // date of previous day-of-year calculation
-	int doy;  // current day-of-year value
+	static int DayOfYear (double mjd, double ijd);
+	// day of year for date mjd with integer part ijd
+
+	MsisTable *table; // tabulated model, or NULL for direct evaluation
 };
 
 #endif // !__EARTHATMNRLMSISE00
\ No newline at end of file
@@ -0,0 +1,243 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// ======================================================================
+// Tabulated NRLMSISE-00 model (see MsisTable.h)
+// ======================================================================
+
+#include "MsisTable.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+static const double kB = 1.38066e-23*1e6; // Boltzmann constant and scale from cm^-3 to m^-3
+
+void MsisParams (struct nrlmsise_input *input, struct nrlmsise_flags *flags,
+	double &T, double &p, double &rho)
+{
+	struct nrlmsise_output output;
+	gtd7 (input, flags, &output);
+	double n = output.d[0]+output.d[1]+output.d[2]+output.d[3]+output.d[4]+output.d[6]+output.d[7]; // total number density [1/cm^3]
+	T   = output.t[1];
+	p   = n*kB*T;
+	rho = output.d[5]*1e3;
+}
+
+// ======================================================================
+// class MsisTable
+
+MsisTable::MsisTable (double tol, double _altmax, size_t membudget)
+{
+	// The interpolation error of log(density) is about 0.045 s^2 for the
+	// cell sizes below scaled by s, in all altitude ranges
+	static const double base_alt[NLAYER+1] = {0.0, 120.0, 200.0, 500.0, 1e10}; // layer boundaries [km]
+	static const double base_dalt[NLAYER]  = {2.0, 4.0, 10.0, 20.0};          // cell heights [km]
+	double s = std::min (2.0, sqrt (tol/0.05));
+	int i;
+
+	altmax = _altmax;
+	for (i = na = nlayer = 0; i < NLAYER && base_alt[i] < altmax; i++) {
+		double alt1 = std::min (base_alt[i+1], altmax);
+		int n = std::max (1, (int)ceil ((alt1-base_alt[i])/(base_dalt[i]*s)));
+		layer[i].alt0 = base_alt[i];
+		layer[i].dalt = (alt1-base_alt[i])/n;
+		layer[i].i0 = na;
+		na += n;
+		nlayer++;
+	}
+	na = ((na + TILE-1) / TILE) * TILE; // the top layer extends beyond altmax to fill the tiles
+
+	nlat = (int)ceil (180.0/(10.0*s));
+	nlat = ((nlat + TILE-1) / TILE) * TILE;
+	dlat = 180.0/nlat;
+	nlst = (int)ceil (24.0/(1.0*s));
+	nlst = ((nlst + TILE-1) / TILE) * TILE;
+	dlst = 24.0/nlst;
+	nlng = (int)ceil (360.0/(30.0*s));
+	nlng = ((nlng + TILE-1) / TILE) * TILE;
+	dlng = 360.0/nlng;
+
+	maxTiles = std::max ((size_t)1, membudget / sizeof(Tile));
+	tick = 0;
+
+	memset (&flags, 0, sizeof(flags));
+	for (i = 1; i < 24; i++) flags.switches[i] = 1;
+	doy = -1; // invalidate
+	f107A = f107 = ap = 0.0;
+}
+
+MsisTable::~MsisTable ()
+{
+	Clear ();
+}
+
+void MsisTable::Clear ()
+{
+	// caller holds the exclusive lock
+	for (auto &t : tiles) delete t.second;
+	tiles.clear();
+}
+
+size_t MsisTable::nTiles () const
+{
+	std::shared_lock<std::shared_mutex> lock(mtx);
+	return tiles.size();
+}
+
+size_t MsisTable::MemUsage () const
+{
+	return nTiles() * sizeof(Tile);
+}
+
+void MsisTable::SetKey (int _doy, double _f107A, double _f107, double _ap)
+{
+	{
+		std::shared_lock<std::shared_mutex> lock(mtx);
+		if (_doy == doy && _f107A == f107A && _f107 == f107 && _ap == ap) return;
+	}
+	std::unique_lock<std::shared_mutex> wlock(mtx);
+	if (_doy != doy || _f107A != f107A || _f107 != f107 || _ap != ap) { // not set by another thread in the meantime
+		Clear ();
+		doy = _doy;
+		f107A = _f107A;
+		f107 = _f107;
+		ap = _ap;
+	}
+}
+
+double MsisTable::AltNode (int i) const
+{
+	int l = nlayer-1;
+	while (l > 0 && i < layer[l].i0) l--;
+	return layer[l].alt0 + (i-layer[l].i0)*layer[l].dalt;
+}
+
+bool MsisTable::Eval (double alt, double lat, double lng, double lst, double &T, double &p, double &rho)
+{
+	if (alt < 0.0 || alt >= altmax) return false;
+
+	// altitude cell
+	int l = nlayer-1;
+	while (l > 0 && alt < layer[l].alt0) l--;
+	int ia = layer[l].i0 + (int)((alt-layer[l].alt0)/layer[l].dalt);
+	if (l < nlayer-1) ia = std::min (ia, layer[l+1].i0-1);
+	double a0 = AltNode (ia);
+	double wa = (alt-a0)/(AltNode (ia+1)-a0);
+
+	// angular cells (local time and longitude are periodic)
+	lst = fmod (lst, 24.0);
+	if (lst < 0.0) lst += 24.0;
+	lng = fmod (lng + 180.0, 360.0);
+	if (lng < 0.0) lng += 360.0;
+	double flat = (lat+90.0)/dlat, flst = lst/dlst, flng = lng/dlng;
+	int ilat = std::max (0, std::min ((int)flat, nlat-1));
+	int ilst = std::min ((int)flst, nlst-1);
+	int ilng = std::min ((int)flng, nlng-1);
+	double wlat = flat-ilat, wlst = flst-ilst, wlng = flng-ilng;
+
+	int ta = ia/TILE, tlat = ilat/TILE, tlst = ilst/TILE, tlng = ilng/TILE;
+	int i0 = (((ia-ta*TILE)*NODE + (ilat-tlat*TILE))*NODE + (ilst-tlst*TILE))*NODE + (ilng-tlng*TILE);
+
+	std::shared_lock<std::shared_mutex> lock(mtx);
+	Tile *tile = GetTile (ta, tlat, tlst, tlng);
+	if (!tile) {
+		lock.unlock();
+		Tile *t = NewTile ();
+		{
+			std::unique_lock<std::shared_mutex> wlock(mtx);
+			auto res = tiles.emplace (Key (ta, tlat, tlst, tlng), t);
+			if (!res.second) delete t; // added concurrently by another thread
+			else {
+				t->lastuse.store (++tick, std::memory_order_relaxed);
+				if (tiles.size() > maxTiles) EvictTiles ();
+			}
+		}
+		lock.lock();
+		if (!(tile = GetTile (ta, tlat, tlst, tlng))) return false; // evicted again straight away (budget of a single tile)
+	}
+
+	// Nodes are evaluated by the first thread to claim them. A thread that
+	// finds a node claimed but not yet ready evaluates its own copy rather
+	// than waiting.
+	double v[3] = {0.0, 0.0, 0.0};
+	for (int c = 0; c < 16; c++) {
+		int da = (c >> 3) & 1, dlat_ = (c >> 2) & 1, dlst_ = (c >> 1) & 1, dlng_ = c & 1;
+		double w = (da ? wa : 1.0-wa) * (dlat_ ? wlat : 1.0-wlat) * (dlst_ ? wlst : 1.0-wlst) * (dlng_ ? wlng : 1.0-wlng);
+		int j = i0 + ((da*NODE + dlat_)*NODE + dlst_)*NODE + dlng_;
+		float *fn = tile->f[j], fl[3];
+		if (tile->state[j].load (std::memory_order_acquire) != NODE_READY) {
+			unsigned char s = NODE_EMPTY;
+			if (tile->state[j].compare_exchange_strong (s, NODE_BUSY, std::memory_order_acquire)) {
+				EvalNode (ia+da, ilat+dlat_, ilst+dlst_, ilng+dlng_, fn);
+				tile->state[j].store (NODE_READY, std::memory_order_release);
+			} else if (s == NODE_BUSY) {
+				EvalNode (ia+da, ilat+dlat_, ilst+dlst_, ilng+dlng_, fn = fl);
+			}
+		}
+		v[0] += w*fn[0];
+		v[1] += w*fn[1];
+		v[2] += w*fn[2];
+	}
+	rho = exp (v[0]);
+	p   = exp (v[1]);
+	T   = v[2];
+	return true;
+}
+
+MsisTable::Tile *MsisTable::GetTile (int ia, int ilat, int ilst, int ilng)
+{
+	// caller holds the lock. Tiles used since the last insertion share its
+	// stamp, which is all EvictTiles needs, and a tile is only written to
+	// when it is first used after an insertion.
+	auto it = tiles.find (Key (ia, ilat, ilst, ilng));
+	if (it == tiles.end()) return 0;
+	if (it->second->lastuse.load (std::memory_order_relaxed) != tick)
+		it->second->lastuse.store (tick, std::memory_order_relaxed);
+	return it->second;
+}
+
+MsisTable::Tile *MsisTable::NewTile ()
+{
+	Tile *tile = new Tile;
+	for (int i = 0; i < NODE*NODE*NODE*NODE; i++)
+		tile->state[i].store (NODE_EMPTY, std::memory_order_relaxed);
+	tile->lastuse = 0;
+	return tile;
+}
+
+void MsisTable::EvalNode (int ia, int ilat, int ilst, int ilng, float *f) const
+{
+	// caller holds the lock, so the key is stable
+	struct nrlmsise_input input = {0, doy, 0.0, 0.0, 0.0, 0.0, 0.0, f107A, f107, ap, NULL};
+	struct nrlmsise_flags fl = flags; // gtd7 writes to the flags
+	double T, p, rho;
+	input.alt    = AltNode (ia);
+	input.g_lat  = ilat*dlat - 90.0;
+	input.lst    = ilst*dlst;
+	input.g_long = ilng*dlng - 180.0;
+	input.sec    = fmod (input.lst - input.g_long/15.0 + 48.0, 24.0) * 3600.0; // UT
+	MsisParams (&input, &fl, T, p, rho);
+	f[0] = (float)log (rho);
+	f[1] = (float)log (p);
+	f[2] = (float)T;
+}
+
+void MsisTable::EvictTiles ()
+{
+	// caller holds the exclusive lock. Drop the oldest eighth of the budget
+	// in one go so that eviction scans stay rare.
+	size_t ndrop = std::max ((size_t)1, maxTiles / 8);
+	std::vector<std::pair<unsigned long long, unsigned long long>> age;
+	age.reserve (tiles.size());
+	for (auto &t : tiles)
+		age.emplace_back (t.second->lastuse.load (std::memory_order_relaxed), t.first);
+	ndrop = std::min (ndrop, age.size());
+	std::nth_element (age.begin(), age.begin() + (ndrop-1), age.end());
+	for (size_t j = 0; j < ndrop; j++) {
+		auto it = tiles.find (age[j].second);
+		delete it->second;
+		tiles.erase (it);
+	}
+}
@@ -0,0 +1,105 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#ifndef __MSISTABLE_H
+#define __MSISTABLE_H
+
+#include "nrlmsise-00.h"
+#include <stddef.h>
+#include <atomic>
+#include <shared_mutex>
+#include <unordered_map>
+
+// ======================================================================
+// Evaluation of the NRLMSISE-00 model
+// ======================================================================
+
+void MsisParams (struct nrlmsise_input *input, struct nrlmsise_flags *flags,
+	double &T, double &p, double &rho);
+// Temperature T [K], pressure p [Pa] and density rho [kg/m^3] from gtd7
+// for the given input. flags: model switches (see nrlmsise-00.h). gtd7
+// writes the derived switches into flags, so concurrent callers must not
+// share a flags structure.
+
+// ======================================================================
+// class MsisTable
+// Tabulated NRLMSISE-00 model for one day of year and one set of solar
+// flux and geomagnetic indices. The table spans altitude x latitude x
+// local solar time x longitude (the time of day follows from local time
+// and longitude) and stores log(density), log(pressure) and temperature
+// at the nodes, which are interpolated linearly in all four coordinates.
+// The grid is stored in tiles of TILE^4 cells, which are allocated on
+// first use and dropped in least-recently-used order once the memory
+// budget is exhausted. The model is evaluated for each node when it is
+// first needed, so the cost of filling the table follows the number of
+// cells actually visited. Changing the day or the indices invalidates all
+// tiles.
+// SetKey and Eval may be called concurrently from several threads.
+// Independent of the Orbiter API.
+// ======================================================================
+
+class MsisTable {
+public:
+	MsisTable (double tol, double altmax, size_t membudget);
+	// tol: target interpolation error of log(density)
+	// altmax: upper altitude limit of the table [km]
+	// membudget: max. memory used by tiles [bytes]
+
+	~MsisTable ();
+
+	void SetKey (int doy, double f107A, double f107, double ap);
+	// Select the day of year and the indices for subsequent Eval calls
+	// (from all threads). Drops all tiles if any of them differ from the
+	// current ones.
+
+	bool Eval (double alt, double lat, double lng, double lst, double &T, double &p, double &rho);
+	// Interpolated model parameters (units as for MsisParams) at altitude
+	// alt [km], latitude lat and longitude lng [deg] and local solar time
+	// lst [h]. Returns false if alt is outside the table; T, p and rho are
+	// not modified in that case.
+
+	inline double AltMax () const { return altmax; }
+
+	size_t nTiles () const;
+	size_t MemUsage () const;
+	// currently cached tiles and the memory they occupy
+
+	enum { TILE = 4, NODE = TILE + 1, NLAYER = 4 };
+
+private:
+	enum NodeState { NODE_EMPTY, NODE_BUSY, NODE_READY };
+	struct Tile {
+		float f[NODE*NODE*NODE*NODE][3];  // log(rho), log(p), T at the tile nodes, alt-major
+		std::atomic<unsigned char> state[NODE*NODE*NODE*NODE]; // NodeState of each node
+		std::atomic<unsigned long long> lastuse;
+	};
+
+	Tile *GetTile (int ia, int ilat, int ilst, int ilng);
+	Tile *NewTile ();
+	void EvalNode (int ia, int ilat, int ilst, int ilng, float *f) const;
+	void EvictTiles ();
+	void Clear ();
+	double AltNode (int i) const;
+	static inline unsigned long long Key (int ia, int ilat, int ilst, int ilng)
+	{ return ((unsigned long long)ia << 48) | ((unsigned long long)ilat << 32) | ((unsigned long long)ilst << 16) | (unsigned long long)ilng; }
+
+	struct {
+		double alt0, dalt;     // layer base [km] and cell height
+		int i0;                // index of the first cell in the layer
+	} layer[NLAYER];           // altitude layers with different cell heights
+	int nlayer;                // number of layers used
+	double altmax;             // table top [km]
+	double dlat, dlst, dlng;   // cell size [deg], [h], [deg]
+	int na, nlat, nlst, nlng;  // number of cells
+	size_t maxTiles;           // tile budget
+
+	int doy;                          // table key: day of year
+	double f107A, f107, ap;           // table key: indices
+	struct nrlmsise_flags flags;      // model switches (copied for each evaluation)
+
+	mutable std::shared_mutex mtx;    // guards the key and the tile map
+	std::unordered_map<unsigned long long, Tile*> tiles;
+	unsigned long long tick;          // LRU stamp: advanced by each tile insertion (under the exclusive lock)
+};
+
+#endif // !__MSISTABLE_H
@@ -20,9 +20,9 @@ void Earth::clbkInit (FILEHANDLE cfg)
 	ReadData ("Earth");
 }
 
-int Earth::clbkEphemeris (double mjd, int req, double *ret)
+int Earth::AssembleEphem (double mjd, int req, double *r, double *ret)
 {
-	VsopEphem (mjd, ret);
+	for (int i = 0; i < 6; i++) ret[i] = r[i];
 	return fmtflag | EPHEM_TRUEPOS | EPHEM_TRUEVEL;
 }
 
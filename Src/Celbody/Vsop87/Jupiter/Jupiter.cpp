@@ -25,18 +25,14 @@ void Jupiter::clbkInit (FILEHANDLE cfg)
 	ReadData ("Jupiter");
 }
 
-int Jupiter::clbkEphemeris (double mjd, int req, double *ret)
+int Jupiter::AssembleEphem (double mjd, int req, double *r, double *ret)
 {
 	// This version adds barycentric offset to VSOP result
 	// so that true Jupiter position is returned
 
-	static double r[6];
 	int i;
 
-	// Get barycentre data from VSOP
-	VsopEphem (mjd, r);
-
-	// Convert to cartesian
+	// Convert barycentre data from VSOP to cartesian
 	Pol2Crt (r, ret);
 
 	if (req & (EPHEM_BARYPOS | EPHEM_BARYVEL))
@@ -56,7 +52,7 @@ int Jupiter::clbkFastEphemeris (double simt, int req, double *ret)
 	// This version adds barycentric offset to VSOP result
 	// so that true Jupiter position is returned
 
-	static double r[6];
+	double r[6];
 
 	// Get barycentre interpolation from VSOP
 	VsopFastEphem (simt, r);
@@ -14,9 +14,11 @@ class Jupiter: public VSOPOBJ {
 public:
 	Jupiter (OBJHANDLE hCBody);
 	void clbkInit (FILEHANDLE cfg);
-	int clbkEphemeris (double mjd, int req, double *ret);
 	int clbkFastEphemeris (double simt, int req, double *ret);
 
+protected:
+	int AssembleEphem (double mjd, int req, double *r, double *ret);
+
 private:
 	Sample bsp[2]; // barycentre offset interpolation
 };
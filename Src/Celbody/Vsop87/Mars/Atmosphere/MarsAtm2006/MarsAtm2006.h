@@ -12,12 +12,13 @@
 // Mars atmosphere model, as used in Orbiter 2006
 // ======================================================================
 
-class MarsAtmosphere_2006: public ATMOSPHERE {
+class MarsAtmosphere_2006: public ATMOSPHERE2 {
 public:
-	MarsAtmosphere_2006 (CELBODY2 *body): ATMOSPHERE (body) {}
+	MarsAtmosphere_2006 (CELBODY2 *body): ATMOSPHERE2 (body) {}
 	const char *clbkName () const;
 	bool clbkConstants (ATMCONST *atmc) const;
 	bool clbkParams (const PRM_IN *prm_in, PRM_OUT *prm);
+	bool clbkParamsBatch (int n, const PRM_IN *prm_in, PRM_OUT *prm);
 };
 
 #endif // !__MARSATM2006_H
\ No newline at end of file
@@ -14,8 +14,10 @@ class Neptune: public VSOPOBJ {
 public:
 	Neptune (OBJHANDLE hCBody);
 	void clbkInit (FILEHANDLE cfg);
-	int clbkEphemeris (double mjd, int req, double *ret);
 	int clbkFastEphemeris (double simt, int req, double *ret);
+
+protected:
+	int AssembleEphem (double mjd, int req, double *r, double *ret);
 };
 
 #endif // !__VSOP87_NEPTUNE
\ No newline at end of file
@@ -13,6 +13,12 @@
 Saturn::Saturn (OBJHANDLE hCBody): VSOPOBJ (hCBody)
 {
 	a0 = 9.6;    // semi-major axis [AU]
+	for (int j = 0; j < 4; j++) {
+		bsp[j].t = -1e20; // invalidate
+		bsp[j].rad = 1;
+		for (int i = 0; i < 6; i++)
+			bsp[j].param[i] = 0.0;
+	}
 }
 
 void Saturn::clbkInit (FILEHANDLE cfg)
@@ -21,18 +27,14 @@ void Saturn::clbkInit (FILEHANDLE cfg)
 	ReadData ("Saturn");
 }
 
-int Saturn::clbkEphemeris (double mjd, int req, double *ret)
+int Saturn::AssembleEphem (double mjd, int req, double *r, double *ret)
 {
 	// This version adds barycentric offset to VSOP result
 	// so that true Saturn position is returned
 
-	static double r[6];
 	int i;
 
-	// Get barycentre data from VSOP
-	VsopEphem (mjd, r);
-
-	// Convert to cartesian
+	// Convert barycentre data from VSOP to cartesian
 	Pol2Crt (r, ret);
 
 	if (req & (EPHEM_BARYPOS | EPHEM_BARYVEL))
@@ -50,7 +52,7 @@ int Saturn::clbkEphemeris (double mjd, int req, double *ret)
 
 int Saturn::clbkFastEphemeris (double simt, int req, double *ret)
 {
-	static double r[6];
+	double r[6];
 	int i;
 
 	// Get barycentre interpolation from VSOP
@@ -60,7 +62,7 @@ int Saturn::clbkFastEphemeris (double simt, int req, double *ret)
 	Pol2Crt (r, ret+6);
 
 	// Get barycentre offset interpolation from SATSAT
-	SaturnFastEphemeris (simt, r);
+	SaturnFastEphemeris (simt, r, bsp);
 	for (i = 0; i < 6; i++) ret[i] = ret[i+6]+r[i];
 
 	return EPHEM_TRUEPOS | EPHEM_TRUEVEL | EPHEM_BARYPOS | EPHEM_BARYVEL;
@@ -14,8 +14,13 @@ class Saturn: public VSOPOBJ {
 public:
 	Saturn (OBJHANDLE hCBody);
 	void clbkInit (FILEHANDLE cfg);
-	int clbkEphemeris (double mjd, int req, double *ret);
 	int clbkFastEphemeris (double simt, int req, double *ret);
+
+protected:
+	int AssembleEphem (double mjd, int req, double *r, double *ret);
+
+private:
+	Sample bsp[4]; // barycentre offset interpolation (Titan, Iapetus)
 };
 
 #endif // !__VSOP87_SATURN
\ No newline at end of file
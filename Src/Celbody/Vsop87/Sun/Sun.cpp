@@ -22,10 +22,10 @@ void Sun::clbkInit (FILEHANDLE cfg)
 	ReadData ("Sun");
 }
 
-int Sun::clbkEphemeris (double mjd, int req, double *ret)
+int Sun::AssembleEphem (double mjd, int req, double *r, double *ret)
 {
 	if (req & (EPHEM_TRUEPOS | EPHEM_TRUEVEL))
-		VsopEphem (mjd, ret);
+		for (int i = 0; i < 6; i++) ret[i] = r[i];
 	if (req & (EPHEM_BARYPOS | EPHEM_BARYVEL))
 		for (int i = 6; i < 12; i++) ret[i] = 0.0;
 	return (req & 0xF) | fmtflag;
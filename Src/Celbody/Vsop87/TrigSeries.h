@@ -0,0 +1,183 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#ifndef __TRIGSERIES_H
+#define __TRIGSERIES_H
+
+// ===========================================================
+// Summation kernels for the periodic series of the analytic
+// ephemerides (VSOP87, ELP2000-82). The terms are stored as
+// structure-of-arrays (one array per term parameter), and sine
+// and cosine are evaluated with a polynomial kernel in blocks of
+// TRIG_LANES terms. The lane loops have no calls or branches, so
+// the compiler can map a block onto a SIMD register (4 lanes with
+// AVX/AVX2, 8 with AVX-512); otherwise they run as plain scalar
+// code with the same results.
+// Each kernel returns the sum and its time derivative from a single
+// pass over the terms.
+// ===========================================================
+
+#if defined(__AVX512F__)
+#define TRIG_LANES 8
+#elif defined(__AVX2__) || defined(__AVX__)
+#define TRIG_LANES 4
+#else
+#define TRIG_LANES 2
+#endif
+
+// Sine and cosine of x. Cody-Waite reduction to |r| <= pi/4 followed by
+// the fdlibm minimax polynomials. Accurate to about 1 ulp for |x| < 1e6,
+// and to the rounding error of x itself for larger arguments (|x| < 3e9).
+inline void TrigSinCos (double x, double &s, double &c)
+{
+	const double invpio2 = 6.36619772367581382433e-01;
+	const double pio2_1  = 1.57079632673412561417e+00; // first 33 bits of pi/2
+	const double pio2_2  = 6.07710050630396597660e-11; // next 33 bits
+	const double pio2_3  = 2.02226624871116645580e-21; // remainder
+	const double rnd     = 6755399441055744.0;          // 1.5*2^52: round to integer
+
+	double q = (x*invpio2 + rnd) - rnd;
+	double r = ((x - q*pio2_1) - q*pio2_2) - q*pio2_3;
+	int iq = (int)q;
+
+	double z = r*r;
+	double sr = r + r*z*(-1.66666666666666324348e-01 + z*(8.33333333332248946124e-03 +
+		z*(-1.98412698298579493134e-04 + z*(2.75573137070700676789e-06 +
+		z*(-2.50507602534068634195e-08 + z*1.58969099521155010221e-10)))));
+	double cr = 1.0 - 0.5*z + z*z*(4.16666666666666019037e-02 + z*(-1.38888888888741095749e-03 +
+		z*(2.48015872894767294178e-05 + z*(-2.75573143513906633035e-07 +
+		z*(2.08757232129817482790e-09 - z*1.13596475577881948265e-11)))));
+
+	// quadrant: swap for odd q, sign from bit 1 of q (sin) and q+1 (cos)
+	double ss = (iq & 1 ? cr : sr);
+	double cc = (iq & 1 ? sr : cr);
+	s = ss * (double)(1 - (iq & 2));
+	c = cc * (double)(1 - ((iq+1) & 2));
+}
+
+// Sum of a[i]*cos(b[i] + c[i]*t), i = 0..n-1, and its derivative with
+// respect to t (VSOP87 form)
+inline void TrigSumCos (int n, const double *a, const double *b, const double *c, double t,
+	double &sum, double &dsum)
+{
+	double acc[TRIG_LANES], dacc[TRIG_LANES];
+	double sn[TRIG_LANES], cs[TRIG_LANES];
+	int i, k;
+
+	for (k = 0; k < TRIG_LANES; k++) acc[k] = dacc[k] = 0.0;
+	for (i = 0; i + TRIG_LANES <= n; i += TRIG_LANES) {
+		for (k = 0; k < TRIG_LANES; k++)
+			TrigSinCos (b[i+k] + c[i+k]*t, sn[k], cs[k]);
+		for (k = 0; k < TRIG_LANES; k++) {
+			acc[k]  += a[i+k]*cs[k];
+			dacc[k] -= a[i+k]*c[i+k]*sn[k];
+		}
+	}
+	for (k = 0; i < n; i++, k++) {
+		TrigSinCos (b[i] + c[i]*t, sn[0], cs[0]);
+		acc[k]  += a[i]*cs[0];
+		dacc[k] -= a[i]*c[i]*sn[0];
+	}
+	sum = dsum = 0.0;
+	for (k = 0; k < TRIG_LANES; k++) sum += acc[k], dsum += dacc[k];
+}
+
+// Sum of x[i]*sin(y_i(t)), with y_i(t) = p[0][i] + p[1][i]*t + ... + p[4][i]*t^4,
+// i = 0..n-1, and its derivative with respect to t (ELP2000-82 form)
+inline void TrigSumSinPoly4 (int n, const double *x, const double *const p[5], double t,
+	double &sum, double &dsum)
+{
+	double acc[TRIG_LANES], dacc[TRIG_LANES];
+	double y[TRIG_LANES], ydot[TRIG_LANES], sn[TRIG_LANES], cs[TRIG_LANES];
+	const double *p0 = p[0], *p1 = p[1], *p2 = p[2], *p3 = p[3], *p4 = p[4];
+	int i, k;
+
+	for (k = 0; k < TRIG_LANES; k++) acc[k] = dacc[k] = 0.0;
+	for (i = 0; i + TRIG_LANES <= n; i += TRIG_LANES) {
+		for (k = 0; k < TRIG_LANES; k++) {
+			y[k]    = p0[i+k] + t*(p1[i+k] + t*(p2[i+k] + t*(p3[i+k] + t*p4[i+k])));
+			ydot[k] = p1[i+k] + t*(2.0*p2[i+k] + t*(3.0*p3[i+k] + t*4.0*p4[i+k]));
+			TrigSinCos (y[k], sn[k], cs[k]);
+		}
+		for (k = 0; k < TRIG_LANES; k++) {
+			acc[k]  += x[i+k]*sn[k];
+			dacc[k] += x[i+k]*cs[k]*ydot[k];
+		}
+	}
+	for (k = 0; i < n; i++, k++) {
+		y[0]    = p0[i] + t*(p1[i] + t*(p2[i] + t*(p3[i] + t*p4[i])));
+		ydot[0] = p1[i] + t*(2.0*p2[i] + t*(3.0*p3[i] + t*4.0*p4[i]));
+		TrigSinCos (y[0], sn[0], cs[0]);
+		acc[k]  += x[i]*sn[0];
+		dacc[k] += x[i]*cs[0]*ydot[0];
+	}
+	sum = dsum = 0.0;
+	for (k = 0; k < TRIG_LANES; k++) sum += acc[k], dsum += dacc[k];
+}
+
+// ===========================================================
+// Multi-epoch forms of the kernels: the sums for m times t[j],
+// j = 0..m-1. Here the lanes run over the times, so each term is
+// loaded once per block of TRIG_LANES times, and the sums are
+// accumulated term by term for each time.
+// ===========================================================
+
+// TrigSumCos for the times t[0..m-1]
+inline void TrigSumCosN (int n, const double *a, const double *b, const double *c,
+	int m, const double *t, double *sum, double *dsum)
+{
+	double tt[TRIG_LANES], acc[TRIG_LANES], dacc[TRIG_LANES];
+	double sn[TRIG_LANES], cs[TRIG_LANES];
+	int i, j, k, nl;
+
+	for (j = 0; j < m; j += TRIG_LANES) {
+		nl = (m-j < TRIG_LANES ? m-j : TRIG_LANES);
+		for (k = 0; k < TRIG_LANES; k++) {
+			tt[k] = t[j + (k < nl ? k : nl-1)]; // pad a partial block
+			acc[k] = dacc[k] = 0.0;
+		}
+		for (i = 0; i < n; i++) {
+			const double ai = a[i], bi = b[i], ci = c[i];
+			for (k = 0; k < TRIG_LANES; k++)
+				TrigSinCos (bi + ci*tt[k], sn[k], cs[k]);
+			for (k = 0; k < TRIG_LANES; k++) {
+				acc[k]  += ai*cs[k];
+				dacc[k] -= ai*ci*sn[k];
+			}
+		}
+		for (k = 0; k < nl; k++) sum[j+k] = acc[k], dsum[j+k] = dacc[k];
+	}
+}
+
+// TrigSumSinPoly4 for the times t[0..m-1]
+inline void TrigSumSinPoly4N (int n, const double *x, const double *const p[5],
+	int m, const double *t, double *sum, double *dsum)
+{
+	double tt[TRIG_LANES], acc[TRIG_LANES], dacc[TRIG_LANES];
+	double y[TRIG_LANES], ydot[TRIG_LANES], sn[TRIG_LANES], cs[TRIG_LANES];
+	const double *p0 = p[0], *p1 = p[1], *p2 = p[2], *p3 = p[3], *p4 = p[4];
+	int i, j, k, nl;
+
+	for (j = 0; j < m; j += TRIG_LANES) {
+		nl = (m-j < TRIG_LANES ? m-j : TRIG_LANES);
+		for (k = 0; k < TRIG_LANES; k++) {
+			tt[k] = t[j + (k < nl ? k : nl-1)];
+			acc[k] = dacc[k] = 0.0;
+		}
+		for (i = 0; i < n; i++) {
+			const double xi = x[i], q0 = p0[i], q1 = p1[i], q2 = p2[i], q3 = p3[i], q4 = p4[i];
+			for (k = 0; k < TRIG_LANES; k++) {
+				y[k]    = q0 + tt[k]*(q1 + tt[k]*(q2 + tt[k]*(q3 + tt[k]*q4)));
+				ydot[k] = q1 + tt[k]*(2.0*q2 + tt[k]*(3.0*q3 + tt[k]*4.0*q4));
+				TrigSinCos (y[k], sn[k], cs[k]);
+			}
+			for (k = 0; k < TRIG_LANES; k++) {
+				acc[k]  += xi*sn[k];
+				dacc[k] += xi*cs[k]*ydot[k];
+			}
+		}
+		for (k = 0; k < nl; k++) sum[j+k] = acc[k], dsum[j+k] = dacc[k];
+	}
+}
+
+#endif // !__TRIGSERIES_H
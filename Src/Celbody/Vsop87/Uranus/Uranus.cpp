@@ -20,9 +20,9 @@ void Uranus::clbkInit (FILEHANDLE cfg)
 	ReadData ("Uranus");
 }
 
-int Uranus::clbkEphemeris (double mjd, int req, double *ret)
+int Uranus::AssembleEphem (double mjd, int req, double *r, double *ret)
 {
-	VsopEphem (mjd, ret+6);
+	for (int i = 0; i < 6; i++) ret[i+6] = r[i];
 	return fmtflag | EPHEM_BARYPOS | EPHEM_BARYVEL;
 }
 
@@ -24,10 +24,9 @@ const char *VenusAtmosphere_2006::clbkName () const
 	return "2006 Edition model";
 }
 
-bool VenusAtmosphere_2006::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
+// Parameters at geometric altitude alt [m]
+static inline void AtmParams (double alt, ATMOSPHERE::PRM_OUT *prm)
 {
-	double alt = (prm_in->flag & PRM_ALT ? prm_in->alt : 0.0);
-
 	const double g0R = 0.0469506;
 	// g0/R, where g0 is gravitational acceleration at sea level,
 	// and R is specific gas constant for air
@@ -64,7 +63,18 @@ bool VenusAtmosphere_2006::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
 		prm->p   = 9.2e6 * e;
 		prm->rho = 65 * e / t;
 	}
+}
 
+bool VenusAtmosphere_2006::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
+{
+	AtmParams (prm_in->flag & PRM_ALT ? prm_in->alt : 0.0, prm);
+	return true;
+}
+
+bool VenusAtmosphere_2006::clbkParamsBatch (int n, const PRM_IN *prm_in, PRM_OUT *prm)
+{
+	for (int i = 0; i < n; i++)
+		AtmParams (prm_in[i].flag & PRM_ALT ? prm_in[i].alt : 0.0, prm+i);
 	return true;
 }
 
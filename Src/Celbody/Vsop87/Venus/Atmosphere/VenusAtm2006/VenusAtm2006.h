@@ -12,12 +12,13 @@
 // Venus atmosphere model, as used in Orbiter 2006
 // ======================================================================
 
-class VenusAtmosphere_2006: public ATMOSPHERE {
+class VenusAtmosphere_2006: public ATMOSPHERE2 {
 public:
-	VenusAtmosphere_2006 (CELBODY2 *body): ATMOSPHERE (body) {}
+	VenusAtmosphere_2006 (CELBODY2 *body): ATMOSPHERE2 (body) {}
 	const char *clbkName () const;
 	bool clbkConstants (ATMCONST *atmc) const;
 	bool clbkParams (const PRM_IN *prm_in, PRM_OUT *prm);
+	bool clbkParamsBatch (int n, const PRM_IN *prm_in, PRM_OUT *prm);
 };
 
 #endif // !__VENUSATM2006_H
\ No newline at end of file
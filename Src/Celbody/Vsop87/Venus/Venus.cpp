@@ -20,9 +20,9 @@ void Venus::clbkInit (FILEHANDLE cfg)
 	ReadData ("Venus");
 }
 
-int Venus::clbkEphemeris (double mjd, int req, double *ret)
+int Venus::AssembleEphem (double mjd, int req, double *r, double *ret)
 {
-	VsopEphem (mjd, ret);
+	for (int i = 0; i < 6; i++) ret[i] = r[i];
 	if (req & (EPHEM_BARYPOS | EPHEM_BARYVEL))
 		for (int i = 6; i < 12; i++) ret[i] = ret[i-6];
 	return req | fmtflag | (EPHEM_TRUEPOS | EPHEM_TRUEVEL | EPHEM_BARYISTRUE);
@@ -13,28 +13,27 @@ inline double Radius (double *data)
 	return sqrt (data[0]*data[0] + data[1]*data[1] + data[2]*data[2]);
 }
 
+static const double mjd2000 = 51544.5;     // MJD date of epoch J2000
+static const double cheby_reltol = 1e-4;   // Chebyshev fit tolerance, relative to ErrorLimit
+static const double AU = 299792458*499.004783806; // 1 AU in meters
+
 // ===========================================================
 // class VSOPOBJ
 // Base class for planets controlled by VSOP87 solutions
 // ===========================================================
 
-VSOPOBJ::VSOPOBJ (OBJHANDLE hCBody): CELBODY2 (hCBody)
+VSOPOBJ::VSOPOBJ (OBJHANDLE hCBody): CELBODY3 (hCBody)
 {
 	a0 = 1.0;               // should be overwritten by derived class
 	double interval = 10.0; // default sampling interval
 	prec = 1e-6;            // default precision
-	termidx = 0;
-	termlen = 0;
-	term = 0;
 	sp[0].t = sp[1].t = -1e20; // invalidate
+	bCheby = true;          // default: Chebyshev cache enabled
 	SetSeries ('B');        // default series: spherical, J2000
 }
 
 VSOPOBJ::~VSOPOBJ ()
 {
-	if (termidx) delete []termidx;
-	if (termlen) delete []termlen;
-	if (term) delete []term;
 }
 
 bool VSOPOBJ::bEphemeris () const
@@ -47,6 +46,7 @@ void VSOPOBJ::clbkInit (FILEHANDLE cfg)
 	CELBODY2::clbkInit (cfg);
 	oapiReadItem_float (cfg, (char*)"ErrorLimit", prec); // read custom precision from config file
 	oapiReadItem_float (cfg, (char*)"SamplingInterval", interval);
+	oapiReadItem_bool (cfg, (char*)"ChebyshevCache", bCheby);
 }
 
 void VSOPOBJ::SetSeries (char series)
@@ -59,59 +59,20 @@ void VSOPOBJ::SetSeries (char series)
 
 bool VSOPOBJ::ReadData (const char *name)
 {
-	int nterm, cooidx, alpha, i, iused, nused = 0, ntot = 0;
-	double a, b, c, tfac, err;
-	TERM3 **ppterm, *pterm;
+	int nused, ntot;
 
 	char cbuf[256];
 	sprintf (cbuf, "Config\\%s\\Data\\Vsop87%c.dat", name, sid);
-	ifstream ifs (cbuf);
-	if (!ifs) {
+	nused = series.Read (cbuf, sid, a0, prec, &ntot);
+	if (nused < 0) {
 		oapiWriteLogError("VSOP87 %s: Data file not found: %s", name, cbuf);
 		return false;
 	}
 
-	ifs >> nalpha;
-
-	ppterm  = new TERM3*[(nalpha+1)*3];
-	termidx = new IDX3[nalpha+1];
-	termlen = new IDX3[nalpha+2];
-
-	for (cooidx = 0; cooidx < 3; cooidx++) {
-		tfac = 1.0;
-		for (alpha = 0; alpha <= nalpha; alpha++) {
-			ifs >> nterm;
-			pterm = ppterm[cooidx*(nalpha+1)+alpha] = new TERM3[nterm];
-			for (i = 0, iused = nterm; i < nterm; i++) {
-				ifs >> a >> b >> c;
-				if (iused == nterm) {
-					pterm[i][0] = a, pterm[i][1] = b, pterm[i][2] = c;
-					if (cooidx == 2) a /= a0; // radius in terms of mean SMa
-					err = 2.0*sqrt (i+1.0)*a*tfac;
-					if (err < prec) iused = i;
-				}
-			}
-			termlen[alpha][cooidx] = iused;
-			termidx[alpha][cooidx] = nused;
-			nused += iused;
-			ntot  += nterm;
-			tfac *= 5.0; // don't ask
-		}
-		termlen[alpha][cooidx] = 0;
-	}
-	// now copy everything into a single array
-	term = new TERM3[nused];
-	for (cooidx = 0; cooidx < 3; cooidx++) {
-		for (alpha = 0; alpha <= nalpha; alpha++) {
-			memcpy (term+termidx[alpha][cooidx], ppterm[cooidx*(nalpha+1)+alpha], termlen[alpha][cooidx]*sizeof(TERM3));
-			delete []ppterm[cooidx*(nalpha+1)+alpha];
-		}
-	}
-	delete []ppterm;
-
 	Init();
 
 	oapiWriteLogV("VSOP87(%c) %s: Precision %0.1le, Terms %d/%d", sid, name, prec, nused, ntot);
+	if (bCheby) oapiWriteLogV("VSOP87(%c) %s: Chebyshev granule length %0.2lf days", sid, name, cheby.Length());
 	return true;
 }
 
@@ -119,87 +80,105 @@ void VSOPOBJ::Init ()
 {
 	sp[0].t = 0;
 	sp[1].t = interval;
-	VsopEphem (oapiTime2MJD(sp[0].t), sp[0].param);
-	VsopEphem (oapiTime2MJD(sp[1].t), sp[1].param);
+	VsopSeries (oapiTime2MJD(sp[0].t), sp[0].param);
+	VsopSeries (oapiTime2MJD(sp[1].t), sp[1].param);
 	sp[0].rad = Radius (sp[0].param);
 	sp[1].rad = Radius (sp[1].param);
+
+	if (bCheby) {
+		// Granules of 1/16 orbit (close to the JPL ephemeris granules for the
+		// inner planets), halved by the cache if the series needs it.
+		// Tolerances in the units of the series results: [rad, rad, AU] for
+		// spherical, [m] for rectangular coordinates
+		double len = 365.25*pow (a0, 1.5) / 16.0;
+		double tol[3];
+		if (fmtflag & EPHEM_POLAR) tol[0] = tol[1] = cheby_reltol*prec, tol[2] = cheby_reltol*prec*a0;
+		else                       tol[0] = tol[1] = tol[2] = cheby_reltol*prec*a0*AU;
+		cheby.Setup (ChebySample, this, len, tol);
+		chebyFast.Setup (ChebySample, this, len, tol, 2);
+	}
+}
+
+void VSOPOBJ::ChebySample (void *context, double t, double *ret)
+{
+	((VSOPOBJ*)context)->VsopSeries (t + mjd2000, ret);
+	for (int i = 3; i < 6; i++) ret[i] *= 86400.0; // rates per day
 }
 
 // ===========================================================
 // Name: VsopEphem()
-// Desc: Return heliocentric ecliptic spherical positions and
-//       velocity for planet 'obj' (VSOP_MERCURY to VSOP_NEPTUNE
-//       at time 'mjd' for ecliptic and equinox J2000.
-//       Values returned in 'ret' are
-//       ret[0] = longitude l [rad]
-//       ret[1] = latitude b  [rad]
-//       ret[2] = radius r    [AU]
-//       ret[3] = velocity in longitude [rad/s]
-//       ret[4] = velocity in latitude  [rad/s]
-//       ret[5] = radial velocity [AU/s]
+// Desc: Return ephemerides for time 'mjd' in the format of
+//       VsopSeries, from the Chebyshev approximation of the
+//       series if enabled.
 // ===========================================================
 void VSOPOBJ::VsopEphem (double mjd, double *ret)
 {
-	static const double mjd2000 = 51544.5;  // MJD date of epoch J2000
-	static const double a1000   = 365250.0; // days per millenium
-	static const double rsec    = 1.0/(a1000*86400.0); // 1/seconds per millenium
-
-	static const double c0   = 299792458;     // speed of light [m/s]
-	static const double tauA = 499.004783806; // light time for 1 AU [s]
-	static const double AU   = c0*tauA;       // 1 AU in meters
-	static const double pscl = AU;            // convert AU -> m
-	static const double vscl = AU*rsec;       // convert AU/millenium -> m/s
-
-	TERM3 *pterm;
-
-	double a, b, c, arg, tm, termdot;
-	int i, cooidx, alpha;
-
-	// zero result array
-	for (i = 0; i < 6; i++) ret[i] = 0.0;
-
-	// set time and powers
-	double t[VSOP_MAXALPHA+1];
-	t[0] = 1.0;
-	t[1] = (mjd-mjd2000)/a1000;
-	for (i = 2; i <= VSOP_MAXALPHA; ++i) t[i] = t[i-1] * t[1];
-
-	// term summation
-	for (cooidx = 0; cooidx < 3; ++cooidx) { // loop over spatial dimensions
-
-		for (alpha = 0; termlen[alpha][cooidx]; ++alpha) { // loop over powers of time
-
-			pterm = term+termidx[alpha][cooidx];
-			tm = termdot = 0.0;
-		    for (i = 0; i < termlen[alpha][cooidx]; ++i) {
-				a        = pterm[i][0];
-				b        = pterm[i][1];
-				c        = pterm[i][2];
-				arg      = b + c * t[1];
-				tm      += a * cos(arg);
-				termdot -= c * a * sin(arg);
-			}
-			ret[cooidx] += t[alpha] * tm;
-			ret[cooidx+3] += t[alpha] * termdot +
-				(alpha > 0 ? alpha * t[alpha - 1] * tm : 0.0);
-
-		} // end loop alpha
-	} // end loop cooidx
+	if (bCheby) {
+		cheby.Eval (mjd - mjd2000, ret);
+		for (int i = 3; i < 6; i++) ret[i] /= 86400.0;
+	} else {
+		VsopSeries (mjd, ret);
+	}
+}
 
-	if (fmtflag & EPHEM_POLAR) {
-		// convert millenium rate to second rate
-		for (i = 3; i < 6; i++) ret[i] *= rsec;
-		// should also convert radius from AU to m
+// ===========================================================
+// Name: VsopEphemN()
+// Desc: Multi-epoch version of VsopEphem. Without the Chebyshev
+//       cache, the series terms are summed for all epochs in one
+//       pass (see VSOPSERIES::EvalN)
+// ===========================================================
+void VSOPOBJ::VsopEphemN (int n, const double *mjd, double *ret)
+{
+	if (bCheby) {
+		for (int j = 0; j < n; j++)
+			VsopEphem (mjd[j], ret+6*j);
 	} else {
-		double tmp;
-		for (i = 0; i < 3; i++) ret[i] *= pscl;
-		for (     ; i < 6; i++) ret[i] *= vscl;
-		// swap y and z to map to orbiter system
-		tmp = ret[1]; ret[1] = ret[2]; ret[2] = tmp;
-		tmp = ret[4]; ret[4] = ret[5]; ret[5] = tmp;
+		series.EvalN (n, mjd, ret);
 	}
 }
 
+// ===========================================================
+// Name: clbkEphemeris()
+// Desc: Series values at mjd, assembled into the body's
+//       ephemeris data by AssembleEphem
+// ===========================================================
+int VSOPOBJ::clbkEphemeris (double mjd, int req, double *ret)
+{
+	double r[6];
+	VsopEphem (mjd, r);
+	return AssembleEphem (mjd, req, r, ret);
+}
+
+// ===========================================================
+// Name: clbkEphemerisBatch()
+// Desc: As clbkEphemeris, for n epochs. The series values for a
+//       chunk of epochs are computed together before assembly.
+// ===========================================================
+int VSOPOBJ::clbkEphemerisBatch (int n, const double *mjd, int req, double *ret)
+{
+	const int nchunk = 64;
+	double r[6*nchunk];
+	int i, j, m, flag = 0;
+
+	for (i = 0; i < n; i += m) {
+		m = (n-i < nchunk ? n-i : nchunk);
+		VsopEphemN (m, mjd+i, r);
+		for (j = 0; j < m; j++)
+			flag = AssembleEphem (mjd[i+j], req, r+6*j, ret+12*(i+j));
+	}
+	return flag;
+}
+
+// ===========================================================
+// Name: VsopSeries()
+// Desc: Return ephemerides for time 'mjd' by summation of the
+//       series terms (see VSOPSERIES::Eval for the format)
+// ===========================================================
+void VSOPOBJ::VsopSeries (double mjd, double *ret)
+{
+	series.Eval (mjd, ret);
+}
+
 // ===========================================================
 // Name: VsopFastEphem()
 // Desc: Generate planetary position and velocity data at the
@@ -215,6 +194,14 @@ void VSOPOBJ::VsopEphem (double mjd, double *ret)
 // ===========================================================
 void VSOPOBJ::VsopFastEphem (double simt, double *ret)
 {
+	if (bCheby) {
+		// The granule of the current time is kept apart from those of
+		// arbitrary queries, so it is never displaced by them
+		chebyFast.Eval ((oapiTime2MJD (0) - mjd2000) + simt/86400.0, ret);
+		for (int i = 3; i < 6; i++) ret[i] /= 86400.0;
+		return;
+	}
+
 	Sample *s0, *s1;
 	
 	if (sp[0].t < sp[1].t) s0 = sp+0, s1 = sp+1;
@@ -225,7 +212,7 @@ void VSOPOBJ::VsopFastEphem (double simt, double *ret)
 	} else if (simt > s1->t) {
 		if (simt <= s1->t + interval) {
 			s0->t = s1->t + interval;
-			VsopEphem (oapiTime2MJD (s0->t), s0->param);
+			VsopSeries (oapiTime2MJD (s0->t), s0->param);
 			if (fmtflag & EPHEM_POLAR) { // check for phase wrap in longitude
 				if      (s0->param[0]-s1->param[0] >  PI) s1->param[0] += 2.0*PI;
 				else if (s0->param[0]-s1->param[0] < -PI) s1->param[0] -= 2.0*PI;
@@ -235,7 +222,7 @@ void VSOPOBJ::VsopFastEphem (double simt, double *ret)
 			Interpolate (simt, ret, s1, s0);
 		} else {
 			s0->t = simt;
-			VsopEphem (oapiTime2MJD (s0->t), s0->param);
+			VsopSeries (oapiTime2MJD (s0->t), s0->param);
 			if (!(fmtflag & EPHEM_POLAR))
 				s0->rad = Radius (s0->param);
 			for (int i = 0; i < 6; i++) ret[i] = s0->param[i];
@@ -243,7 +230,7 @@ void VSOPOBJ::VsopFastEphem (double simt, double *ret)
 	} else {
 		if (simt >= s0->t - interval) {
 			s1->t = s0->t - interval;
-			VsopEphem (oapiTime2MJD (s1->t), s1->param);
+			VsopSeries (oapiTime2MJD (s1->t), s1->param);
 			if (fmtflag & EPHEM_POLAR) { // check for phase wrap in longitude
 				if      (s1->param[0]-s0->param[0] >  PI) s0->param[0] += 2.0*PI;
 				else if (s1->param[0]-s0->param[0] < -PI) s0->param[0] -= 2.0*PI;
@@ -253,9 +240,9 @@ void VSOPOBJ::VsopFastEphem (double simt, double *ret)
 			Interpolate (simt, ret, s1, s0);
 		} else {
 			s1->t = simt;
-			VsopEphem (oapiTime2MJD (s1->t), s1->param);
+			VsopSeries (oapiTime2MJD (s1->t), s1->param);
 			s0->t = simt + interval;
-			VsopEphem (oapiTime2MJD (s0->t), s0->param);
+			VsopSeries (oapiTime2MJD (s0->t), s0->param);
 			if (fmtflag & EPHEM_POLAR) { // check for phase wrap in longitude
 				if      (s0->param[0]-s1->param[0] >  PI) s1->param[0] += 2.0*PI;
 				else if (s0->param[0]-s1->param[0] < -PI) s1->param[0] -= 2.0*PI;
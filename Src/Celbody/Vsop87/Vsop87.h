@@ -6,25 +6,29 @@
 
 #include "OrbiterAPI.h"
 #include "CelbodyAPI.h"
-
-#define VSOP_MAXALPHA 5		// max power of time
-
-typedef int IDX3[3];
-typedef double TERM3[3];
+#include "ChebyCache.h"
+#include "VsopSeries.h"
 
 // ===========================================================
 // class VSOPOBJ
 // Base class for planets controlled by VSOP87 solutions
 // ===========================================================
 
-class DLLEXPORT VSOPOBJ: public CELBODY2 {
+class DLLEXPORT VSOPOBJ: public CELBODY3 {
 public:
 	VSOPOBJ (OBJHANDLE hCBody);
 	virtual ~VSOPOBJ ();
 	bool bEphemeris() const;
 	void clbkInit (FILEHANDLE cfg);
+	int  clbkEphemeris (double mjd, int req, double *ret);
+	int  clbkEphemerisBatch (int n, const double *mjd, int req, double *ret);
 
 protected:
+	virtual int AssembleEphem (double mjd, int req, double *r, double *ret) = 0;
+	// Body-specific part of clbkEphemeris: fill ret from the series
+	// values r at time mjd (as returned by VsopEphem). r may be modified.
+	// Returns the EPHEM_xxx flags of ret
+
 	void SetSeries (char series);
 	// Set VSOP series ('A' to 'E')
 
@@ -34,24 +38,33 @@ protected:
 	void Init ();
 
 	void VsopEphem (double mjd, double *ret);
-	// Calculate ephemerides
+	// Calculate ephemerides (from the Chebyshev cache, if enabled)
+
+	void VsopEphemN (int n, const double *mjd, double *ret);
+	// VsopEphem for the n times mjd[0..n-1], results in ret[6*j..6*j+5]
 
 	void VsopFastEphem (double simt, double *ret);
 	// Interpolated sequential ephemerides
 
+	void VsopSeries (double mjd, double *ret);
+	// Calculate ephemerides by summation of the series terms
+
 	double a0;       // semi-major axis [AU]
 	double prec;     // tolerance limit (1e-3 .. 1e-8)
 	double interval; // sample interval for fast ephemeris [s]
 	int fmtflag;     // data format flag
-	int nalpha;      // order of time polynomials
-	IDX3 *termidx;   // term index list
-	IDX3 *termlen;   // term list lengths
-	TERM3 *term;     // term list
+	VSOPSERIES series; // series terms
 	Sample sp[2];
+	bool bCheby;     // use Chebyshev approximations of the series
+	ChebyCache cheby;     // granules for arbitrary epochs
+	ChebyCache chebyFast; // granules for the current simulation time
 
 private:
 	void Interpolate (double t, double *data, const Sample *s0, const Sample *s1);
 
+	static void ChebySample (void *context, double t, double *ret);
+	// Series evaluation for the cache, t in days since J2000
+
 	char sid;
 	int datatp;  // return data type: true pos or barycentric
 };
@@ -0,0 +1,216 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#include "VsopSeries.h"
+#include "TrigSeries.h"
+#include <math.h>
+#include <ctype.h>
+#include <fstream>
+
+using namespace std;
+
+static const double mjd2000 = 51544.5;     // MJD date of epoch J2000
+static const double AU = 299792458*499.004783806; // 1 AU in meters
+
+// ===========================================================
+// class VSOPSERIES
+// ===========================================================
+
+VSOPSERIES::VSOPSERIES ()
+{
+	polar = true;
+	nalpha = 0;
+	termidx = 0;
+	termlen = 0;
+	term[0] = term[1] = term[2] = 0;
+}
+
+VSOPSERIES::~VSOPSERIES ()
+{
+	Clear();
+}
+
+void VSOPSERIES::Clear ()
+{
+	if (termidx) { delete []termidx; termidx = 0; }
+	if (termlen) { delete []termlen; termlen = 0; }
+	for (int i = 0; i < 3; i++)
+		if (term[i]) { delete []term[i]; term[i] = 0; }
+}
+
+int VSOPSERIES::Read (const char *fname, char series, double a0, double prec, int *ntotal)
+{
+	int nterm, cooidx, alpha, i, iused, nused = 0, ntot = 0;
+	double a, b, c, tfac, err;
+	TERM3 **ppterm, *pterm;
+
+	ifstream ifs (fname);
+	if (!ifs) return -1;
+
+	Clear();
+	series = toupper (series);
+	polar = (series == 'B' || series == 'D');
+
+	ifs >> nalpha;
+
+	ppterm  = new TERM3*[(nalpha+1)*3];
+	termidx = new IDX3[nalpha+1];
+	termlen = new IDX3[nalpha+2];
+
+	for (cooidx = 0; cooidx < 3; cooidx++) {
+		tfac = 1.0;
+		for (alpha = 0; alpha <= nalpha; alpha++) {
+			ifs >> nterm;
+			pterm = ppterm[cooidx*(nalpha+1)+alpha] = new TERM3[nterm];
+			for (i = 0, iused = nterm; i < nterm; i++) {
+				ifs >> a >> b >> c;
+				if (iused == nterm) {
+					pterm[i][0] = a, pterm[i][1] = b, pterm[i][2] = c;
+					if (cooidx == 2) a /= a0; // radius in terms of mean SMa
+					err = 2.0*sqrt (i+1.0)*a*tfac;
+					if (err < prec) iused = i;
+				}
+			}
+			termlen[alpha][cooidx] = iused;
+			termidx[alpha][cooidx] = nused;
+			nused += iused;
+			ntot  += nterm;
+			tfac *= 5.0; // don't ask
+		}
+		termlen[alpha][cooidx] = 0;
+	}
+	// now copy everything into single arrays, one per term parameter,
+	// for the vectorised summation
+	for (i = 0; i < 3; i++)
+		term[i] = new double[nused];
+	for (cooidx = 0; cooidx < 3; cooidx++) {
+		for (alpha = 0; alpha <= nalpha; alpha++) {
+			pterm = ppterm[cooidx*(nalpha+1)+alpha];
+			for (i = 0; i < termlen[alpha][cooidx]; i++) {
+				term[0][termidx[alpha][cooidx]+i] = pterm[i][0];
+				term[1][termidx[alpha][cooidx]+i] = pterm[i][1];
+				term[2][termidx[alpha][cooidx]+i] = pterm[i][2];
+			}
+			delete []pterm;
+		}
+	}
+	delete []ppterm;
+
+	if (ntotal) *ntotal = ntot;
+	return nused;
+}
+
+// ===========================================================
+// Name: Eval()
+// Desc: Return heliocentric ecliptic spherical positions and
+//       velocity for planet 'obj' (VSOP_MERCURY to VSOP_NEPTUNE
+//       at time 'mjd' for ecliptic and equinox J2000.
+//       Values returned in 'ret' are
+//       ret[0] = longitude l [rad]
+//       ret[1] = latitude b  [rad]
+//       ret[2] = radius r    [AU]
+//       ret[3] = velocity in longitude [rad/s]
+//       ret[4] = velocity in latitude  [rad/s]
+//       ret[5] = radial velocity [AU/s]
+//       For rectangular series, ret contains position [m] and
+//       velocity [m/s] in the orbiter frame.
+// ===========================================================
+static const double a1000   = 365250.0; // days per millenium
+static const double rsec    = 1.0/(a1000*86400.0); // 1/seconds per millenium
+
+void VSOPSERIES::Eval (double mjd, double *ret) const
+{
+	double tm, termdot;
+	int i, k, cooidx, alpha;
+
+	// zero result array
+	for (i = 0; i < 6; i++) ret[i] = 0.0;
+
+	// set time and powers
+	double t[VSOP_MAXALPHA+1];
+	t[0] = 1.0;
+	t[1] = (mjd-mjd2000)/a1000;
+	for (i = 2; i <= VSOP_MAXALPHA; ++i) t[i] = t[i-1] * t[1];
+
+	// term summation
+	for (cooidx = 0; cooidx < 3; ++cooidx) { // loop over spatial dimensions
+
+		for (alpha = 0; termlen[alpha][cooidx]; ++alpha) { // loop over powers of time
+
+			k = termidx[alpha][cooidx];
+			TrigSumCos (termlen[alpha][cooidx], term[0]+k, term[1]+k, term[2]+k, t[1], tm, termdot);
+			ret[cooidx] += t[alpha] * tm;
+			ret[cooidx+3] += t[alpha] * termdot +
+				(alpha > 0 ? alpha * t[alpha - 1] * tm : 0.0);
+
+		} // end loop alpha
+	} // end loop cooidx
+
+	Scale (ret);
+}
+
+// ===========================================================
+// Name: EvalN()
+// Desc: Multi-epoch version of Eval. The times are processed
+//       in chunks, and for each block of terms the summation
+//       kernel runs over all times of the chunk.
+// ===========================================================
+void VSOPSERIES::EvalN (int n, const double *mjd, double *ret) const
+{
+	const int nchunk = 64;
+	double t[VSOP_MAXALPHA+1][nchunk], tm[nchunk], termdot[nchunk];
+	int i, j, m, k, cooidx, alpha;
+
+	for (; n > 0; n -= m, mjd += m, ret += 6*m) {
+		m = (n < nchunk ? n : nchunk);
+
+		// zero result array
+		for (j = 0; j < 6*m; j++) ret[j] = 0.0;
+
+		// set times and powers
+		for (j = 0; j < m; j++) {
+			t[0][j] = 1.0;
+			t[1][j] = (mjd[j]-mjd2000)/a1000;
+			for (i = 2; i <= VSOP_MAXALPHA; ++i) t[i][j] = t[i-1][j] * t[1][j];
+		}
+
+		// term summation
+		for (cooidx = 0; cooidx < 3; ++cooidx) {
+			for (alpha = 0; termlen[alpha][cooidx]; ++alpha) {
+				k = termidx[alpha][cooidx];
+				TrigSumCosN (termlen[alpha][cooidx], term[0]+k, term[1]+k, term[2]+k, m, t[1], tm, termdot);
+				for (j = 0; j < m; j++) {
+					ret[6*j+cooidx] += t[alpha][j] * tm[j];
+					ret[6*j+cooidx+3] += t[alpha][j] * termdot[j] +
+						(alpha > 0 ? alpha * t[alpha - 1][j] * tm[j] : 0.0);
+				}
+			}
+		}
+
+		for (j = 0; j < m; j++) Scale (ret+6*j);
+	}
+}
+
+// ===========================================================
+// Name: Scale()
+// Desc: Convert the sums of Eval to the output units and frame
+// ===========================================================
+void VSOPSERIES::Scale (double *ret) const
+{
+	static const double pscl = AU;            // convert AU -> m
+	static const double vscl = AU*rsec;       // convert AU/millenium -> m/s
+	int i;
+
+	if (polar) {
+		// convert millenium rate to second rate
+		for (i = 3; i < 6; i++) ret[i] *= rsec;
+		// should also convert radius from AU to m
+	} else {
+		double tmp;
+		for (i = 0; i < 3; i++) ret[i] *= pscl;
+		for (     ; i < 6; i++) ret[i] *= vscl;
+		// swap y and z to map to orbiter system
+		tmp = ret[1]; ret[1] = ret[2]; ret[2] = tmp;
+		tmp = ret[4]; ret[4] = ret[5]; ret[5] = tmp;
+	}
+}
@@ -0,0 +1,53 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#ifndef __VSOPSERIES_H
+#define __VSOPSERIES_H
+
+#define VSOP_MAXALPHA 5		// max power of time
+
+typedef int IDX3[3];
+typedef double TERM3[3];
+
+// ===========================================================
+// class VSOPSERIES
+// Term lists of one VSOP87 solution and their summation.
+// Independent of the Orbiter API, so that the series can also
+// be evaluated by offline tools.
+// ===========================================================
+
+class VSOPSERIES {
+public:
+	VSOPSERIES ();
+	~VSOPSERIES ();
+
+	int Read (const char *fname, char series, double a0, double prec, int *ntot = 0);
+	// Read the terms of series ('A' to 'E') from data file fname, up to
+	// the precision prec (relative to semi-major axis a0 [AU] for the
+	// radius). Returns the number of terms used, or -1 if the file could
+	// not be read. ntot (optional): total number of terms in the file
+
+	void Eval (double mjd, double *ret) const;
+	// Sum the series at time mjd. See Vsop87.cpp for the format of ret
+
+	void EvalN (int n, const double *mjd, double *ret) const;
+	// Sum the series at the n times mjd[0..n-1], with the results for
+	// mjd[j] in ret[6*j..6*j+5] (same format as Eval). Each term is
+	// loaded once for a block of times, which is faster than n calls
+	// to Eval
+
+	inline bool Polar () const { return polar; }
+	// Spherical (series 'B', 'D') or rectangular coordinates
+
+private:
+	void Clear ();
+	void Scale (double *ret) const;
+
+	bool polar;      // spherical coordinates
+	int nalpha;      // order of time polynomials
+	IDX3 *termidx;   // term index list
+	IDX3 *termlen;   // term list lengths
+	double *term[3]; // term list as separate arrays of amplitudes, phases, frequencies
+};
+
+#endif // !__VSOPSERIES_H
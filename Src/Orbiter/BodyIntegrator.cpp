@@ -20,10 +20,9 @@
 //    AngIntData data: angular state information
 //
 // Parameters for linear+angular state propagators:
-//    double h: step interval for full step [s]
-//    int nsub: number of subsamples
-//    int isub: current subsample
-//    double dt: subsample step interval [s]
+//    int method: propagation method (PROP_xxx, see Integrators.h)
+//    double t: start of the substep, from the start of the frame [s]
+//    double h: substep interval [s]
 //
 // Parameters for perturbation propagators:
 //    PertIntData data: orbit state informations
@@ -43,385 +42,82 @@
 #include "Orbiter.h"
 #include "Rigidbody.h"
 #include "Element.h"
+#include "LinAngIntegrators.h"
 #include "Log.h"
 #include <stdio.h>
 
 extern TimeData td;
 extern char DBG_MSG[256];
 
-// ===========================================================================
-// Runge-Kutta integration parameters (RK5-RK8)
-// Used by the driver routines below
-// (Note that RK2 and RK4 are implemented directly without using the driver
-// routines)
-// ===========================================================================
-
-// ---------------------------------------------------------------------------
-// RK5 6-stage parameters
-// ---------------------------------------------------------------------------
-
-static const int RK5_n = 6;
-static const double RK5_alpha[RK5_n-1] = {
-	1.0/5.0, 3.0/10.0, 4.0/5.0, 8.0/9.0, 1.0
-};
-static const double RK5_beta[(RK5_n-1)*(RK5_n-1)] = {
-	1.0/5.0, 0, 0, 0, 0,
-	3.0/40.0, 9.0/40.0, 0, 0, 0,
-	44.0/45.0, -56.0/15.0, 32.0/9.0, 0, 0,
-	19372.0/6561.0, -25360.0/2187.0, 64448.0/6561.0, -212.0/729.0, 0,
-	9017.0/3168.0, -355.0/33.0, 46732.0/5247.0, 49.0/176.0, -5103.0/18656.0
-};
-static const double RK5_gamma[RK5_n] = {
-	35.0/384.0, 0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0
-};
-
-// ---------------------------------------------------------------------------
-// RK6 8-stage parameters
-// ---------------------------------------------------------------------------
-
-static const int RK6_n = 8;
-static const double RK6_alpha[RK6_n-1] = {
-	1.0/6.0, 4.0/15.0, 2.0/3.0, 5.0/6.0, 1.0, 1.0/15.0, 1.0
-};
-static const double RK6_beta[(RK6_n-1)*(RK6_n-1)] = {
-	1.0/6.0, 0, 0, 0, 0, 0, 0,
-	4.0/75.0, 16.0/75.0, 0, 0, 0, 0, 0,
-	5.0/6.0, -8.0/3.0, 5.0/2.0, 0, 0, 0, 0,
-	-165.0/64.0, 55.0/6.0, -425.0/64.0, 85.0/96.0, 0, 0, 0,
-	12.0/5.0, -8.0, 4015.0/612.0, -11.0/36.0, 88.0/255.0, 0, 0,
-	-8263.0/15000.0, 124.0/75.0, -643.0/680.0, -81.0/250.0, 2484.0/10625.0, 0, 0,
-	3501.0/1720.0, -300.0/43.0, 297275.0/52632.0, -319.0/2322.0, 24068.0/84065.0, 0, 3850.0/26703.0
-};
-static const double RK6_gamma[RK6_n] = {
-	3.0/40.0, 0, 875.0/2244.0, 23.0/72.0, 264.0/1955.0, 0, 125.0/11592.0, 43.0/616.0
-};
-
-// ---------------------------------------------------------------------------
-// RK7 11-stage parameters
-// ---------------------------------------------------------------------------
-
-static const int RK7_n = 11;
-static const double RK7_alpha[RK7_n-1] = {
-	2.0/27.0, 1.0/9.0, 1.0/6.0, 5.0/12.0, 1.0/2.0, 5.0/6.0, 1.0/6.0, 2.0/3.0, 1.0/3.0, 1.0
-};
-static const double RK7_beta[(RK7_n-1)*(RK7_n-1)] = {
-	2.0/27.0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	1.0/36.0, 1.0/12.0, 0, 0, 0, 0, 0, 0, 0, 0,
-	1.0/24.0, 0, 1.0/8.0, 0, 0, 0, 0, 0, 0, 0,
-	5.0/12.0, 0, -25.0/16.0, 25.0/16.0, 0, 0, 0, 0, 0, 0,
-	1.0/20.0, 0, 0, 1.0/4.0, 1.0/5.0, 0, 0, 0, 0, 0,
-	-25.0/108.0, 0, 0, 125.0/108.0, -65.0/27.0, 125.0/54.0, 0, 0, 0, 0,
-	31.0/300.0, 0, 0, 0, 61.0/225.0, -2.0/9.0, 13.0/900.0, 0, 0, 0,
-	2.0, 0, 0, -53.0/6.0, 704.0/45.0, -107.0/9.0, 67.0/90.0, 3.0, 0, 0,
-	-91.0/108.0, 0, 0, 23.0/108.0, -976.0/135.0, 311.0/54.0, -19.0/60.0, 17.0/6.0, -1.0/12.0, 0,
-	2383.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -301.0/82.0, 2133.0/4100.0, 45.0/82.0, 45.0/164.0, 18.0/41.0
-};
-static const double RK7_gamma[RK7_n] = {
-	41.0/840.0, 0, 0, 0, 0, 34.0/105.0, 9.0/35.0, 9.0/35.0, 9.0/280.0, 9.0/280.0, 41.0/840.0
-};
-
-// ---------------------------------------------------------------------------
-// RK8 13-stage parameters
-// ---------------------------------------------------------------------------
-
-static const int RK8_n = 13;
-static const double RK8_alpha[RK8_n-1] = {
-	2.0/27.0, 1.0/9.0, 1.0/6.0, 5.0/12.0, 1.0/2.0, 5.0/6.0, 1.0/6.0, 2.0/3.0, 1.0/3.0, 1.0, 0, 1.0
-};
-static const double RK8_beta[(RK8_n-1)*(RK8_n-1)] = {
-	2.0/27.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	1.0/36.0, 1.0/12.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	1.0/24.0, 0, 1.0/8.0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	5.0/12.0, 0, -25.0/16.0, 25.0/16.0, 0, 0, 0, 0, 0, 0, 0, 0,
-	1.0/20.0, 0, 0, 1.0/4.0, 1.0/5.0, 0, 0, 0, 0, 0, 0, 0,
-	-25.0/108.0, 0, 0, 125.0/108.0, -65.0/27.0, 125.0/54.0, 0, 0, 0, 0, 0, 0,
-	31.0/300.0, 0, 0, 0, 61.0/225.0, -2.0/9.0, 13.0/900.0, 0, 0, 0, 0, 0,
-	2.0, 0, 0, -53.0/6.0, 704.0/45.0, -107.0/9.0, 67.0/90.0, 3.0, 0, 0, 0, 0,
-	-91.0/108.0, 0, 0, 23.0/108.0, -976.0/135.0, 311.0/54.0, -19.0/60.0, 17.0/6.0, -1.0/12.0, 0, 0, 0,
-	2383.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -301.0/82.0, 2133.0/4100.0, 45.0/82.0, 45.0/164.0, 18.0/41.0, 0, 0,
-	3.0/205.0, 0, 0, 0, 0, -6.0/41.0, -3.0/205.0, -3.0/41.0, 3.0/41.0, 6.0/41.0, 0, 0,
-	-1777.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -289.0/82.0, 2193.0/4100.0, 51.0/82.0, 33.0/164.0, 12.0/41.0, 0, 1.0
-};
-static const double RK8_gamma[RK8_n] = {
-	0, 0, 0, 0, 0, 34.0/105.0, 9.0/35.0, 9.0/35.0, 9.0/280.0, 9.0/280.0, 0, 41.0/840.0, 41.0/840.0
-};
-
 // ===========================================================================
 // Propagators for linear and angular state vectors combined
+// The schemes are shared with the propagation harness (LinAngIntegrators.h)
 // ===========================================================================
 
-// ---------------------------------------------------------------------------
-// 2nd order 2-stage Runge-Kutta (linear+angular)
-// ---------------------------------------------------------------------------
-
-void RigidBody::RK2_LinAng (double h, int nsub, int isub)
-{
-	double h05 = h*0.5;
-
-	Vector acc1, tau;
-	StateVectors s;
-	s.pos.Set (s1->pos+s1->vel*h05);
-	s.vel.Set (s1->vel+acc*h05);
-	s.SetRot (s1->Q.Rot(s1->omega*h05));
-	s.omega.Set (s1->omega+arot*h05);
-	GetIntermediateMoments (acc1, tau, s, (isub+0.5)/nsub, h);
-
-	rpos_add += s.vel*h;
-	rvel_add += acc1*h;
-	s1->Q.Rotate (s.omega*h);
-	arot = EulerInv_full (tau, s.omega); // may need to allow use of the simplified versions here
-	s1->omega += arot*h;
-}
-
-// ---------------------------------------------------------------------------
-// 4th order 4-stage Runge-Kutta (linear+angular)
-// ---------------------------------------------------------------------------
-
-void RigidBody::RK4_LinAng (double h, int nsub, int isub)
-{
-	double h05 = h*0.5;
-	double hi6 = h/6.0;
-
-	Vector tau, acc1, aacc1, acc2, aacc2, acc3, aacc3;
-	StateVectors sa, sb, sc;
-	sa.pos.Set (s1->pos+s1->vel*h05);
-	sa.vel.Set (s1->vel+acc*h05);
-	sa.SetRot (s1->Q.Rot(s1->omega*h05));
-	sa.omega.Set (s1->omega+arot*h05);
-	GetIntermediateMoments (acc1, tau, sa, (isub+0.5)/nsub, h);
-	aacc1.Set (EulerInv_full (tau, sa.omega));
-
-	sb.pos.Set (s1->pos+sa.vel*h05);
-	sb.vel.Set (s1->vel+acc1*h05);
-	sb.SetRot (s1->Q.Rot(sa.omega*h05));
-	sb.omega.Set (s1->omega+aacc1*h05);
-	GetIntermediateMoments (acc2, tau, sb, (isub+0.5)/nsub, h);
-	aacc2.Set (EulerInv_full (tau, sb.omega));
-
-	sc.pos.Set (s1->pos+sb.vel*h);
-	sc.vel.Set (s1->vel+acc2*h);
-	sc.SetRot (s1->Q.Rot(sb.omega*h));
-	sc.omega.Set (s1->omega+aacc2*h);
-	GetIntermediateMoments (acc3, tau, sc, (isub+1.0)/nsub, h);
-	aacc3.Set (EulerInv_full (tau, sc.omega));
-
-	rvel_add += (acc +(acc1+acc2)*2.0+acc3)*hi6;
-	rpos_add += (s1->vel+(sa.vel+sb.vel)*2.0+sc.vel)*hi6;
-	s1->Q.Rotate ((s1->omega+(sa.omega+sb.omega)*2.0+sc.omega)*hi6);
-	s1->omega += (arot+(aacc1+aacc2)*2.0+aacc3)*hi6;
-}
-
-// ---------------------------------------------------------------------------
-// Driver routine for Runge-Kutta solvers RK5-RK8 (linear+angular)
-// Note: NOT THREADSAFE
-// ---------------------------------------------------------------------------
-
-void RigidBody::RKdrv_LinAng (double h, int nsub, int isub, int n, const double *alpha, const double *beta, const double *gamma)
-{
-	int i, j;
-	double bh;
-	static int nbuf = 8;
-	static StateVectors *s = new StateVectors[nbuf]; TRACENEW
-	static Vector *a       = new Vector[nbuf]; TRACENEW  // linear acceleration
-	static Vector *d       = new Vector[nbuf]; TRACENEW  // angular acceleration
-	Vector tau;
-	if (n > nbuf) { // grow buffers
-		delete []s;
-		delete []a;
-		delete []d;
-		s = new StateVectors[n]; TRACENEW
-		a = new Vector[n]; TRACENEW
-		d = new Vector[n]; TRACENEW
-		nbuf = n;
+// Evaluation of the intermediate moments for the schemes. Time is measured
+// from the start of the frame.
+struct RigidBody::MomentModel {
+	RigidBody *body;
+	double T; // frame length [s]
+
+	void Moments (const StateVectors &s, double t, double h, Vector &acc, Vector &arot)
+	{
+		Vector tau;
+		body->GetIntermediateMoments (acc, tau, s, t/T, h);
+		arot = body->EulerInv_full (tau, s.omega); // may need to allow use of the simplified versions here
 	}
-
-	s[0].Set (s1->vel, s1->pos, s1->omega, s1->Q);
-	a[0].Set (acc);
-	d[0].Set (arot);
-
-	for (i = 1; i < n; i++) {
-		s[i].Set (s1->vel, s1->pos, s1->omega, s1->Q);
-		for (j = 0; j < i; j++)
-			s[i].Advance (beta[j]*h, a[j], s[j].vel, d[j], s[j].omega);
-		GetIntermediateMoments (a[i],tau,s[i],(isub+alpha[i-1])/nsub, h);
-		d[i].Set (EulerInv_full (tau, s[i].omega));
-		beta += n-1;
-	}
-	for (i = 0; i < n; i++) {
-		bh = gamma[i]*h;
-		rvel_add += a[i]       * bh;
-		rpos_add += s[i].vel   * bh;
-		s1->Q.Rotate (s[i].omega * bh);
-		s1->omega += d[i]      * bh;
-	}
-}
-
-// ---------------------------------------------------------------------------
-// 5th order 6-stage Runge-Kutta (linear+angular)
-// ---------------------------------------------------------------------------
-
-void RigidBody::RK5_LinAng (double h, int nsub, int isub)
-{
-	RKdrv_LinAng (h, nsub, isub, RK5_n, RK5_alpha, RK5_beta, RK5_gamma);
-}
-
-// ---------------------------------------------------------------------------
-// 6th order 8-stage Runge-Kutta (linear+angular)
-// ---------------------------------------------------------------------------
-
-void RigidBody::RK6_LinAng (double h, int nsub, int isub)
-{
-	RKdrv_LinAng (h, nsub, isub, RK6_n, RK6_alpha, RK6_beta, RK6_gamma);
-}
-
-// ---------------------------------------------------------------------------
-// 7th order 11-stage Runge-Kutta (linear+angular)
-// ---------------------------------------------------------------------------
-
-void RigidBody::RK7_LinAng (double h, int nsub, int isub)
-{
-	RKdrv_LinAng (h, nsub, isub, RK7_n, RK7_alpha, RK7_beta, RK7_gamma);
-}
-
-// ---------------------------------------------------------------------------
-// 8th order 13-stage Runge-Kutta (linear+angular)
-// ---------------------------------------------------------------------------
-
-void RigidBody::RK8_LinAng (double h, int nsub, int isub)
-{
-	RKdrv_LinAng (h, nsub, isub, RK8_n, RK8_alpha, RK8_beta, RK8_gamma);
-}
-
-
-// ---------------------------------------------------------------------------
-// 2nd order symplectic propagator (linear+angular)
-// Note: the propagation of angular state is guesswork ...
-// ---------------------------------------------------------------------------
-
-void RigidBody::SY2_LinAng (double h, int nsub, int isub)
-{
-	double h05 = h*0.5;
-	StateVectors s;
-	Vector tau;
-	rpos_add += (rvel_base+rvel_add)*h05;
-	s1->Q.Rotate (s1->omega*h05);
-	s.Set (s1->vel, rpos_base+rpos_add, s1->omega, s1->Q);
-	GetIntermediateMoments (acc, tau, s, (isub+0.5)/nsub, h);
-	arot.Set (EulerInv_full (tau, s.omega));
-	rvel_add += acc*h;
-	s1->omega += arot*h;
-	rpos_add += (rvel_base+rvel_add)*h05;
-	s1->Q.Rotate (s1->omega*h05);
-}
-
-// ---------------------------------------------------------------------------
-// 4nd order symplectic propagator (linear+angular)
-// Note: the propagation of angular state is guesswork ...
-// ---------------------------------------------------------------------------
-
-void RigidBody::SY4_LinAng (double h, int nsub, int isub)
-{
-	int i;
-	double sec = 0.0;
-	static const double b = 1.25992104989487319066654436028;      // 2^1/3
-	static const double a = 2 - b;
-	static const double x0 = -b / a;
-	static const double x1 = 1. / a;
-	static const double d4[3] = {x1, x0, x1};
-	static const double c4[4] = {x1/2, (x0+x1)/2, (x0+x1)/2, x1/2};
-	StateVectors s;
-	Vector tau;
-
-	for (i = 0; i < 4; i++) {
-		double step = h * c4[i];
-		rpos_add += (rvel_base+rvel_add)*step;
-		s1->Q.Rotate (s1->omega*step);
-		sec += c4[i];
-		if (i != 3) {
-			s.Set (rvel_base+rvel_add, rpos_base+rpos_add, s1->omega, s1->Q);
-			GetIntermediateMoments (acc, tau, s, (isub+sec)/nsub, h);
-			arot.Set (EulerInv_full (tau, s.omega));
-			rvel_add += acc * (h*d4[i]);
-			s1->omega += arot * (h*d4[i]);
-		}
-	}
-}
+};
 
 // ---------------------------------------------------------------------------
-// 6nd order symplectic propagator (linear+angular)
-// Note: the propagation of angular state is guesswork ...
+// Fixed-step substep (linear+angular)
 // ---------------------------------------------------------------------------
 
-void RigidBody::SY6_LinAng (double h, int nsub, int isub)
+void RigidBody::Step_LinAng (int method, double t, double h)
 {
-	int i;
-	double sec = 0.0;
-	static const double w1 = -0.117767998417887E1;
-	static const double w2 = 0.235573213359357E0;
-	static const double w3 = 0.784513610477560E0;
-	static const double w0 = (1-2*(w1+w2+w3));
-	static const double d6[7] = { w3, w2, w1, w0, w1, w2, w3 };
-	static const double c6[8] = { w3/2, (w3+w2)/2, (w2+w1)/2, (w1+w0)/2,
-                         (w1+w0)/2, (w2+w1)/2, (w3+w2)/2, w3/2 };
-	StateVectors s;
-	Vector tau;
-
-	for (i = 0; i < 8; i++) {
-		double step = h * c6[i];
-		rpos_add += (rvel_base+rvel_add)*step;
-		s1->Q.Rotate (s1->omega*step);
-		sec += c6[i];
-		if (i != 7) {
-			s.Set (rvel_base+rvel_add, rpos_base+rpos_add, s1->omega, s1->Q);
-			GetIntermediateMoments (acc, tau, s, (isub+sec)/nsub, h);
-			arot.Set (EulerInv_full (tau, s.omega));
-			rvel_add += acc * (h*d6[i]);
-			s1->omega += arot * (h*d6[i]);
-		}
-	}
+	MomentModel m = {this, td.SimDT};
+	LinAngState x;
+	x.pos0 = rpos_base, x.dpos = rpos_add;
+	x.vel0 = rvel_base, x.dvel = rvel_add;
+	x.Q = s1->Q, x.omega = s1->omega;
+	x.acc = acc, x.arot = arot;
+
+	::Step_LinAng (m, x, method, t, h);
+
+	rpos_add = x.dpos, rvel_add = x.dvel;
+	s1->pos = x.Pos(), s1->vel = x.Vel();
+	s1->omega = x.omega;
+	s1->Q.Set (x.Q);
+	s1->R.Set (s1->Q);
+	acc = x.acc, arot = x.arot;
 }
 
 // ---------------------------------------------------------------------------
-// 8nd order symplectic propagator (linear+angular)
-// Note: the propagation of angular state is guesswork ...
+// Adaptive embedded Runge-Kutta propagation over the frame (linear+angular)
+// The local error is measured relative to the state w.r.t. the reference
+// body. The substep length proposed at the end of the frame is kept for the
+// next one.
 // ---------------------------------------------------------------------------
 
-void RigidBody::SY8_LinAng (double h, int nsub, int isub)
+int RigidBody::RKadapt_LinAng (int method, double atgt)
 {
-	int i;
-	double sec = 0.0;
-	// set 3 from Yoshida's Table 2
-	const double W1 =  0.311790812418427e0;
-	const double W2 = -0.155946803821447e1;
-	const double W3 = -0.167896928259640e1;
-	const double W4 =  0.166335809963315e1;
-	const double W5 = -0.106458714789183e1;
-	const double W6 =  0.136934946416871e1;
-	const double W7 =  0.629030650210433e0;
-	const double W0 = (1-2*(W1+W2+W3+W4+W5+W6+W7));
-
-	const static double d8[15] = {W7, W6, W5, W4, W3, W2, W1, W0,
-		                          W1, W2, W3, W4, W5, W6, W7};
-	const static double c8[16] = { W7/2, (W7+W6)/2, (W6+W5)/2, (W5+W4)/2,
-                         (W4+W3)/2, (W3+W2)/2, (W2+W1)/2, (W1+W0)/2,
-                         (W1+W0)/2, (W2+W1)/2, (W3+W2)/2, (W4+W3)/2,
-                         (W5+W4)/2, (W6+W5)/2, (W7+W6)/2,  W7/2 };
-	StateVectors s;
-	Vector tau;
-
-	for (i = 0; i < 16; i++) {
-		double step = h * c8[i];
-		rpos_add += (rvel_base+rvel_add)*step;
-		s1->Q.Rotate (s1->omega*step);
-		sec += c8[i];
-		if (i != 15) {
-			s.Set (rvel_base+rvel_add, rpos_base+rpos_add, s1->omega, s1->Q);
-			GetIntermediateMoments (acc, tau, s, (isub+sec)/nsub, h);
-			arot.Set (EulerInv_full (tau, s.omega));
-			rvel_add += acc * (h*d8[i]);
-			s1->omega += arot * (h*d8[i]);
-		}
-	}
+	MomentModel m = {this, td.SimDT};
+	LinAngState x;
+	x.pos0 = rpos_base, x.dpos = rpos_add;
+	x.vel0 = rvel_base, x.dvel = rvel_add;
+	x.Q = s1->Q, x.omega = s1->omega;
+	x.acc = acc, x.arot = arot;
+
+	double rscale = (cbody ? cpos.length() : s1->pos.length());
+	double vscale = (cbody ? cvel.length() : s1->vel.length());
+	int nacc = ::RKadapt_LinAng (m, x, method, 0.0, td.SimDT, PropAdaptTol, rscale, vscale, atgt, hAdapt);
+
+	rpos_add = x.dpos, rvel_add = x.dvel;
+	s1->pos = x.Pos(), s1->vel = x.Vel();
+	s1->omega = x.omega;
+	s1->Q.Set (x.Q);
+	s1->R.Set (s1->Q);
+	acc = x.acc, arot = x.arot;
+	return nacc;
 }
 
 #ifdef UNDEF
@@ -36,6 +36,11 @@ CelestialBody::CelestialBody (double _mass, double _size)
 	el = new Elements; TRACENEW
 	ClearModule();
 	usePinesGravity = false;
+	pinesgrid = NULL;
+	pinesTol = 0.0;
+	pinesDegLast = -1;
+	pinesDegSum = 0;
+	pinesDegCount = 0;
 }
 
 CelestialBody::CelestialBody (char *fname)
@@ -44,6 +49,11 @@ CelestialBody::CelestialBody (char *fname)
 	char cbuf[256];
 	int gravcoeff = 0;
 	usePinesGravity = false;
+	pinesgrid = NULL;
+	pinesTol = 0.0;
+	pinesDegLast = -1;
+	pinesDegSum = 0;
+	pinesDegCount = 0;
 
 	DefaultParam ();
 	ClearModule ();
@@ -103,6 +113,11 @@ CelestialBody::CelestialBody (char *fname)
 
 		if (readResult == 0) {
 			usePinesGravity = true;
+			const CFG_PHYSICSPRM &prm = g_pOrbiter->Cfg()->CfgPhysicsPrm;
+			if (prm.GravGridTol > 0.0) {
+				pinesgrid = new PinesGravGrid(pinesgrav, prm.GravGridTol, (size_t)prm.GravGridMem << 20); TRACENEW
+			}
+			GetItemReal(ifs, "GravAccTolerance", pinesTol);
 		}
 	}
 
@@ -154,6 +169,28 @@ CelestialBody::CelestialBody (char *fname)
 	Dphi = fmod (Dphi, Pi2);
 }
 
+int CelestialBody::pinesDegree (double r) const
+{
+	int n = (pinesTol > 0.0 ? pinesgrav.GetTruncationDegree (r, pinesTol*1e-3) : (int)pinesgrav.GetCoeffCutoff());
+	// sample every 16th call of each thread for the statistics, so that
+	// concurrent evaluations don't write to the shared counters on every call
+	static thread_local unsigned int ncall = 0;
+	if (!(ncall++ & 15)) {
+		pinesDegLast.store (n, std::memory_order_relaxed);
+		pinesDegSum.fetch_add (n, std::memory_order_relaxed);
+		pinesDegCount.fetch_add (1, std::memory_order_relaxed);
+	}
+	return n;
+}
+
+void CelestialBody::PinesDegreeStats (int &last, double &mean, bool reset) const
+{
+	long long count = (reset ? pinesDegCount.exchange (0) : pinesDegCount.load());
+	long long sum   = (reset ? pinesDegSum.exchange (0) : pinesDegSum.load());
+	last = pinesDegLast.load();
+	mean = (count ? (double)sum/(double)count : -1.0);
+}
+
 CelestialBody::~CelestialBody ()
 {
 	ClearModule();
@@ -165,6 +202,7 @@ CelestialBody::~CelestialBody ()
 		delete []jcoeff;
 		jcoeff = NULL;
 	}
+	if (pinesgrid) delete pinesgrid;
 }
 
 void CelestialBody::DefaultParam ()
@@ -484,6 +522,7 @@ void CelestialBody::Update (bool force)
 	if (bDynamicPosVel) {
 		bpos = (nsecondary ? Pos2Barycentre (s1->pos) : s1->pos);
 		bvel = s1->vel;
+		UpdateInterpolant ();
 	}
 
 	acc = cpos * (-cvel.length2()/cpos.length2());
@@ -559,6 +598,20 @@ int CelestialBody::ExternEphemeris (double mjd, int req, double *res) const
 	return 0;
 }
 
+int CelestialBody::ExternEphemerisBatch (int n, const double *mjd, int req, double *res) const
+{
+	if (module && module->Version() >= 3) // batch interface
+		return ((CELBODY3*)module)->clbkEphemerisBatch (n, mjd, req, res);
+
+	int flg = 0;
+	for (int j = 0; j < n; j++) {
+		int f = ExternEphemeris (mjd[j], req, res+12*j);
+		if (!j) flg = f;
+		else if (f != flg) return 0;
+	}
+	return flg;
+}
+
 int CelestialBody::ExternFastEphemeris (double simt, int req, double *res) const
 {
 	if (module) {
@@ -640,55 +693,43 @@ bool CelestialBody::PosVelAtTime (double t, Vector *p, Vector *v) const
 	return true;
 }
 
-Vector CelestialBody::InterpolatePosition (double n) const
+bool CelestialBody::PosVelAtMJD (int n, const double *mjd, Vector *p, Vector *v) const
 {
-	// Interpolate global position of body by iterative bisection
-
-	if      (n == 0)   return s0->pos;
-	else if (n == 1.0) return s1->pos;
+	if (bDynamicPosVel) return false;
+	// can't calc at arbitrary times if using dynamic updates
 
-	Vector refp0, refp1, refpm;
-	const CelestialBody *ref = ElRef();
-	if (ref) {
-		// otherwise assume that reference position is origin
-		refp0.Set (ref->s0->pos);
-		refp1.Set (ref->s1->pos);
-		refpm = ref->InterpolatePosition (n);
-		// recursively get reference position at fractional step n
-	}
-
-	const double eps = 1e-2;
-	Vector rp0 (s0->pos-refp0);        // rel. position at current step
-	Vector rp1 (s1->pos-refp1);        // rel. position at next step
-	double rd0 = rp0.length();         // radius at current step
-	double rd1 = rp1.length();         // radius at next step
-	double n0 = 0.0;                   // lower bound of search bracket
-	double n1 = 1.0;                   // upper bound of search bracket
-	double nm = 0.5, d = 0.5;          // current trial point
-	double rdm = (rd0+rd1)*0.5;        // trial radius
-	Vector rpm = (rp0+rp1).unit()*rdm; // trial position
-	while (fabs (nm-n) > eps && d > eps) { // interval too large - continue
-		d *= 0.5;                         // new interval width
-		if (nm < n) {                     // cut away lower half of interval
-			rp0 = rpm;
-			rd0 = rdm;
-			n0  = nm;
-			nm += d;
-		} else {                          // cut away upper half of interval
-			rp1 = rpm;
-			rd1 = rdm;
-			n1  = nm;
-			nm -= d;
+	const int nchunk = 64;
+	double res[12*nchunk];
+	Vector bp, bv, vtmp;
+	int i, j, m, flg;
+	int req = (v ? EPHEM_TRUEPOS | EPHEM_TRUEVEL : EPHEM_TRUEPOS);
+
+	for (i = 0; i < n; i += m) {
+		m = (n-i < nchunk ? n-i : nchunk);
+		flg = ExternEphemerisBatch (m, mjd+i, req, res);
+		for (j = i; j < i+m; j++) {
+			if (flg) {
+				InterpretEphemeris (res+12*(j-i), flg, p+j, v ? v+j : 0, &bp, v ? &bv : 0);
+				if (!(flg & EPHEM_TRUEPOS)) p[j] = bp;
+				if (v && !(flg & EPHEM_TRUEVEL)) v[j] = bv;
+			} else {
+				el->PosVel (p[j], v ? v[j] : vtmp, (mjd[j]-td.MJD_ref)*86400.0);
+			}
 		}
-		rdm = (rd0+rd1)*0.5;              // new trial radius
-		rpm = (rp0+rp1).unit()*rdm;       // new trial position
-	}
-	if (fabs (nm-n) > 1e-10) {        // linear interpolation of remaining step
-		double scale = (n-n0)/(n1-n0);
-		rdm = rd0 + (rd1-rd0)*scale;
-		rpm = (rp0 + (rp1-rp0)*scale).unit() * rdm;
 	}
-	return rpm + refpm;
+	return true;
+}
+
+void CelestialBody::UpdateInterpolant ()
+{
+	interp.Setup (s0->pos, s0->vel, s1->pos, s1->vel, td.SimDT);
+}
+
+Vector CelestialBody::InterpolatePosition (double n) const
+{
+	if      (n == 0)   return s0->pos;
+	else if (n == 1.0) return s1->pos;
+	else               return interp.Pos (n);
 }
 
 StateVectors CelestialBody::InterpolateState (double n) const
@@ -704,7 +745,7 @@ StateVectors CelestialBody::InterpolateState (double n) const
 
 	StateVectors sv;
 	sv.pos = InterpolatePosition (n);
-	sv.vel = s0->vel*(1.0-n) + s1->vel*n; // may need a better interpolation
+	sv.vel = interp.Vel (n);
 	GetRotation (td.SimT0 + td.SimDT*n, sv.R);
 	sv.Q.Set (sv.R);
 	sv.omega.Set (s0->omega*(1.0-n) + s1->omega*n); // is this ok?
@@ -971,6 +1012,26 @@ double CELBODY2::SidRotPeriod () const
 }
 
 
+// =======================================================================
+// class CELBODY3: API interface class
+
+CELBODY3::CELBODY3 (OBJHANDLE hCBody): CELBODY2 (hCBody)
+{
+	version++;
+}
+
+int CELBODY3::clbkEphemerisBatch (int n, const double *mjd, int req, double *ret)
+{
+	int flag = 0;
+	for (int j = 0; j < n; j++) {
+		int f = clbkEphemeris (mjd[j], req, ret+12*j);
+		if (!j) flag = f;
+		else if (f != flag) return 0;
+	}
+	return flag;
+}
+
+
 // =======================================================================
 // class ATMOSPHERE: API interface class
 
@@ -993,3 +1054,46 @@ bool ATMOSPHERE::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm_out)
 	return false;
 }
 
+int ATMOSPHERE::Version () const
+{
+	// ATMOSPHERE has no room for a version field, so the version follows
+	// from the instance's type
+	try {
+		return (dynamic_cast<const ATMOSPHERE2*>(this) ? 2 : 1); // null if not an ATMOSPHERE2 instance
+	}
+	catch(...) {
+		return 1;
+	}
+}
+
+bool ATMOSPHERE::ParamsBatch (int n, const PRM_IN *prm_in, PRM_OUT *prm_out)
+{
+	if (Version() >= 2)
+		return static_cast<ATMOSPHERE2*>(this)->clbkParamsBatch (n, prm_in, prm_out);
+
+	bool ok = true;
+	for (int j = 0; j < n; j++)
+		if (!clbkParams (prm_in+j, prm_out+j)) ok = false;
+	return ok;
+}
+
+
+// =======================================================================
+// class ATMOSPHERE2: API interface class
+
+ATMOSPHERE2::ATMOSPHERE2 (CELBODY2 *body): ATMOSPHERE (body)
+{
+}
+
+ATMOSPHERE2::~ATMOSPHERE2 ()
+{
+}
+
+bool ATMOSPHERE2::clbkParamsBatch (int n, const PRM_IN *prm_in, PRM_OUT *prm_out)
+{
+	bool ok = true;
+	for (int j = 0; j < n; j++)
+		if (!clbkParams (prm_in+j, prm_out+j)) ok = false;
+	return ok;
+}
+
@@ -12,6 +12,8 @@
 #include "RigidBody.h"
 #include "OrbiterAPI.h"
 #include "PinesGrav.h"
+#include "PhysicsCore.h"
+#include <atomic>
 
 // Module interface methods - OBSOLETE
 typedef void   (*OPLANET_SetPrecision)(double prec);
@@ -96,15 +98,24 @@ public:
 	// ecliptic frame, relative to planet's parent. Only works if planet updates
 	// position analytically, otherwise function returns false
 
+	bool PosVelAtMJD (int n, const double *mjd, Vector *p, Vector *v) const;
+	// Multi-epoch version of PosVelAtTime: positions p[j] and velocities v[j]
+	// (if v != NULL) at the n dates mjd[j] (MJD). The module's ephemeris
+	// series are evaluated for groups of dates together, which is much faster
+	// than n calls to PosVelAtTime. Returns false for dynamic position updates
+
 	void GetRotation (double t, Matrix &rot) const;
 	// Returns rotation matrix at time t.
 	// Note: this function assumes current precession, i.e. t sufficiently close to td.SimT0
 
+	void UpdateInterpolant ();
+	// Set up the interpolant for InterpolatePosition/InterpolateState from
+	// the states s0 and s1. Called once per time step, after s1 is known.
+
 	Vector InterpolatePosition (double n) const;
 	// interpolate a planet position to a time between last and current time step,
 	// where n=0 refers to last step, and n=1 to current step.
-	// linear interpolation of position, plus linear interpolation of radius, if
-	// body's element reference exists
+	// cubic Hermite interpolation between the positions and velocities at both ends
 
 	StateVectors InterpolateState (double n) const;
 	// Celestial body state vectors at fractional time n [0..1] between
@@ -123,13 +134,28 @@ public:
 
 	// returns true if the body uses Pines Algorithm to calculate gravitational acceleration from spherical harmonics
 	inline bool usePines() const { return usePinesGravity; }
-	inline Vector pinesAccel(const Vector rposmax, const int maxDegree, const int maxOrder){
+	inline Vector pinesAccel(const Vector rposmax, const int maxDegree, const int maxOrder) const {
+		Vector g;
+		if (pinesgrid && maxDegree == (int)pinesgrav.GetCoeffCutoff() && maxOrder == maxDegree &&
+			pinesgrid->GetPinesGrav(rposmax, g))
+			return g;
 		return pinesgrav.GetPinesGrav(rposmax, maxDegree, maxOrder);
 	}
 	inline unsigned int GetPinesCutoff() const {
 		return pinesgrav.GetCoeffCutoff(); 
 	}
 
+	int pinesDegree (double r) const;
+	// Degree/order to use for evaluating the harmonic model at radius r [km].
+	// Returns the model cutoff unless the body defines GravAccTolerance, in which
+	// case the series is truncated where the remaining terms fall below it.
+	// Safe to call concurrently.
+
+	void PinesDegreeStats (int &last, double &mean, bool reset = true) const;
+	// Degree returned by the most recent sampled pinesDegree call, and the mean
+	// over the sampled calls since the last reset (or -1 if there were none).
+	// pinesDegree samples every 16th call on each thread.
+
 protected:
 	//Matrix R_ref_rel;     // rotation matrix for tilting the axis of rotation (including precession)
 	Matrix R_ecl;         // precession matrix
@@ -160,6 +186,10 @@ protected:
 	// Try to obtain ephemeris data at mjd from external module
 	// req contains data request flags, return value contains satisfied requests
 
+	int ExternEphemerisBatch (int n, const double *mjd, int req, double *res) const;
+	// ExternEphemeris for the n dates mjd[0..n-1], with results in res[12*j..].
+	// Return value as for ExternEphemeris (the same for all dates), or 0
+
 	int ExternFastEphemeris (double simt, int req, double *res) const;
 	// Try to obtain fast sequential ephemeris data at simt from
 	// external module.
@@ -223,7 +253,13 @@ private:
 
 	PinesGravProp pinesgrav; // coefficients and methods for calculating non-spherical gravity vectors using Pines Algorithm
 	bool usePinesGravity;    // use Pines Algorithm if true, if false use the older jcoeff method
+	PinesGravGrid *pinesgrid; // interpolation grid for near-surface gravity (NULL if disabled)
+	double pinesTol;         // acceleration tolerance for truncating the harmonic series [m/s^2] (0=use full cutoff)
+	mutable std::atomic<int> pinesDegLast;        // degree used in the most recent sampled evaluation
+	mutable std::atomic<long long> pinesDegSum;   // sum of sampled degrees since last stats reset
+	mutable std::atomic<long long> pinesDegCount; // number of sampled evaluations since last stats reset
 
+	StepInterpolant interp;  // position interpolant over the current time step
 	Vector bpos, bvel;       // object's barycentre state (the barycentre of the set of bodies including *this and its children) with respect to the true position of the parent of *this
 	Vector bposofs, bvelofs; // body barycentre state - true state
 	bool ephem_parentbary;   // true if body calculates its state with respect to the parent barycentre, false if with respect to parent's true position
@@ -48,6 +48,8 @@ CFG_PHYSICSPRM CfgPhysicsPrm_default = {
 	true,		// bOrbitStabilise (use Encke orbit stabilisation)
 	0.05,		// Stabilise_PLimit (perturbation limit for stabilisation)
 	0.01,		// Stabilise_SLimit (step size limit for stabilisation)
+	false,		// bFastForward (no analytic fast-forward propagation)
+	0.05,		// FastForward_SLimit (step size limit for fast-forward propagation)
 	0.02,		// PPropSubLimit (orbit step target for perturbation subsampling)
 	10,			// PPropSubMax (max number of subsampling steps for perturbation integration)
 	0.05,		// PPropStepLimit (orbit step limit for nonspherical gravity suppression)
@@ -59,8 +61,12 @@ CFG_PHYSICSPRM CfgPhysicsPrm_default = {
 	{1.0*RAD, 4.0*RAD, 10.0*RAD, 1e10, 1e10},		// PropALimit (angle limits for angular propagation levels)
 	20.0*RAD,	// APropSubLimit (angle step limit for angular subsampling)
 	10, 		// PropSubMax (max number of subsampling steps)
+	1e-12,		// PropAdaptTol (local error tolerance for adaptive propagators)
 	30.0*RAD,	// APropCouplingLimit (angle step limit for cross term suppresion)
-	3600.0*RAD	// APropTorqueLimit (angle step limit for torque suppression)
+	3600.0*RAD,	// APropTorqueLimit (angle step limit for torque suppression)
+	0,			// nPropThreads (propagate vessels serially)
+	0.0,		// GravGridTol (evaluate gravity harmonics directly)
+	64			// GravGridMem (gravity grid memory budget per body [MB])
 };
 
 CFG_LOGICPRM CfgLogicPrm_default = {
@@ -158,7 +164,11 @@ CFG_PLANETRENDERPRM CfgPRenderPrm_default = {
 	5,          // patch mesh resolution power
 	50,			// load frequency (Hz)
 	3,			// aniso mode (1=none)
-	0x0003      // TileLoadFlags (load from individual tile files + compressed archives)
+	0x0003,     // TileLoadFlags (load from individual tile files + compressed archives)
+	128,        // ElevCacheSize (MB)
+	1,          // ElevPrefetchThreads
+	1e5,        // ElevPrefetchAlt (m)
+	60.0        // ElevPrefetchTime (s)
 };
 
 CFG_MAPPRM CfgMapPrm_default = {
@@ -250,6 +260,7 @@ CFG_CMDLINEPRM CfgCmdlinePrm_default = {
 	0.0,                // fixed time step length (0 = disabled)
 	0.0,                // Max sys time (0 = unlimited)
 	0.0,                // Max sim time (0 = unlimited)
+	-1,                 // PropThreads (-1 = use config setting)
 	std::string(),      // launch scenario (empty: open Launchpad dialog)
 	std::list<std::string>() // list of plugins to load
 };
@@ -565,6 +576,14 @@ bool Config::Load(const char *fname)
 		CfgPRenderPrm.ResolutionBias = max (-2.0, min (2.0, d));
 	if (GetInt (ifs, "TileLoadFlags", i))
 		CfgPRenderPrm.TileLoadFlags = max (min(i, 3), 1);
+	if (GetInt (ifs, "ElevationCacheSize", i))
+		CfgPRenderPrm.ElevCacheSize = max (i, 1);
+	if (GetInt (ifs, "ElevationPrefetchThreads", i))
+		CfgPRenderPrm.ElevPrefetchThreads = max (min (i, 8), 0);
+	if (GetReal (ifs, "ElevationPrefetchAlt", d))
+		CfgPRenderPrm.ElevPrefetchAlt = max (d, 0.0);
+	if (GetReal (ifs, "ElevationPrefetchTime", d))
+		CfgPRenderPrm.ElevPrefetchTime = max (d, 1.0);
 
 	// map dialog parameters
 	if (GetInt (ifs, "MapDlgFlag", i))
@@ -592,6 +611,8 @@ bool Config::Load(const char *fname)
 	GetBool (ifs, "StabiliseOrbits", CfgPhysicsPrm.bOrbitStabilise);
 	GetReal (ifs, "StabilisePLimit", CfgPhysicsPrm.Stabilise_PLimit);
 	GetReal (ifs, "StabiliseSLimit", CfgPhysicsPrm.Stabilise_SLimit);
+	GetBool (ifs, "FastForwardOrbits", CfgPhysicsPrm.bFastForward);
+	GetReal (ifs, "FastForwardSLimit", CfgPhysicsPrm.FastForward_SLimit);
 	if (GetString (ifs, "PertPropSubsampling", cbuf))
 		sscanf (cbuf, "%d%lf", &CfgPhysicsPrm.PPropSubMax, &CfgPhysicsPrm.PPropSubLimit);
 	GetReal (ifs, "PertPropNonsphericalLimit", CfgPhysicsPrm.PPropStepLimit);
@@ -612,6 +633,10 @@ bool Config::Load(const char *fname)
 	CfgPhysicsPrm.PropTLim[CfgPhysicsPrm.nLPropLevel-1] = 1e10;
 	CfgPhysicsPrm.PropALim[CfgPhysicsPrm.nLPropLevel-1] = 1e10;
 	GetInt (ifs, "PropSubsampling", CfgPhysicsPrm.PropSubMax);
+	GetReal (ifs, "PropAdaptiveTolerance", CfgPhysicsPrm.PropAdaptTol);
+	GetInt (ifs, "PropThreads", CfgPhysicsPrm.nPropThreads);
+	GetReal (ifs, "GravGridTolerance", CfgPhysicsPrm.GravGridTol);
+	GetInt (ifs, "GravGridMemory", CfgPhysicsPrm.GravGridMem);
 
 #ifdef UNDEF
 	// BEGIN OBSOLETE
@@ -1164,6 +1189,10 @@ BOOL Config::Write (const char *fname) const
 			ofs << "StabilisePLimit = " << CfgPhysicsPrm.Stabilise_PLimit << '\n';
 		if (CfgPhysicsPrm.Stabilise_SLimit != CfgPhysicsPrm_default.Stabilise_SLimit || bEchoAll)
 			ofs << "StabiliseSLimit = " << CfgPhysicsPrm.Stabilise_SLimit << '\n';
+		if (CfgPhysicsPrm.bFastForward != CfgPhysicsPrm_default.bFastForward || bEchoAll)
+			ofs << "FastForwardOrbits = " << BoolStr (CfgPhysicsPrm.bFastForward) << '\n';
+		if (CfgPhysicsPrm.FastForward_SLimit != CfgPhysicsPrm_default.FastForward_SLimit || bEchoAll)
+			ofs << "FastForwardSLimit = " << CfgPhysicsPrm.FastForward_SLimit << '\n';
 		if (CfgPhysicsPrm.PPropSubMax != CfgPhysicsPrm_default.PPropSubMax || CfgPhysicsPrm.PPropSubLimit != CfgPhysicsPrm_default.PPropSubLimit || bEchoAll)
 			ofs << "PertPropSubsampling = " << CfgPhysicsPrm.PPropSubMax << ' ' << CfgPhysicsPrm.PPropSubLimit << '\n';
 		if (CfgPhysicsPrm.PPropStepLimit != CfgPhysicsPrm_default.PPropStepLimit || bEchoAll)
@@ -1188,6 +1217,14 @@ BOOL Config::Write (const char *fname) const
 #endif
 		if (CfgPhysicsPrm.PropSubMax != CfgPhysicsPrm_default.PropSubMax || bEchoAll)
 			ofs << "PropSubsampling = " << CfgPhysicsPrm.PropSubMax << '\n';
+		if (CfgPhysicsPrm.PropAdaptTol != CfgPhysicsPrm_default.PropAdaptTol || bEchoAll)
+			ofs << "PropAdaptiveTolerance = " << CfgPhysicsPrm.PropAdaptTol << '\n';
+		if (CfgPhysicsPrm.nPropThreads != CfgPhysicsPrm_default.nPropThreads || bEchoAll)
+			ofs << "PropThreads = " << CfgPhysicsPrm.nPropThreads << '\n';
+		if (CfgPhysicsPrm.GravGridTol != CfgPhysicsPrm_default.GravGridTol || bEchoAll)
+			ofs << "GravGridTolerance = " << CfgPhysicsPrm.GravGridTol << '\n';
+		if (CfgPhysicsPrm.GravGridMem != CfgPhysicsPrm_default.GravGridMem || bEchoAll)
+			ofs << "GravGridMemory = " << CfgPhysicsPrm.GravGridMem << '\n';
 	}
 
 	if (memcmp (&CfgPRenderPrm, &CfgPRenderPrm_default, sizeof(CFG_PLANETRENDERPRM)) || bEchoAll) {
@@ -1212,6 +1249,14 @@ BOOL Config::Write (const char *fname) const
 			ofs << "PlanetResolutionBias = " << CfgPRenderPrm.ResolutionBias << '\n';
 		if (CfgPRenderPrm.TileLoadFlags != CfgPRenderPrm_default.TileLoadFlags || bEchoAll)
 			ofs << "TileLoadFlags = " << CfgPRenderPrm.TileLoadFlags << '\n';
+		if (CfgPRenderPrm.ElevCacheSize != CfgPRenderPrm_default.ElevCacheSize || bEchoAll)
+			ofs << "ElevationCacheSize = " << CfgPRenderPrm.ElevCacheSize << '\n';
+		if (CfgPRenderPrm.ElevPrefetchThreads != CfgPRenderPrm_default.ElevPrefetchThreads || bEchoAll)
+			ofs << "ElevationPrefetchThreads = " << CfgPRenderPrm.ElevPrefetchThreads << '\n';
+		if (CfgPRenderPrm.ElevPrefetchAlt != CfgPRenderPrm_default.ElevPrefetchAlt || bEchoAll)
+			ofs << "ElevationPrefetchAlt = " << CfgPRenderPrm.ElevPrefetchAlt << '\n';
+		if (CfgPRenderPrm.ElevPrefetchTime != CfgPRenderPrm_default.ElevPrefetchTime || bEchoAll)
+			ofs << "ElevationPrefetchTime = " << CfgPRenderPrm.ElevPrefetchTime << '\n';
 	}
 
 	if (memcmp (&CfgMapPrm, &CfgMapPrm_default, sizeof (CFG_MAPPRM)) || bEchoAll) {
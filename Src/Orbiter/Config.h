@@ -13,6 +13,7 @@
 //#include <d3d.h>
 #include <windows.h>
 #include "Vecmat.h"
+#include "Integrators.h"
 #include <iostream>
 #include <fstream>
 #include <list>
@@ -21,18 +22,8 @@
 // dynamic state propagation methods
 #define MAX_PROP_LEVEL  5
 #define MAX_APROP_LEVEL 5
-#define NPROP_METHOD   10
 #define NAPROP_METHOD   6
-#define PROP_RK2        0
-#define PROP_RK4        1
-#define PROP_RK5        2
-#define PROP_RK6        3
-#define PROP_RK7        4
-#define PROP_RK8        5
-#define PROP_SY2        6
-#define PROP_SY4        7
-#define PROP_SY6        8
-#define PROP_SY8        9
+// method identifiers PROP_xxx: see Integrators.h
 
 #define SURF_MAX_PATCHLEVEL 14
 #define SURF_MAX_PATCHLEVEL2 21
@@ -65,6 +56,8 @@ struct CFG_PHYSICSPRM {
 	bool   bOrbitStabilise;		// use Encke orbit stabilisation at high time accelerations
 	double Stabilise_PLimit;	// perturbation limit for stabilisation
 	double Stabilise_SLimit;	// step size limit for stabilisation
+	bool   bFastForward;		// use analytic (Kepler + secular drift) propagation for coasting vessels at high time accelerations
+	double FastForward_SLimit;	// step size limit for fast-forward propagation
 	double PPropSubLimit;		// orbit step target for perturbation subsampling
 	int    PPropSubMax;			// max number of subsampling steps (perturbation integration)
 	double PPropStepLimit;		// orbit step limit for nonspherical gravity suppression
@@ -76,8 +69,12 @@ struct CFG_PHYSICSPRM {
 	double PropALim[MAX_PROP_LEVEL];  // angle step limits for the propagation levels
 	double APropSubLimit;		// angle step limit for subsampling
 	int    PropSubMax;			// max number of subsampling steps
+	double PropAdaptTol;		// relative local error tolerance for the adaptive propagators (PROP_DP5, PROP_RKF78)
 	double APropCouplingLimit;	// angle step limit for cross term suppresion
 	double APropTorqueLimit;	// angle step limit for torque suppression
+	int    nPropThreads;		// worker threads for concurrent vessel propagation (0=serial update)
+	double GravGridTol;			// relative error tolerance for interpolated near-surface gravity (0=disabled)
+	int    GravGridMem;			// memory budget per body for the gravity interpolation grid [MB]
 };
 
 struct CFG_LOGICPRM {
@@ -184,6 +181,10 @@ struct CFG_PLANETRENDERPRM {
 	int    LoadFrequency;       // tile load frequency
 	int    AnisoMode;
 	DWORD  TileLoadFlags;       // flags for planetary tile load mechanism
+	int    ElevCacheSize;       // memory budget of the shared elevation tile cache [MB]
+	int    ElevPrefetchThreads; // I/O threads for elevation tile prefetch (0=disabled)
+	double ElevPrefetchAlt;     // altitude limit for elevation tile prefetch [m]
+	double ElevPrefetchTime;    // ground track prediction time for elevation tile prefetch [s]
 };
 
 struct CFG_MAPPRM {
@@ -288,6 +289,7 @@ struct CFG_CMDLINEPRM {
 	double FixedStep;           // fixed time step length (0 = disabled). If != 0, overrides CFG_DEBUGPRM::FixedStep
 	double MaxSysTime;          // Max session runtime (sys time). 0 = unlimited
 	double MaxSimTime;          // Max session runtime (sim time). 0 = unlimited
+	int    PropThreads;         // worker threads for concurrent vessel propagation (-1 = use CFG_PHYSICSPRM::nPropThreads)
 	std::string LaunchScenario; // if not empty, start scenario instantly without opening Launchpad
 	std::list<std::string> LoadPlugins; // list of plugins to load
 };
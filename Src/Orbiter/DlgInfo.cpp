@@ -452,7 +452,7 @@ void DlgInfo::DrawInfoVessel(Vessel *vessel) {
                     ImGui::TableSetColumnIndex(0);
                     ImGui::TextUnformatted("State Propagator");
                     ImGui::TableSetColumnIndex(1);
-                    ImGui::TextUnformatted(vessel->isOrbitStabilised() ? "stabilised" : vessel->CurPropagatorStr());
+                    ImGui::TextUnformatted(vessel->isFastForwarded() ? "fast-forward" : vessel->isOrbitStabilised() ? "stabilised" : vessel->CurPropagatorStr());
 
                 ImGui::TableNextRow();
                     ImGui::TableSetColumnIndex(0);
@@ -550,6 +550,19 @@ void DlgInfo::DrawInfoCelestialBody(CelestialBody *cbody) {
                 ImGui::TableSetColumnIndex(1);
                 ImGui::TextUnformatted(cbuf);
 
+            if (cbody->usePines()) {
+                int nlast;
+                double nmean;
+                cbody->PinesDegreeStats (nlast, nmean);
+                if (nmean >= 0.0) sprintf (cbuf, "%d (mean %0.1f, model %d)", nlast, nmean, cbody->GetPinesCutoff());
+                else sprintf (cbuf, "N/A (model %d)", cbody->GetPinesCutoff());
+                ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::TextUnformatted("Harmonics Degree Used");
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::TextUnformatted(cbuf);
+            }
+
             ImGui::TableNextRow();
                 ImGui::TableSetColumnIndex(0);
                 ImGui::TextUnformatted("Siderial day");
@@ -0,0 +1,124 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// ======================================================================
+// Elevation tile prefetch (see ElevPrefetch.h)
+// ======================================================================
+
+#include "ElevPrefetch.h"
+#include "Vessel.h"
+#include "Planet.h"
+#include "Element.h"
+#include "TimeData.h"
+
+using std::min;
+using std::max;
+
+extern TimeData td;
+
+static const int MAXSAMPLE = 64; // max. track points per vessel and prediction
+
+ElevationPrefetcher::ElevationPrefetcher (int nthread, double _maxalt, double _horizon, size_t maxqueue)
+: maxalt(_maxalt), horizon(_horizon), loader(nthread, maxqueue)
+{
+	tnext = -1e100;
+}
+
+void ElevationPrefetcher::Schedule (const std::vector<Vessel*> &vessels)
+{
+	if (td.SimT0 < tnext) return;
+	double span = horizon;
+
+	for (size_t i = 0; i < vessels.size(); i++) {
+		const Vessel *v = vessels[i];
+		if (v->GetStatus() != FLIGHTSTATUS_FREEFLIGHT) continue;
+		const Planet *planet = v->ProxyPlanet();
+		if (!planet || v->ElRef() != planet) continue;
+		const ElevationManager *emgr = planet->ElevMgr();
+		if (!emgr) continue;
+		const SurfParam *sp = v->GetSurfParam();
+		if (!sp || sp->ref != planet || sp->alt0 > maxalt) continue;
+		const Elements *el = v->Els();
+		if (!el) continue;
+
+		// step length: about half a tile at the current resolution level
+		// (as requested by SurfParam::Set), up to MAXSAMPLE steps
+		int lvl = emgr->CacheLevel ((int)(32.0-log(max(sp->alt0,100.0))*LOG2));
+		double w = sp->groundspd/sp->rad; // angular ground speed
+		double dt = (w > 0.0 ? 0.5*Pi/(double)(1 << lvl)/w : horizon);
+		int n = (int)ceil (horizon/dt);
+		if (n > MAXSAMPLE) n = MAXSAMPLE;
+		else dt = horizon/n;
+		span = min (span, n*dt);
+
+		Matrix rot;
+		for (int k = 1; k <= n; k++) {
+			double t = td.SimT0 + k*dt;
+			double lng, lat, rad;
+			planet->GetRotation (t, rot);
+			planet->LocalToEquatorial (tmul (rot, el->Pos (t)), lng, lat, rad);
+			double alt = rad - planet->Size();
+			if (alt > maxalt) continue;
+			Request (emgr, lat, lng, (int)(32.0-log(max(alt,100.0))*LOG2));
+		}
+	}
+	tnext = td.SimT0 + 0.5*span;
+}
+
+void ElevationPrefetcher::Request (const ElevationManager *emgr, double lat, double lng, int reqlvl)
+{
+	// nothing to do if the tile serving this position is already known
+	ElevationTileCache &cache = ElevationTileCache::Shared();
+	int lvl = emgr->CacheLevel (reqlvl), ilat, ilng, l;
+	for (l = lvl; l >= 0; l--) {
+		emgr->TileIdx (lat, lng, l, &ilat, &ilng);
+		int state = cache.Probe (emgr->cacheId, l, ilat, ilng);
+		if (state == 1) return;
+		else if (state < 0) break;
+	}
+	if (l < 0) return; // no tile at any level
+
+	emgr->TileIdx (lat, lng, lvl, &ilat, &ilng);
+	source[emgr->cacheId] = emgr;
+	loader.Request ({emgr->cacheId, lvl, ilat, ilng}, [=]() { return Load (emgr, lat, lng, lvl); });
+}
+
+TileLoadQueue::Tile ElevationPrefetcher::Load (const ElevationManager *emgr, double lat, double lng, int reqlvl)
+{
+	// as in ElevationManager::Elevation, the query is served by the
+	// highest level tile that exists at or below the requested level
+	ElevationTileCache &cache = ElevationTileCache::Shared();
+	TileLoadQueue::Tile tile = {0, 0, 0, 0};
+	int ilat, ilng;
+	for (int lvl = reqlvl; lvl >= 0; lvl--) {
+		emgr->TileIdx (lat, lng, lvl, &ilat, &ilng);
+		int state = cache.Probe (emgr->cacheId, lvl, ilat, ilng);
+		if (state == 1) break;      // cached
+		else if (state == 0) continue; // known not to exist
+		INT16 *elev = emgr->ReadTile (lvl, ilat, ilng);
+		if (!elev) {
+			emgr->AddTile (lvl, ilat, ilng, 0); // record the missing tile; no filter involved
+			continue;
+		}
+		tile.lvl = lvl, tile.ilat = ilat, tile.ilng = ilng, tile.data = elev;
+		break;
+	}
+	return tile;
+}
+
+void ElevationPrefetcher::Update ()
+{
+	std::vector<std::pair<TileLoadQueue::Key,TileLoadQueue::Tile> > ready;
+	loader.Collect (ready);
+	for (auto &r : ready) {
+		const TileLoadQueue::Tile &tile = r.second;
+		source[r.first.src]->AddTile (tile.lvl, tile.ilat, tile.ilng, tile.data, true);
+	}
+}
+
+void ElevationPrefetcher::Clear ()
+{
+	loader.Clear();
+	source.clear();
+	tnext = -1e100;
+}
@@ -0,0 +1,68 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// ElevPrefetch.h
+// Background loading of the elevation tiles along the predicted ground
+// tracks of low-flying vessels.
+// =======================================================================
+
+#ifndef __ELEVPREFETCH_H
+#define __ELEVPREFETCH_H
+
+#include <map>
+#include <vector>
+#include "elevmgr.h"
+#include "TileLoadQueue.h"
+
+class Vessel;
+
+// =======================================================================
+// class ElevationPrefetcher
+// Schedule predicts the ground track of each free-flying vessel below
+// maxalt over the next 'horizon' seconds from its osculating elements, and
+// queues the elevation tiles the vessel will query along it. The I/O
+// threads of a TileLoadQueue read and decompress the tiles. The graphics
+// client's elevation filter is not assumed to be thread-safe, so the
+// loaded tiles are passed through it and added to the shared tile cache on
+// the main thread by Update.
+// =======================================================================
+
+class ElevationPrefetcher {
+public:
+	ElevationPrefetcher (int nthread, double maxalt, double horizon, size_t maxqueue = 1024);
+	// nthread: number of I/O threads
+	// maxalt: altitude limit for vessels to be served [m]
+	// horizon: prediction time [s]
+	// maxqueue: max. number of queued tile requests; further requests are dropped
+
+	int nThread () const { return loader.nThread(); }
+
+	void Schedule (const std::vector<Vessel*> &vessels);
+	// Queue the tiles along the predicted ground tracks. Called once per
+	// frame after the state update; the tracks are only recomputed when the
+	// vessels have covered part of the previous prediction.
+
+	void Update ();
+	// Add the tiles loaded since the last call to the cache
+
+	void Clear ();
+	// Discard all pending requests and wait for running loads to finish.
+	// Must be called before elevation managers are destroyed.
+
+	typedef TileLoadQueue::Stats Stats;
+	Stats GetStats () const { return loader.GetStats(); }
+	// Prefetch statistics. The fraction of prefetched tiles that were used
+	// later is available from the tile cache (ElevationTileCache::Stats).
+
+private:
+	void Request (const ElevationManager *emgr, double lat, double lng, int reqlvl);
+	static TileLoadQueue::Tile Load (const ElevationManager *emgr, double lat, double lng, int reqlvl);
+
+	double maxalt, horizon;
+	double tnext;                  // simulation time for the next track prediction
+	TileLoadQueue loader;
+	std::map<unsigned int, const ElevationManager*> source; // elevation managers by cache source id
+};
+
+#endif // !__ELEVPREFETCH_H
@@ -0,0 +1,161 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// ======================================================================
+// Shared elevation tile cache (see ElevTileCache.h)
+// ======================================================================
+
+#include "ElevTileCache.h"
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+static const size_t ENTRY_OVERHEAD = 64; // bookkeeping cost of a map entry [bytes], approx.
+
+ElevationTileCache::ElevationTileCache (size_t membudget)
+{
+	SetBudget (membudget);
+}
+
+ElevationTileCache::~ElevationTileCache ()
+{
+}
+
+ElevationTileCache &ElevationTileCache::Shared ()
+{
+	static ElevationTileCache cache (128 << 20);
+	return cache;
+}
+
+unsigned int ElevationTileCache::NewSource ()
+{
+	static std::atomic<unsigned int> nsrc (0);
+	return ++nsrc;
+}
+
+void ElevationTileCache::SetBudget (size_t membudget)
+{
+	maxShardMem = membudget / NSHARD;
+}
+
+size_t ElevationTileCache::KeyHash::operator() (const Key &k) const
+{
+	uint64_t h = k.src;
+	h = h*0x9E3779B97F4A7C15ull + (uint64_t)k.lvl;
+	h = h*0x9E3779B97F4A7C15ull + (uint64_t)k.ilat;
+	h = h*0x9E3779B97F4A7C15ull + (uint64_t)k.ilng;
+	return (size_t)(h ^ (h >> 29));
+}
+
+ElevationTileCache::Shard &ElevationTileCache::ShardOf (const Key &key)
+{
+	// the top bits select the shard, the map buckets use the bottom ones
+	return shard[(KeyHash()(key) >> 24) % NSHARD];
+}
+
+const ElevationTileCache::Shard &ElevationTileCache::ShardOf (const Key &key) const
+{
+	return shard[(KeyHash()(key) >> 24) % NSHARD];
+}
+
+bool ElevationTileCache::Find (unsigned int src, int lvl, int ilat, int ilng, ElevTilePtr &tile)
+{
+	Key key = {src, lvl, ilat, ilng};
+	Shard &s = ShardOf (key);
+	std::shared_lock<std::shared_mutex> lock(s.mtx);
+	auto it = s.tiles.find (key);
+	if (it == s.tiles.end()) {
+		s.nmiss.fetch_add (1, std::memory_order_relaxed);
+		return false;
+	}
+	it->second.lastuse.store (++s.tick, std::memory_order_relaxed);
+	tile = it->second.tile;
+	s.nhit.fetch_add (1, std::memory_order_relaxed);
+	if (it->second.prefetched.load (std::memory_order_relaxed) && it->second.prefetched.exchange (false))
+		s.nprefetchhit.fetch_add (1, std::memory_order_relaxed);
+	return true;
+}
+
+int ElevationTileCache::Probe (unsigned int src, int lvl, int ilat, int ilng) const
+{
+	Key key = {src, lvl, ilat, ilng};
+	const Shard &s = ShardOf (key);
+	std::shared_lock<std::shared_mutex> lock(s.mtx);
+	auto it = s.tiles.find (key);
+	if (it == s.tiles.end()) return -1;
+	return it->second.tile ? 1 : 0;
+}
+
+ElevTilePtr ElevationTileCache::Insert (unsigned int src, int lvl, int ilat, int ilng, ElevTilePtr tile, size_t size, bool prefetched)
+{
+	Key key = {src, lvl, ilat, ilng};
+	Shard &s = ShardOf (key);
+	std::unique_lock<std::shared_mutex> lock(s.mtx);
+	auto res = s.tiles.try_emplace (key);
+	Entry &e = res.first->second;
+	if (res.second) {
+		e.tile = tile;
+		e.size = (tile ? size : 0) + ENTRY_OVERHEAD;
+		s.mem += e.size;
+		e.lastuse.store (++s.tick, std::memory_order_relaxed);
+		e.prefetched.store (prefetched && tile, std::memory_order_relaxed);
+		if (prefetched && tile) s.nprefetch++;
+		if (s.mem > maxShardMem.load (std::memory_order_relaxed)) Evict (s, key);
+		return tile;
+	} else { // loaded concurrently by another thread
+		e.lastuse.store (++s.tick, std::memory_order_relaxed);
+		return e.tile;
+	}
+}
+
+void ElevationTileCache::Evict (Shard &s, const Key &keep)
+{
+	// caller holds the exclusive lock. Drop the oldest entries down to 7/8
+	// of the budget in one go so that eviction scans stay rare.
+	size_t target = maxShardMem.load (std::memory_order_relaxed) / 8 * 7;
+	std::vector<std::pair<uint64_t, Key> > age;
+	age.reserve (s.tiles.size());
+	for (auto &t : s.tiles)
+		if (!(t.first == keep))
+			age.emplace_back (t.second.lastuse.load (std::memory_order_relaxed), t.first);
+	std::sort (age.begin(), age.end(), [](const std::pair<uint64_t, Key> &a, const std::pair<uint64_t, Key> &b) {
+		return a.first < b.first;
+	});
+	for (size_t j = 0; j < age.size() && s.mem > target; j++) {
+		auto it = s.tiles.find (age[j].second);
+		s.mem -= it->second.size;
+		s.tiles.erase (it);
+		s.nevict++;
+	}
+}
+
+void ElevationTileCache::Drop (unsigned int src)
+{
+	for (int i = 0; i < NSHARD; i++) {
+		Shard &s = shard[i];
+		std::unique_lock<std::shared_mutex> lock(s.mtx);
+		for (auto it = s.tiles.begin(); it != s.tiles.end();) {
+			if (it->first.src == src) {
+				s.mem -= it->second.size;
+				it = s.tiles.erase (it);
+			} else ++it;
+		}
+	}
+}
+
+ElevationTileCache::Stats ElevationTileCache::GetStats () const
+{
+	Stats stats = {0, 0, 0, 0, 0, 0, 0};
+	for (int i = 0; i < NSHARD; i++) {
+		const Shard &s = shard[i];
+		std::shared_lock<std::shared_mutex> lock(s.mtx);
+		stats.hits += s.nhit.load (std::memory_order_relaxed);
+		stats.misses += s.nmiss.load (std::memory_order_relaxed);
+		stats.evictions += s.nevict;
+		stats.prefetched += s.nprefetch;
+		stats.prefetchHits += s.nprefetchhit.load (std::memory_order_relaxed);
+		stats.ntile += s.tiles.size();
+		stats.mem += s.mem;
+	}
+	return stats;
+}
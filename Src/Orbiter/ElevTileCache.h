@@ -0,0 +1,123 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// ElevTileCache.h
+// Process-wide cache of elevation tiles, shared by the elevation managers
+// of all planets. Tiles are looked up by the simulation thread and loaded
+// by the elevation prefetch threads (ElevPrefetch.h).
+// =======================================================================
+
+#ifndef __ELEVTILECACHE_H
+#define __ELEVTILECACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+
+typedef std::shared_ptr<const int16_t> ElevTilePtr;
+// elevation data of a tile (read-only once cached)
+
+// =======================================================================
+// class ElevationTileCache
+// Tiles are keyed by (source, lvl, ilat, ilng), where the source is an id
+// obtained from NewSource (one per elevation manager). The key space is
+// split over NSHARD shards, each with its own lock, LRU clock and
+// statistics counters, and an equal share of the memory budget, so that
+// lookups and prefetch insertions rarely contend. Within a shard, the least recently used tiles are dropped once
+// the budget is exceeded.
+// The cache also records tiles which are known not to exist (null data),
+// so that repeated queries don't probe the tile files again.
+// Tiles are handed out as shared pointers, so evicting a tile does not
+// invalidate it for callers still using it.
+// All methods may be called concurrently. Independent of the Orbiter API.
+// =======================================================================
+
+class ElevationTileCache {
+public:
+	ElevationTileCache (size_t membudget);
+	// membudget: max. memory used by cached tiles [bytes]
+
+	~ElevationTileCache ();
+
+	static ElevationTileCache &Shared ();
+	// The cache used by all elevation managers
+
+	static unsigned int NewSource ();
+	// Returns a new, unique source id
+
+	void SetBudget (size_t membudget);
+	// Change the memory budget. Excess tiles are dropped with the next
+	// insertion into each shard.
+
+	bool Find (unsigned int src, int lvl, int ilat, int ilng, ElevTilePtr &tile);
+	// Look up a tile. Returns false if the tile is not cached. Otherwise
+	// tile receives the data, or a null pointer if the tile is known not to
+	// exist.
+
+	int Probe (unsigned int src, int lvl, int ilat, int ilng) const;
+	// As Find, but not counted in the statistics and without refreshing the
+	// tile. Returns -1 if the tile is not cached, 0 if it is known not to
+	// exist, 1 if its data are cached.
+
+	ElevTilePtr Insert (unsigned int src, int lvl, int ilat, int ilng, ElevTilePtr tile, size_t size, bool prefetched = false);
+	// Add a loaded tile with size [bytes] of data, or a null pointer for a
+	// tile which does not exist. If the tile was inserted by another thread
+	// in the meantime, the cached copy is kept and returned instead.
+	// prefetched: the tile was loaded ahead of use; the first Find for it
+	// counts as a prefetch hit.
+
+	void Drop (unsigned int src);
+	// Remove all tiles of a source
+
+	struct Stats {
+		uint64_t hits;       // successful lookups
+		uint64_t misses;     // failed lookups
+		uint64_t evictions;  // tiles dropped to stay within the budget
+		uint64_t prefetched; // tiles inserted by a prefetcher
+		uint64_t prefetchHits; // prefetched tiles subsequently found by a lookup
+		size_t ntile;        // currently cached tiles (including missing ones)
+		size_t mem;          // memory currently used [bytes]
+	};
+	Stats GetStats () const;
+	// Cache statistics for monitoring
+
+	enum { NSHARD = 16 };
+
+private:
+	struct Key {
+		unsigned int src;
+		int lvl, ilat, ilng;
+		bool operator== (const Key &k) const
+		{ return src == k.src && lvl == k.lvl && ilat == k.ilat && ilng == k.ilng; }
+	};
+	struct KeyHash {
+		size_t operator() (const Key &k) const;
+	};
+	struct Entry {
+		ElevTilePtr tile;
+		size_t size;                         // memory accounted for the entry [bytes]
+		std::atomic<uint64_t> lastuse;
+		std::atomic<bool> prefetched;        // inserted by a prefetcher and not used yet
+	};
+	struct alignas(64) Shard {               // own cache line(s), so shards don't share counters
+		mutable std::shared_mutex mtx;
+		std::unordered_map<Key, Entry, KeyHash> tiles;
+		size_t mem = 0;                      // memory used by the shard's entries [bytes]
+		std::atomic<uint64_t> tick{0};       // LRU clock of the shard's entries
+		std::atomic<uint64_t> nhit{0}, nmiss{0}, nprefetchhit{0}; // updated under the shared lock
+		uint64_t nevict = 0, nprefetch = 0;  // updated under the exclusive lock
+	};
+
+	Shard &ShardOf (const Key &key);
+	const Shard &ShardOf (const Key &key) const;
+	void Evict (Shard &shard, const Key &keep);
+
+	Shard shard[NSHARD];
+	std::atomic<size_t> maxShardMem;         // budget of each shard [bytes]
+};
+
+#endif // !__ELEVTILECACHE_H
@@ -0,0 +1,195 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Integrators.h
+// Identifiers and coefficients of the state vector propagation methods.
+// Shared by the RigidBody propagators (BodyIntegrator.cpp) and the
+// standalone propagation harness (PropHarness.cpp), so both integrate
+// with exactly the same schemes.
+// =======================================================================
+
+#ifndef __INTEGRATORS_H
+#define __INTEGRATORS_H
+
+// dynamic state propagation methods
+#define NPROP_METHOD   12
+#define PROP_RK2        0
+#define PROP_RK4        1
+#define PROP_RK5        2
+#define PROP_RK6        3
+#define PROP_RK7        4
+#define PROP_RK8        5
+#define PROP_SY2        6
+#define PROP_SY4        7
+#define PROP_SY6        8
+#define PROP_SY8        9
+#define PROP_DP5       10  // adaptive Dormand-Prince 5(4), RK5 stages
+#define PROP_RKF78     11  // adaptive Runge-Kutta-Fehlberg 7(8), RK8 stages
+
+#define PROP_ISADAPTIVE(m) ((m) >= PROP_DP5)
+
+// ===========================================================================
+// Runge-Kutta integration parameters (RK5-RK8)
+// Used by the Runge-Kutta driver routines
+// (Note that RK2 and RK4 are implemented directly without using the driver
+// routines)
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// RK5 6-stage parameters
+// ---------------------------------------------------------------------------
+
+static const int RK5_n = 6;
+static const double RK5_alpha[RK5_n-1] = {
+	1.0/5.0, 3.0/10.0, 4.0/5.0, 8.0/9.0, 1.0
+};
+static const double RK5_beta[(RK5_n-1)*(RK5_n-1)] = {
+	1.0/5.0, 0, 0, 0, 0,
+	3.0/40.0, 9.0/40.0, 0, 0, 0,
+	44.0/45.0, -56.0/15.0, 32.0/9.0, 0, 0,
+	19372.0/6561.0, -25360.0/2187.0, 64448.0/6561.0, -212.0/729.0, 0,
+	9017.0/3168.0, -355.0/33.0, 46732.0/5247.0, 49.0/176.0, -5103.0/18656.0
+};
+static const double RK5_gamma[RK5_n] = {
+	35.0/384.0, 0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0
+};
+// The RK5 stages are those of the Dormand-Prince 5(4) pair. Local error
+// estimate of the adaptive DP5 propagator (5th minus embedded 4th order
+// weights). The last entry applies to the derivative at the end of the step,
+// which is also the first stage of the next step (FSAL).
+static const double RK5_err[RK5_n+1] = {
+	71.0/57600.0, 0, -71.0/16695.0, 71.0/1920.0, -17253.0/339200.0, 22.0/525.0, -1.0/40.0
+};
+
+// ---------------------------------------------------------------------------
+// RK6 8-stage parameters
+// ---------------------------------------------------------------------------
+
+static const int RK6_n = 8;
+static const double RK6_alpha[RK6_n-1] = {
+	1.0/6.0, 4.0/15.0, 2.0/3.0, 5.0/6.0, 1.0, 1.0/15.0, 1.0
+};
+static const double RK6_beta[(RK6_n-1)*(RK6_n-1)] = {
+	1.0/6.0, 0, 0, 0, 0, 0, 0,
+	4.0/75.0, 16.0/75.0, 0, 0, 0, 0, 0,
+	5.0/6.0, -8.0/3.0, 5.0/2.0, 0, 0, 0, 0,
+	-165.0/64.0, 55.0/6.0, -425.0/64.0, 85.0/96.0, 0, 0, 0,
+	12.0/5.0, -8.0, 4015.0/612.0, -11.0/36.0, 88.0/255.0, 0, 0,
+	-8263.0/15000.0, 124.0/75.0, -643.0/680.0, -81.0/250.0, 2484.0/10625.0, 0, 0,
+	3501.0/1720.0, -300.0/43.0, 297275.0/52632.0, -319.0/2322.0, 24068.0/84065.0, 0, 3850.0/26703.0
+};
+static const double RK6_gamma[RK6_n] = {
+	3.0/40.0, 0, 875.0/2244.0, 23.0/72.0, 264.0/1955.0, 0, 125.0/11592.0, 43.0/616.0
+};
+
+// ---------------------------------------------------------------------------
+// RK7 11-stage parameters
+// ---------------------------------------------------------------------------
+
+static const int RK7_n = 11;
+static const double RK7_alpha[RK7_n-1] = {
+	2.0/27.0, 1.0/9.0, 1.0/6.0, 5.0/12.0, 1.0/2.0, 5.0/6.0, 1.0/6.0, 2.0/3.0, 1.0/3.0, 1.0
+};
+static const double RK7_beta[(RK7_n-1)*(RK7_n-1)] = {
+	2.0/27.0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1.0/36.0, 1.0/12.0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1.0/24.0, 0, 1.0/8.0, 0, 0, 0, 0, 0, 0, 0,
+	5.0/12.0, 0, -25.0/16.0, 25.0/16.0, 0, 0, 0, 0, 0, 0,
+	1.0/20.0, 0, 0, 1.0/4.0, 1.0/5.0, 0, 0, 0, 0, 0,
+	-25.0/108.0, 0, 0, 125.0/108.0, -65.0/27.0, 125.0/54.0, 0, 0, 0, 0,
+	31.0/300.0, 0, 0, 0, 61.0/225.0, -2.0/9.0, 13.0/900.0, 0, 0, 0,
+	2.0, 0, 0, -53.0/6.0, 704.0/45.0, -107.0/9.0, 67.0/90.0, 3.0, 0, 0,
+	-91.0/108.0, 0, 0, 23.0/108.0, -976.0/135.0, 311.0/54.0, -19.0/60.0, 17.0/6.0, -1.0/12.0, 0,
+	2383.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -301.0/82.0, 2133.0/4100.0, 45.0/82.0, 45.0/164.0, 18.0/41.0
+};
+static const double RK7_gamma[RK7_n] = {
+	41.0/840.0, 0, 0, 0, 0, 34.0/105.0, 9.0/35.0, 9.0/35.0, 9.0/280.0, 9.0/280.0, 41.0/840.0
+};
+
+// ---------------------------------------------------------------------------
+// RK8 13-stage parameters
+// ---------------------------------------------------------------------------
+
+static const int RK8_n = 13;
+static const double RK8_alpha[RK8_n-1] = {
+	2.0/27.0, 1.0/9.0, 1.0/6.0, 5.0/12.0, 1.0/2.0, 5.0/6.0, 1.0/6.0, 2.0/3.0, 1.0/3.0, 1.0, 0, 1.0
+};
+static const double RK8_beta[(RK8_n-1)*(RK8_n-1)] = {
+	2.0/27.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1.0/36.0, 1.0/12.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1.0/24.0, 0, 1.0/8.0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	5.0/12.0, 0, -25.0/16.0, 25.0/16.0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1.0/20.0, 0, 0, 1.0/4.0, 1.0/5.0, 0, 0, 0, 0, 0, 0, 0,
+	-25.0/108.0, 0, 0, 125.0/108.0, -65.0/27.0, 125.0/54.0, 0, 0, 0, 0, 0, 0,
+	31.0/300.0, 0, 0, 0, 61.0/225.0, -2.0/9.0, 13.0/900.0, 0, 0, 0, 0, 0,
+	2.0, 0, 0, -53.0/6.0, 704.0/45.0, -107.0/9.0, 67.0/90.0, 3.0, 0, 0, 0, 0,
+	-91.0/108.0, 0, 0, 23.0/108.0, -976.0/135.0, 311.0/54.0, -19.0/60.0, 17.0/6.0, -1.0/12.0, 0, 0, 0,
+	2383.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -301.0/82.0, 2133.0/4100.0, 45.0/82.0, 45.0/164.0, 18.0/41.0, 0, 0,
+	3.0/205.0, 0, 0, 0, 0, -6.0/41.0, -3.0/205.0, -3.0/41.0, 3.0/41.0, 6.0/41.0, 0, 0,
+	-1777.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -289.0/82.0, 2193.0/4100.0, 51.0/82.0, 33.0/164.0, 12.0/41.0, 0, 1.0
+};
+static const double RK8_gamma[RK8_n] = {
+	0, 0, 0, 0, 0, 34.0/105.0, 9.0/35.0, 9.0/35.0, 9.0/280.0, 9.0/280.0, 0, 41.0/840.0, 41.0/840.0
+};
+// RK7 and RK8 form the Fehlberg 7(8) pair. Local error estimate of the
+// adaptive RKF78 propagator (8th minus 7th order weights)
+static const double RK8_err[RK8_n] = {
+	-41.0/840.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -41.0/840.0, 41.0/840.0, 41.0/840.0
+};
+
+// ===========================================================================
+// Symplectic integration parameters (SY2-SY8)
+// c: position (drift) step fractions, d: velocity (kick) step fractions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// SY2 parameters (leapfrog)
+// ---------------------------------------------------------------------------
+
+static const double SY2_d[1] = {1.0};
+static const double SY2_c[2] = {0.5, 0.5};
+
+// ---------------------------------------------------------------------------
+// SY4 parameters
+// ---------------------------------------------------------------------------
+
+static const double SY4_b  = 1.25992104989487319066654436028;      // 2^1/3
+static const double SY4_a  = 2 - SY4_b;
+static const double SY4_x0 = -SY4_b / SY4_a;
+static const double SY4_x1 = 1. / SY4_a;
+static const double SY4_d[3] = {SY4_x1, SY4_x0, SY4_x1};
+static const double SY4_c[4] = {SY4_x1/2, (SY4_x0+SY4_x1)/2, (SY4_x0+SY4_x1)/2, SY4_x1/2};
+
+// ---------------------------------------------------------------------------
+// SY6 parameters
+// ---------------------------------------------------------------------------
+
+static const double SY6_w1 = -0.117767998417887E1;
+static const double SY6_w2 = 0.235573213359357E0;
+static const double SY6_w3 = 0.784513610477560E0;
+static const double SY6_w0 = (1-2*(SY6_w1+SY6_w2+SY6_w3));
+static const double SY6_d[7] = { SY6_w3, SY6_w2, SY6_w1, SY6_w0, SY6_w1, SY6_w2, SY6_w3 };
+static const double SY6_c[8] = { SY6_w3/2, (SY6_w3+SY6_w2)/2, (SY6_w2+SY6_w1)/2, (SY6_w1+SY6_w0)/2,
+                                 (SY6_w1+SY6_w0)/2, (SY6_w2+SY6_w1)/2, (SY6_w3+SY6_w2)/2, SY6_w3/2 };
+
+// ---------------------------------------------------------------------------
+// SY8 parameters (set 3 from Yoshida's Table 2)
+// ---------------------------------------------------------------------------
+
+static const double SY8_W1 =  0.311790812418427e0;
+static const double SY8_W2 = -0.155946803821447e1;
+static const double SY8_W3 = -0.167896928259640e1;
+static const double SY8_W4 =  0.166335809963315e1;
+static const double SY8_W5 = -0.106458714789183e1;
+static const double SY8_W6 =  0.136934946416871e1;
+static const double SY8_W7 =  0.629030650210433e0;
+static const double SY8_W0 = (1-2*(SY8_W1+SY8_W2+SY8_W3+SY8_W4+SY8_W5+SY8_W6+SY8_W7));
+static const double SY8_d[15] = { SY8_W7, SY8_W6, SY8_W5, SY8_W4, SY8_W3, SY8_W2, SY8_W1, SY8_W0,
+                                  SY8_W1, SY8_W2, SY8_W3, SY8_W4, SY8_W5, SY8_W6, SY8_W7 };
+static const double SY8_c[16] = { SY8_W7/2, (SY8_W7+SY8_W6)/2, (SY8_W6+SY8_W5)/2, (SY8_W5+SY8_W4)/2,
+                                  (SY8_W4+SY8_W3)/2, (SY8_W3+SY8_W2)/2, (SY8_W2+SY8_W1)/2, (SY8_W1+SY8_W0)/2,
+                                  (SY8_W1+SY8_W0)/2, (SY8_W2+SY8_W1)/2, (SY8_W3+SY8_W2)/2, (SY8_W4+SY8_W3)/2,
+                                  (SY8_W5+SY8_W4)/2, (SY8_W6+SY8_W5)/2, (SY8_W7+SY8_W6)/2, SY8_W7/2 };
+
+#endif // !__INTEGRATORS_H
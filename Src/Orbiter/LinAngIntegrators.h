@@ -0,0 +1,284 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// LinAngIntegrators.h
+// Propagation schemes for the linear and angular state of a rigid body.
+// Shared by the RigidBody propagators (BodyIntegrator.cpp) and the
+// standalone propagation harness (PropHarness.cpp), which only differ in
+// how the accelerations are evaluated.
+//
+// The schemes are templates over a model class M which provides
+//    void Moments (const StateVectors &s, double t, double h,
+//                  Vector &acc, Vector &arot)
+// returning the linear acceleration acc and angular acceleration arot
+// for the intermediate state s at time t, during a step of length h.
+// t is on the same scale as the time arguments of the schemes.
+// =======================================================================
+
+#ifndef __LINANGINTEGRATORS_H
+#define __LINANGINTEGRATORS_H
+
+#include <algorithm>
+#include <math.h>
+#include "Vecmat.h"
+#include "Integrators.h"
+
+// =======================================================================
+// Propagation state. Position and velocity are split into a base and an
+// increment to minimise roundoff errors; the schemes only modify the
+// increments.
+
+struct LinAngState {
+	Vector pos0, vel0;  // base position and velocity
+	Vector dpos, dvel;  // position and velocity increments
+	Quaternion Q;       // orientation
+	Vector omega;       // angular velocity
+	Vector acc, arot;   // linear and angular acceleration at the current state
+
+	inline Vector Pos () const { return pos0+dpos; }
+	inline Vector Vel () const { return vel0+dvel; }
+};
+
+// ---------------------------------------------------------------------------
+// 2nd order 2-stage Runge-Kutta
+// ---------------------------------------------------------------------------
+
+template<class M>
+void RK2_LinAng (M &m, LinAngState &x, double t, double h)
+{
+	double h05 = h*0.5;
+	Vector pos (x.Pos()), vel (x.Vel());
+
+	Vector acc1, arot1;
+	StateVectors s;
+	s.Set (vel+x.acc*h05, pos+vel*h05, x.omega+x.arot*h05, x.Q.Rot (x.omega*h05));
+	m.Moments (s, t+h05, h, acc1, arot1);
+
+	x.dpos += s.vel*h;
+	x.dvel += acc1*h;
+	x.Q.Rotate (s.omega*h);
+	x.omega += arot1*h;
+}
+
+// ---------------------------------------------------------------------------
+// 4th order 4-stage Runge-Kutta
+// ---------------------------------------------------------------------------
+
+template<class M>
+void RK4_LinAng (M &m, LinAngState &x, double t, double h)
+{
+	double h05 = h*0.5;
+	double hi6 = h/6.0;
+	Vector pos (x.Pos()), vel (x.Vel());
+
+	Vector acc1, arot1, acc2, arot2, acc3, arot3;
+	StateVectors sa, sb, sc;
+	sa.Set (vel+x.acc*h05, pos+vel*h05, x.omega+x.arot*h05, x.Q.Rot (x.omega*h05));
+	m.Moments (sa, t+h05, h, acc1, arot1);
+	sb.Set (vel+acc1*h05, pos+sa.vel*h05, x.omega+arot1*h05, x.Q.Rot (sa.omega*h05));
+	m.Moments (sb, t+h05, h, acc2, arot2);
+	sc.Set (vel+acc2*h, pos+sb.vel*h, x.omega+arot2*h, x.Q.Rot (sb.omega*h));
+	m.Moments (sc, t+h, h, acc3, arot3);
+
+	x.dvel += (x.acc+(acc1+acc2)*2.0+acc3)*hi6;
+	x.dpos += (vel+(sa.vel+sb.vel)*2.0+sc.vel)*hi6;
+	x.Q.Rotate ((x.omega+(sa.omega+sb.omega)*2.0+sc.omega)*hi6);
+	x.omega += (x.arot+(arot1+arot2)*2.0+arot3)*hi6;
+}
+
+// ---------------------------------------------------------------------------
+// Driver routine for Runge-Kutta solvers RK5-RK8 (n <= RK8_n stages)
+// ---------------------------------------------------------------------------
+
+template<class M>
+void RKdrv_LinAng (M &m, LinAngState &x, double t, double h, int n, const double *alpha, const double *beta, const double *gamma)
+{
+	StateVectors s[RK8_n];
+	Vector a[RK8_n]; // linear acceleration
+	Vector d[RK8_n]; // angular acceleration
+	Vector pos (x.Pos()), vel (x.Vel());
+
+	s[0].Set (vel, pos, x.omega, x.Q);
+	a[0] = x.acc;
+	d[0] = x.arot;
+	for (int i = 1; i < n; i++) {
+		s[i].Set (vel, pos, x.omega, x.Q);
+		for (int j = 0; j < i; j++)
+			s[i].Advance (beta[j]*h, a[j], s[j].vel, d[j], s[j].omega);
+		m.Moments (s[i], t+alpha[i-1]*h, h, a[i], d[i]);
+		beta += n-1;
+	}
+	for (int i = 0; i < n; i++) {
+		double bh = gamma[i]*h;
+		x.dvel += a[i]*bh;
+		x.dpos += s[i].vel*bh;
+		x.Q.Rotate (s[i].omega*bh);
+		x.omega += d[i]*bh;
+	}
+}
+
+// ---------------------------------------------------------------------------
+// Driver routine for the symplectic solvers SY2-SY8: n alternating drift (c)
+// and n-1 kick (d) steps
+// Note: the propagation of angular state is guesswork ...
+// ---------------------------------------------------------------------------
+
+template<class M>
+void SYdrv_LinAng (M &m, LinAngState &x, double t, double h, int n, const double *c, const double *d)
+{
+	double sec = 0.0;
+	StateVectors s;
+	for (int i = 0; i < n; i++) {
+		double step = h*c[i];
+		x.dpos += x.Vel()*step;
+		x.Q.Rotate (x.omega*step);
+		sec += c[i];
+		if (i != n-1) {
+			s.Set (x.Vel(), x.Pos(), x.omega, x.Q);
+			m.Moments (s, t+sec*h, h, x.acc, x.arot);
+			x.dvel += x.acc*(h*d[i]);
+			x.omega += x.arot*(h*d[i]);
+		}
+	}
+}
+
+// ---------------------------------------------------------------------------
+// Step of length h from time t with a fixed-step method (PROP_xxx; the
+// adaptive methods use their RK5/RK8 stages without error control).
+// acc and arot are updated to the end of the step.
+// ---------------------------------------------------------------------------
+
+template<class M>
+void Step_LinAng (M &m, LinAngState &x, int method, double t, double h)
+{
+	switch (method) {
+	case PROP_RK2:   RK2_LinAng (m, x, t, h); break;
+	case PROP_RK5:
+	case PROP_DP5:   RKdrv_LinAng (m, x, t, h, RK5_n, RK5_alpha, RK5_beta, RK5_gamma); break;
+	case PROP_RK6:   RKdrv_LinAng (m, x, t, h, RK6_n, RK6_alpha, RK6_beta, RK6_gamma); break;
+	case PROP_RK7:   RKdrv_LinAng (m, x, t, h, RK7_n, RK7_alpha, RK7_beta, RK7_gamma); break;
+	case PROP_RK8:
+	case PROP_RKF78: RKdrv_LinAng (m, x, t, h, RK8_n, RK8_alpha, RK8_beta, RK8_gamma); break;
+	case PROP_SY2:   SYdrv_LinAng (m, x, t, h, 2, SY2_c, SY2_d); break;
+	case PROP_SY4:   SYdrv_LinAng (m, x, t, h, 4, SY4_c, SY4_d); break;
+	case PROP_SY6:   SYdrv_LinAng (m, x, t, h, 8, SY6_c, SY6_d); break;
+	case PROP_SY8:   SYdrv_LinAng (m, x, t, h, 16, SY8_c, SY8_d); break;
+	default:         RK4_LinAng (m, x, t, h); break;
+	}
+	StateVectors s;
+	s.Set (x.Vel(), x.Pos(), x.omega, x.Q);
+	m.Moments (s, t+h, h, x.acc, x.arot);
+}
+
+// ---------------------------------------------------------------------------
+// Adaptive embedded Runge-Kutta propagation
+// DP5: Dormand-Prince 5(4) on the RK5 stages, FSAL
+// RKF78: Runge-Kutta-Fehlberg 7(8) on the RK8 stages
+// Covers the interval [t0,t0+T] with error-controlled substeps of at least
+// T/RKADAPT_MAXSTEP. The local error is measured relative to the position
+// and velocity scales rscale and vscale, with relative tolerance tol.
+// atgt > 0 limits the rotation angle per substep. h is the initial substep
+// length (<= 0: T), and returns the length proposed for the next call.
+// Returns the number of accepted substeps.
+// ---------------------------------------------------------------------------
+
+#define RKADAPT_MAXSTEP 1000
+
+template<class M>
+int RKadapt_LinAng (M &m, LinAngState &x, int method, double t0, double T, double tol,
+	double rscale, double vscale, double atgt, double &h)
+{
+	const double *alpha, *beta, *gamma, *err;
+	int n, order;
+	bool fsal;
+	if (method == PROP_DP5) {
+		n = RK5_n, alpha = RK5_alpha, beta = RK5_beta, gamma = RK5_gamma, err = RK5_err;
+		order = 4, fsal = true;
+	} else {
+		n = RK8_n, alpha = RK8_alpha, beta = RK8_beta, gamma = RK8_gamma, err = RK8_err;
+		order = 7, fsal = false;
+	}
+
+	StateVectors s[RK8_n];
+	Vector a[RK8_n]; // linear acceleration
+	Vector d[RK8_n]; // angular acceleration
+	StateVectors s_end;
+	Vector acc_end, arot_end;
+
+	double t = 0.0;
+	double hmin = T/RKADAPT_MAXSTEP;
+	if (h <= 0.0) h = T;
+	int nacc = 0;
+
+	while (t < T) {
+		double w = x.omega.length();
+		double hs = (atgt > 0.0 && w*h > atgt ? atgt/w : h); // angular step target
+		hs = std::min (std::max (hmin, hs), T-t); // never step past the end of the interval
+		Vector pos (x.Pos()), vel (x.Vel());
+
+		// stages
+		const double *b = beta;
+		s[0].Set (vel, pos, x.omega, x.Q);
+		a[0] = x.acc;
+		d[0] = x.arot;
+		for (int i = 1; i < n; i++) {
+			s[i].Set (vel, pos, x.omega, x.Q);
+			for (int j = 0; j < i; j++)
+				s[i].Advance (b[j]*hs, a[j], s[j].vel, d[j], s[j].omega);
+			m.Moments (s[i], t0+t+alpha[i-1]*hs, hs, a[i], d[i]);
+			b += n-1;
+		}
+
+		// solution and error estimate
+		Vector dpos, dvel, domega, epos, evel, eomega;
+		Quaternion Q (x.Q);
+		for (int i = 0; i < n; i++) {
+			double gh = gamma[i]*hs, eh = err[i]*hs;
+			dpos   += s[i].vel * gh;
+			dvel   += a[i]     * gh;
+			domega += d[i]     * gh;
+			Q.Rotate (s[i].omega * gh);
+			epos   += s[i].vel * eh;
+			evel   += a[i]     * eh;
+			eomega += d[i]     * eh;
+		}
+		s_end.Set (vel+dvel, pos+dpos, x.omega+domega, Q);
+		if (fsal) { // the end point derivative is part of the error estimate, and the first stage of the next step
+			double eh = err[n]*hs;
+			m.Moments (s_end, t0+t+hs, hs, acc_end, arot_end);
+			epos   += s_end.vel * eh;
+			evel   += acc_end   * eh;
+			eomega += arot_end  * eh;
+		}
+		double e = std::max (epos.length() / (tol*rscale),
+			                 evel.length() / (tol*(vscale + x.acc.length()*hs)));
+		if (w) e = std::max (e, eomega.length() / (tol*(w + x.arot.length()*hs)));
+		double fac = (e > 0.0 ? 0.9*pow (e, -1.0/(order+1)) : 5.0);
+		fac = std::max (0.2, std::min (5.0, fac));
+
+		if (e <= 1.0 || hs <= hmin) { // accept
+			x.dpos += dpos;
+			x.dvel += dvel;
+			x.omega = s_end.omega;
+			x.Q = Q;
+			t += hs;
+			if (t > T*(1.0-1e-12)) t = T;
+			if (fsal) {
+				x.acc = acc_end;
+				x.arot = arot_end;
+			} else {
+				s_end.Set (x.Vel(), x.Pos(), x.omega, x.Q);
+				m.Moments (s_end, t0+t, hs, x.acc, x.arot);
+			}
+			nacc++;
+			if (hs < h && fac >= 1.0) h = std::max (h, hs*fac); // truncated step: keep the proposal
+			else h = hs*fac;
+		} else {
+			h = hs*fac;
+		}
+	}
+	return nacc;
+}
+
+#endif // !__LINANGINTEGRATORS_H
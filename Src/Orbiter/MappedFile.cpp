@@ -0,0 +1,163 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// MappedFile.cpp
+// Read-only memory mapping of a complete file, or positional reads from
+// the file where a mapping isn't wanted or can't be made.
+// =======================================================================
+
+#include "MappedFile.h"
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile ()
+{
+	data = 0;
+	size = 0;
+#ifdef _WIN32
+	hFile = INVALID_HANDLE_VALUE;
+	hMap = NULL;
+#else
+	fd = -1;
+#endif
+}
+
+MappedFile::~MappedFile ()
+{
+	Close ();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open (const char *fname, bool map)
+{
+	Close ();
+	hFile = CreateFileA (fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fsize;
+	if (!GetFileSizeEx (hFile, &fsize) || !fsize.QuadPart) {
+		Close ();
+		return false;
+	}
+	size = (uint64_t)fsize.QuadPart;
+	if (!map) return true;
+
+	if (size > (uint64_t)(size_t)-1) { // can't be addressed by this process
+		Close ();
+		return false;
+	}
+	hMap = CreateFileMappingA (hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!hMap) {
+		Close ();
+		return false;
+	}
+	data = (const unsigned char*)MapViewOfFile (hMap, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		Close ();
+		return false;
+	}
+	return true;
+}
+
+bool MappedFile::Read (uint64_t ofs, void *buf, size_t n) const
+{
+	if (ofs > size || n > size-ofs) return false;
+	if (data) {
+		memcpy (buf, data+ofs, n);
+		return true;
+	}
+	if (hFile == INVALID_HANDLE_VALUE) return false;
+	// The offset is passed with each read, so concurrent reads don't
+	// depend on the shared file pointer
+	BYTE *p = (BYTE*)buf;
+	while (n) {
+		OVERLAPPED ov = {};
+		ov.Offset = (DWORD)ofs;
+		ov.OffsetHigh = (DWORD)(ofs >> 32);
+		DWORD nread, nreq = (DWORD)(n < 0x40000000 ? n : 0x40000000);
+		if (!ReadFile (hFile, p, nreq, &nread, &ov) || !nread) return false;
+		p += nread, ofs += nread, n -= nread;
+	}
+	return true;
+}
+
+void MappedFile::Close ()
+{
+	if (data) UnmapViewOfFile (data);
+	if (hMap) CloseHandle (hMap);
+	if (hFile != INVALID_HANDLE_VALUE) CloseHandle (hFile);
+	data = 0;
+	size = 0;
+	hMap = NULL;
+	hFile = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::Open (const char *fname, bool map)
+{
+	Close ();
+	fd = open (fname, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat (fd, &st) || !st.st_size) {
+		Close ();
+		return false;
+	}
+	size = (uint64_t)st.st_size;
+	if (!map) return true;
+
+	if (size > (uint64_t)(size_t)-1) { // can't be addressed by this process
+		Close ();
+		return false;
+	}
+	void *p = mmap (0, (size_t)size, PROT_READ, MAP_SHARED, fd, 0);
+	close (fd); // the mapping keeps its own reference to the file
+	fd = -1;
+	if (p == MAP_FAILED) {
+		Close ();
+		return false;
+	}
+	data = (const unsigned char*)p;
+	return true;
+}
+
+bool MappedFile::Read (uint64_t ofs, void *buf, size_t n) const
+{
+	if (ofs > size || n > size-ofs) return false;
+	if (data) {
+		memcpy (buf, data+ofs, n);
+		return true;
+	}
+	if (fd < 0) return false;
+	unsigned char *p = (unsigned char*)buf;
+	while (n) {
+		ssize_t nread = pread (fd, p, n, (off_t)ofs);
+		if (nread < 0 && errno == EINTR) continue;
+		if (nread <= 0) return false;
+		p += nread, ofs += nread, n -= nread;
+	}
+	return true;
+}
+
+void MappedFile::Close ()
+{
+	if (data) munmap ((void*)data, (size_t)size);
+	if (fd >= 0) close (fd);
+	data = 0;
+	size = 0;
+	fd = -1;
+}
+
+#endif
@@ -0,0 +1,54 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// MappedFile.h
+// Read-only memory mapping of a complete file, or positional reads from
+// the file where a mapping isn't wanted or can't be made.
+// =======================================================================
+
+#ifndef __MAPPEDFILE_H
+#define __MAPPEDFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class MappedFile {
+public:
+	MappedFile ();
+	~MappedFile ();
+
+	bool Open (const char *fname, bool map = true);
+	// Open the file read-only. With map=true the whole file is mapped, and
+	// Open returns false if the mapping fails. With map=false the file is
+	// only opened for Read. Returns false if the file can't be opened (or is
+	// empty). Any previously opened file is released first.
+
+	void Close ();
+
+	bool Read (uint64_t ofs, void *buf, size_t n) const;
+	// Copy n bytes from file offset ofs into buf, from the mapping or with a
+	// positional read. Returns false if the range isn't inside the file or
+	// can't be read. May be called concurrently.
+
+	bool IsOpen () const { return size != 0; }
+	bool IsMapped () const { return data != 0; }
+	const unsigned char *Data () const { return data; }
+	// start of the mapping (NULL if the file is not mapped)
+	uint64_t Size () const { return size; }
+
+private:
+	MappedFile (const MappedFile&) = delete;
+	MappedFile &operator= (const MappedFile&) = delete;
+
+	const unsigned char *data;
+	uint64_t size;
+#ifdef _WIN32
+	void *hFile;
+	void *hMap;
+#else
+	int fd;
+#endif
+};
+
+#endif // !__MAPPEDFILE_H
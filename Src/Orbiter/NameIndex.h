@@ -0,0 +1,88 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// NameIndex.h
+// Hash index of named objects, used by PlanetarySystem for its name
+// lookups (objects and surface bases).
+// =======================================================================
+
+#ifndef __NAMEINDEX_H
+#define __NAMEINDEX_H
+
+#include <ctype.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// =======================================================================
+// class NameIndex
+// Objects of type T (which provides const char *Name() const) are keyed
+// by their lower-case name. Objects sharing a key are kept in order of
+// registration. A case-insensitive lookup returns the first object
+// registered under the key, a case-sensitive lookup the first one whose
+// name matches exactly. The name of an object must not change while it is
+// registered. Independent of the Orbiter API.
+// =======================================================================
+
+template<class T>
+class NameIndex {
+public:
+	NameIndex (): nobj(0) {}
+
+	void Add (T *obj)
+	{
+		index[Key (obj->Name())].push_back (obj);
+		nobj++;
+	}
+
+	bool Remove (T *obj)
+	// Returns false if obj is not registered
+	{
+		auto it = index.find (Key (obj->Name()));
+		if (it == index.end()) return false;
+		auto &entry = it->second;
+		auto e = std::find (entry.begin(), entry.end(), obj);
+		if (e == entry.end()) return false;
+		entry.erase (e);
+		if (entry.empty()) index.erase (it);
+		nobj--;
+		return true;
+	}
+
+	void Clear ()
+	{
+		index.clear();
+		nobj = 0;
+	}
+
+	T *Find (const char *name, bool ignorecase, bool (*match)(const T*) = 0) const
+	// First object with this name for which match (if provided) returns true
+	{
+		auto it = index.find (Key (name));
+		if (it == index.end()) return 0;
+		for (T *obj : it->second)
+			if ((ignorecase || !strcmp (obj->Name(), name)) && (!match || match (obj)))
+				return obj;
+		return 0;
+	}
+
+	size_t size () const { return nobj; }
+	// number of registered objects
+
+	static std::string Key (const char *name)
+	// index key for an object name
+	{
+		std::string key (name);
+		for (auto &c : key) c = (char)tolower ((unsigned char)c);
+		return key;
+	}
+
+private:
+	std::unordered_map<std::string, std::vector<T*> > index;
+	size_t nobj;
+};
+
+#endif // !__NAMEINDEX_H
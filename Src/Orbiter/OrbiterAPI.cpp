@@ -1212,6 +1212,22 @@ DLLEXPORT double oapiGetPlanetJCoeff (OBJHANDLE hPlanet, DWORD n)
 	return (n < cb->nJcoeff() ? cb->Jcoeff(n) : 0.0);
 }
 
+DLLEXPORT bool oapiGetPlanetEphemeris (OBJHANDLE hPlanet, int n, const double *mjd, VECTOR3 *pos, VECTOR3 *vel)
+{
+	const int nchunk = 64;
+	Vector p[nchunk], v[nchunk];
+	CelestialBody *cb = (CelestialBody*)hPlanet;
+	for (int i = 0, m; i < n; i += m) {
+		m = (n-i < nchunk ? n-i : nchunk);
+		if (!cb->PosVelAtMJD (m, mjd+i, p, vel ? v : 0)) return false;
+		for (int j = 0; j < m; j++) {
+			pos[i+j] = MakeVECTOR3 (p[j]);
+			if (vel) vel[i+j] = MakeVECTOR3 (v[j]);
+		}
+	}
+	return true;
+}
+
 // Elevation support interface
 DLLEXPORT ELEVHANDLE oapiElevationManager (OBJHANDLE hPlanet)
 {
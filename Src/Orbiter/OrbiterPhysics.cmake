@@ -0,0 +1,34 @@
+# Copyright (c) Martin Schweiger
+# Licensed under the MIT License
+
+# Headless physics library: the propagation support and gravity models shared
+# with the simulation core, the standalone propagation harness (PropHarness.h)
+# and the support code they need, without Win32, graphics or simulation
+# globals. Used by the batch propagator and the tests, and can be built on its
+# own on any platform (see Utils/propbatch).
+
+if(NOT TARGET OrbiterPhysics)
+	find_package(Threads REQUIRED)
+
+	add_library(OrbiterPhysics STATIC
+		${CMAKE_CURRENT_LIST_DIR}/MappedFile.cpp
+		${CMAKE_CURRENT_LIST_DIR}/PhysicsCore.cpp
+		${CMAKE_CURRENT_LIST_DIR}/PinesGrav.cpp
+		${CMAKE_CURRENT_LIST_DIR}/PropHarness.cpp
+		${CMAKE_CURRENT_LIST_DIR}/Vecmat.cpp
+		${CMAKE_CURRENT_LIST_DIR}/WorkerPool.cpp
+	)
+
+	target_include_directories(OrbiterPhysics
+		PUBLIC ${CMAKE_CURRENT_LIST_DIR}
+	)
+
+	target_link_libraries(OrbiterPhysics
+		PUBLIC Threads::Threads
+	)
+
+	set_target_properties(OrbiterPhysics
+		PROPERTIES
+		FOLDER Core
+	)
+endif()
@@ -0,0 +1,89 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// PhysicsCore.cpp
+// Orbit propagation support (see PhysicsCore.h)
+// =======================================================================
+
+#include "PhysicsCore.h"
+#include <algorithm>
+
+// =======================================================================
+// class SecularDrift
+
+// Rotation of v by angle phi about unit axis u, in the sense of the orbits
+// whose normal crossp(vel,pos) is u
+static Vector RotateOrbit (const Vector &v, const Vector &u, double phi)
+{
+	double c = cos(phi), s = sin(phi);
+	return v*c + crossp (v, u)*s + u*(dotp (u, v)*(1.0-c));
+}
+
+// Mean motion, eccentricity, semi-latus rectum and unit normal of an orbit
+static void OrbitShape (double mu, const Vector &pos, const Vector &vel,
+	double &n, double &e, double &p, Vector &nml)
+{
+	Vector h = crossp (vel, pos);
+	double r = pos.length();
+	double a = 1.0 / (2.0/r - dotp (vel, vel)/mu);
+	p = dotp (h, h)/mu;
+	e = sqrt (std::max (0.0, 1.0 - p/a));
+	n = sqrt (mu/(a*a*a));
+	nml = h.unit();
+}
+
+void SecularDrift::AddOblateness (double mu, const Vector &pos, const Vector &vel, double J2, double R, const Vector &pole)
+{
+	double n, e, p;
+	Vector nml;
+	OrbitShape (mu, pos, vel, n, e, p, nml);
+	double cosi = dotp (nml, pole), cosi2 = cosi*cosi;
+	double k = n*J2*(R*R)/(p*p);
+	wnode += pole * (-1.5*k*cosi);
+	wapse += 0.75*k*(5.0*cosi2 - 1.0);
+	dn    += 0.75*k*sqrt (1.0-e*e)*(3.0*cosi2 - 1.0);
+}
+
+void SecularDrift::AddThirdBody (double mu, const Vector &pos, const Vector &vel, double mu3, const Vector &pos3, const Vector &vel3)
+{
+	double n, e, p;
+	Vector nml;
+	OrbitShape (mu, pos, vel, n, e, p, nml);
+	Vector nml3 = crossp (vel3, pos3).unit();
+	double r3 = pos3.length();
+	double k = mu3/(r3*r3*r3*n);
+	double e2 = e*e, se = sqrt (1.0-e2);
+	double cosi = dotp (nml, nml3), cosi2 = cosi*cosi;
+	wnode += nml3 * (-0.75*k*(1.0+1.5*e2)*cosi/se);
+	wapse += 0.75*k*(2.0 - 2.5*(1.0-cosi2) + 0.5*e2)/se;
+	dn    -= 0.125*k*(3.0*cosi2 - 1.0)*(7.0 + 3.0*e2);
+}
+
+void SecularDrift::Apply (double dt, Vector &pos, Vector &vel) const
+{
+	if (wapse) {
+		Vector nml = crossp (vel, pos).unit();
+		pos = RotateOrbit (pos, nml, wapse*dt);
+		vel = RotateOrbit (vel, nml, wapse*dt);
+	}
+	double w = wnode.length();
+	if (w) {
+		Vector axis = wnode/w;
+		pos = RotateOrbit (pos, axis, w*dt);
+		vel = RotateOrbit (vel, axis, w*dt);
+	}
+}
+
+// =======================================================================
+// class StepInterpolant
+
+void StepInterpolant::Setup (const Vector &p0, const Vector &v0, const Vector &p1, const Vector &v1, double dt)
+{
+	Vector dp (p1-p0), w0 (v0*dt), w1 (v1*dt);
+	a = p0;
+	b = w0;
+	c = dp*3.0 - w0*2.0 - w1;
+	d = w0 + w1 - dp*2.0;
+	idt = (dt ? 1.0/dt : 0.0);
+}
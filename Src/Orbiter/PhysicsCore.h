@@ -0,0 +1,79 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// PhysicsCore.h
+// Orbit propagation support shared by the simulation core and the
+// standalone tools: the secular perturbation rates used for fast-forward
+// propagation (RigidBody) and the step interpolant of the celestial body
+// positions (CelestialBody).
+// Free of Win32, graphics and simulation globals (g_pOrbiter, td, g_psys),
+// so it can be built on any platform. Units and frames follow the
+// simulation core: SI units, left-handed ecliptic frame.
+// =======================================================================
+
+#ifndef __PHYSICSCORE_H
+#define __PHYSICSCORE_H
+
+#include "Vecmat.h"
+
+// =======================================================================
+// Averaged (secular) perturbations of an elliptic orbit, for propagating
+// the orbit analytically over long steps ("fast-forward" mode). The rates
+// are the orbit-averaged first-order effects of the central body's J2 and
+// of distant third bodies; short-periodic terms are ignored, so osculating
+// elements are treated as mean elements.
+// Vectors follow the left-handed convention of class Elements: the orbit
+// normal is crossp(vel,pos), and a positive rotation about an axis is
+// prograde for an orbit whose normal points along it.
+
+struct SecularDrift {
+	Vector wnode;  // precession rate vector of the orbital plane [rad/s]
+	double wapse;  // apsidal rotation rate within the orbital plane [rad/s]
+	double dn;     // mean motion correction [rad/s]
+
+	SecularDrift (): wapse(0.0), dn(0.0) {}
+
+	void AddOblateness (double mu, const Vector &pos, const Vector &vel, double J2, double R, const Vector &pole);
+	// Add the J2 rates of a central body with mean radius R and rotation
+	// axis pole (unit vector), for the orbit given by pos,vel relative to it
+
+	void AddThirdBody (double mu, const Vector &pos, const Vector &vel, double mu3, const Vector &pos3, const Vector &vel3);
+	// Add the rates due to a body with gravitational parameter mu3 at
+	// pos3, moving with vel3 relative to the central body (quadrupole
+	// approximation, averaged over both orbits)
+
+	void Apply (double dt, Vector &pos, Vector &vel) const;
+	// Rotate a state by the apsidal and nodal drift accumulated over dt.
+	// The Kepler motion itself is left to the caller, which should advance
+	// the mean anomaly by (n+dn)*dt.
+};
+
+// =======================================================================
+// Cubic Hermite interpolant of a body's motion over one time step, from
+// the positions and velocities at both ends. Used for the positions of
+// the celestial bodies at the intermediate stages of the propagators.
+// The interpolant is linear in the states, so it can be applied to global
+// positions directly: the sum of the interpolants of a moon relative to
+// its planet and of the planet equals the interpolant of the moon.
+
+class StepInterpolant {
+public:
+	StepInterpolant (): idt(0.0) {}
+
+	void Setup (const Vector &p0, const Vector &v0, const Vector &p1, const Vector &v1, double dt);
+	// p0, v0: state at the start of the step, p1, v1: state at the end,
+	// dt: step length [s]
+
+	inline Vector Pos (double n) const { return a + (b + (c + d*n)*n)*n; }
+	// Position at fractional step n (0 = start, 1 = end)
+
+	inline Vector Vel (double n) const { return (b + (c*2.0 + d*(3.0*n))*n)*idt; }
+	// Velocity at fractional step n (undefined for dt = 0)
+
+private:
+	Vector a, b, c, d;  // polynomial coefficients in n
+	double idt;         // 1/dt
+};
+
+#endif // !__PHYSICSCORE_H
@@ -20,11 +20,25 @@
 */
 
 
-#include <fstream>
+#include <stdio.h>
+#include <new>
 #include <cmath>
+#include <algorithm>
+#include <mutex>
+#include <string.h>
+#include <filesystem>
 #include "Vecmat.h"
 #include "PinesGrav.h"
-#include "Orbiter.h"
+
+#ifndef _WIN32
+// the gravity model is also part of the headless physics library
+#include <errno.h>
+static inline int fopen_s(FILE** f, const char* name, const char* mode)
+{
+	*f = fopen(name, mode);
+	return *f ? 0 : errno;
+}
+#endif
 
 PinesGravProp::PinesGravProp(CelestialBody* celestialbody)
 {
@@ -39,75 +53,186 @@ PinesGravProp::PinesGravProp(CelestialBody* celestialbody)
 	referenceLon = 0.0;
 	C = NULL;
 	S = NULL;
-	A = NULL;
-	R = NULL;
-	I = NULL;
 	numCoeff = 0;
 	CoeffCutoff = 0;
-
-	r = 0.0;
-	s = 0.0;
-	t = 0.0;
-	u = 0.0;
-	rho = 0.0;
-	rhop = 0.0;
-
-	g1temp = 0.0;
-	g2temp = 0.0;
-	g3temp = 0.0;
-	g4temp = 0.0;
-
-	g1 = 0.0;
-	g2 = 0.0;
-	g3 = 0.0;
-	g4 = 0.0;
+	srcSize = 0;
+
+	Adiag = NULL;
+	Aoff = NULL;
+	ALPHA = NULL;
+	BETA = NULL;
+	GALPHA = NULL;
+	Ccol = NULL;
+	Scol = NULL;
+	colOfs = NULL;
+	degRMS = NULL;
 }
 
 PinesGravProp::~PinesGravProp()
 {
-	delete[] C;
-	delete[] S;
-	delete[] A;
-	delete[] R;
-	delete[] I;
+	if (!coeffFile.IsOpen()) {
+		delete[] C;
+		delete[] S;
+	}
+	FreeTables();
+}
+
+void PinesGravWorkspace::Reserve(int maxDegree)
+{
+	if (maxDegree <= capacity) return;
+	size_t n = (size_t)maxDegree;
+	A.resize((n + 3) * (n + 4) / 2);
+	R.resize(n + 2);
+	I.resize(n + 2);
+	W.resize((n + 2) * 3 * PINES_LANES);
+	capacity = maxDegree;
+}
+
+static PinesGravWorkspace& ThreadWorkspace()
+{
+	thread_local PinesGravWorkspace ws;
+	return ws;
 }
 
-inline void PinesGravProp::GenerateAssocLegendreMatrix(int maxDegree)
+inline void PinesGravProp::GenerateAssocLegendreMatrix(double* __restrict A, double u, int maxDegree) const
 {
 	A[0] = sqrt(2.0);
 
 	for (int m = 0; m <= (maxDegree + 2); m++) {
 
 		if (m != 0) {
-			A[NM(m, m)] = sqrt(1. + (1. / (2. * (double)m))) * A[NM(m - 1, m - 1)]; // diagonal terms
+			A[NM(m, m)] = Adiag[m] * A[NM(m - 1, m - 1)]; // diagonal terms
 		}
 
 		if (m != (maxDegree + 2)) {
-			A[NM(m + 1, m)] = sqrt(2. * (double)m + 3.) * u * A[NM(m, m)]; // off-diagonal terms
+			A[NM(m + 1, m)] = Aoff[m] * u * A[NM(m, m)]; // off-diagonal terms
 		}
 
 		if (m < maxDegree + 1) {
 			for (int n = m + 2; n <= (maxDegree + 2); n++) {
+				A[NM(n, m)] = ALPHA[NM(n, m)] * u * A[NM(n - 1, m)] - BETA[NM(n, m)] * A[NM(n - 2, m)]; // remaining terms in the column
+			}
+		}
+	}
+
+	for (int n = 0; n <= (maxDegree + 2); n++) {
+		A[NM(n, 0)] = A[NM(n, 0)] * sqrt(0.5);
+	}
+
+}
+
+void PinesGravProp::GenerateRecurrenceTables()
+{
+	// All factors of the Legendre recurrence and of the gradient sum depend only on
+	// n and m, so they are evaluated once here instead of on every call.
+	unsigned int nmax = CoeffCutoff + 2;
+
+	for (unsigned int m = 0; m <= nmax; m++) {
+		Adiag[m] = (m ? sqrt(1. + (1. / (2. * (double)m))) : 0.0);
+		Aoff[m] = sqrt(2. * (double)m + 3.);
+	}
+
+	for (unsigned int n = 0; n <= nmax; n++) {
+		for (unsigned int m = 0; m <= n; m++) {
+			if (n >= m + 2) {
 				double ALPHA_NUM = (2. * (double)n + 1.) * (2. * (double)n - 1.);
 				double ALPHA_DEN = ((double)n - (double)m) * ((double)n + (double)m);
-				double ALPHA = sqrt(ALPHA_NUM / ALPHA_DEN);
 				double BETA_NUM = (2. * (double)n + 1.) * ((double)n - (double)m - 1.) * ((double)n + (double)m - 1.);
 				double BETA_DEN = (2. * (double)n - 3.) * ((double)n + (double)m) * ((double)n - (double)m);
-				double BETA = sqrt(BETA_NUM / BETA_DEN);
+				ALPHA[NM(n, m)] = sqrt(ALPHA_NUM / ALPHA_DEN);
+				BETA[NM(n, m)] = sqrt(BETA_NUM / BETA_DEN);
+			}
+			else {
+				ALPHA[NM(n, m)] = 0.0;
+				BETA[NM(n, m)] = 0.0;
+			}
+		}
+	}
 
+	for (unsigned int n = 0; n <= CoeffCutoff; n++) {
+		for (unsigned int m = 0; m <= n; m++) {
+			double SM = (m ? 1.0 : 0.5);
+			GALPHA[NM(n, m)] = sqrt(SM * ((double)n - (double)m) * ((double)n + (double)m + 1));
+		}
+	}
 
-				A[NM(n, m)] = ALPHA * u * A[NM(n - 1, m)] - BETA * A[NM(n - 2, m)]; // remaining terms in the column
-			}
+	// column-major copy of the coefficients: column m holds degrees m..CoeffCutoff
+	unsigned int ofs = 0;
+	for (unsigned int m = 0; m <= CoeffCutoff; m++) {
+		colOfs[m] = ofs;
+		for (unsigned int n = m; n <= CoeffCutoff; n++) {
+			Ccol[ofs] = C[NM(n, m)];
+			Scol[ofs] = S[NM(n, m)];
+			ofs++;
 		}
 	}
 
-	for (int n = 0; n <= (maxDegree + 2); n++) {
-		A[NM(n, 0)] = A[NM(n, 0)] * sqrt(0.5);
+	// coefficient power per degree, for choosing the truncation degree
+	for (unsigned int n = 0; n <= CoeffCutoff; n++) {
+		double sum = 0.0;
+		for (unsigned int m = 0; m <= n; m++)
+			sum += C[NM(n, m)] * C[NM(n, m)] + S[NM(n, m)] * S[NM(n, m)];
+		degRMS[n] = sqrt(sum);
 	}
+}
 
+int PinesGravProp::GetTruncationDegree(double r, double tol) const
+{
+	// Degree n contributes about GM/r^2 (n+1) (R/r)^n degRMS[n] to the acceleration.
+	// Accumulate from the top until the dropped part reaches the tolerance.
+	double q = refRad / r;
+	if (q >= 1.0) return CoeffCutoff; // inside the reference sphere: series converges slowly, use everything
+	double g0 = GM / (r * r);
+	int n0 = (int)std::min((double)CoeffCutoff, -600.0 / log(q)); // skip terms that would underflow
+	double qn = pow(q, (double)n0);
+	double err = 0.0;
+	for (int n = n0; n > 0; n--) {
+		err += g0 * (n + 1) * qn * degRMS[n];
+		if (err > tol) return n;
+		qn /= q;
+	}
+	return 0;
 }
 
 int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTerms, int &maxModelTerms)
+{
+	// prefer a precompiled binary file next to the text file
+	char binname[512];
+	strncpy(binname, filename, 507);
+	binname[507] = '\0';
+	char* ext = strrchr(binname, '.');
+	char* sep = std::max(strrchr(binname, '\\'), strrchr(binname, '/'));
+	if (!ext || (sep && ext < sep)) ext = binname + strlen(binname);
+	strcpy(ext, ".pgb");
+	if (IsGravModelBinCurrent(binname, filename) &&
+		readGravModelBin(binname, cutoff, actualLoadedTerms, maxModelTerms) == 0)
+		return 0;
+
+	return readGravModelText(filename, cutoff, actualLoadedTerms, maxModelTerms);
+}
+
+bool PinesGravProp::IsGravModelBinCurrent(const char* binname, const char* txtname)
+{
+	namespace fs = std::filesystem;
+	std::error_code ecbin, ectxt;
+	fs::file_time_type tbin = fs::last_write_time(binname, ecbin);
+	fs::file_time_type ttxt = fs::last_write_time(txtname, ectxt);
+	if (ecbin) return false; // no binary file
+	if (ectxt) return true;  // binary file without the text file
+	if (tbin < ttxt) return false;
+
+	uintmax_t txtsize = fs::file_size(txtname, ectxt);
+	PinesGravFileHeader hdr;
+	FILE* f = nullptr;
+	if (ectxt || fopen_s(&f, binname, "rb") || !f)
+		return false;
+	bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1 &&
+		hdr.version == PINES_FILE_VERSION && hdr.srcSize == (uint64_t)txtsize;
+	fclose(f);
+	return ok;
+}
+
+int PinesGravProp::readGravModelText(const char* filename, int cutoff, int &actualLoadedTerms, int &maxModelTerms)
 {
 	FILE* gravModelFile = nullptr;
 	char gravFileLine[512];
@@ -120,9 +245,6 @@ int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTe
 	try {
 		C = new double[(size_t)NM(cutoff + 1, cutoff + 1)];
 		S = new double[(size_t)NM(cutoff + 1, cutoff + 1)];
-		R = new double[(size_t)cutoff + 2];
-		I = new double[(size_t)cutoff + 2];
-		A = new double[NM((size_t)cutoff + 3, (size_t)cutoff + 3)];
 	}
 	catch (std::bad_alloc) {
 		return 2; //Could not allocate space
@@ -133,6 +255,9 @@ int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTe
 	S[0] = 0; 
 
 	int file_error = fopen_s(&gravModelFile, filename, "rt");
+	std::error_code ec;
+	srcSize = std::filesystem::file_size(filename, ec);
+	if (ec) srcSize = 0;
 
 	if (file_error == 0 && gravModelFile) {
 		while (fgets(gravFileLine, 511, gravModelFile))
@@ -151,6 +276,7 @@ int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTe
 					&normalized,
 					&referenceLat,
 					&referenceLon)) {
+					fclose(gravModelFile);
 					return 3; //Bad first line format
 				}
 				maxLines = NM(order, degree);
@@ -168,11 +294,17 @@ int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTe
 				if (!sscanf(gravFileLine, " %*d , %*d , %lf , %lf , %*lf , %*lf \n",
 					&C[lineindex],
 					&S[lineindex])) {
+					fclose(gravModelFile);
 					return 4;//Bad coefficient line format
 				}
 				numCoeff = linecount++;
 			}
 		}
+		fclose(gravModelFile);
+
+		if (SetupTables())
+			return 2; //Could not allocate space
+
 		actualLoadedTerms = NM(CoeffCutoff, CoeffCutoff);
 		maxModelTerms = NM(order,degree);
 		return 0; //successfully loaded gravity coefficients
@@ -182,15 +314,164 @@ int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTe
 	}
 }
 
-Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder)
+int PinesGravProp::readGravModelBin(const char* filename, int cutoff, int& actualLoadedTerms, int& maxModelTerms)
 {
-	r = rpos.length();
-	s = rpos.x / r;
-	t = rpos.y / r;
-	u = rpos.z / r;
+	MappedFile& mf = coeffFile;
+	if (!mf.Open(filename))
+		return 1;
+
+	const PinesGravFileHeader* hdr = (const PinesGravFileHeader*)mf.Data();
+	if (mf.Size() < sizeof(PinesGravFileHeader) ||
+		memcmp(hdr->magic, PINES_FILE_MAGIC, 8) || hdr->version != PINES_FILE_VERSION ||
+		hdr->ncoeff != (uint64_t)NM(hdr->nmax, hdr->nmax) + 1 ||
+		hdr->ofsC % PINES_FILE_ALIGN || hdr->ofsS % PINES_FILE_ALIGN ||
+		hdr->ofsC + hdr->ncoeff * sizeof(double) > mf.Size() ||
+		hdr->ofsS + hdr->ncoeff * sizeof(double) > mf.Size()) {
+		mf.Close();
+		return 3; //Not a valid coefficient file
+	}
 
-	rho = GM / (r * refRad);
-	rhop = refRad / r;
+	refRad = hdr->refRad;
+	GM = hdr->GM;
+	degree = hdr->degree;
+	order = hdr->order;
+	normalized = hdr->normalized;
+	referenceLat = hdr->referenceLat;
+	referenceLon = hdr->referenceLon;
+	srcSize = hdr->srcSize;
+	CoeffCutoff = (unsigned int)std::max(0, std::min(cutoff, (int)hdr->nmax));
+
+	// the coefficients are used in place: a lower cutoff only uses a prefix of the arrays
+	C = (double*)(mf.Data() + hdr->ofsC);
+	S = (double*)(mf.Data() + hdr->ofsS);
+	numCoeff = NM(CoeffCutoff, CoeffCutoff) + 1;
+
+	if (SetupTables()) {
+		// release the mapping, so a fallback to the text file owns C and S
+		mf.Close();
+		C = S = NULL;
+		return 2; //Could not allocate space
+	}
+
+	actualLoadedTerms = NM(CoeffCutoff, CoeffCutoff);
+	maxModelTerms = NM(order, degree);
+	return 0;
+}
+
+int PinesGravProp::writeGravModelBin(const char* filename) const
+{
+	PinesGravFileHeader hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, PINES_FILE_MAGIC, 8);
+	hdr.version = PINES_FILE_VERSION;
+	hdr.nmax = CoeffCutoff;
+	hdr.degree = degree;
+	hdr.order = order;
+	hdr.normalized = normalized;
+	hdr.refRad = refRad;
+	hdr.GM = GM;
+	hdr.referenceLat = referenceLat;
+	hdr.referenceLon = referenceLon;
+	hdr.ncoeff = NM(CoeffCutoff, CoeffCutoff) + 1;
+	size_t nbytes = (size_t)hdr.ncoeff * sizeof(double);
+	size_t pad = (PINES_FILE_ALIGN - nbytes % PINES_FILE_ALIGN) % PINES_FILE_ALIGN;
+	hdr.ofsC = ((sizeof(hdr) + PINES_FILE_ALIGN - 1) / PINES_FILE_ALIGN) * PINES_FILE_ALIGN;
+	hdr.ofsS = hdr.ofsC + nbytes + pad;
+	hdr.srcSize = srcSize;
+
+	FILE* f = nullptr;
+	if (fopen_s(&f, filename, "wb") || !f)
+		return 1;
+	static const char zero[PINES_FILE_ALIGN] = { 0 };
+	bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+		fwrite(zero, 1, (size_t)hdr.ofsC - sizeof(hdr), f) == (size_t)hdr.ofsC - sizeof(hdr) &&
+		fwrite(C, sizeof(double), (size_t)hdr.ncoeff, f) == (size_t)hdr.ncoeff &&
+		fwrite(zero, 1, pad, f) == pad &&
+		fwrite(S, sizeof(double), (size_t)hdr.ncoeff, f) == (size_t)hdr.ncoeff;
+	ok = (fclose(f) == 0) && ok;
+	return ok ? 0 : 1;
+}
+
+int PinesGravProp::ConvertGravModel(const char* txtname, const char* binname, int& nmax)
+{
+	// read the header line to find the full degree of the model
+	FILE* f = nullptr;
+	if (fopen_s(&f, txtname, "rt") || !f)
+		return 1;
+	char line[512];
+	int mdegree = 0, morder = 0;
+	bool ok = fgets(line, 511, f) &&
+		sscanf(line, " %*lf , %*lf , %*lf , %d , %d", &morder, &mdegree) == 2;
+	fclose(f);
+	if (!ok) return 3;
+
+	PinesGravProp prop(nullptr);
+	int nloaded, nmodel;
+	int res = prop.readGravModelText(txtname, std::max(morder, mdegree), nloaded, nmodel);
+	if (res) return res;
+	nmax = prop.CoeffCutoff;
+	return prop.writeGravModelBin(binname);
+}
+
+int PinesGravProp::SetupTables()
+{
+	try {
+		size_t ntab = NM(CoeffCutoff + 3, 0);
+		size_t ncol = NM(CoeffCutoff + 1, 0);
+		Adiag = new double[(size_t)CoeffCutoff + 3];
+		Aoff = new double[(size_t)CoeffCutoff + 3];
+		ALPHA = new double[ntab];
+		BETA = new double[ntab];
+		GALPHA = new double[ncol];
+		Ccol = new double[ncol];
+		Scol = new double[ncol];
+		colOfs = new unsigned int[(size_t)CoeffCutoff + 1];
+		degRMS = new double[(size_t)CoeffCutoff + 1];
+	}
+	catch (std::bad_alloc) {
+		FreeTables(); // drop a partial allocation, so the tables can be set up again
+		return 2; //Could not allocate space
+	}
+	GenerateRecurrenceTables();
+	return 0;
+}
+
+void PinesGravProp::FreeTables()
+{
+	delete[] Adiag;  Adiag = NULL;
+	delete[] Aoff;   Aoff = NULL;
+	delete[] ALPHA;  ALPHA = NULL;
+	delete[] BETA;   BETA = NULL;
+	delete[] GALPHA; GALPHA = NULL;
+	delete[] Ccol;   Ccol = NULL;
+	delete[] Scol;   Scol = NULL;
+	delete[] colOfs; colOfs = NULL;
+	delete[] degRMS; degRMS = NULL;
+}
+
+Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder) const
+{
+	return GetPinesGrav(rpos, maxDegree, maxOrder, ThreadWorkspace());
+}
+
+Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int degreeReq, const int orderReq, PinesGravWorkspace& ws) const
+{
+	// the coefficient and recurrence tables end at CoeffCutoff, and orders above
+	// the degree don't contribute
+	const int maxDegree = std::min(degreeReq, (int)CoeffCutoff);
+	const int maxOrder = std::min(orderReq, maxDegree);
+	ws.Reserve(maxDegree);
+	double* __restrict A = ws.A.data();
+	double* __restrict R = ws.R.data();
+	double* __restrict I = ws.I.data();
+
+	double r = rpos.length();
+	double s = rpos.x / r;
+	double t = rpos.y / r;
+	double u = rpos.z / r;
+
+	double rho = GM / (r * refRad);
+	double rhop = refRad / r;
 
 	R[0] = 0.0;
 	I[0] = 0.0;
@@ -202,26 +483,19 @@ Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const
 		I[m] = s * I[m - 1] + t * R[m - 1];
 	}
 
-	g1temp = 0.0;
-	g2temp = 0.0;
-	g3temp = 0.0;
-	g4temp = 0.0;
-
-	g1 = 0.0;
-	g2 = 0.0;
-	g3 = 0.0;
-	g4 = 0.0;
+	double g1 = 0.0;
+	double g2 = 0.0;
+	double g3 = 0.0;
+	double g4 = 0.0;
 
 	int nmodel = 0;
-	GenerateAssocLegendreMatrix(maxDegree);
+	GenerateAssocLegendreMatrix(A, u, maxDegree);
 	for (int n = 0; n <= maxDegree; n++) {
 
-		g1temp = 0.0;
-		g2temp = 0.0;
-		g3temp = 0.0;
-		g4temp = 0.0;
-
-		double SM = 0.5;
+		double g1temp = 0.0;
+		double g2temp = 0.0;
+		double g3temp = 0.0;
+		double g4temp = 0.0;
 
 		if (n > maxOrder)
 			nmodel = maxOrder;
@@ -236,14 +510,12 @@ Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const
 			double F = S[NM(n, m)] * R[m] - C[NM(n, m)] * I[m];
 
 
-			double ALPHA = sqrt(SM * ((double)n - (double)m) * ((double)n + (double)m + 1));
+			double GA = GALPHA[NM(n, m)];
 
 			g1temp = g1temp + A[NM(n, m)] * (double)m * E;
 			g2temp = g2temp + A[NM(n, m)] * (double)m * F;
-			g3temp = g3temp + ALPHA * A[NM(n, m + 1)] * D;
-			g4temp = g4temp + (((double)n + (double)m + 1) * A[NM(n, m)] + ALPHA * u * A[NM(n, m + 1)]) * D;
-
-			if (m == 0) { SM = 1.0; ; }
+			g3temp = g3temp + GA * A[NM(n, m + 1)] * D;
+			g4temp = g4temp + (((double)n + (double)m + 1) * A[NM(n, m)] + GA * u * A[NM(n, m + 1)]) * D;
 		}
 		rho = rhop * rho;
 
@@ -261,4 +533,300 @@ Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const
 	gperturbed.z = (g3 - g4 * u);
 
 	return gperturbed;
-}
\ No newline at end of file
+}
+
+void PinesGravProp::GetPinesGravBatch(int npos, const double* x, const double* y, const double* z,
+	double* gx, double* gy, double* gz, const int maxDegree, const int maxOrder) const
+{
+	GetPinesGravBatch(npos, x, y, z, gx, gy, gz, maxDegree, maxOrder, ThreadWorkspace());
+}
+
+void PinesGravProp::GetPinesGravBatch(int npos, const double* x, const double* y, const double* z,
+	double* gx, double* gy, double* gz, const int degreeReq, const int orderReq, PinesGravWorkspace& ws) const
+{
+	const int maxDegree = std::min(degreeReq, (int)CoeffCutoff);
+	const int maxOrder = std::min(orderReq, maxDegree);
+	ws.Reserve(maxDegree);
+	double* Wbuf = ws.W.data();
+	int i = 0;
+	for (; i + PINES_LANES <= npos; i += PINES_LANES)
+		PinesGravBlock<PINES_LANES>(x + i, y + i, z + i, gx + i, gy + i, gz + i, maxDegree, maxOrder, Wbuf);
+	for (; i < npos; i++) // scalar remainder
+		PinesGravBlock<1>(x + i, y + i, z + i, gx + i, gy + i, gz + i, maxDegree, maxOrder, Wbuf);
+}
+
+template<int W>
+void PinesGravProp::PinesGravBlock(const double* x, const double* y, const double* z,
+	double* gx, double* gy, double* gz, int maxDegree, int maxOrder, double* __restrict Wbuf) const
+{
+	// Same sum as GetPinesGrav, but with the order m in the outer loop. This way only
+	// two columns of the Legendre matrix are alive at any time, and the W positions of
+	// a block are carried along in the innermost loops. The summation order differs
+	// from the scalar path, so results agree to rounding error only.
+
+	double s[W], t[W], u[W];
+	double Rm[W], Im[W], Rm1[W], Im1[W];
+	double g1[W], g2[W], g3[W], g4[W];
+
+	double* __restrict colA = Wbuf;                                 // column m of A
+	double* __restrict colB = colA + ((size_t)maxDegree + 2) * W;  // column m+1 of A
+	double* __restrict rhoN = colB + ((size_t)maxDegree + 2) * W;  // (GM/(r refRad)) (refRad/r)^(n+1)
+
+	for (int k = 0; k < W; k++) {
+		double rk = sqrt(x[k] * x[k] + y[k] * y[k] + z[k] * z[k]);
+		s[k] = x[k] / rk;
+		t[k] = y[k] / rk;
+		u[k] = z[k] / rk;
+		double rhop = refRad / rk;
+		double rho = GM / (rk * refRad);
+		for (int n = 0; n <= maxDegree; n++) {
+			rho = rhop * rho;
+			rhoN[n * W + k] = rho;
+		}
+		Rm[k] = 0.0;  Im[k] = 0.0;
+		Rm1[k] = 1.0; Im1[k] = 0.0;
+		g1[k] = g2[k] = g3[k] = g4[k] = 0.0;
+	}
+
+	// column 0
+	double diag = sqrt(2.0); // unscaled diagonal term A(m,m)
+	for (int k = 0; k < W; k++) {
+		colA[0 * W + k] = diag;
+		if (maxDegree >= 1) colA[1 * W + k] = Aoff[0] * u[k] * diag;
+	}
+	for (int n = 2; n <= maxDegree; n++)
+		for (int k = 0; k < W; k++)
+			colA[n * W + k] = ALPHA[NM(n, 0)] * u[k] * colA[(n - 1) * W + k] - BETA[NM(n, 0)] * colA[(n - 2) * W + k];
+	for (int n = 0; n <= maxDegree; n++)
+		for (int k = 0; k < W; k++)
+			colA[n * W + k] *= sqrt(0.5);
+
+	int mmax = (maxOrder < maxDegree ? maxOrder : maxDegree);
+	for (int m = 0; m <= mmax; m++) {
+
+		// column m+1
+		if (m + 1 <= maxDegree) {
+			int m1 = m + 1;
+			diag *= Adiag[m1];
+			for (int k = 0; k < W; k++) {
+				colB[m1 * W + k] = diag;
+				if (m1 + 1 <= maxDegree) colB[(m1 + 1) * W + k] = Aoff[m1] * u[k] * diag;
+			}
+			for (int n = m1 + 2; n <= maxDegree; n++)
+				for (int k = 0; k < W; k++)
+					colB[n * W + k] = ALPHA[NM(n, m1)] * u[k] * colB[(n - 1) * W + k] - BETA[NM(n, m1)] * colB[(n - 2) * W + k];
+		}
+
+		const double* Cm = Ccol + colOfs[m] - m;
+		const double* Sm = Scol + colOfs[m] - m;
+		double dm = (double)m;
+
+		// diagonal term n = m: A(m,m+1) does not contribute
+		{
+			double Cnm = Cm[m], Snm = Sm[m];
+			double dnm1 = (double)m + (double)m + 1;
+			for (int k = 0; k < W; k++) {
+				double a = colA[m * W + k];
+				double D = Cnm * Rm1[k] + Snm * Im1[k];
+				double E = Cnm * Rm[k] + Snm * Im[k];
+				double F = Snm * Rm[k] - Cnm * Im[k];
+				double rho = rhoN[m * W + k];
+				g1[k] += rho * (a * dm * E);
+				g2[k] += rho * (a * dm * F);
+				g4[k] += rho * (dnm1 * a * D);
+			}
+		}
+
+		for (int n = m + 1; n <= maxDegree; n++) {
+			double Cnm = Cm[n], Snm = Sm[n];
+			double GA = GALPHA[NM(n, m)];
+			double dnm1 = (double)n + (double)m + 1;
+			for (int k = 0; k < W; k++) {
+				double a = colA[n * W + k];
+				double b = colB[n * W + k];
+				double D = Cnm * Rm1[k] + Snm * Im1[k];
+				double E = Cnm * Rm[k] + Snm * Im[k];
+				double F = Snm * Rm[k] - Cnm * Im[k];
+				double rho = rhoN[n * W + k];
+				g1[k] += rho * (a * dm * E);
+				g2[k] += rho * (a * dm * F);
+				g3[k] += rho * (GA * b * D);
+				g4[k] += rho * ((dnm1 * a + GA * u[k] * b) * D);
+			}
+		}
+
+		// advance the longitude recursion R(m+1), I(m+1) -> R(m+2), I(m+2)
+		for (int k = 0; k < W; k++) {
+			Rm[k] = Rm1[k];
+			Im[k] = Im1[k];
+			Rm1[k] = s[k] * Rm[k] - t[k] * Im[k];
+			Im1[k] = s[k] * Im[k] + t[k] * Rm[k];
+		}
+
+		double* tmp = colA; colA = colB; colB = tmp;
+	}
+
+	for (int k = 0; k < W; k++) {
+		gx[k] = (g1[k] - g4[k] * s[k]);
+		gy[k] = (g2[k] - g4[k] * t[k]);
+		gz[k] = (g3[k] - g4[k] * u[k]);
+	}
+}
+
+// ======================================================================================
+// PinesGravGrid
+
+PinesGravGrid::PinesGravGrid(const PinesGravProp& _prop, double tol, size_t membudget, double shell)
+	: prop(_prop)
+{
+	// Trilinear interpolation of a harmonic of degree n with node spacing h (rad)
+	// has a relative error of about (n h)^2/8, so the cell size follows from the
+	// tolerance and the model cutoff. Radial spacing is matched to the angular
+	// spacing at the reference radius.
+	int nmax = std::max(1u, prop.GetCoeffCutoff());
+	double h = sqrt(8.0 * tol) / nmax;
+
+	nlat = (int)ceil(Pi / h);
+	nlat = ((nlat + TILE - 1) / TILE) * TILE;
+	nlng = 2 * nlat;
+	dlat = Pi / nlat;
+	dlng = Pi2 / nlng;
+
+	rmin = prop.GetRefRad() * (1.0 - 0.02);  // allow for terrain below the reference radius
+	rmax = prop.GetRefRad() * (1.0 + shell);
+	nr = (int)ceil((rmax - rmin) / (prop.GetRefRad() * dlat));
+	nr = ((nr + TILE - 1) / TILE) * TILE;
+	dr = (rmax - rmin) / nr;
+
+	maxTiles = std::max((size_t)1, membudget / sizeof(Tile));
+	tick = 0;
+}
+
+PinesGravGrid::~PinesGravGrid()
+{
+	for (auto& t : tiles) delete t.second;
+}
+
+size_t PinesGravGrid::nTiles() const
+{
+	std::shared_lock<std::shared_mutex> lock(mtx);
+	return tiles.size();
+}
+
+size_t PinesGravGrid::MemUsage() const
+{
+	return nTiles() * sizeof(Tile);
+}
+
+bool PinesGravGrid::GetPinesGrav(const Vector& rpos, Vector& g) const
+{
+	double r = rpos.length();
+	if (r < rmin || r >= rmax) return false;
+
+	double lat = asin(rpos.z / r);
+	double lng = atan2(rpos.y, rpos.x);
+
+	double fr = (r - rmin) / dr;
+	double flat = (lat + Pi05) / dlat;
+	double flng = (lng + Pi) / dlng;
+	int ir = std::min((int)fr, nr - 1);
+	int ilat = std::min((int)flat, nlat - 1);
+	int ilng = std::min((int)flng, nlng - 1);
+	double wr = fr - ir, wlat = flat - ilat, wlng = flng - ilng;
+
+	int tr = ir / TILE, tlat = ilat / TILE, tlng = ilng / TILE;
+	int i0 = ((ir - tr * TILE) * NODE + (ilat - tlat * TILE)) * NODE + (ilng - tlng * TILE);
+
+	std::shared_lock<std::shared_mutex> lock(mtx);
+	const Tile* tile = GetTile(tr, tlat, tlng);
+	if (!tile) {
+		lock.unlock();
+		Tile* t = BuildTile(tr, tlat, tlng);
+		{
+			std::unique_lock<std::shared_mutex> wlock(mtx);
+			auto res = tiles.emplace(Key(tr, tlat, tlng), t);
+			if (!res.second) delete t; // built concurrently by another thread
+			else {
+				t->lastuse.store(++tick, std::memory_order_relaxed);
+				if (tiles.size() > maxTiles) EvictTiles();
+			}
+		}
+		lock.lock();
+		tile = GetTile(tr, tlat, tlng);
+		if (!tile) return false; // evicted again straight away (budget of a single tile)
+	}
+
+	double v[3] = { 0.0, 0.0, 0.0 };
+	for (int c = 0; c < 8; c++) {
+		int dr_ = (c >> 2) & 1, dlat_ = (c >> 1) & 1, dlng_ = c & 1;
+		double w = (dr_ ? wr : 1.0 - wr) * (dlat_ ? wlat : 1.0 - wlat) * (dlng_ ? wlng : 1.0 - wlng);
+		const float* gn = tile->g[i0 + (dr_ * NODE + dlat_) * NODE + dlng_];
+		v[0] += w * gn[0];
+		v[1] += w * gn[1];
+		v[2] += w * gn[2];
+	}
+	g.Set(v[0], v[1], v[2]);
+	return true;
+}
+
+const PinesGravGrid::Tile* PinesGravGrid::GetTile(int ir, int ilat, int ilng) const
+{
+	// caller holds the lock. Tiles used since the last insertion share its
+	// stamp, which is all EvictTiles needs, and a tile is only written to
+	// when it is first used after an insertion.
+	auto it = tiles.find(Key(ir, ilat, ilng));
+	if (it == tiles.end()) return 0;
+	if (it->second->lastuse.load(std::memory_order_relaxed) != tick)
+		it->second->lastuse.store(tick, std::memory_order_relaxed);
+	return it->second;
+}
+
+PinesGravGrid::Tile* PinesGravGrid::BuildTile(int ir, int ilat, int ilng) const
+{
+	const int nn = NODE * NODE * NODE;
+	std::vector<double> x(nn), y(nn), z(nn), gx(nn), gy(nn), gz(nn);
+	int i = 0;
+	for (int a = 0; a < NODE; a++) {
+		double r = rmin + (ir * TILE + a) * dr;
+		for (int b = 0; b < NODE; b++) {
+			double lat = (ilat * TILE + b) * dlat - Pi05;
+			double slat = sin(lat), clat = cos(lat);
+			for (int c = 0; c < NODE; c++) {
+				double lng = (ilng * TILE + c) * dlng - Pi;
+				x[i] = r * clat * cos(lng);
+				y[i] = r * clat * sin(lng);
+				z[i] = r * slat;
+				i++;
+			}
+		}
+	}
+	int nmax = prop.GetCoeffCutoff();
+	prop.GetPinesGravBatch(nn, x.data(), y.data(), z.data(), gx.data(), gy.data(), gz.data(), nmax, nmax);
+
+	Tile* tile = new Tile;
+	for (i = 0; i < nn; i++) {
+		tile->g[i][0] = (float)gx[i];
+		tile->g[i][1] = (float)gy[i];
+		tile->g[i][2] = (float)gz[i];
+	}
+	tile->lastuse = 0;
+	return tile;
+}
+
+void PinesGravGrid::EvictTiles() const
+{
+	// caller holds the exclusive lock. Drop the oldest eighth of the budget in
+	// one go so that eviction scans stay rare.
+	size_t ndrop = std::max((size_t)1, maxTiles / 8);
+	std::vector<std::pair<unsigned long long, unsigned long long>> age;
+	age.reserve(tiles.size());
+	for (auto& t : tiles)
+		age.emplace_back(t.second->lastuse.load(std::memory_order_relaxed), t.first);
+	ndrop = std::min(ndrop, age.size());
+	std::nth_element(age.begin(), age.begin() + (ndrop - 1), age.end());
+	for (size_t j = 0; j < ndrop; j++) {
+		auto it = tiles.find(age[j].second);
+		delete it->second;
+		tiles.erase(it);
+	}
+}
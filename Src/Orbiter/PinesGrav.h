@@ -21,19 +21,131 @@
 
 #ifndef __PINESGRAV_H
 #define __PINESGRAV_H
+
+#include <vector>
+#include <atomic>
+#include <shared_mutex>
+#include <unordered_map>
+#include <stdint.h>
+#include "MappedFile.h"
+
 class CelestialBody;
 
+// Number of positions evaluated together by GetPinesGravBatch. The lane loops
+// are written so that the compiler can map one lane block onto a SIMD register.
+#if defined(__AVX512F__)
+#define PINES_LANES 8
+#elif defined(__AVX2__) || defined(__AVX__)
+#define PINES_LANES 4
+#else
+#define PINES_LANES 2
+#endif
+
+// Scratch space for evaluating the Pines sum. PinesGravProp itself is read-only
+// once the model is loaded, so each thread (or each caller that wants to manage
+// its own memory) evaluates the field with its own workspace.
+class PinesGravWorkspace
+{
+public:
+	void Reserve(int maxDegree);
+	// Grow the buffers to hold an expansion up to maxDegree
+
+private:
+	friend class PinesGravProp;
+	std::vector<double> A;   // associated Legendre matrix
+	std::vector<double> R;   // longitude recursion, real part
+	std::vector<double> I;   // longitude recursion, imaginary part
+	std::vector<double> W;   // lane-blocked columns for the batch evaluation
+	int capacity = -1;       // degree the buffers are sized for
+};
+
+// Binary coefficient file (.pgb). The header is followed by the C and S arrays,
+// each holding the coefficients up to nmax in the triangular NM(n,m) order used
+// by PinesGravProp, so any lower cutoff is a prefix of the arrays. Array offsets
+// are multiples of PINES_FILE_ALIGN. Values are stored in native (little endian)
+// byte order. The size of the text file the coefficients were converted from is
+// recorded, so a file converted from a different version of the model is not used.
+#define PINES_FILE_MAGIC "PINESGRV"
+#define PINES_FILE_VERSION 2
+#define PINES_FILE_ALIGN 64
+
+struct PinesGravFileHeader {
+	char magic[8];           // PINES_FILE_MAGIC
+	uint32_t version;        // PINES_FILE_VERSION
+	uint32_t nmax;           // degree and order of the stored coefficients
+	uint32_t degree;         // model header values, as in the text file
+	uint32_t order;
+	uint32_t normalized;
+	uint32_t reserved;
+	double refRad;
+	double GM;
+	double referenceLat;
+	double referenceLon;
+	uint64_t ncoeff;         // entries per array (NM(nmax,nmax)+1)
+	uint64_t ofsC;           // byte offset of the C array
+	uint64_t ofsS;           // byte offset of the S array
+	uint64_t srcSize;        // size of the source text file [bytes] (0=unknown)
+};
+
 class PinesGravProp
 {
 public:
 	PinesGravProp(CelestialBody* celestialbody);
 	~PinesGravProp();
 	int readGravModel(char* filename, int cutoff, int& actualLoadedTerms, int& maxModelTerms);
-	Vector GetPinesGrav(const Vector rposmax, const int maxDegree, const int maxOrder);
+	// Load the model up to degree/order cutoff. If a binary version of the file
+	// (same name, extension .pgb) exists it is mapped instead of parsing the text,
+	// unless it is older than the text file or was converted from a file of
+	// different size.
+	// Return values: 0=ok, 1=file not found, 2=out of memory, 3=bad header, 4=bad coefficient line
+
+	int readGravModelText(const char* filename, int cutoff, int& actualLoadedTerms, int& maxModelTerms);
+	int readGravModelBin(const char* filename, int cutoff, int& actualLoadedTerms, int& maxModelTerms);
+	// Load from a specific format. readGravModelBin returns 3 if the file is not
+	// a valid coefficient file.
+
+	int writeGravModelBin(const char* filename) const;
+	// Write the loaded coefficients (up to the current cutoff) in binary format.
+	// Returns 0 on success, 1 if the file can't be written.
+
+	static int ConvertGravModel(const char* txtname, const char* binname, int& nmax);
+	// Convert a text model at full degree to binary format. Returns 0 on success,
+	// otherwise the readGravModelText/writeGravModelBin error code.
+
+	static bool IsGravModelBinCurrent(const char* binname, const char* txtname);
+	// true if binname exists and can stand in for txtname (see readGravModel)
+
+	// Evaluate the perturbation at rpos. The version without workspace argument
+	// uses a thread-local workspace. Both are safe to call concurrently.
+	// maxDegree is limited to the loaded cutoff, and maxOrder to maxDegree.
+	Vector GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder) const;
+	Vector GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder, PinesGravWorkspace& ws) const;
+
+	// Evaluate the perturbation for npos positions at once. Positions (x,y,z) and
+	// results (gx,gy,gz) are in structure-of-arrays layout, in the same units and
+	// frame as GetPinesGrav.
+	void GetPinesGravBatch(int npos, const double* x, const double* y, const double* z,
+		double* gx, double* gy, double* gz, const int maxDegree, const int maxOrder) const;
+	void GetPinesGravBatch(int npos, const double* x, const double* y, const double* z,
+		double* gx, double* gy, double* gz, const int maxDegree, const int maxOrder, PinesGravWorkspace& ws) const;
+
+	int GetTruncationDegree(double r, double tol) const;
+	// Lowest degree N for which the estimated contribution of all degrees
+	// N < n <= CoeffCutoff at radius r [km] is below tol [km/s^2]. The estimate
+	// uses the RMS coefficient power of each degree, so it bounds the global
+	// average rather than the local error. Returns 0 if the entire model is
+	// below tolerance.
+
 	inline unsigned int GetCoeffCutoff() const { return CoeffCutoff; }
+	inline double GetRefRad() const { return refRad; }
 private:
 	CelestialBody* parentBody;
-	inline void GenerateAssocLegendreMatrix(int maxDegree);
+	inline void GenerateAssocLegendreMatrix(double* __restrict A, double u, int maxDegree) const;
+	int SetupTables();
+	void FreeTables();
+	void GenerateRecurrenceTables();
+	template<int W> void PinesGravBlock(const double* x, const double* y, const double* z,
+		double* gx, double* gy, double* gz, int maxDegree, int maxOrder, double* __restrict Wbuf) const;
 
 	static inline unsigned int NM(unsigned int n, unsigned int m) { return (n * n + n) / 2 + m; }
 
@@ -47,23 +159,72 @@ private:
 	double referenceLon;
 	double* __restrict C;
 	double* __restrict S;
-	double* __restrict A;
-	double* __restrict R;
-	double* __restrict I;
 	unsigned long int numCoeff;
+	uint64_t srcSize;           // size of the text file the coefficients come from [bytes] (0=unknown)
+	MappedFile coeffFile;       // if open, C and S point into the mapped binary file
+
+	// recurrence factors, precomputed up to CoeffCutoff at load time
+	double* __restrict Adiag;   // diagonal factors sqrt(1+1/2m)
+	double* __restrict Aoff;    // off-diagonal factors sqrt(2m+3)
+	double* __restrict ALPHA;   // column recurrence factors, indexed by NM(n,m)
+	double* __restrict BETA;
+	double* __restrict GALPHA;  // derivative factors sqrt(SM(n-m)(n+m+1)), indexed by NM(n,m)
+
+	// coefficients in column (order) major layout for the batch evaluation
+	double* __restrict Ccol;
+	double* __restrict Scol;
+	unsigned int* colOfs;       // start of column m in Ccol/Scol
+
+	double* __restrict degRMS;  // sqrt(sum_m C(n,m)^2+S(n,m)^2) for each degree n
+};
+
+// Interpolation grid of the perturbation field (evaluated at the full coefficient
+// cutoff) in a spherical shell above the reference radius. The shell is divided
+// into tiles of TILE^3 cells, which are evaluated on first use and dropped in
+// least-recently-used order once the memory budget is exhausted. Queries are a
+// hash lookup plus trilinear interpolation, independent of the model degree.
+class PinesGravGrid
+{
+public:
+	PinesGravGrid(const PinesGravProp& prop, double tol, size_t membudget, double shell = 0.1);
+	// tol: target interpolation error relative to the perturbation magnitude
+	// membudget: max. memory used by tiles [bytes]
+	// shell: shell thickness as fraction of the reference radius
+
+	~PinesGravGrid();
+
+	bool GetPinesGrav(const Vector& rpos, Vector& g) const;
+	// Interpolated perturbation at rpos (same units and frame as
+	// PinesGravProp::GetPinesGrav). Returns false if rpos is outside the shell;
+	// g is not modified in that case.
+
+	size_t nTiles() const;
+	size_t MemUsage() const;
+	// currently cached tiles and the memory they occupy
+
+	enum { TILE = 8, NODE = TILE + 1 };
+
+private:
+	struct Tile {
+		float g[NODE * NODE * NODE][3];  // perturbation at the tile nodes, r-major
+		mutable std::atomic<unsigned long long> lastuse;
+	};
 
-	double r, s, t, u;
-	double rho, rhop;
+	const Tile* GetTile(int ir, int ilat, int ilng) const;
+	Tile* BuildTile(int ir, int ilat, int ilng) const;
+	void EvictTiles() const;
+	static inline unsigned long long Key(int ir, int ilat, int ilng)
+	{ return ((unsigned long long)ir << 42) | ((unsigned long long)ilat << 21) | (unsigned long long)ilng; }
 
-	double g1temp;
-	double g2temp;
-	double g3temp;
-	double g4temp;
+	const PinesGravProp& prop;
+	double rmin, rmax;         // shell boundaries
+	double dr, dlat, dlng;     // cell size
+	int nr, nlat, nlng;        // number of cells
+	size_t maxTiles;           // tile budget
 
-	double g1;
-	double g2;
-	double g3;
-	double g4;
+	mutable std::shared_mutex mtx;
+	mutable std::unordered_map<unsigned long long, Tile*> tiles;
+	mutable unsigned long long tick; // LRU stamp: advanced by each tile insertion (under the exclusive lock)
 };
 
 #endif
\ No newline at end of file
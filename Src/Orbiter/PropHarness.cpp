@@ -0,0 +1,271 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// PropHarness.cpp
+// Standalone propagation harness (see PropHarness.h)
+// =======================================================================
+
+#include "PropHarness.h"
+#include "PinesGrav.h"
+#include "LinAngIntegrators.h"
+#include <algorithm>
+
+static const double Ggrav = 6.67259e-11; // gravitational constant, as in Astro.h
+
+static inline double posangle (double a)
+{
+	a = fmod (a, Pi2);
+	return (a >= 0.0 ? a : a+Pi2);
+}
+
+// =======================================================================
+// class HarnessBody
+
+HarnessBody::HarnessBody ()
+{
+	Mass = 0.0;
+	Size = 1.0;
+	rot_T = 1e10;
+	Dphi = 0.0;
+	eps_rel = Lrel0 = 0.0;
+	mjd_rel = 51544.5;
+	prec_T = 0.0;
+	eps_ref = lan_ref = 0.0;
+	pines = 0;
+	pinesTol = 0.0;
+	GM = 0.0;
+	rot_omega = prec_omega = 0.0;
+	cos_eps = 1.0, sin_eps = 0.0;
+	Lrel = rotation_off = 0.0;
+	R_ref = R_ecl = IMatrix();
+}
+
+void HarnessBody::Setup (double mjd_ref, double mjd_epoch)
+{
+	// Mirrors CelestialBody::Setup and the offset merging in the
+	// CelestialBody constructor
+	GM = Ggrav * Mass;
+	if (eps_ref) {
+		double sine = sin(eps_ref), cose = cos(eps_ref);
+		double sinl = sin(lan_ref), cosl = cos(lan_ref);
+		R_ref.Set (1,0,0,  0,cose,-sine,  0,sine,cose);
+		R_ref.premul (Matrix (cosl,0,-sinl,  0,1,0,  sinl,0,cosl));
+	} else {
+		R_ref = IMatrix();
+	}
+	prec_omega = (prec_T ? Pi2/prec_T : 0.0);
+	rot_omega = Pi2/rot_T;
+	cos_eps = cos(eps_rel), sin_eps = sin(eps_rel);
+
+	Dphi += (mjd_ref - mjd_epoch) * (86400.0/rot_T)*Pi2;
+	Dphi += Lrel0*cos(eps_rel);
+	Dphi = fmod (Dphi, Pi2);
+
+	UpdatePrecession (mjd_ref);
+}
+
+void HarnessBody::UpdatePrecession (double mjd)
+{
+	// See CelestialBody::UpdatePrecession
+	Lrel = Lrel0 + prec_omega*(mjd-mjd_rel);
+	double sinl = sin(Lrel), cosl = cos(Lrel);
+	Matrix R_ref_rel (cosl, -sinl*sin_eps, -sinl*cos_eps,
+		              0,    cos_eps,       -sin_eps,
+			          sinl, cosl*sin_eps,  cosl*cos_eps);
+	if (eps_ref) R_ref_rel.premul (R_ref);
+
+	Vector R_axis = mul (R_ref_rel, Vector(0,1,0));
+	double eps_ecl = acos (R_axis.y);
+	double lan_ecl = atan2 (-R_axis.x, R_axis.z);
+	double sinL = sin(lan_ecl), cosL = cos(lan_ecl);
+	double sine = sin(eps_ecl), cose = cos(eps_ecl);
+	R_ecl.Set (cosL, -sinL*sine, -sinL*cose,
+		       0,    cose,       -sine,
+			   sinL, cosL*sine,   cosL*cose);
+	double cos_poff = cosL*R_ref_rel.m11 + sinL*R_ref_rel.m31;
+	double sin_poff = -(cosL*R_ref_rel.m13 + sinL*R_ref_rel.m33);
+	rotation_off = atan2(sin_poff,cos_poff);
+}
+
+void HarnessBody::GetRotation (double t, Matrix &R) const
+{
+	double r = posangle (Dphi + t*rot_omega - Lrel*cos_eps + rotation_off);
+	double cosr = cos(r), sinr = sin(r);
+	R.Set (cosr, 0.0, -sinr,
+	       0.0,  1.0,  0.0,
+	       sinr, 0.0,  cosr);
+	R.premul (R_ecl);
+}
+
+Vector HarnessBody::Gacc (const Vector &gpos, double t) const
+{
+	Vector rpos (pos - gpos);
+	double d = rpos.length();
+	Vector acc (rpos * (GM / (d*d*d)));
+
+	if (pines) {
+		// same frame conversions as SingleGacc_perturbation
+		Matrix rot;
+		GetRotation (t, rot);
+		Vector lpos = -tmul (rot, rpos)/1000.0;
+		std::swap (lpos.y, lpos.z);
+		int n = (pinesTol > 0.0 ? pines->GetTruncationDegree (lpos.length(), pinesTol*1e-3) : (int)pines->GetCoeffCutoff());
+		if (n) {
+			Vector dg = pines->GetPinesGrav (lpos, n, n);
+			std::swap (dg.y, dg.z);
+			acc += mul (rot, dg) * 1000.0;
+		}
+	}
+	return acc;
+}
+
+// =======================================================================
+// class HarnessSystem
+
+Vector HarnessSystem::Gacc (const Vector &gpos, double t) const
+{
+	Vector acc;
+	for (const HarnessBody &b : bodies)
+		acc += b.Gacc (gpos, t);
+	return acc;
+}
+
+// =======================================================================
+// class HarnessPropagator
+
+void HarnessPropagator::SetInertia (const Vector &_pmi)
+{
+	pmi = _pmi;
+	bAtt = (pmi.x > 0.0 && pmi.y > 0.0 && pmi.z > 0.0);
+}
+
+Vector HarnessPropagator::EulerInv (const Vector &omega) const
+{
+	// RigidBody::EulerInv_full without torque
+	return Vector (
+		-(pmi.y-pmi.z)*omega.y*omega.z / pmi.x,
+		-(pmi.z-pmi.x)*omega.z*omega.x / pmi.y,
+		-(pmi.x-pmi.y)*omega.x*omega.y / pmi.z);
+}
+
+// Accelerations for the schemes of LinAngIntegrators.h, counting the
+// evaluations. Time is the absolute time of the HarnessState.
+struct HarnessPropagator::Model {
+	const HarnessPropagator &prop;
+	int neval;
+
+	void Moments (const StateVectors &s, double t, double h, Vector &acc, Vector &arot)
+	{
+		acc = prop.sys.Gacc (s.pos, t);
+		arot = (prop.bAtt ? prop.EulerInv (s.omega) : Vector());
+		neval++;
+	}
+};
+
+static void LoadState (const HarnessState &s, LinAngState &x)
+{
+	x.pos0 = s.pos, x.vel0 = s.vel;
+	x.dpos = x.dvel = Vector();
+	x.Q = s.Q, x.omega = s.omega;
+	x.acc = s.acc, x.arot = s.arot;
+}
+
+static void StoreState (const LinAngState &x, HarnessState &s)
+{
+	s.pos = x.Pos(), s.vel = x.Vel();
+	s.Q = x.Q, s.omega = x.omega;
+	s.acc = x.acc, s.arot = x.arot;
+}
+
+void HarnessPropagator::Init (HarnessState &s) const
+{
+	s.acc = sys.Gacc (s.pos, s.t);
+	if (bAtt) s.arot = EulerInv (s.omega);
+}
+
+int HarnessPropagator::Propagate (HarnessState &s, double dt, int method, int nsub) const
+{
+	int neval = 0;
+	double h = dt/nsub;
+	for (int i = 0; i < nsub; i++)
+		neval += Step (s, h, method);
+	return neval;
+}
+
+int HarnessPropagator::Step (HarnessState &s, double h, int method) const
+{
+	Model m = {*this, 0};
+	LinAngState x;
+	LoadState (s, x);
+	Step_LinAng (m, x, method, s.t, h);
+	StoreState (x, s);
+	s.t += h;
+	return m.neval;
+}
+
+int HarnessPropagator::PropagateAdaptive (HarnessState &s, double dt, int method, double tol, double &h, int *nstep) const
+{
+	Model m = {*this, 0};
+	LinAngState x;
+	LoadState (s, x);
+	Vector r (s.pos);
+	if (sys.nBody()) r -= sys.Body(0).pos;
+	int nacc = RKadapt_LinAng (m, x, method, s.t, dt, tol, r.length(), s.vel.length(), 0.0, h);
+	StoreState (x, s);
+	s.t += dt;
+	if (nstep) *nstep = nacc;
+	return m.neval;
+}
+
+// =======================================================================
+// Auxiliary functions
+
+void KeplerState (double mu, double a, double e, double i, double theta, double omegab,
+	double L, double dt, Vector &pos, Vector &vel)
+{
+	// follows Elements::Setup/PosVel
+	double p = a * (1.0-e*e);
+	double n = sqrt (fabs (mu/(a*a*a)));
+	double ma = L - omegab + n*dt;
+	double ta;
+	if (e < 1.0) {
+		ma = posangle (ma);
+		double E = ma;
+		for (int k = 0; k < 32; k++) {
+			double res = ma - E + e*sin(E);
+			if (fabs (res) < 1e-14) break;
+			E += std::max (-1.0, std::min (1.0, res/(1.0 - e*cos(E))));
+		}
+		ta = 2.0 * atan (sqrt ((1.0+e)/(1.0-e)) * tan (0.5*E));
+	} else {
+		double E = 0.0;
+		for (int k = 0; k < 64; k++) {
+			double res = ma - e*sinh(E) + E;
+			if (fabs (res) < 1e-14) break;
+			E += std::max (-1.0, std::min (1.0, res/(e*cosh(E) - 1.0)));
+		}
+		double chea = cosh (E);
+		ta = acos ((e - chea)/(e*chea - 1.0));
+		if (E < 0.0) ta = -ta;
+	}
+	double r = p / (1.0 + e*cos(ta));
+	double omega = omegab-theta;
+	double sint = sin(theta), cost = cos(theta);
+	double sini = sin(i), cosi = cos(i);
+
+	double sinto = sin (ta + omega), costo = cos (ta + omega);
+	pos.x = r * (cost*costo - sint*sinto*cosi);
+	pos.z = r * (sint*costo + cost*sinto*cosi);
+	pos.y = r * sinto * sini;
+
+	double muh = sqrt (mu/p);
+	double vx = -muh * sin (ta);
+	double vz =  muh * (e + cos(ta));
+	double thetav = atan2 (vz, vx);
+	double rv = sqrt (vx*vx + vz*vz);
+	sinto = sin (thetav + omega), costo = cos (thetav + omega);
+	vel.x = rv * (cost*costo - sint*sinto*cosi);
+	vel.z = rv * (sint*costo + cost*sinto*cosi);
+	vel.y = rv * sinto * sini;
+}
@@ -0,0 +1,155 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// PropHarness.h
+// Standalone propagation harness for tests and batch tools: a simplified
+// model of the gravitational field of a set of celestial bodies (point
+// mass plus optional spherical harmonics), driving the RigidBody
+// integration schemes for the linear state of a point mass and the
+// torque-free attitude motion of a rigid body.
+// The schemes (LinAngIntegrators.h) and the harmonics model (PinesGrav.h)
+// are the ones the simulation uses. The force model is not: the bodies
+// are static, every body acts as a point mass (plus harmonics) without
+// the third-body treatment of PlanetarySystem, and the body rotation and
+// Kepler orbits are separate implementations of the formulae of
+// CelestialBody and Elements. Results validate the integration schemes,
+// not the simulation's force model.
+// Free of Win32, graphics and simulation globals (g_pOrbiter, td, g_psys),
+// so it can be built on any platform. Units and frames follow the
+// simulation core: SI units, left-handed ecliptic frame, time t in seconds
+// since a reference MJD.
+// =======================================================================
+
+#ifndef __PROPHARNESS_H
+#define __PROPHARNESS_H
+
+#include "Vecmat.h"
+#include "Integrators.h"
+#include <vector>
+
+class PinesGravProp;
+
+// =======================================================================
+// A celestial body at a fixed position, rotating about its axis.
+// Rotation and precession parameters have the same meaning as the
+// corresponding planet configuration entries (see CelestialBody).
+
+class HarnessBody {
+public:
+	HarnessBody ();
+
+	void Setup (double mjd_ref, double mjd_epoch = 51544.5);
+	// Derive rotation constants after the parameters have been set.
+	// mjd_ref: MJD at t=0; mjd_epoch: epoch of the body's orbital elements
+	// (used by CelestialBody to merge the rotation offset)
+
+	void UpdatePrecession (double mjd);
+	// Set the orientation of the rotation axis for date mjd. The axis is
+	// kept fixed between calls.
+
+	void GetRotation (double t, Matrix &R) const;
+	// Rotation matrix (body-fixed -> global frame) at time t
+
+	Vector Gacc (const Vector &gpos, double t) const;
+	// Gravitational acceleration at global position gpos and time t
+
+	double Mass;            // [kg]
+	double Size;            // mean radius [m]
+	Vector pos;             // global position [m]
+	double rot_T;           // sidereal rotation period [s]
+	double Dphi;            // SidRotOffset [rad]
+	double eps_rel, Lrel0;  // Obliquity, LAN [rad]
+	double mjd_rel;         // LAN_MJD
+	double prec_T;          // PrecessionPeriod [days], 0 if none
+	double eps_ref, lan_ref;// PrecessionObliquity, PrecessionLAN [rad]
+	const PinesGravProp *pines; // spherical harmonics model, or NULL (not owned)
+	double pinesTol;        // acceleration tolerance for truncating the harmonics [m/s^2] (0=full cutoff)
+
+private:
+	double GM;
+	double rot_omega, prec_omega;
+	double cos_eps, sin_eps;
+	double Lrel, rotation_off;
+	Matrix R_ref, R_ecl;
+};
+
+// =======================================================================
+// The set of bodies acting on the propagated objects
+
+class HarnessSystem {
+public:
+	void AddBody (const HarnessBody &body) { bodies.push_back (body); }
+	int nBody () const { return (int)bodies.size(); }
+	HarnessBody &Body (int i) { return bodies[i]; }
+	const HarnessBody &Body (int i) const { return bodies[i]; }
+
+	Vector Gacc (const Vector &gpos, double t) const;
+	// Total gravitational acceleration at gpos and time t
+
+private:
+	std::vector<HarnessBody> bodies;
+};
+
+// =======================================================================
+// Linear state of a propagated point mass
+
+struct HarnessState {
+	Vector pos, vel;  // global position [m] and velocity [m/s]
+	Vector acc;       // acceleration at pos (kept up to date by the propagator)
+	Quaternion Q;     // orientation (only propagated if the inertia is set)
+	Vector omega;     // angular velocity in the body frame [rad/s]
+	Vector arot;      // angular acceleration (kept up to date by the propagator)
+	double t;         // time [s]
+};
+
+class HarnessPropagator {
+public:
+	HarnessPropagator (const HarnessSystem &sys): sys(sys), bAtt(false) {}
+
+	void SetInertia (const Vector &pmi);
+	// Principal moments of inertia (mass-normalised) [m^2]. If set, the
+	// attitude is propagated along with the linear state (no torques).
+
+	void Init (HarnessState &s) const;
+	// Evaluate the acceleration for a new state
+
+	int Step (HarnessState &s, double h, int method) const;
+	// Advance s by one step of length h with integrator method (PROP_xxx).
+	// The schemes are those of the RigidBody propagators (LinAngIntegrators.h).
+	// Returns the number of acceleration evaluations.
+
+	int Propagate (HarnessState &s, double dt, int method, int nsub) const;
+	// Advance s by dt in nsub equal steps. Returns the number of
+	// acceleration evaluations.
+
+	int PropagateAdaptive (HarnessState &s, double dt, int method, double tol, double &h, int *nstep = 0) const;
+	// Advance s by dt with an embedded error-controlled scheme (PROP_DP5 or
+	// PROP_RKF78), keeping the local error of each step below tol, relative
+	// to the distance and speed w.r.t. the first body at the start of the
+	// call (as RigidBody does for each frame). Steps are at least
+	// dt/RKADAPT_MAXSTEP long.
+	// h: step length to start with (0: unknown), on exit the step length
+	// proposed for the next call. nstep (optional): accepted steps.
+	// Returns the number of acceleration evaluations.
+
+private:
+	struct Model; // acceleration evaluation for the schemes
+	Vector EulerInv (const Vector &omega) const;
+
+	const HarnessSystem &sys;
+	Vector pmi;
+	bool bAtt;
+};
+
+// =======================================================================
+// Auxiliary functions
+
+void KeplerState (double mu, double a, double e, double i, double theta, double omegab,
+	double L, double dt, Vector &pos, Vector &vel);
+// State relative to the central body from osculating elements in the
+// simulation's convention (a [m], angles [rad]: inclination, longitude of
+// ascending node, longitude of periapsis, mean longitude at epoch), dt [s]
+// after the epoch. mu = G(M+m).
+
+#endif // !__PROPHARNESS_H
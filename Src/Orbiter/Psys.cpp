@@ -25,6 +25,11 @@ extern char DBG_MSG[256];
 PlanetarySystem::PlanetarySystem (char *fname, const Config* config, OutputLoadStatusCallback outputLoadStatus, void* callbackContext)
 {
 	Read (fname, config, outputLoadStatus, callbackContext);
+	int nPropThreads = config->CfgCmdlinePrm.PropThreads; // command line overrides Orbiter.cfg
+	SetPropagationThreads (nPropThreads >= 0 ? nPropThreads : config->CfgPhysicsPrm.nPropThreads);
+	const CFG_PLANETRENDERPRM &prm = config->CfgPRenderPrm;
+	if (prm.ElevPrefetchThreads > 0)
+		m_prefetch = std::make_unique<ElevationPrefetcher>(prm.ElevPrefetchThreads, prm.ElevPrefetchAlt, prm.ElevPrefetchTime);
 }
 
 PlanetarySystem::~PlanetarySystem ()
@@ -37,6 +42,17 @@ void PlanetarySystem::Clear ()
 	DestroyDeviceObjects ();
 	m_Name.clear();
 
+	// no tile loads may be running when the planets (and their elevation managers) are deleted
+	if (m_prefetch) {
+		ElevationPrefetcher::Stats stats = m_prefetch->GetStats();
+		if (stats.loaded) {
+			ElevationTileCache::Stats cstats = ElevationTileCache::Shared().GetStats();
+			LOGOUT("Elevation prefetch: %llu tiles requested, %llu dropped, %llu loaded, %llu of %llu prefetched tiles used",
+				stats.requested, stats.dropped, stats.loaded, cstats.prefetchHits, cstats.prefetched);
+		}
+		m_prefetch->Clear();
+	}
+
 	//Vessel destructor broadcasts messages to every other vessel in 'vessels'.
 	//We remove it from the collection as soon as we deleted it to prevent the next Vessel to broadcast to the free'd one.
 	while (vessels.size()) {
@@ -54,6 +70,8 @@ void PlanetarySystem::Clear ()
 	stars     .clear();
 	planets   .clear();
 	celestials.clear();
+	m_bodyIndex.Clear();
+	m_baseIndex.Clear();
 
 	g_bForceUpdate = true;
 
@@ -99,30 +117,28 @@ void PlanetarySystem::Write (ostream &os)
 
 Body *PlanetarySystem::GetObj (const char *name, bool ignorecase)
 {
-	for (DWORD i = 0; i < bodies.size(); i++)
-		if (!StrComp (bodies[i]->Name(), name, ignorecase)) return bodies[i];
-	return 0;
+	return m_bodyIndex.Find (name, ignorecase);
 }
 
 CelestialBody *PlanetarySystem::GetGravObj (const char *name, bool ignorecase) const
 {
-	for (DWORD i = 0; i < celestials.size(); i++)
-		if (!StrComp (celestials[i]->Name(), name, ignorecase)) return celestials[i];
-	return 0;
+	return (CelestialBody*)m_bodyIndex.Find (name, ignorecase, [](const Body *body) {
+		return body->Type() == OBJTP_STAR || body->Type() == OBJTP_PLANET;
+	});
 }
 
 Planet *PlanetarySystem::GetPlanet (const char *name, bool ignorecase)
 {
-	for (size_t i = 0; i < planets.size(); i++)
-		if (!StrComp (planets[i]->Name(), name, ignorecase)) return planets[i];
-	return 0;
+	return (Planet*)m_bodyIndex.Find (name, ignorecase, [](const Body *body) {
+		return body->Type() == OBJTP_PLANET;
+	});
 }
 
 Vessel *PlanetarySystem::GetVessel (const char *name, bool ignorecase) const
 {
-	for (DWORD i = 0; i < vessels.size(); i++)
-		if (!StrComp (vessels[i]->Name(), name, ignorecase)) return vessels[i];
-	return 0;
+	return (Vessel*)m_bodyIndex.Find (name, ignorecase, [](const Body *body) {
+		return body->Type() == OBJTP_VESSEL;
+	});
 }
 
 bool PlanetarySystem::isObject (const Body *obj) const
@@ -149,13 +165,7 @@ Base *PlanetarySystem::GetBase (const Planet *planet, const char *name, bool ign
 
 Base *PlanetarySystem::GetBase (const char *name, bool ignorecase)
 {
-	for (DWORD i = 0; i < celestials.size(); i++) {
-		if (celestials[i]->Type() != OBJTP_PLANET) continue;
-		Planet *planet = (Planet*)celestials[i];
-		Base *base = GetBase (planet, name, ignorecase);
-		if (base) return base;
-	}
-	return 0;
+	return m_baseIndex.Find (name, ignorecase);
 }
 
 void PlanetarySystem::OptionChanged(DWORD cat, DWORD item)
@@ -326,6 +336,7 @@ void PlanetarySystem::ActivatePlanetLabels(bool activate)
 void PlanetarySystem::AddBody (Body *_body)
 {
 	bodies.emplace_back(_body);
+	m_bodyIndex.Add (_body);
 }
 
 bool PlanetarySystem::DelBody (Body *_body)
@@ -341,6 +352,8 @@ bool PlanetarySystem::DelBody (Body *_body)
 	//if (bodies[i]->s0) bodies[i]->s0 = NULL; // s0 is used in vessels destructor due to undocking of
 	//if (bodies[i]->s1) bodies[i]->s1 = NULL; // vessels before deletion.
 	
+	m_bodyIndex.Remove (_body);
+
 	delete bodies[i]; // delete actual bodies/vessels
 
 	std::iter_swap(bodies.begin() + i, bodies.end() - 1);
@@ -362,6 +375,8 @@ size_t PlanetarySystem::AddPlanet (Planet *_planet, CelestialBody *cbody)
 	planets.emplace_back(_planet);
 	AddGrav (_planet); // register in list of massive objects
 	AddBody (_planet); // register in general list
+	for (DWORD i = 0; i < _planet->nBase(); i++) // surface bases are loaded with the planet
+		m_baseIndex.Add (_planet->GetBase (i));
 	_planet->SetPsys (this);
 	_planet->Attach (cbody);
 	return planets.size();
@@ -595,13 +610,12 @@ Vector SingleGacc_perturbation (const Vector &rpos, const CelestialBody *body)
 		lpos.y = lpos.z; 
 		lpos.z = temp_y;
 
-		unsigned int maxDegreeOrder = body->GetPinesCutoff();
+		//truncate the series where the remaining terms are negligible at this distance
+		int maxDegreeOrder = body->pinesDegree(lpos.length());
+		if (!maxDegreeOrder) return dg;
 		//get aceleration vector from spherical harmonics
-		{
-			//Limit scope of the const cast. the internal state of body.PinesGravProp does need to change when this finction is called.
-			CelestialBody* unconstbody = const_cast<CelestialBody*>(body);
-			dg = unconstbody->pinesAccel(lpos, maxDegreeOrder, maxDegreeOrder);
-		}
+		//(the model is read-only; scratch space is per thread, so this is safe to call concurrently)
+		dg = body->pinesAccel(lpos, maxDegreeOrder, maxDegreeOrder);
 
 		//Convert back to Orbiter's lefthandedness
 		temp_y = dg.y;
@@ -818,18 +832,48 @@ void PlanetarySystem::Update (bool force)
 	for (i = 0; i < bodies      .size(); i++) bodies      [i]->BeginStateUpdate ();
 	for (i = 0; i < stars       .size(); i++) stars       [i]->RelTrueAndBaryState();
 	for (i = 0; i < stars       .size(); i++) stars       [i]->AbsTrueState();
+	for (i = 0; i < celestials  .size(); i++) celestials  [i]->UpdateInterpolant ();
 	for (i = 0; i < celestials  .size(); i++) celestials  [i]->Update (force);
 	for (i = 0; i < vessels     .size(); i++) vessels     [i]->UpdateBodyForces ();
 	for (i = 0; i < supervessels.size(); i++) supervessels[i]->Update (force);
+	if (m_workers) PropagateVesselsConcurrent (force);
 	for (i = 0; i < vessels     .size(); i++) vessels     [i]->Update (force);
 }
 
+void PlanetarySystem::SetPropagationThreads (int nthread)
+{
+	if (nthread <= 0) m_workers.reset();
+	else if (!m_workers || m_workers->nThread() != nthread) m_workers = std::make_unique<WorkerPool>(nthread);
+}
+
+void PlanetarySystem::PropagateVesselsConcurrent (bool force)
+{
+	// Only the state integration runs on the workers. Everything with side
+	// effects beyond the vessel itself (module callbacks, touchdown, comms,
+	// docking, supervessels) stays in the serial loops in Update and
+	// FinaliseUpdate and runs in the usual order, so results do not depend
+	// on thread scheduling.
+	m_concurrent.clear();
+	for (size_t i = 0; i < vessels.size(); i++)
+		if (vessels[i]->CanPropagateConcurrently (force))
+			m_concurrent.push_back (vessels[i]);
+	if (m_concurrent.size() < 2) return;
+
+	m_workers->ParallelFor (m_concurrent.size(), [this, force](size_t i) {
+		m_concurrent[i]->Propagate (force);
+	});
+}
+
 void PlanetarySystem::FinaliseUpdate ()
 {
 	DWORD i;
 	for (i = 0; i < bodies.size(); i++) bodies[i]->EndStateUpdate ();
 	for (i = 0; i < supervessels.size(); i++) supervessels[i]->PostUpdate ();
 	for (i = 0; i < vessels.size(); i++) vessels[i]->PostUpdate ();
+	if (m_prefetch) {
+		m_prefetch->Update ();
+		m_prefetch->Schedule (vessels);
+	}
 }
 
 void PlanetarySystem::Timejump (const TimeJumpData& jump)
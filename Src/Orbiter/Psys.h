@@ -9,7 +9,11 @@
 #include "Base.h"
 #include "Star.h"
 #include "Planet.h"
+#include "WorkerPool.h"
+#include "ElevPrefetch.h"
+#include "NameIndex.h"
 #include <functional>
+#include <memory>
 
 class Vessel;
 class SuperVessel;
@@ -82,6 +86,10 @@ public:
 	// search through the bases of all planets
 	// NOTE: THIS SHOULD NOT BE NECESSARY!
 
+	// The name lookups above use hash indices (NameIndex), maintained by
+	// AddStar/AddPlanet/AddVessel/DelVessel. Case-sensitive lookups compare
+	// the (usually single) candidates for the lower-case name.
+
 	/**
 	 * \brief Called when the user interactively changes a simulation option
 	 * \param cat option category (see \ref optcat)
@@ -124,6 +132,9 @@ public:
 	void Update (bool force = false);
 	// Perform time step for the planetary system
 
+	void SetPropagationThreads (int nthread);
+	// Number of worker threads for concurrent vessel propagation (0 = serial)
+
 	void FinaliseUpdate ();
 
 	void Timejump (const TimeJumpData& jump);
@@ -154,7 +165,7 @@ public:
 	Vector Gacc_intermediate (const Vector &gpos, double n, const Body *exclude = 0, GFieldData *gfd = 0) const;
 	// Acceleration vector due to gravitational forces at global position gpos at intermediate
 	// time t = t0+n*dt, where 0 <= n <= 1 is a fractional time step, n = (t-t0)/dt, and dt = t1-t0.
-	// Uses linear interpolation of celestial body positions.
+	// Uses cubic Hermite interpolation of celestial body positions.
 	// If gfd != 0 then only g-sources from this list are computed
 
 	Vector Gacc_intermediate_pert (const CelestialBody *cbody, const Vector &gpos, double n, const Body *exclude, GFieldData *gfd) const;
@@ -226,6 +237,22 @@ private:
 	std::vector<SuperVessel*> supervessels;
 	// List of spacecraft groups (composite vessels)
 
+	NameIndex<Body> m_bodyIndex;
+	NameIndex<Base> m_baseIndex;
+	// objects and surface bases by name
+
+	std::unique_ptr<WorkerPool> m_workers;
+	// worker threads for concurrent vessel propagation, if enabled
+
+	std::vector<Vessel*> m_concurrent;
+	// vessels propagated concurrently in the current step
+
+	std::unique_ptr<ElevationPrefetcher> m_prefetch;
+	// background loading of elevation tiles for low-flying vessels, if enabled
+
+	void PropagateVesselsConcurrent (bool force);
+	// Integrate all vessels that qualify for it on the worker pool
+
 	std::vector< oapi::GraphicsClient::LABELLIST> m_labelList; ///< list of celestial markers
 	//oapi::GraphicsClient::LABELLIST *labellist;
 	//int nlabellist;
@@ -16,6 +16,8 @@
 #include "Orbiter.h"
 #include "Rigidbody.h"
 #include "Celbody.h"
+#include "Planet.h"
+#include "PhysicsCore.h"
 #include "Psys.h"
 #include "Element.h"
 #include "Astro.h"
@@ -34,9 +36,12 @@ extern char DBG_MSG[256];
 bool       RigidBody::bDistmass = false;
 bool       RigidBody::bGPerturb = false;
 int        RigidBody::nPropLevel = 1;
-RigidBody::PROPMODE RigidBody::PropMode[MAX_PROP_LEVEL] = {&RigidBody::RK2_LinAng, 0, 0.0, 0.0, 0.0, 0.0};
+double     RigidBody::PropAdaptTol = 1e-12;
+RigidBody::PROPMODE RigidBody::PropMode[MAX_PROP_LEVEL] = {0, 0.0, 0.0, 0.0, 0.0};
 
 const double gfielddata_updt_interval = 60.0;
+const double fastforward_pe_margin = 1.05;  // min. periapsis for fast-forward, relative to atmosphere or surface radius
+const double fastforward_soi_margin = 0.5;  // max. apoapsis for fast-forward, relative to sphere of influence radius
 
 inline Vector Call_EulerInv_full (RigidBody *body, const Vector &tau, const Vector &omega)
 { return body->EulerInv_full (tau, omega); }
@@ -87,11 +92,13 @@ void RigidBody::SetDefaultCaps ()
 	bDistmass = g_pOrbiter->Cfg()->CfgPhysicsPrm.bDistributedMass;
 	bGPerturb = g_pOrbiter->Cfg()->CfgPhysicsPrm.bNonsphericalGrav;
 	bOrbitStabilised = false;
+	bFastForwarded = false;
 	bIgnoreGravTorque = false;
 	tidaldamp = 0.0;
 	PropLevel = 0;
 	PropSubMax = g_pOrbiter->Cfg()->CfgPhysicsPrm.PropSubMax;
 	nPropSubsteps = 1;
+	hAdapt = 0.0;
 	gfielddata.ngrav = 0;
 	gfielddata.updt = -1e10; // invalidate
 }
@@ -142,22 +149,11 @@ void RigidBody::SetupPropagationModes ()
 		PropMode[i].tlim = g_pOrbiter->Cfg()->CfgPhysicsPrm.PropTLim[i];
 		PropMode[i].alim = g_pOrbiter->Cfg()->CfgPhysicsPrm.PropALim[i];
 		PropMode[i].propidx = g_pOrbiter->Cfg()->CfgPhysicsPrm.PropMode[i];
-		switch (PropMode[i].propidx) {
-		case PROP_RK2:  PropMode[i].propagator = &RigidBody::RK2_LinAng;  break;
-		case PROP_RK4:  PropMode[i].propagator = &RigidBody::RK4_LinAng;  break;
-		case PROP_RK5:  PropMode[i].propagator = &RigidBody::RK5_LinAng;  break;
-		case PROP_RK6:  PropMode[i].propagator = &RigidBody::RK6_LinAng;  break;
-		case PROP_RK7:  PropMode[i].propagator = &RigidBody::RK7_LinAng;  break;
-		case PROP_RK8:  PropMode[i].propagator = &RigidBody::RK8_LinAng;  break;
-		case PROP_SY2:  PropMode[i].propagator = &RigidBody::SY2_LinAng;  break;
-		case PROP_SY4:  PropMode[i].propagator = &RigidBody::SY4_LinAng;  break;
-		case PROP_SY6:  PropMode[i].propagator = &RigidBody::SY6_LinAng;  break;
-		case PROP_SY8:  PropMode[i].propagator = &RigidBody::SY8_LinAng;  break;
-		default:        PropMode[i].propagator = &RigidBody::RK4_LinAng;  break;
-		}
+		// DP5 and RKF78 fall back to RK5 and RK8 for fixed substeps, unknown ids to RK4 (see Step_LinAng)
 	}
 	PropMode[nPropLevel-1].tlim = 1e20;
 	PropMode[nPropLevel-1].alim = 1e20;
+	PropAdaptTol = g_pOrbiter->Cfg()->CfgPhysicsPrm.PropAdaptTol;
 }
 
 // =======================================================================
@@ -174,7 +170,10 @@ void RigidBody::SetPropagator (int &plevel, int &nstep) const
 		if (astep < PropMode[plevel].alim)
 			break;
 
-	nstep = min (PropSubMax, (int)ceil (max (td.SimDT / PropMode[plevel].ttgt, astep / PropMode[plevel].atgt)));
+	if (PROP_ISADAPTIVE (PropMode[plevel].propidx))
+		nstep = 0; // substeps are chosen by error control
+	else
+		nstep = min (PropSubMax, (int)ceil (max (td.SimDT / PropMode[plevel].ttgt, astep / PropMode[plevel].atgt)));
 }
 
 // =======================================================================
@@ -211,8 +210,14 @@ void RigidBody::Update (bool force)
 			gfielddata.updt = td.SimT0 + gfielddata_updt_interval;
 		}
 
-		// First check if we should do a stabilised state update
-		if (bCanUpdateStabilised &&
+		// First check if the orbit can be propagated analytically
+		bFastForwarded = FastForward();
+		if (bFastForwarded) {
+
+			bOrbitStabilised = false;
+
+		// Next check if we should do a stabilised state update
+		} else if (bCanUpdateStabilised &&
 			ostep > g_pOrbiter->Cfg()->CfgPhysicsPrm.Stabilise_SLimit &&
 			g_psys->GetGravityContribution (cbody, cpos+cbody->GPos()) > 1-g_pOrbiter->Cfg()->CfgPhysicsPrm.Stabilise_PLimit) {
 
@@ -245,19 +250,19 @@ void RigidBody::Update (bool force)
 			do {
 				// Select propagator
 				SetPropagator (PropLevel, nPropSubsteps);
-				double dt = td.SimDT/nPropSubsteps;
 
-				// Perform step propagation with sub-steps
 				s1->Set (*s0);
 				acc = acc0, arot = arot0;
 				rpos_add = rpos_add0, rvel_add = rvel_add0;
-				for (i = 0; i < nPropSubsteps; i++) {
-					((*this).*(PropMode[PropLevel].propagator)) (dt, nPropSubsteps, i);
-					s1->pos = rpos_base + rpos_add;
-					s1->vel = rvel_base + rvel_add;
-					s1->R.Set (s1->Q);
-					GetIntermediateMoments (acc, tau, *s1, (i+1.0)/nPropSubsteps, dt);
-					arot.Set (EulerInv_full (tau, s1->omega));
+
+				if (!nPropSubsteps) {
+					// Perform step propagation with error-controlled sub-steps
+					nPropSubsteps = RKadapt_LinAng (PropMode[PropLevel].propidx, PropMode[PropLevel].atgt);
+				} else {
+					// Perform step propagation with sub-steps
+					double dt = td.SimDT/nPropSubsteps;
+					for (i = 0; i < nPropSubsteps; i++)
+						Step_LinAng (PropMode[PropLevel].propidx, i*dt, dt);
 				}
 			} while (!ValidateStateUpdate (s1));
 			//s1->R.Set (s1->Q);
@@ -303,6 +308,73 @@ void RigidBody::Update (bool force)
 
 // =======================================================================
 
+bool RigidBody::FastForward ()
+{
+	const CFG_PHYSICSPRM &prm = g_pOrbiter->Cfg()->CfgPhysicsPrm;
+	if (!prm.bFastForward || !el || !cbody || ostep < prm.FastForward_SLimit) return false;
+	if (!CanFastForward()) return false;
+
+	el->Calculate (cpos, cvel, td.SimT0);
+	if (el->e >= 1.0) return false; // escape trajectory
+
+	// the orbit must stay clear of the surface and atmosphere at periapsis
+	double rmin = cbody->Size();
+	if (cbody->Type() == OBJTP_PLANET && ((const Planet*)cbody)->HasAtmosphere())
+		rmin = ((const Planet*)cbody)->AtmRadLimit();
+	if (el->PeDist() < rmin*fastforward_pe_margin) return false;
+
+	// ... and well inside the reference body's sphere of influence
+	const CelestialBody *parent = cbody->ElRef();
+	if (parent) {
+		double rsoi = (cbody->GPos()-parent->GPos()).length() * pow (cbody->Mass()/parent->Mass(), 0.4);
+		if (el->ApDist() > fastforward_soi_margin*rsoi) return false;
+	}
+	if (g_psys->GetGravityContribution (cbody, s0->pos) < 1.0-prm.Stabilise_PLimit) return false;
+
+	// averaged drift of the orbit due to oblateness and the other gravity sources
+	SecularDrift drift;
+	double mu = el->Mu();
+	if (cbody->UseComplexGravity() && cbody->nJcoeff())
+		drift.AddOblateness (mu, cpos, cvel, cbody->Jcoeff(0), cbody->Size(), cbody->RotAxis());
+	for (DWORD i = 0; i < gfielddata.ngrav; i++) {
+		const CelestialBody *body = g_psys->GetGravObj (gfielddata.gravidx[i]);
+		if (body == cbody) continue;
+		Vector pos3 (body->GPos()-cbody->GPos());
+		if (pos3.length() < 2.0*el->ApDist()) return false; // quadrupole approximation not valid
+		drift.AddThirdBody (mu, cpos, cvel, Ggrav*body->Mass(), pos3, body->GVel()-cbody->GVel());
+	}
+
+	// Kepler motion with corrected mean motion, then rotate the orbit
+	double dt = td.SimDT;
+	double n = Pi2/el->OrbitT();
+	Vector pos, vel;
+	el->PosVel (pos, vel, td.SimT0 + dt*(1.0 + drift.dn/n));
+	drift.Apply (dt, pos, vel);
+
+	s1->Set (*s0);
+	s1->pos.Set (pos + cbody->s1->pos);
+	s1->vel.Set (vel + cbody->s1->vel);
+	FlushRPos();
+	FlushRVel();
+
+	// torque-free rotation at constant angular velocity
+	double w = s1->omega.length();
+	if (w) {
+		double hphi = 0.5*w*dt;
+		s1->Q.postmul (Quaternion (s1->omega*(sin(hphi)/w), cos(hphi)));
+	}
+	s1->R.Set (s1->Q);
+	arot.Set (0,0,0);
+
+	Vector tau;
+	GetIntermediateMoments (acc, tau, *s1, 1, dt);
+	nPropSubsteps = 1;
+	el_valid = false;
+	return true;
+}
+
+// =======================================================================
+
 void RigidBody::ScanGFieldSources (const PlanetarySystem *psys)
 {
 	psys->ScanGFieldSources (&s0->pos, this, &gfielddata);
@@ -525,12 +597,14 @@ void RigidBody::SetDynamicUpdate (bool dynamic)
 const char *RigidBody::PropagatorStr (DWORD idx, bool verbose) {
 	static const char *ShortPropModeStr[NPROP_METHOD] = {
 		"RK2", "RK4", "RK5", "RK6", "RK7", "RK8",
-		"SY2", "SY4", "SY6", "SY8"
+		"SY2", "SY4", "SY6", "SY8",
+		"DP5", "RKF78"
 	};
 	static const char *LongPropModeStr[NPROP_METHOD] = {
 		"Runge-Kutta, 2nd order (RK2)", "Runge-Kutta, 4th order (RK4)", "Runge-Kutta, 5th order (RK5)", "Runge-Kutta, 6th order (RK6)",
 		"Runge-Kutta, 7th order (RK7)", "Runge-Kutta, 8th order (RK8)",
-		"Symplectic, 2nd order (SY2)", "Symplectic, 4th order (SY4)", "Symplectic, 6th order (SY6)", "Symplectic, 8th order (SY8)"
+		"Symplectic, 2nd order (SY2)", "Symplectic, 4th order (SY4)", "Symplectic, 6th order (SY6)", "Symplectic, 8th order (SY8)",
+		"Adaptive Dormand-Prince 5(4) (DP5)", "Adaptive Runge-Kutta-Fehlberg 7(8) (RKF78)"
 	};
 	return (idx < NPROP_METHOD ? (verbose ? LongPropModeStr[idx] : ShortPropModeStr[idx]) : "unknown");
 }
@@ -50,9 +50,6 @@ typedef struct {  // data for linear perturbation integrators
 typedef void (*Propagator)(RigidBody*,double);  // time propagation function template
 typedef void (*AngPropagator)(RigidBody*,const AngIntData&); // angular time propagation template
 
-typedef void (RigidBody::*LinAngPropagator)(double, int, int);
-// state propagator function template
-
 // =======================================================================
 
 class RigidBody: public Body {
@@ -88,7 +85,9 @@ public:
 	virtual void SetPropagator (int &plevel, int &nstep) const;
 	// return propagator level (0..nPropLevel-1) and substep number (1..PropSubMax)
 	// for current step. Note that nstep > PropSubMax is valid, but should only be
-	// used for immediate collision treatment
+	// used for immediate collision treatment. nstep = 0 is returned for levels
+	// using an adaptive propagator and requests error-controlled substeps.
+	// Overloaded versions may set nstep > 0 to enforce fixed substeps.
 
 	virtual void GetIntermediateMoments (Vector &acc, Vector &tau,
 		const StateVectors &state, double tfrac, double dt);
@@ -167,6 +166,13 @@ public:
 	virtual bool isOrbitStabilised () const { return bOrbitStabilised; }
 	// return true if body uses orbit stabilisation for the current step
 
+	virtual bool isFastForwarded () const { return bFastForwarded; }
+	// return true if body uses fast-forward propagation for the current step
+
+	virtual bool CanFastForward () const { return true; }
+	// return true if the body is coasting (no forces other than gravity act
+	// on it), so its orbit may be propagated analytically
+
 	inline bool canDynamicPosVel () const { return bDynamicPosVel; }
 	// return true if body can update its position by state vector integration
 
@@ -213,6 +219,10 @@ protected:
 	// Indicates if the current step was updated by "orbit stabilisation",
 	// i.e. Encke's method.
 
+	bool bFastForwarded;
+	// Indicates if the current step was updated analytically ("fast-forward"
+	// mode: Kepler orbit plus averaged perturbations).
+
 	bool bIgnoreGravTorque;
 	// flag for suppressing gravity-gradient torque (to avoid numerical instability)
 
@@ -241,17 +251,18 @@ private:
 	// Dynamic integrators for linear and angular state vectors
 	// Implemented in BodyIntegrator.cpp
 
-	void RKdrv_LinAng (double h, int nsub, int isub, int n, const double *alpha, const double *beta, const double *gamma); // RK engine for RK5-8, linear+angular
-	void RK2_LinAng (double h, int nsub, int isub);  // RK2, linear+angular
-	void RK4_LinAng (double h, int nsub, int isub);  // RK4, linear+angular
-	void RK5_LinAng (double h, int nsub, int isub);  // RK5, linear+angular
-	void RK6_LinAng (double h, int nsub, int isub);  // RK6, linear+angular
-	void RK7_LinAng (double h, int nsub, int isub);  // RK7, linear+angular
-	void RK8_LinAng (double h, int nsub, int isub);  // RK8, linear+angular
-	void SY2_LinAng (double h, int nsub, int isub);  // symplectic, order 2, linear+angular
-	void SY4_LinAng (double h, int nsub, int isub);  // symplectic, order 4, linear+angular
-	void SY6_LinAng (double h, int nsub, int isub);  // symplectic, order 6, linear+angular
-	void SY8_LinAng (double h, int nsub, int isub);  // symplectic, order 8, linear+angular
+	// Schemes in LinAngIntegrators.h, evaluated with GetIntermediateMoments
+
+	struct MomentModel; // adapter of GetIntermediateMoments for the schemes
+
+	void Step_LinAng (int method, double t, double h);
+	// Substep of length h from t seconds into the frame, with fixed-step method
+	// 'method' (PROP_xxx), linear+angular. Updates acc and arot to the end
+	// of the substep.
+
+	int RKadapt_LinAng (int method, double atgt);
+	// Adaptive embedded RK propagation (DP5, RKF78) over the full frame interval,
+	// linear+angular. atgt: angular step target [rad]. Returns accepted substeps.
 
 	// Propagators for 2-body orbit perturbations
 	//void RK2_LinAng_Encke (double h, int nsub, int isub);
@@ -263,10 +274,13 @@ private:
 
 	void Encke ();
 
+	bool FastForward ();
+	// Propagate a coasting orbit analytically over the full frame interval,
+	// if it is eligible. Returns false (without updating) otherwise.
+
 	// -----------------------------------------------------------------------
 
 	static struct PROPMODE {
-		LinAngPropagator propagator;
 		int propidx;  // propagator method index
 		double ttgt;  // time step target [s]
 		double atgt;  // angular step target [rad]
@@ -274,9 +288,11 @@ private:
 		double alim;  // angular step limit [rad]
 	} PropMode[MAX_PROP_LEVEL];
 	static int nPropLevel; // number of propagator stages
+	static double PropAdaptTol; // local error tolerance for adaptive propagators
 	int PropLevel;         // current propagator stage
 	int PropSubMax;        // upper limit for number of subsamples
 	int nPropSubsteps;     // current number of subsamples
+	double hAdapt;         // substep length proposed by the last adaptive update [s] (0=none)
 };
 
 #endif // !__RIGIDBODY_H
\ No newline at end of file
@@ -931,6 +931,14 @@ bool SuperVessel::ThrustEngaged () const
 
 // =======================================================================
 
+bool SuperVessel::CanFastForward () const
+{
+	if (Flin.x || Flin.y || Flin.z || Amom.x || Amom.y || Amom.z) return false;
+	return VesselBase::CanFastForward ();
+}
+
+// =======================================================================
+
 void SuperVessel::ComponentStateVectors (const StateVectors *s, StateVectors *scomp, int comp) const
 {
 	scomp->vel.Set (s->vel + mul (s->R, crossp (vlist[comp].rpos-cg, s->omega)));
@@ -166,6 +166,8 @@ protected:
 
 	bool ThrustEngaged () const;
 
+	bool CanFastForward () const;
+
 	TOUCHDOWN_VTX *HullvtxFirst ();
 	TOUCHDOWN_VTX *HullvtxNext ();
 	// hull vertex iterator: returns first/next hull vertex in supervessel frame
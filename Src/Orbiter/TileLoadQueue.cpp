@@ -0,0 +1,98 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// ======================================================================
+// Tile load request queue (see TileLoadQueue.h)
+// ======================================================================
+
+#include "TileLoadQueue.h"
+
+TileLoadQueue::TileLoadQueue (int nthread, size_t _maxqueue)
+: maxqueue(_maxqueue)
+{
+	busy = 0;
+	quit = false;
+	nrequest = ndrop = nload = 0;
+	for (int i = 0; i < nthread; i++)
+		threads.emplace_back (&TileLoadQueue::WorkerLoop, this);
+}
+
+TileLoadQueue::~TileLoadQueue ()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		queue.clear();
+		quit = true;
+	}
+	cv.notify_all();
+	for (auto &th : threads) th.join();
+	for (auto &d : done) delete []d.second.data;
+}
+
+bool TileLoadQueue::Request (const Key &key, LoadFunc load)
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (pending.count (key)) return false;
+		if (queue.size() >= maxqueue) {
+			ndrop++;
+			return false;
+		}
+		queue.push_back ({key, std::move (load)});
+		pending.insert (key);
+	}
+	nrequest++;
+	cv.notify_one();
+	return true;
+}
+
+void TileLoadQueue::WorkerLoop ()
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	for (;;) {
+		cv.wait (lock, [this] { return quit || !queue.empty(); });
+		if (quit) return;
+		Job job = std::move (queue.front());
+		queue.pop_front();
+		busy++;
+		lock.unlock();
+
+		Tile tile = job.load();
+
+		lock.lock();
+		if (tile.data) done.push_back (std::make_pair (job.key, tile));
+		else pending.erase (job.key);
+		busy--;
+		cvIdle.notify_all();
+	}
+}
+
+void TileLoadQueue::Collect (std::vector<std::pair<Key,Tile> > &ready)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	for (auto &d : done) {
+		pending.erase (d.first);
+		ready.push_back (d);
+	}
+	nload += done.size();
+	done.clear();
+}
+
+void TileLoadQueue::Clear ()
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	queue.clear();
+	cvIdle.wait (lock, [this] { return busy == 0; });
+	for (auto &d : done) delete []d.second.data;
+	done.clear();
+	pending.clear();
+}
+
+TileLoadQueue::Stats TileLoadQueue::GetStats () const
+{
+	Stats stats;
+	stats.requested = nrequest.load();
+	stats.dropped = ndrop.load();
+	stats.loaded = nload.load();
+	return stats;
+}
@@ -0,0 +1,101 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// TileLoadQueue.h
+// Bounded queue of tile load requests, served by a fixed set of I/O
+// threads. Used by the elevation tile prefetcher (ElevPrefetch.h).
+// =======================================================================
+
+#ifndef __TILELOADQUEUE_H
+#define __TILELOADQUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// =======================================================================
+// class TileLoadQueue
+// Requests are keyed by (source, lvl, ilat, ilng). A key stays pending
+// while its request is queued, being loaded, or loaded but not yet
+// collected, and further requests for it are ignored. Requests beyond
+// the queue limit are dropped. The loaded tiles are handed to the owner
+// by Collect, so they can be processed on the owner's thread.
+// All methods may be called concurrently. Independent of the Orbiter API.
+// =======================================================================
+
+class TileLoadQueue {
+public:
+	struct Key {
+		unsigned int src;    // tile source (ElevationTileCache::NewSource)
+		int lvl, ilat, ilng; // requested tile
+		bool operator< (const Key &k) const
+		{ return src != k.src ? src < k.src : lvl != k.lvl ? lvl < k.lvl : ilat != k.ilat ? ilat < k.ilat : ilng < k.ilng; }
+	};
+
+	struct Tile {
+		int lvl, ilat, ilng; // loaded tile (may differ from the requested one)
+		int16_t *data;       // tile data (allocated with new[]), or null if nothing was loaded
+	};
+
+	typedef std::function<Tile()> LoadFunc;
+	// Loads the tile for a request. Runs on an I/O thread.
+
+	TileLoadQueue (int nthread, size_t maxqueue = 1024);
+	// nthread: number of I/O threads
+	// maxqueue: max. number of queued requests; further requests are dropped
+
+	~TileLoadQueue ();
+
+	int nThread () const { return (int)threads.size(); }
+
+	bool Request (const Key &key, LoadFunc load);
+	// Queue a request. Returns false if the key is already pending or the
+	// queue is full.
+
+	void Collect (std::vector<std::pair<Key,Tile> > &ready);
+	// Append the tiles loaded since the last call to ready. The caller takes
+	// over the tile data, and the keys can be requested again. Loads which
+	// returned no data are not reported.
+
+	void Clear ();
+	// Discard all queued requests and wait for running loads to finish.
+	// Tiles not yet collected are deleted.
+
+	struct Stats {
+		uint64_t requested;  // requests queued
+		uint64_t dropped;    // requests dropped because the queue was full
+		uint64_t loaded;     // tiles handed out by Collect
+	};
+	Stats GetStats () const;
+
+private:
+	void WorkerLoop ();
+
+	struct Job {
+		Key key;
+		LoadFunc load;
+	};
+
+	size_t maxqueue;
+	std::vector<std::thread> threads;
+	mutable std::mutex mtx;         // guards the members below
+	std::condition_variable cv;     // signals new jobs or shutdown
+	std::condition_variable cvIdle; // signals that a worker finished a job
+	std::deque<Job> queue;          // requests waiting for a worker
+	std::vector<std::pair<Key,Tile> > done; // loaded tiles waiting for Collect
+	std::set<Key> pending;          // requests queued, loading or waiting for Collect
+	int busy;                       // workers currently loading
+	bool quit;
+
+	std::atomic<uint64_t> nrequest, ndrop, nload;
+};
+
+#endif // !__TILELOADQUEUE_H
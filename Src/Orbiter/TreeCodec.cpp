@@ -0,0 +1,82 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// ======================================================================
+// Tile tree archive codecs (see TreeCodec.h)
+// ======================================================================
+
+#include "TreeCodec.h"
+#include <ctype.h>
+#include "zlib.h"
+#include "zstd.h"
+#include "lz4.h"
+#include "lz4hc.h"
+
+static const char *codecName[TREECODEC_COUNT] = { "zlib", "zstd", "lz4" };
+
+static const int ZSTD_LEVEL = 19; // archives are packed once, so favour the ratio; decoding speed is independent of the level
+
+const char *TreeCodecName (int codec)
+{
+	return (codec >= 0 && codec < TREECODEC_COUNT ? codecName[codec] : 0);
+}
+
+int TreeCodecFromName (const char *name)
+{
+	for (int codec = 0; codec < TREECODEC_COUNT; codec++) {
+		const char *a = name, *b = codecName[codec];
+		while (*a && tolower ((unsigned char)*a) == *b) a++, b++;
+		if (!*a && !*b) return codec;
+	}
+	return -1;
+}
+
+uint32_t TreeCodecBound (int codec, uint32_t ninp)
+{
+	switch (codec) {
+	case TREECODEC_ZLIB: return (uint32_t)compressBound (ninp);
+	case TREECODEC_ZSTD: return (uint32_t)ZSTD_compressBound (ninp);
+	case TREECODEC_LZ4:  return (uint32_t)LZ4_compressBound ((int)ninp);
+	default:             return 0;
+	}
+}
+
+uint32_t TreeDeflate (int codec, const uint8_t *inp, uint32_t ninp, uint8_t *outp, uint32_t noutp)
+{
+	switch (codec) {
+	case TREECODEC_ZLIB: {
+		uLongf ndata = noutp;
+		return (compress (outp, &ndata, inp, ninp) == Z_OK ? (uint32_t)ndata : 0);
+		}
+	case TREECODEC_ZSTD: {
+		size_t ndata = ZSTD_compress (outp, noutp, inp, ninp, ZSTD_LEVEL);
+		return (ZSTD_isError (ndata) ? 0 : (uint32_t)ndata);
+		}
+	case TREECODEC_LZ4: {
+		int ndata = LZ4_compress_HC ((const char*)inp, (char*)outp, (int)ninp, (int)noutp, LZ4HC_CLEVEL_MAX);
+		return (ndata > 0 ? (uint32_t)ndata : 0);
+		}
+	default:
+		return 0;
+	}
+}
+
+uint32_t TreeInflate (int codec, const uint8_t *inp, uint32_t ninp, uint8_t *outp, uint32_t noutp)
+{
+	switch (codec) {
+	case TREECODEC_ZLIB: {
+		uLongf ndata = noutp;
+		return (uncompress (outp, &ndata, inp, ninp) == Z_OK ? (uint32_t)ndata : 0);
+		}
+	case TREECODEC_ZSTD: {
+		size_t ndata = ZSTD_decompress (outp, noutp, inp, ninp);
+		return (ZSTD_isError (ndata) ? 0 : (uint32_t)ndata);
+		}
+	case TREECODEC_LZ4: {
+		int ndata = LZ4_decompress_safe ((const char*)inp, (char*)outp, (int)ninp, (int)noutp);
+		return (ndata > 0 ? (uint32_t)ndata : 0);
+		}
+	default:
+		return 0;
+	}
+}
@@ -0,0 +1,53 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// TreeCodec.h
+// Compression codecs for the node data of tile tree (.tree) archives.
+// Shared by the archive readers (ZTreeMgr) and the packing tool (texpack).
+// Independent of the Orbiter API.
+// =======================================================================
+
+#ifndef __TREECODEC_H
+#define __TREECODEC_H
+
+#include <stdint.h>
+
+// =======================================================================
+// Archive format versions and header flags
+// Version 1 archives are always zlib-compressed. Version 2 archives store
+// the codec in the header flags; their version byte makes older readers
+// reject them instead of misreading the data.
+
+const uint8_t TREEFILE_VERSION_ZLIB  = 1;  // header version for zlib archives
+const uint8_t TREEFILE_VERSION_CODEC = 2;  // header version for other codecs
+
+const uint32_t TREEFILE_DEFLATE     = 0x01; // node data are compressed
+const uint32_t TREEFILE_CODEC_MASK  = 0xF0; // codec id (version 2 only)
+const int      TREEFILE_CODEC_SHIFT = 4;
+
+enum TreeCodec {
+	TREECODEC_ZLIB,    // zlib deflate (default)
+	TREECODEC_ZSTD,    // Zstandard
+	TREECODEC_LZ4,     // LZ4 (high-compression encoder, fast decoder)
+	TREECODEC_COUNT
+};
+
+const char *TreeCodecName (int codec);
+// Codec name ("zlib", "zstd", "lz4"), or 0 for an invalid codec
+
+int TreeCodecFromName (const char *name);
+// Codec id for a name (case-insensitive), or -1 if unknown
+
+uint32_t TreeCodecBound (int codec, uint32_t ninp);
+// Max. compressed size of ninp bytes [bytes]
+
+uint32_t TreeDeflate (int codec, const uint8_t *inp, uint32_t ninp, uint8_t *outp, uint32_t noutp);
+// Compress ninp bytes into outp (of size noutp, at least TreeCodecBound).
+// Returns the compressed size, or 0 on failure.
+
+uint32_t TreeInflate (int codec, const uint8_t *inp, uint32_t ninp, uint8_t *outp, uint32_t noutp);
+// Decompress a node of ninp bytes into outp of size noutp. Returns the
+// decompressed size, or 0 on failure. May be called concurrently.
+
+#endif // !__TREECODEC_H
@@ -23,8 +23,16 @@ const double LOG2  = 1.0/log(2.0); // conversion factor from log->log2
 inline double Rad (double deg) { return _RAD_*deg; }
 inline double Deg (double rad) { return _DEG_*rad; }
 
+class Vector;
+class Matrix;
+class Vector4;
+class Matrix4;
 class Quaternion;
 
+// QR decomposition (defined with the matrix classes below)
+void qrdcmp (Matrix &a, Vector &c, Vector &d, int *sing = 0);
+void qrdcmp (Matrix4 &a, Vector4 &c, Vector4 &d, int *sing = 0);
+
 // =======================================================================
 // Auxiliary functions
 
@@ -227,7 +235,7 @@ public:
 
 	void orthogonalise (int axis);
 
-	friend void qrdcmp (Matrix &a, Vector &c, Vector &d, int *sing = 0);
+	friend void qrdcmp (Matrix &a, Vector &c, Vector &d, int *sing);
 	friend void qrsolv (const Matrix &a, const Vector &c, const Vector &d, Vector &b);
 
 	union {
@@ -310,7 +318,7 @@ public:
 	inline double operator() (int i, int j) const
 	{ return data[i*4+j]; }
 
-	friend void qrdcmp (Matrix4 &a, Vector4 &c, Vector4 &d, int *sing = 0);
+	friend void qrdcmp (Matrix4 &a, Vector4 &c, Vector4 &d, int *sing);
 	friend void qrsolv (const Matrix4 &a, const Vector4 &c, const Vector4 &d, Vector4 &b);
 	friend void QRFactorize (Matrix4 &A, Vector4 &c, Vector4 &d);
 	friend void RSolve (const Matrix4 &A, const Vector4 &d, Vector4 &b);
@@ -297,6 +297,7 @@ void Vessel::SetDefaultState ()
 	proxyvessel         = 0;
 	supervessel         = 0;
 	scanvessel          = 0;
+	bPropagated         = false;
 	attmode             = 1;
 	ctrlsurfmode        = 0;
 	for (i = 0; i < 6; i++)
@@ -1131,6 +1132,13 @@ bool Vessel::isOrbitStabilised () const
 
 // ==============================================================
 
+bool Vessel::isFastForwarded () const
+{
+	return supervessel ? supervessel->isFastForwarded() : bFastForwarded;
+}
+
+// ==============================================================
+
 bool Vessel::SetTouchdownPoints (const TOUCHDOWNVTX *tdvtx, DWORD ntp)
 {
 	dCHECK(ntp >= 3, "Vessel::SetTouchdownPoints: at least 3 points must be provided");
@@ -4711,6 +4719,11 @@ bool Vessel::AddSurfaceForces (Vector *F, Vector *M, const StateVectors *s, doub
 
 void Vessel::Update (bool force)
 {
+	// The flag set by Propagate only applies to this step. Clear it on every
+	// path, since the vessel may have been attached or docked since then.
+	bool propagated = bPropagated;
+	bPropagated = false;
+
 	// if the vessel is part of a composite structure or passively attached
 	// to a parent vessel, its state is updated by the composite or parent
 	if (attach)
@@ -4723,6 +4736,8 @@ void Vessel::Update (bool force)
 		if (!supervessel) {
 			if (bFRplayback) {
 				FRecorder_Play();          // update from playback stream
+			} else if (propagated) {
+				// already integrated in the concurrent phase
 			} else {
 				RigidBody::Update (force); // standard dynamic update
 			}
@@ -4930,6 +4945,30 @@ void Vessel::Update (bool force)
 	UpdateAttachments();
 }
 
+bool Vessel::CanPropagateConcurrently (bool force) const
+{
+	// Only independent free-flying vessels qualify. Their integration reads the
+	// celestial body states and writes nothing but their own state, as long as
+	// they stay clear of surface contact checks (elevation queries) for the
+	// whole step, so ElevationManager::Elevation is only called from the
+	// simulation thread. The gravity source rescan is excluded because it
+	// randomises its next update time.
+	if (force || attach || supervessel || bFRplayback) return false;
+	if (fstatus != FLIGHTSTATUS_FREEFLIGHT || !bDynamicPosVel) return false;
+	if (!gfielddata.ngrav) return false;
+	if (proxybody) {
+		double vrel = (s0->vel - proxybody->GVel()).length();
+		if (sp.alt < 1e4 + 2.0*size + vrel*td.SimDT) return false;
+	}
+	return true;
+}
+
+void Vessel::Propagate (bool force)
+{
+	RigidBody::Update (force);
+	bPropagated = true;
+}
+
 void Vessel::UpdatePassive ()
 {
 	StateVectors *s = (s1 ? s1:s0); // hack - this should really only be called during update phase
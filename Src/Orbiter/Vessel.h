@@ -1129,6 +1129,15 @@ public:
 
 	void Update (bool force = false);
 	void UpdatePassive ();
+
+	bool CanPropagateConcurrently (bool force) const;
+	// true if the vessel's dynamic state integration for the current step
+	// only reads shared data and can run on a worker thread
+
+	void Propagate (bool force);
+	// integrate the vessel's free-flight state ahead of Update. Only valid
+	// if CanPropagateConcurrently returned true for this step
+
 	void UpdateAttachments();
 	void UpdateBodyForces ();
 	void UpdateThrustForces ();
@@ -1209,6 +1218,9 @@ public:
 	bool isOrbitStabilised () const;
 	// true if vessel uses 2-body analytic update to stabilise orbit
 
+	bool isFastForwarded () const;
+	// true if vessel orbit is propagated analytically (fast-forward mode)
+
 	bool HasExtpassMeshes() const { return extpassmesh; }
 	// returns true if visual representation contins meshes that are rendered
 	// in the external render pass during cockpit view
@@ -1310,6 +1322,8 @@ protected:
 
 	bool ThrustEngaged () const { return m_bThrustEngaged; }
 
+	bool CanFastForward () const { return !bForceActive && VesselBase::CanFastForward(); }
+
 	bool IsComponent () const { return supervessel != 0 || attach; }
 	const VesselBase *GetSuperStructure () const;
 
@@ -1641,6 +1655,7 @@ private:
 	int   lstatus;            // landing/docking comms status (0=no contact, 1=contact,
 	DWORD nport;              // allocated landing pad/docking port no (>=0, (DWORD)-1=none)
 	UINT  scanvessel;         // next vessel to check for docking event
+	bool  bPropagated;        // state already integrated by Propagate for this step
 
 	mutable bool surfprm_valid;
 	bool pyp_valid;
@@ -397,6 +397,13 @@ void VesselBase::SetPropagator (int &plevel, int &nstep) const
 	collision_during_update = false; // reset collision check
 }
 
+// ==============================================================
+
+bool VesselBase::CanFastForward () const
+{
+	return !bSurfaceContact && !sp.is_in_atm && !ThrustEngaged();
+}
+
 // =======================================================================
 
 bool VesselBase::ValidateStateUpdate (StateVectors *s)
@@ -174,6 +174,9 @@ protected:
 	virtual void SetPropagator (int &plevel, int &nstep) const;
 	// set timestep propagator parameters; overrides defaults during ground contact
 
+	virtual bool CanFastForward () const;
+	// no fast-forward propagation with surface contact, in atmosphere or with engines firing
+
 	virtual bool ValidateStateUpdate (StateVectors *s);
 
 	virtual bool AddSurfaceForces (Vector *F, Vector *M,
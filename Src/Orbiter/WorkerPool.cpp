@@ -0,0 +1,92 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// WorkerPool.cpp
+// Fixed set of worker threads for data-parallel loops in the simulation
+// update phase.
+// =======================================================================
+
+#include "WorkerPool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool (int nthread)
+{
+	job = 0;
+	jobSize = 0;
+	chunk = 1;
+	next = 0;
+	generation = 0;
+	nBusy = 0;
+	bQuit = false;
+	for (int i = 0; i < nthread; i++)
+		threads.emplace_back (&WorkerPool::WorkerLoop, this);
+}
+
+WorkerPool::~WorkerPool ()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		bQuit = true;
+	}
+	cvStart.notify_all();
+	for (auto &t : threads)
+		t.join();
+}
+
+void WorkerPool::ParallelFor (size_t n, const std::function<void(size_t)> &func)
+{
+	if (!n) return;
+	if (threads.empty() || n == 1) {
+		for (size_t i = 0; i < n; i++) func(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		job = &func;
+		jobSize = n;
+		// aim for a few chunks per thread to balance uneven per-index cost
+		chunk = std::max ((size_t)1, n / ((threads.size()+1) * 8));
+		next = 0;
+		nBusy = (int)threads.size();
+		generation++;
+	}
+	cvStart.notify_all();
+
+	RunChunks();
+
+	std::unique_lock<std::mutex> lock(mtx);
+	cvDone.wait (lock, [this] { return nBusy == 0; });
+	job = 0;
+}
+
+void WorkerPool::RunChunks ()
+{
+	const std::function<void(size_t)> &func = *job;
+	for (;;) {
+		size_t i0 = next.fetch_add (chunk);
+		if (i0 >= jobSize) break;
+		size_t i1 = std::min (i0 + chunk, jobSize);
+		for (size_t i = i0; i < i1; i++)
+			func(i);
+	}
+}
+
+void WorkerPool::WorkerLoop ()
+{
+	unsigned int seen = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			cvStart.wait (lock, [&] { return bQuit || generation != seen; });
+			if (bQuit) return;
+			seen = generation;
+		}
+		RunChunks();
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			if (--nBusy == 0) cvDone.notify_one();
+		}
+	}
+}
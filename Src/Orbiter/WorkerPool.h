@@ -0,0 +1,55 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// WorkerPool.h
+// Fixed set of worker threads for data-parallel loops in the simulation
+// update phase.
+// =======================================================================
+
+#ifndef __WORKERPOOL_H
+#define __WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool {
+public:
+	WorkerPool (int nthread);
+	// Create a pool with nthread workers. The calling thread takes part in
+	// ParallelFor as well, so nthread+1 threads share the work.
+
+	~WorkerPool ();
+
+	int nThread () const { return (int)threads.size(); }
+
+	void ParallelFor (size_t n, const std::function<void(size_t)> &func);
+	// Call func(i) for i = 0..n-1 and return when all calls have completed.
+	// Indices are claimed dynamically in small chunks, so threads that finish
+	// early keep taking work from the remainder of the range.
+	// The order in which func is called is unspecified: func must only
+	// modify data that belongs to index i.
+
+private:
+	void WorkerLoop ();
+	void RunChunks ();
+
+	std::vector<std::thread> threads;
+	std::mutex mtx;
+	std::condition_variable cvStart;  // signalled when a new job is posted
+	std::condition_variable cvDone;   // signalled when the last worker leaves a job
+
+	const std::function<void(size_t)> *job; // current loop body
+	size_t jobSize;                   // number of indices in the current job
+	size_t chunk;                     // indices claimed per fetch
+	std::atomic<size_t> next;         // next unclaimed index
+	unsigned int generation;          // job counter, used to wake the workers
+	int nBusy;                        // workers still working on the current job
+	bool bQuit;
+};
+
+#endif // !__WORKERPOOL_H
@@ -1,9 +1,27 @@
 // Copyright (c) Martin Schweiger
 // Licensed under the MIT License
 
+#include <stdio.h>
+#include <string.h>
 #include "ZTreeMgr.h"
-#include "zlib.h"
-#include "util.h"
+
+static const size_t POOLSIZE = 8;  // max. number of released buffers kept for reuse
+static const size_t BUFHDR = 16;   // buffer prefix storing the capacity (keeps the data aligned)
+static const int MAXLEVEL = 31;    // max. tree level accepted from the TOC
+
+// Index key of a node above level 4 (never 0)
+static inline uint64_t NodeKey(int lvl, int ilat, int ilng)
+{
+	return ((uint64_t)lvl << 56) | ((uint64_t)ilat << 28) | (uint64_t)ilng;
+}
+
+static inline size_t KeyHash(uint64_t key)
+{
+	key ^= key >> 31;
+	key *= 0x7fb5d329728ea185ull;
+	key ^= key >> 27;
+	return (size_t)key;
+}
 
 // =======================================================================
 // File header for compressed tree files
@@ -12,10 +30,10 @@ TreeFileHeader::TreeFileHeader ()
 {
 	magic[0] = 'T';
 	magic[1] = 'X';
-	magic[2] = 1;
+	magic[2] = TREEFILE_VERSION_ZLIB;
 	magic[3] = 0;
 	size = sizeof(TreeFileHeader);
-	flags = 0;
+	flags = TREEFILE_DEFLATE;
 	nodeCount = 0;
 	dataOfs = size;
 	dataLength = 0;
@@ -31,23 +49,40 @@ size_t TreeFileHeader::fwrite(FILE *f)
 
 // -----------------------------------------------------------------------
 
-bool TreeFileHeader::fread(FILE *f)
+bool TreeFileHeader::Read(const BYTE *buf, uint64_t fsize)
 {
-	BYTE buf[4];
-	DWORD sz, flags;
-	if (::fread(buf, 1, 4, f) < 4 || memcmp(buf, magic, 4))
+	DWORD sz;
+	if (fsize < sizeof(TreeFileHeader) || buf[0] != magic[0] || buf[1] != magic[1] || buf[3] != magic[3])
 		return false;
-	if (::fread(&sz, sizeof(DWORD), 1, f) != 1 || sz != size)
+	if (buf[2] != TREEFILE_VERSION_ZLIB && buf[2] != TREEFILE_VERSION_CODEC)
 		return false;
-	::fread(&flags, sizeof(DWORD), 1, f);
-	::fread(&dataOfs, sizeof(DWORD), 1, f);
-	::fread(&dataLength, sizeof(__int64), 1, f);
-	::fread(&nodeCount, sizeof(DWORD), 1, f);
-	::fread(&rootPos1, sizeof(DWORD), 1, f);
-	::fread(&rootPos2, sizeof(DWORD), 1, f);
-	::fread(&rootPos3, sizeof(DWORD), 1, f);
-	::fread(rootPos4, sizeof(DWORD), 2, f);
-	return true;
+	memcpy(&sz, buf+4, sizeof(DWORD));
+	if (sz != size)
+		return false;
+	memcpy(this, buf, sizeof(TreeFileHeader)); // file layout is the member layout
+	if (Codec() < 0)
+		return false;
+	return (__int64)dataOfs + dataLength <= (__int64)fsize &&
+		(__int64)size + (__int64)nodeCount*sizeof(TreeNode) <= (__int64)dataOfs;
+}
+
+// -----------------------------------------------------------------------
+
+int TreeFileHeader::Codec() const
+{
+	if (magic[2] == TREEFILE_VERSION_ZLIB)
+		return TREECODEC_ZLIB;
+	int codec = (int)((flags & TREEFILE_CODEC_MASK) >> TREEFILE_CODEC_SHIFT);
+	return (codec < TREECODEC_COUNT ? codec : -1);
+}
+
+// -----------------------------------------------------------------------
+
+void TreeFileHeader::SetCodec(int codec)
+{
+	// zlib archives keep version 1, so that older readers can use them
+	magic[2] = (codec == TREECODEC_ZLIB ? TREEFILE_VERSION_ZLIB : TREEFILE_VERSION_CODEC);
+	flags = (flags & ~TREEFILE_CODEC_MASK) | (codec == TREECODEC_ZLIB ? 0 : (DWORD)codec << TREEFILE_CODEC_SHIFT);
 }
 
 // =======================================================================
@@ -73,7 +108,7 @@ TreeTOC::~TreeTOC()
 
 // -----------------------------------------------------------------------
 
-size_t TreeTOC::fread(DWORD size, FILE *f)
+bool TreeTOC::Read(const BYTE *buf, DWORD size)
 {
 	if (ntreebuf != size) {
 		TreeNode *tmp = new TreeNode[size];
@@ -81,15 +116,16 @@ size_t TreeTOC::fread(DWORD size, FILE *f)
 		tree = tmp;
 		ntree = ntreebuf = size;
 	}
-	return ::fread(tree, sizeof(TreeNode), size, f);
+	memcpy(tree, buf, size*sizeof(TreeNode));
+	return size > 0;
 }
 
 // =======================================================================
 // ZTreeMgr class: manage a single layer tree for a planet
 
-ZTreeMgr *ZTreeMgr::CreateFromFile(const char *PlanetPath, Layer _layer)
+ZTreeMgr *ZTreeMgr::CreateFromFile(const char *PlanetPath, Layer _layer, bool map)
 {
-	ZTreeMgr *mgr = new ZTreeMgr(PlanetPath, _layer);
+	ZTreeMgr *mgr = new ZTreeMgr(PlanetPath, _layer, map);
 	if (!mgr->TOC().size()) {
 		delete mgr;
 		mgr = 0;
@@ -99,13 +135,17 @@ ZTreeMgr *ZTreeMgr::CreateFromFile(const char *PlanetPath, Layer _layer)
 
 // -----------------------------------------------------------------------
 
-ZTreeMgr::ZTreeMgr(const char *PlanetPath, Layer _layer)
+ZTreeMgr::ZTreeMgr(const char *PlanetPath, Layer _layer, bool map)
 {
 	path = new char[strlen(PlanetPath)+1];
 	strcpy(path, PlanetPath);
 	layer = _layer;
-	treef = 0;
-	OpenArchive();
+	codec = TREECODEC_ZLIB;
+	imask = 0;
+	if (OpenArchive(map) && !BuildIndex()) { // corrupt TOC: treat as no archive
+		treef.Close();
+		toc.ntree = 0;
+	}
 }
 
 // -----------------------------------------------------------------------
@@ -114,23 +154,24 @@ ZTreeMgr::~ZTreeMgr()
 {
 	delete []path;
 	path = NULL;
-	if (treef) fclose(treef);
+	for (size_t i = 0; i < pool.size(); i++)
+		delete [](pool[i]-BUFHDR);
 }
 
 // -----------------------------------------------------------------------
 
-bool ZTreeMgr::OpenArchive()
+bool ZTreeMgr::OpenArchive(bool map)
 {
 	const char *name[6] = { "Surf", "Mask", "Elev", "Elev_mod", "Label", "Cloud" };
 	char fname[256];
 	sprintf (fname, "%s\\Archive\\%s.tree", path, name[layer]);
-	treef = fopen(fname, "rb");
-	if (!treef) return false;
+	if (!treef.Open(fname, map) && (!map || !treef.Open(fname, false))) // fall back to file reads if the mapping fails
+		return false;
 
 	TreeFileHeader tfh;
-	if (!tfh.fread(treef)) {
-		fclose(treef);
-		treef = 0;
+	BYTE hbuf[sizeof(TreeFileHeader)];
+	if (!treef.Read(0, hbuf, sizeof(hbuf)) || !tfh.Read(hbuf, treef.Size())) {
+		treef.Close();
 		return false;
 	}
 	rootPos1 = tfh.rootPos1;
@@ -139,10 +180,11 @@ bool ZTreeMgr::OpenArchive()
 	for (int i = 0; i < 2; i++)
 		rootPos4[i] = tfh.rootPos4[i];
 	dofs = (__int64)tfh.dataOfs;
+	codec = tfh.Codec();
 
-	if (!toc.fread(tfh.nodeCount, treef)) {
-		fclose(treef);
-		treef = 0;
+	std::vector<BYTE> tbuf((size_t)tfh.nodeCount*sizeof(TreeNode));
+	if (!treef.Read(tfh.size, tbuf.data(), tbuf.size()) || !toc.Read(tbuf.data(), tfh.nodeCount)) {
+		treef.Close();
 		return false;
 	}
 	toc.totlength = tfh.dataLength;
@@ -152,67 +194,181 @@ bool ZTreeMgr::OpenArchive()
 
 // -----------------------------------------------------------------------
 
-DWORD ZTreeMgr::Idx(int lvl, int ilat, int ilng)
+bool ZTreeMgr::BuildIndex()
 {
-	if (lvl <= 4) {
-		return (lvl == 1 ? rootPos1 : lvl == 2 ? rootPos2 : lvl == 3 ? rootPos3 : rootPos4[ilng]);
-	} else {
-		int plvl = lvl-1;
-		int pilat = ilat/2;
-		int pilng = ilng/2;
-		DWORD pidx = Idx(plvl, pilat, pilng);
-		if (pidx == (DWORD)-1)
-			return pidx;
-		int cidx = ((ilat&1) << 1) + (ilng&1);
-		return toc[pidx].child[cidx];
+	// size the table for a load factor of at most 3/4
+	size_t n = 0, nslot = 16;
+	for (DWORD i = 0; i < toc.size(); i++)
+		for (int j = 0; j < 4; j++)
+			if (toc[i].child[j] < toc.size()) n++;
+	while (nslot*3 < n*4) nslot *= 2;
+	ikey.assign(nslot, 0);
+	iidx.assign(nslot, (DWORD)-1);
+	imask = nslot-1;
+
+	// Each node may be reached only once. A node linked twice (e.g. a cycle
+	// back to an ancestor) would be indexed under several keys and could
+	// overfill the table.
+	std::vector<bool> visited(toc.size(), false);
+	for (int i = 0; i < 2; i++) {
+		if (rootPos4[i] >= toc.size()) continue;
+		if (visited[rootPos4[i]]) return CorruptIndex();
+		visited[rootPos4[i]] = true;
 	}
+	for (int i = 0; i < 2; i++)
+		if (!IndexSubtree(rootPos4[i], 4, 0, i, visited))
+			return CorruptIndex();
+	return true;
 }
 
 // -----------------------------------------------------------------------
 
-DWORD ZTreeMgr::ReadData(DWORD idx, BYTE **outp)
+bool ZTreeMgr::IndexSubtree(DWORD idx, int lvl, int ilat, int ilng, std::vector<bool> &visited)
+{
+	if (idx >= toc.size() || lvl >= MAXLEVEL) return true;
+	for (int i = 0; i < 4; i++) {
+		DWORD cidx = toc[idx].child[i];
+		if (cidx >= toc.size()) continue;
+		if (visited[cidx]) return false; // node linked twice (corrupt TOC)
+		visited[cidx] = true;
+		int clat = ilat*2 + i/2, clng = ilng*2 + i%2;
+		uint64_t key = NodeKey(lvl+1, clat, clng);
+		size_t h = KeyHash(key) & imask;
+		while (ikey[h]) h = (h+1) & imask; // keys of distinct nodes are distinct
+		ikey[h] = key;
+		iidx[h] = cidx;
+		if (!IndexSubtree(cidx, lvl+1, clat, clng, visited)) return false;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool ZTreeMgr::CorruptIndex()
 {
-	if (idx == (DWORD)-1) return 0; // sanity check
+	ikey.clear();
+	iidx.clear();
+	imask = 0;
+	return false;
+}
 
-	DWORD esize = NodeSizeInflated(idx);
-	if (!esize) // node doesn't have data, but has descendants with data
-		return 0;
+// -----------------------------------------------------------------------
 
-	if (_fseeki64(treef, toc[idx].pos+dofs, SEEK_SET))
+size_t ZTreeMgr::IndexSize() const
+{
+	return ikey.capacity()*sizeof(uint64_t) + iidx.capacity()*sizeof(DWORD);
+}
+
+// -----------------------------------------------------------------------
+
+DWORD ZTreeMgr::Idx(int lvl, int ilat, int ilng) const
+{
+	if (lvl < 4)
+		return (lvl == 1 ? rootPos1 : lvl == 2 ? rootPos2 : lvl == 3 ? rootPos3 : (DWORD)-1);
+	if (lvl == 4)
+		return (ilng == 0 || ilng == 1 ? rootPos4[ilng] : (DWORD)-1);
+	if (!imask || lvl > MAXLEVEL || ilat < 0 || ilng < 0 || ilat >= (1 << (lvl-4)) || ilng >= (2 << (lvl-4)))
+		return (DWORD)-1;
+	uint64_t key = NodeKey(lvl, ilat, ilng);
+	for (size_t h = KeyHash(key) & imask; ikey[h]; h = (h+1) & imask)
+		if (ikey[h] == key) return iidx[h];
+	return (DWORD)-1;
+}
+
+// -----------------------------------------------------------------------
+
+DWORD ZTreeMgr::NodeData(DWORD idx, const BYTE **zdata, std::vector<BYTE> &buf) const
+{
+	if (idx >= toc.size() || !NodeSizeInflated(idx)) // no node, or node without data but with descendants with data
 		return 0;
 
+	__int64 ofs = toc[idx].pos+dofs;
 	DWORD zsize = NodeSizeDeflated(idx);
-	BYTE *zbuf = new BYTE[zsize];	
-	fread(zbuf, 1, zsize, treef);
+	if (ofs < dofs || ofs+zsize > (__int64)treef.Size()) // corrupt TOC entry
+		return 0;
+	if (treef.IsMapped()) {
+		*zdata = treef.Data()+ofs;
+	} else {
+		buf.resize(zsize);
+		if (!treef.Read(ofs, buf.data(), zsize))
+			return 0;
+		*zdata = buf.data();
+	}
+	return zsize;
+}
 
-	BYTE *ebuf = new BYTE[esize];
+// -----------------------------------------------------------------------
 
-	DWORD ndata = Inflate(zbuf, zsize, ebuf, esize);
-	delete []zbuf;
-	zbuf = NULL;
+DWORD ZTreeMgr::ReadData(DWORD idx, BYTE *outp, DWORD noutp) const
+{
+	static thread_local std::vector<BYTE> rbuf; // compressed data read from an unmapped archive
+	const BYTE *zbuf;
+	DWORD zsize = NodeData(idx, &zbuf, rbuf);
+	if (!zsize || noutp < NodeSizeInflated(idx))
+		return 0;
+	return Inflate(zbuf, zsize, outp, NodeSizeInflated(idx));
+}
+
+// -----------------------------------------------------------------------
+
+DWORD ZTreeMgr::ReadData(DWORD idx, BYTE **outp)
+{
+	static thread_local std::vector<BYTE> rbuf; // compressed data read from an unmapped archive
+	const BYTE *zbuf;
+	DWORD zsize = NodeData(idx, &zbuf, rbuf);
+	if (!zsize)
+		return 0;
+
+	// take the smallest pooled buffer that fits, or allocate a new one
+	DWORD esize = NodeSizeInflated(idx);
+	BYTE *ebuf = 0;
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		size_t j, jmin = pool.size();
+		for (j = 0; j < pool.size(); j++) {
+			DWORD cap = *(DWORD*)(pool[j]-BUFHDR);
+			if (cap >= esize && (jmin == pool.size() || cap < *(DWORD*)(pool[jmin]-BUFHDR)))
+				jmin = j;
+		}
+		if (jmin < pool.size()) {
+			ebuf = pool[jmin];
+			pool[jmin] = pool.back();
+			pool.pop_back();
+		}
+	}
+	if (!ebuf) {
+		ebuf = new BYTE[BUFHDR+esize+1]+BUFHDR;
+		*(DWORD*)(ebuf-BUFHDR) = esize;
+	}
 
+	DWORD ndata = Inflate(zbuf, zsize, ebuf, esize);
 	if (!ndata) {
-		delete []ebuf;
+		ReleaseData(ebuf);
 		ebuf = 0;
-	}
+	} else
+		ebuf[ndata] = 0;
 	*outp = ebuf;
 	return ndata;
 }
 
 // -----------------------------------------------------------------------
 
-DWORD ZTreeMgr::Inflate(const BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp)
+DWORD ZTreeMgr::Inflate(const BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp) const
 {
-	DWORD ndata = noutp;
-	if (uncompress (outp, &ndata, inp, ninp) != Z_OK)
-		return 0;
-	return ndata;
+	return TreeInflate(codec, inp, ninp, outp, noutp);
 }
 
 // -----------------------------------------------------------------------
 
 void ZTreeMgr::ReleaseData(BYTE *data)
 {
-	delete []data;
-	data = NULL;
-}
\ No newline at end of file
+	if (!data) return;
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		if (pool.size() < POOLSIZE) {
+			pool.push_back(data);
+			return;
+		}
+	}
+	delete [](data-BUFHDR);
+}
@@ -4,13 +4,18 @@
 // =======================================================================
 // ZTreeMgr.h
 // Manage compressed and packed tile trees for planetary surface and cloud layers.
+// Shared by the orbiter core (elevation) and the D3D9 graphics client.
 // =======================================================================
 
 #ifndef __ZTREEMGR_H
 #define __ZTREEMGR_H
 
 #include <iostream>
+#include <mutex>
+#include <vector>
 #include <windows.h>
+#include "MappedFile.h"
+#include "TreeCodec.h"
 
 // =======================================================================
 // Tree node structure
@@ -36,12 +41,18 @@ class TreeFileHeader {
 public:
 	TreeFileHeader();
 	size_t fwrite(FILE *f);
-	bool fread(FILE *f);
+	bool Read(const BYTE *buf, uint64_t fsize);
+	// Read the header from buf (the first sizeof(TreeFileHeader) bytes of a
+	// file of length fsize [bytes])
+	int Codec() const;
+	// node data codec (TreeCodec)
+	void SetCodec(int codec);
+	// select the node data codec; sets the matching format version
 
 private:
-	BYTE magic[4];      // file ID and version
+	BYTE magic[4];      // file ID and version (see TreeCodec.h)
 	DWORD size;         // header size [bytes]
-	DWORD flags;        // bit flags
+	DWORD flags;        // bit flags (TREEFILE_xxx)
 	DWORD dataOfs;      // file offset of start of data block (header + TOC)
 	__int64 dataLength; // total length of compressed data block
 	DWORD nodeCount;    // total number of tree nodes
@@ -60,7 +71,8 @@ class TreeTOC {
 public:
 	TreeTOC();
 	~TreeTOC();
-	size_t fread(DWORD size, FILE *f);
+	bool Read(const BYTE *buf, DWORD size);
+	// Copy size node entries from buf
 	inline DWORD size() const { return ntree; }
 	inline const TreeNode &operator[](int idx) const { return tree[idx]; }
 
@@ -79,19 +91,50 @@ private:
 
 // =======================================================================
 // ZTreeMgr class: manage a single layer tree for a planet
+// In 64-bit builds the archive is mapped into memory, so the compressed
+// node data can be accessed without copying. Archives of several GB don't
+// fit into the address space of a 32-bit process, so there (or if the
+// mapping fails) the node data are read from the file on demand.
+// All read methods may be called concurrently.
 
 class ZTreeMgr {
 public:
 	enum Layer { LAYER_SURF, LAYER_MASK, LAYER_ELEV, LAYER_ELEVMOD, LAYER_LABEL, LAYER_CLOUD };
-	static ZTreeMgr *CreateFromFile(const char *PlanetPath, Layer _layer);
-	ZTreeMgr(const char *PlanetPath, Layer _layer);
+	static ZTreeMgr *CreateFromFile(const char *PlanetPath, Layer _layer, bool map = (sizeof(size_t) > 4));
+	ZTreeMgr(const char *PlanetPath, Layer _layer, bool map = (sizeof(size_t) > 4));
+	// map: map the archive into memory if possible; otherwise read from the file
 	~ZTreeMgr();
 	const TreeTOC &TOC() const { return toc; }
 
-	DWORD Idx(int lvl, int ilat, int ilng);
+	DWORD Idx(int lvl, int ilat, int ilng) const;
 	// return the array index of an arbitrary tile ((DWORD)-1: not present)
+	// Constant time: tiles above level 4 are looked up in a hash index
+	// built from the TOC when the archive is opened. An archive whose TOC
+	// links a node more than once is treated as corrupt and not opened.
+
+	inline bool HasTile(int lvl, int ilat, int ilng) const
+	{ return Idx(lvl, ilat, ilng) != (DWORD)-1; }
+
+	size_t IndexSize() const;
+	// memory used by the tile index [bytes]
+
+	DWORD NodeData(DWORD idx, const BYTE **zdata, std::vector<BYTE> &buf) const;
+	// Compressed data of a node (in the archive's codec). zdata points into
+	// the archive mapping (valid for the lifetime of the manager), or into
+	// buf if the archive is not mapped. Returns the data size [bytes], or 0
+	// if the node doesn't exist or has no data.
+
+	bool IsMapped() const { return treef.IsMapped(); }
+	// true if the archive is mapped into memory
+
+	DWORD ReadData(DWORD idx, BYTE *outp, DWORD noutp) const;
+	// Decompress the node data into a caller-provided buffer of noutp
+	// bytes, which must hold at least NodeSizeInflated(idx) bytes. Returns
+	// the data size, or 0 on failure.
 
 	DWORD ReadData(DWORD idx, BYTE **outp);
+	// Decompress the node data into a buffer taken from the manager's pool.
+	// The buffer is zero-terminated and must be returned with ReleaseData.
 
 	inline DWORD ReadData(int lvl, int ilat, int ilng, BYTE **outp)
 	{ return (ilat < 0 || ilng < 0) ? 0 : ReadData(Idx(lvl, ilat, ilng), outp); }
@@ -101,20 +144,41 @@ public:
 	inline DWORD NodeSizeDeflated(DWORD idx) const { return toc.NodeSizeDeflated(idx); }
 	inline DWORD NodeSizeInflated(DWORD idx) const { return toc.NodeSizeInflated(idx); }
 
+	int Codec() const { return codec; }
+	// codec of the node data (TreeCodec)
+
 protected:
-	bool OpenArchive();
-	DWORD Inflate(const BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp);
+	bool OpenArchive(bool map);
+	bool BuildIndex();
+	// build the tile index; false if the TOC is corrupt
+	bool IndexSubtree(DWORD idx, int lvl, int ilat, int ilng, std::vector<bool> &visited);
+	bool CorruptIndex();
+	// discard a partial index; returns false
+	DWORD Inflate(const BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp) const;
 
 private:
+	ZTreeMgr(const ZTreeMgr&) = delete;
+	ZTreeMgr &operator=(const ZTreeMgr&) = delete;
+
 	char *path;
 	Layer layer;
-	FILE *treef;
+	int codec;         // node data codec (TreeCodec)
+	MappedFile treef;  // archive mapping, or file for positional reads
 	TreeTOC toc;
 	DWORD rootPos1;    // index of level-1 tile ((DWORD)-1 for not present)
 	DWORD rootPos2;    // index of level-2 tile ((DWORD)-1 for not present)
 	DWORD rootPos3;    // index of level-3 tile ((DWORD)-1 for not present)
 	DWORD rootPos4[2]; // index of the level-4 tiles (quadtree roots; (DWORD)-1 for not present)
 	__int64 dofs;
+
+	// tile index: open addressing hash table of the nodes above level 4,
+	// keyed by NodeKey (0 = empty slot)
+	std::vector<uint64_t> ikey;
+	std::vector<DWORD> iidx;
+	size_t imask;      // table size - 1 (power of 2)
+
+	std::mutex poolMutex;     // guards pool
+	std::vector<BYTE*> pool;  // released buffers for reuse by ReadData
 };
 
 #endif // !__ZTREEMGR_H
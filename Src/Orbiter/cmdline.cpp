@@ -175,6 +175,7 @@ std::vector<::CommandLine::Key>& orbiter::CommandLine::KeyList() const
 		{ KEY_MAXSYSTIME, "maxsystime", 'T', true},
 		{ KEY_MAXSIMTIME, "maxsimtime", 't', true},
 		{ KEY_FRAMECOUNT, "maxframes", '_', true},
+		{ KEY_PROPTHREADS, "propthreads", '_', true},
 		{ KEY_PLUGIN, "plugin", 'p', true}
 	};
 	return keyList;
@@ -182,7 +183,7 @@ std::vector<::CommandLine::Key>& orbiter::CommandLine::KeyList() const
 
 void orbiter::CommandLine::ApplyOption(const Key* key, const std::string& value)
 {
-	int res;
+	int res, i;
 	size_t s;
 	double f;
 	CFG_CMDLINEPRM& cfg = m_pOrbiter->Cfg()->CfgCmdlinePrm;
@@ -227,6 +228,11 @@ void orbiter::CommandLine::ApplyOption(const Key* key, const std::string& value)
 		if (res == 1)
 			cfg.FrameLimit = s;
 		break;
+	case KEY_PROPTHREADS:
+		res = sscanf(value.c_str(), "%d", &i);
+		if (res == 1 && i >= 0)
+			cfg.PropThreads = i;
+		break;
 	case KEY_PLUGIN:
 		cfg.LoadPlugins.push_back(value);
 		break;
@@ -253,6 +259,7 @@ void orbiter::CommandLine::PrintHelpAndExit() const
 	std::cout << "  --maxsystime=<t>, -T <t>: Terminate session after <t> seconds\n";
 	std::cout << "  --maxsimtime=<t>, -t <t>: Terminate session at simulation time <t>\n";
 	std::cout << "  --maxframes=<f>: Terminate session after <f> time frames\n";
+	std::cout << "  --propthreads=<n>: Propagate free-flying vessels on <n> worker threads (0: serial update)\n";
 	std::cout << "  --plugin=<pg>, -p <pg>: Load plugin <pg> (from Modules\\Plugin\\<pg>.dll)\n";
 	std::cout << std::endl;
 
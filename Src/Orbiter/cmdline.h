@@ -74,6 +74,7 @@ namespace orbiter {
 			KEY_MAXSYSTIME,
 			KEY_MAXSIMTIME,
 			KEY_FRAMECOUNT,
+			KEY_PROPTHREADS,
 			KEY_PLUGIN
 		};
 
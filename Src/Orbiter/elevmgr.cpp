@@ -5,6 +5,7 @@
 #include "Celbody.h"
 #include "Planet.h"
 #include "Orbiter.h"
+#include "Log.h"
 #include <filesystem>
 
 using std::min;
@@ -42,6 +43,8 @@ ElevationManager::ElevationManager (const CelestialBody *_cbody)
 	tilesource = g_pOrbiter->Cfg()->CfgPRenderPrm.TileLoadFlags;
 	maxlvl = MAXLVL_LIMIT;
 	elev_res = 1.0;
+	cacheId = ElevationTileCache::NewSource();
+	ElevationTileCache::Shared().SetBudget ((size_t)g_pOrbiter->Cfg()->CfgPRenderPrm.ElevCacheSize << 20);
 	if (cbody->Type() == OBJTP_PLANET) {
 		maxlvl = min ((DWORD)maxlvl, ((Planet*)cbody)->MaxPatchLevel()-7);
 		// -7: -4 for level offset of quadtree root, -3 for great-grandfather elevation access mode
@@ -52,6 +55,11 @@ ElevationManager::ElevationManager (const CelestialBody *_cbody)
 		g_pOrbiter->Cfg()->PTexPath (cbuf, cbody->Name());
 		treeMgr[0] = ZTreeMgr::CreateFromFile(cbuf, ZTreeMgr::LAYER_ELEV);
 		treeMgr[1] = ZTreeMgr::CreateFromFile(cbuf, ZTreeMgr::LAYER_ELEVMOD);
+		for (int i = 0; i < 2; i++)
+			if (treeMgr[i])
+				LOGOUT_FINE("%s: %s archive (%s, %s) with %u nodes, tile index %0.1f KB", cbody->Name(), i ? "Elev_mod" : "Elev",
+					TreeCodecName(treeMgr[i]->Codec()), treeMgr[i]->IsMapped() ? "mapped" : "file reads",
+					treeMgr[i]->TOC().size(), treeMgr[i]->IndexSize()/1024.0);
 	} else {
 		for (int i = 0; i < 2; i++)
 			treeMgr[i] = 0;
@@ -72,7 +80,7 @@ ElevationManager::ElevationManager (const CelestialBody *_cbody)
 
 ElevationManager::~ElevationManager ()
 {
-	if (local_cache) delete local_cache;
+	ElevationTileCache::Shared().Drop (cacheId);
 	for (int i = 0; i < 2; i++)
 		if (treeMgr[i])
 			delete treeMgr[i];
@@ -112,7 +120,7 @@ bool ElevationManager::HasElevationTile(int lvl, int ilat, int ilng) const
 			if (std::filesystem::exists(path)) return true;
 		}
 		if (treeMgr[0]) {
-			if (treeMgr[0]->Idx(lvl, ilat, ilng) != DWORD(-1)) return true;
+			if (treeMgr[0]->HasTile(lvl, ilat, ilng)) return true;
 		}
 	}
 	return false;
@@ -304,6 +312,41 @@ bool ElevationManager::LoadElevationTile_mod (int lvl, int ilat, int ilng, doubl
 	return false;
 }
 
+int ElevationManager::CacheLevel (int reqlvl) const
+{
+	return (reqlvl ? min (max(0,reqlvl-7), maxlvl) : maxlvl);
+}
+
+ElevTilePtr ElevationManager::GetTile (int lvl, int ilat, int ilng) const
+{
+	ElevationTileCache &cache = ElevationTileCache::Shared();
+	ElevTilePtr tile;
+	if (cache.Find (cacheId, lvl, ilat, ilng, tile))
+		return tile;
+
+	// not cached: load it, or record that it doesn't exist
+	return AddTile (lvl, ilat, ilng, ReadTile (lvl, ilat, ilng));
+}
+
+INT16 *ElevationManager::ReadTile (int lvl, int ilat, int ilng) const
+{
+	INT16 *elev = LoadElevationTile (lvl+4, ilat, ilng, elev_res);
+	if (elev)
+		LoadElevationTile_mod (lvl+4, ilat, ilng, elev_res, elev); // load modifications
+	return elev;
+}
+
+ElevTilePtr ElevationManager::AddTile (int lvl, int ilat, int ilng, INT16 *elev, bool prefetched) const
+{
+	ElevTilePtr tile;
+	if (elev) {
+		auto gc = g_pOrbiter->GetGraphicsClient();
+		if (gc) gc->clbkFilterElevation((OBJHANDLE)cbody, ilat, ilng, lvl, elev_res, elev);
+		tile = ElevTilePtr (elev, std::default_delete<INT16[]>());
+	}
+	return ElevationTileCache::Shared().Insert (cacheId, lvl, ilat, ilng, tile, elev_stride*elev_stride*sizeof(INT16), prefetched);
+}
+
 // Tile quadrants and mask bits
 // +--------+--------+
 // |        |        |
@@ -322,7 +365,7 @@ double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vec
 {
 	double e = 0.0;
 	if (reslvl) *reslvl = 0;
-	reqlvl = (reqlvl ? min (max(0,reqlvl-7), maxlvl) : maxlvl);
+	reqlvl = CacheLevel (reqlvl);
 
 	if (mode) {
 		ElevationTile *tile;
@@ -332,10 +375,14 @@ double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vec
 			ntile = tilecache->size();
 		}
 
-		if (!ntile) {
-			if (!local_cache) local_cache = new std::vector<ElevationTile>(8);
-			tile = local_cache->data();
-			ntile = local_cache->size();
+		if (!ntile) { // cache of the most recent tiles, in front of the shared cache
+			// Elevation is only queried from the simulation thread: vessels close to
+			// a surface are never propagated concurrently (Vessel::CanPropagateConcurrently),
+			// and the ElevPrefetch threads only load tiles. The cache is thread_local so
+			// that a query from another thread can't corrupt it.
+			static thread_local std::vector<ElevationTile> local_cache(8);
+			tile = local_cache.data();
+			ntile = local_cache.size();
 		}
 
 		int i, lvl, ilat, ilng;
@@ -343,7 +390,7 @@ double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vec
 
 		for (i = 0; i < ntile; i++) {
 			if (tile[i].data &&
-				reqlvl == tile[i].tgtlvl && tile[i].mgr == this &&
+				reqlvl == tile[i].tgtlvl && tile[i].src == cacheId &&
 				lat >= tile[i].latmin && lat <= tile[i].latmax &&
 				lng >= tile[i].lngmin && lng <= tile[i].lngmax) {
 				int q = -1;
@@ -369,12 +416,11 @@ double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vec
 
 			for (lvl = reqlvl; lvl >= 0; lvl--) {
 				TileIdx (lat, lng, lvl, &ilat, &ilng);
-				t->data = LoadElevationTile (lvl+4, ilat, ilng, elev_res);
+				t->data = GetTile (lvl, ilat, ilng);
 				if (t->data) {
-					LoadElevationTile_mod (lvl+4, ilat, ilng, elev_res, t->data); // load modifications
 					int nlat = 1 << lvl;
 					int nlng = 2 << lvl;
-					t->mgr = this;
+					t->src = cacheId;
 					t->lvl = lvl;
 					t->ilat = ilat;
 					t->ilng = ilng;
@@ -400,8 +446,6 @@ double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vec
 					//oapiWriteLogV("LoadTile[0x%X]: lvl=%d, flags=0x%X, q=%d, i(%d, %d)", t, lvl, t->quadrants, q, ilng, ilat);
 
 					// still need to store emin and emax
-					auto gc = g_pOrbiter->GetGraphicsClient();
-					if (gc) gc->clbkFilterElevation((OBJHANDLE)cbody, ilat, ilng, lvl, elev_res, t->data);
 					break;
 				}
 			}
@@ -409,12 +453,12 @@ double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vec
 		}
 
 		if (t->data) {
-			INT16 *elev_base = t->data+elev_stride+1; // strip padding
+			const INT16 *elev_base = t->data.get()+elev_stride+1; // strip padding
 			double latidx = (lat-t->latmin) * elev_grid/(t->latmax-t->latmin);
 			double lngidx = (lng-t->lngmin) * elev_grid/(t->lngmax-t->lngmin);
 			int lat0 = (int)latidx;
 			int lng0 = (int)lngidx;
-			INT16 *eptr = elev_base + lat0*elev_stride + lng0;
+			const INT16 *eptr = elev_base + lat0*elev_stride + lng0;
 			if (mode == 1) { // linear interpolation
 				bool tri;
 				double w_lat = latidx-lat0;
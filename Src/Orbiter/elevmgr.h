@@ -7,21 +7,19 @@
 #include "windows.h"
 #include "vecmat.h"
 #include "ZTreeMgr.h"
+#include "ElevTileCache.h"
 #include <vector>
 
 class CelestialBody;
 
 struct ElevationTile {
 	ElevationTile() { 
-		data = nullptr;
 		Clear();
 	}
-	~ElevationTile() { if (data) delete []data; }
 
 	void Clear() { 
-		if (data) delete[]data; 
-		data = nullptr;
-		mgr = nullptr;
+		data.reset();
+		src = 0;
 		lvl = tgtlvl = 0;
 		latmin = latmax = 0.0;
 		lngmin = lngmax = 0.0;
@@ -34,7 +32,7 @@ struct ElevationTile {
 		nmlidx = 0;
 	}
 
-	INT16 *data;
+	ElevTilePtr data; // shared with the tile cache
 	int lvl, tgtlvl;
 	double latmin, latmax;
 	double lngmin, lngmax;
@@ -45,10 +43,12 @@ struct ElevationTile {
 	int quadrants;
 	bool celldiag;
 	int nmlidx;
-	const class ElevationManager* mgr;
+	unsigned int src; // id of the elevation manager which provided the tile
 };
 
 class ElevationManager {
+	friend class ElevationPrefetcher;
+
 public:
 	ElevationManager (const CelestialBody *_cbody);
 	~ElevationManager();
@@ -76,6 +76,34 @@ protected:
 	bool LoadElevationTile_mod (int lvl, int ilat, int ilng, double tgt_res, INT16 *elev) const;
 	bool HasElevationTile(int lvl, int ilat, int ilng) const;
 
+	/**
+	* \brief Elevation tile from the shared tile cache, loaded on a miss
+	* \param lvl tile level (without the quadtree root offset)
+	* \param ilat latitude index of the tile
+	* \param ilng longitude index of the tile
+	* \return tile data, or null if no tile exists at this index
+	*/
+	ElevTilePtr GetTile (int lvl, int ilat, int ilng) const;
+
+	/**
+	* \brief Load an elevation tile and apply the elevation modifications
+	* \return tile data (allocated with new[]), or null if no tile exists
+	* \note Only reads files, so it may be called from any thread.
+	*/
+	INT16 *ReadTile (int lvl, int ilat, int ilng) const;
+
+	/**
+	* \brief Pass a tile returned by ReadTile through the graphics client's
+	*   elevation filter and add it to the shared tile cache
+	* \param elev tile data (taken over by the cache), or null
+	* \param prefetched true if the tile was loaded ahead of use
+	* \return the cached tile data
+	*/
+	ElevTilePtr AddTile (int lvl, int ilat, int ilng, INT16 *elev, bool prefetched = false) const;
+
+	int CacheLevel (int reqlvl) const;
+	// tile level used for a requested resolution level (see Elevation)
+
 private:
 	const CelestialBody *cbody;
 	int maxlvl = 0;
@@ -84,7 +112,7 @@ private:
 	DWORD tilesource = 2; // bit 1: try loading from cache, bit 2: try loading from archive
 	ZTreeMgr *treeMgr[5];
 	bool bDirExists, bModExists;
-	mutable std::vector<ElevationTile> *local_cache = nullptr;
+	unsigned int cacheId;  // source id of this manager's tiles in the shared tile cache
 };
 
 #endif // !__ELEVMGR_H
\ No newline at end of file
@@ -0,0 +1,243 @@
+#include "MsisTable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+// Tabulated NRLMSISE-00 model (MsisTable) against direct evaluation of
+// gtd7, and both evaluated concurrently from several threads. The
+// "[.benchmark]" test cases print the cost of both for a set of low Earth
+// orbits and the throughput for different thread counts; run them
+// explicitly with
+//    Atmosphere.Nrlmsise [benchmark]
+
+struct Sample {
+	double alt, lat, lng, lst; // [km], [deg], [deg], [h]
+};
+
+static struct nrlmsise_flags DefaultFlags ()
+{
+	struct nrlmsise_flags flags;
+	memset (&flags, 0, sizeof(flags));
+	for (int i = 1; i < 24; i++) flags.switches[i] = 1;
+	return flags;
+}
+
+// Direct evaluation, with the inputs set up as in EarthAtmosphere_NRLMSISE00
+static void Direct (const Sample &s, int doy, double ut, double &T, double &p, double &rho)
+{
+	struct nrlmsise_flags flags = DefaultFlags();
+	struct nrlmsise_input input = {0, doy, ut*3600.0, s.alt, s.lat, s.lng, s.lst, 140.0, 140.0, 3.0, NULL};
+	MsisParams (&input, &flags, T, p, rho);
+}
+
+// Random sample in the altitude range alt0..alt1, at universal time ut
+static Sample RandomSample (std::mt19937 &rng, double alt0, double alt1, double ut)
+{
+	std::uniform_real_distribution<double> u (0.0, 1.0);
+	Sample s;
+	s.alt = alt0 + (alt1-alt0)*u(rng);
+	s.lat = asin (2.0*u(rng)-1.0)*180.0/3.141592653589793;
+	s.lng = 360.0*u(rng) - 180.0;
+	s.lst = ut + s.lng/15.0; // not reduced to 0..24, as in the module
+	return s;
+}
+
+// Vessels on circular orbits between 200 and 600 km, sampled every dt [s]
+// for nstep steps (step-major)
+static std::vector<Sample> OrbitSamples (int nvessel, int nstep, double dt, unsigned int seed)
+{
+	std::mt19937 rng (seed);
+	std::uniform_real_distribution<double> u (0.0, 1.0);
+	std::vector<double> alt(nvessel), inc(nvessel), phase(nvessel);
+	for (int v = 0; v < nvessel; v++) {
+		alt[v] = 200.0 + 400.0*u(rng);
+		inc[v] = 0.2 + 1.4*u(rng);
+		phase[v] = 6.28*u(rng);
+	}
+	std::vector<Sample> smp(nvessel*nstep);
+	const double n = 2.0*3.141592653589793/5500.0;
+	for (int i = 0; i < nstep; i++) {
+		for (int v = 0; v < nvessel; v++) {
+			double t = i*dt, arg = phase[v] + n*t;
+			Sample &s = smp[i*nvessel+v];
+			s.alt = alt[v];
+			s.lat = asin (sin (inc[v])*sin (arg))*180.0/3.141592653589793;
+			s.lng = fmod (atan2 (cos (inc[v])*sin (arg), cos (arg))*180.0/3.141592653589793 - t/240.0 + 540.0, 360.0) - 180.0;
+			s.lst = fmod (t/3600.0, 24.0) + s.lng/15.0;
+		}
+	}
+	return smp;
+}
+
+struct Result {
+	double T, p, rho;
+};
+
+// Evaluates samples i0, i0+stride, ... directly (table == NULL) or from the
+// table
+static void EvaluateAll (const std::vector<Sample> &smp, size_t i0, size_t stride, MsisTable *table, std::vector<Result> &res)
+{
+	for (size_t i = i0; i < smp.size(); i += stride) {
+		const Sample &s = smp[i];
+		Result &r = res[i];
+		if (table) {
+			table->SetKey (172, 140.0, 140.0, 3.0);
+			table->Eval (s.alt, s.lat, s.lng, s.lst, r.T, r.p, r.rho);
+		} else {
+			double ut = fmod (s.lst - s.lng/15.0 + 48.0, 24.0);
+			Direct (s, 172, ut, r.T, r.p, r.rho);
+		}
+	}
+}
+
+// =======================================================================
+
+TEST_CASE("Tabulated and direct NRLMSISE-00 agree", "[NRLMSISE00]")
+{
+	const double tol = 1e-2;
+	const double band[] = {0.0, 60.0, 100.0, 130.0, 200.0, 400.0, 700.0, 999.0};
+	MsisTable table (tol, 1000.0, 256 << 20);
+	std::mt19937 rng (42);
+
+	for (int b = 0; b < 7; b++) {
+		INFO("altitude " << band[b] << "-" << band[b+1] << " km");
+		double erho = 0.0, ep = 0.0, eT = 0.0;
+		for (int k = 0; k < 500; k++) {
+			double ut = 24.0*k/500.0;
+			Sample s = RandomSample (rng, band[b], band[b+1], ut);
+			double T0, p0, rho0, T1, p1, rho1;
+			Direct (s, 172, ut, T0, p0, rho0);
+			table.SetKey (172, 140.0, 140.0, 3.0);
+			REQUIRE(table.Eval (s.alt, s.lat, s.lng, s.lst, T1, p1, rho1));
+			erho = std::max (erho, fabs (log (rho1/rho0)));
+			ep   = std::max (ep,   fabs (log (p1/p0)));
+			eT   = std::max (eT,   fabs (T1/T0 - 1.0));
+		}
+		CHECK(erho <= tol);
+		CHECK(ep   <= tol);
+		CHECK(eT   <= tol);
+	}
+}
+
+TEST_CASE("NRLMSISE-00 table limits and regeneration", "[NRLMSISE00]")
+{
+	const size_t budget = 1 << 20;
+	MsisTable table (1e-2, 600.0, budget);
+	double T, p, rho;
+
+	// outside the altitude range: left to direct evaluation
+	table.SetKey (10, 150.0, 160.0, 4.0);
+	CHECK_FALSE(table.Eval (-0.1, 0.0, 0.0, 12.0, T, p, rho));
+	CHECK_FALSE(table.Eval (600.0, 0.0, 0.0, 12.0, T, p, rho));
+	CHECK(table.nTiles() == 0);
+
+	// a pass around the globe fills tiles up to the budget, no further
+	for (int i = 0; i < 400; i++)
+		REQUIRE(table.Eval (350.0, 50.0*sin (i*0.05), i*2.7-180.0, i*0.37, T, p, rho));
+	CHECK(table.nTiles() > 0);
+	CHECK(table.MemUsage() <= budget);
+
+	// the same key keeps the tiles, a new one drops them
+	size_t ntile = table.nTiles();
+	table.SetKey (10, 150.0, 160.0, 4.0);
+	CHECK(table.nTiles() == ntile);
+	table.SetKey (11, 150.0, 160.0, 4.0);
+	CHECK(table.nTiles() == 0);
+
+	// and the table follows the new key
+	Sample s = {350.0, 20.0, 30.0, 14.0};
+	double T0, p0, rho0;
+	struct nrlmsise_flags flags = DefaultFlags();
+	struct nrlmsise_input input = {0, 11, (14.0-2.0)*3600.0, s.alt, s.lat, s.lng, s.lst, 150.0, 160.0, 4.0, NULL};
+	MsisParams (&input, &flags, T0, p0, rho0);
+	REQUIRE(table.Eval (s.alt, s.lat, s.lng, s.lst, T, p, rho));
+	CHECK(fabs (log (rho/rho0)) <= 1e-2);
+}
+
+TEST_CASE("Concurrent NRLMSISE-00 evaluation matches serial results", "[NRLMSISE00]")
+{
+	const size_t nthread = 8, nsmp = 4000;
+	std::mt19937 rng (3);
+	std::vector<Sample> smp(nsmp);
+	for (size_t i = 0; i < nsmp; i++)
+		smp[i] = RandomSample (rng, 0.0, 999.0, 24.0*i/nsmp);
+
+	for (int tab = 0; tab < 2; tab++) {
+		INFO((tab ? "tabulated" : "direct"));
+		MsisTable table0 (1e-2, 1000.0, 256 << 20), table1 (1e-2, 1000.0, 256 << 20);
+		std::vector<Result> res0(nsmp), res1(nsmp);
+		EvaluateAll (smp, 0, 1, tab ? &table0 : 0, res0);
+
+		// interleaved samples, so that the threads fill the same tiles
+		std::vector<std::thread> thread;
+		for (size_t i = 0; i < nthread; i++)
+			thread.emplace_back (EvaluateAll, std::cref(smp), i, nthread, tab ? &table1 : (MsisTable*)0, std::ref(res1));
+		for (auto &th : thread) th.join();
+
+		size_t nfail = 0;
+		for (size_t i = 0; i < nsmp; i++)
+			if (res1[i].T != res0[i].T || res1[i].p != res0[i].p || res1[i].rho != res0[i].rho) nfail++;
+		CHECK(nfail == 0);
+		if (tab) CHECK(table1.nTiles() == table0.nTiles());
+	}
+}
+
+TEST_CASE("NRLMSISE-00 table benchmark", "[.benchmark]")
+{
+	static volatile double sink;
+	const int nvessel = 50, nstep = 10000;
+	const double dt = 2.0; // [s]
+	std::vector<Sample> smp = OrbitSamples (nvessel, nstep, dt, 7);
+	std::vector<Result> res(smp.size());
+
+	// direct evaluation, the table filled on the way, and the filled table
+	double rate[3], chk = 0.0;
+	MsisTable table (1e-2, 1000.0, 256 << 20);
+	for (int m = 0; m < 3; m++) {
+		auto t0 = std::chrono::steady_clock::now();
+		EvaluateAll (smp, 0, 1, m ? &table : 0, res);
+		rate[m] = smp.size() / std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+		for (auto &r : res) chk += r.rho;
+	}
+	sink = chk; // keeps the evaluations from being optimised away
+	printf ("\nNRLMSISE-00, %d vessels x %d steps of %g s\n", nvessel, nstep, dt);
+	printf ("%-14s %12.4g queries/s\n", "Direct", rate[0]);
+	printf ("%-14s %12.4g queries/s, speedup %0.2f\n", "Table (fill)", rate[1], rate[1]/rate[0]);
+	printf ("%-14s %12.4g queries/s, speedup %0.2f (%d tiles, %0.1f MB)\n\n", "Table (filled)", rate[2], rate[2]/rate[0],
+		(int)table.nTiles(), table.MemUsage()/1048576.0);
+}
+
+TEST_CASE("NRLMSISE-00 multithreaded throughput", "[.benchmark]")
+{
+	const int nvessel = 64, nstep = 4000;
+	std::vector<Sample> smp = OrbitSamples (nvessel, nstep, 2.0, 5);
+	std::vector<Result> res(smp.size());
+	unsigned int nmax = std::max (8u, std::thread::hardware_concurrency());
+
+	// each thread takes a share of the vessels
+	printf ("\nNRLMSISE-00 throughput, %d vessels x %d steps\n%-8s %14s %14s %14s\n", nvessel, nstep,
+		"Threads", "Direct [1/s]", "Fill [1/s]", "Filled [1/s]");
+	for (unsigned int nthread = 1; nthread <= nmax; nthread *= 2) {
+		double rate[3];
+		MsisTable table (1e-2, 1000.0, 256 << 20);
+		for (int m = 0; m < 3; m++) {
+			auto t0 = std::chrono::steady_clock::now();
+			std::vector<std::thread> thread;
+			for (size_t i = 0; i < nthread; i++)
+				thread.emplace_back (EvaluateAll, std::cref(smp), i, nthread, m ? &table : (MsisTable*)0, std::ref(res));
+			for (auto &th : thread) th.join();
+			rate[m] = smp.size() / std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+		}
+		printf ("%-8u %14.4g %14.4g %14.4g\n", nthread, rate[0], rate[1], rate[2]);
+	}
+	printf ("\n");
+}
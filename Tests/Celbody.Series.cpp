@@ -0,0 +1,322 @@
+#include "TrigSeries.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+using std::vector;
+
+// Term summation of the analytic ephemerides (VSOP87 planets, ELP2000-82
+// main problem for the Moon) with the full series read from the data files
+// installed under Config. The scalar reference sums the terms as the
+// modules did before the vectorised kernels: array-of-structures storage
+// and a sin/cos library call per term.
+// The "[.benchmark]" test case prints full-series evaluations per second
+// for both; run it explicitly with
+//    Celbody.Series [benchmark]
+
+static const double cpi = 3.141592653589793;
+static const double rad = 648000.0/cpi; // arcsec per radian
+
+// -----------------------------------------------------------------------
+// Series of one body: three coordinates, each a set of term blocks
+
+struct Block {
+	int alpha;                     // power of time multiplying the block
+	vector<double> a, b, c;        // SoA: VSOP amplitude/phase/frequency, ELP amplitude
+	vector<double> p[5];           // ELP argument polynomial coefficients
+	vector<double> aos;            // the same terms, interleaved (scalar reference)
+};
+
+struct Series {
+	const char *name;
+	bool elp;                      // ELP form x*sin(y(t)) rather than VSOP form a*cos(b+c*t)
+	vector<Block> coord[3];
+	int nterm = 0;
+};
+
+static bool ReadVsop (Series &s, const char *name, const char *file)
+{
+	std::ifstream ifs (file);
+	if (!ifs) return false;
+	s.name = name;
+	s.elp = false;
+	int nalpha, n;
+	ifs >> nalpha;
+	for (int i = 0; i < 3; i++) {
+		for (int alpha = 0; alpha <= nalpha; alpha++) {
+			Block blk;
+			blk.alpha = alpha;
+			ifs >> n;
+			blk.a.resize (n); blk.b.resize (n); blk.c.resize (n); blk.aos.resize (3*n);
+			for (int k = 0; k < n; k++) {
+				ifs >> blk.a[k] >> blk.b[k] >> blk.c[k];
+				blk.aos[3*k] = blk.a[k], blk.aos[3*k+1] = blk.b[k], blk.aos[3*k+2] = blk.c[k];
+			}
+			s.nterm += n;
+			if (n) s.coord[i].push_back (blk);
+		}
+	}
+	return !ifs.fail();
+}
+
+static bool ReadElp (Series &s, const char *file)
+{
+	// Delaunay arguments D, l', l, F as polynomials in time [centuries]
+	// (without the DE200 fit corrections applied by the Moon module)
+	static const double w[3][5] = {
+		{(218.0+18.0/60.0+59.95571/3600.0)*cpi/180.0, 1732559343.73604/rad, -5.8883/rad, 0.6604e-2/rad, -0.3169e-4/rad},
+		{(83.0+21.0/60.0+11.67475/3600.0)*cpi/180.0, 14643420.2632/rad, -38.2776/rad, -0.45047e-1/rad, 0.21301e-3/rad},
+		{(125.0+2.0/60.0+40.39816/3600.0)*cpi/180.0, -6967919.3622/rad, 6.3622/rad, 0.7625e-2/rad, -0.3586e-4/rad}};
+	static const double eart[5] = {(100.0+27.0/60.0+59.22059/3600.0)*cpi/180.0, 129597742.2758/rad, -0.0202/rad, 0.9e-5/rad, 0.15e-6/rad};
+	static const double peri[5] = {(102.0+56.0/60.0+14.42753/3600.0)*cpi/180.0, 1161.2283/rad, 0.5327/rad, -0.138e-3/rad, 0.0};
+	double del[4][5];
+	for (int k = 0; k < 5; k++) {
+		del[0][k] = w[0][k] - eart[k] + (k ? 0.0 : cpi);
+		del[1][k] = eart[k] - peri[k];
+		del[2][k] = w[0][k] - w[1][k];
+		del[3][k] = w[0][k] - w[2][k];
+	}
+
+	std::ifstream ifs (file);
+	if (!ifs) return false;
+	s.name = "Moon";
+	s.elp = true;
+	for (int i = 0; i < 3; i++) {
+		Block blk;
+		blk.alpha = 0;
+		int n, ilu[4];
+		double coef[7];
+		ifs >> n;
+		blk.a.resize (n); blk.aos.resize (6*n);
+		for (int k = 0; k < 5; k++) blk.p[k].resize (n);
+		for (int j = 0; j < n; j++) {
+			for (int m = 0; m < 4; m++) ifs >> ilu[m];
+			for (int m = 0; m < 7; m++) ifs >> coef[m];
+			blk.a[j] = blk.aos[6*j] = coef[0];
+			for (int k = 0; k < 5; k++) {
+				double y = (i == 2 && !k ? 0.5*cpi : 0.0);
+				for (int m = 0; m < 4; m++) y += ilu[m]*del[m][k];
+				blk.p[k][j] = blk.aos[6*j+k+1] = y;
+			}
+		}
+		s.nterm += n;
+		s.coord[i].push_back (blk);
+	}
+	return !ifs.fail();
+}
+
+static void LoadAll (vector<Series> &series)
+{
+	static const char *planet[8] = {"Mercury", "Venus", "Earth", "Mars", "Jupiter", "Saturn", "Uranus", "Neptune"};
+	char file[256];
+	series.resize (10);
+	REQUIRE(ReadVsop (series[0], "Sun", "Config\\Sun\\Data\\Vsop87E.dat"));
+	for (int i = 0; i < 8; i++) {
+		sprintf (file, "Config\\%s\\Data\\Vsop87B.dat", planet[i]);
+		REQUIRE(ReadVsop (series[i+1], planet[i], file));
+	}
+	REQUIRE(ReadElp (series[9], "Config\\Moon\\Data\\ELP82.dat"));
+}
+
+// -----------------------------------------------------------------------
+// Evaluation: sums and time derivatives of the three coordinates at time t
+// (millennia for VSOP, centuries for ELP)
+
+static void EvalScalar (const Series &s, double t, double *r)
+{
+	for (int i = 0; i < 3; i++) {
+		r[i] = r[i+3] = 0.0;
+		for (const Block &blk : s.coord[i]) {
+			const double *q = blk.aos.data();
+			int n = (int)blk.a.size();
+			double sum = 0.0, dsum = 0.0;
+			if (s.elp) {
+				for (int j = 0; j < n; j++, q += 6) {
+					double y = q[1], ydot = 0.0, tk = 1.0;
+					for (int k = 1; k <= 4; k++) {
+						ydot += q[k+1] * tk * k;
+						tk *= t;
+						y += q[k+1] * tk;
+					}
+					sum  += q[0]*sin (y);
+					dsum += q[0]*cos (y)*ydot;
+				}
+			} else {
+				for (int j = 0; j < n; j++, q += 3) {
+					double arg = q[1] + q[2]*t;
+					sum  += q[0]*cos (arg);
+					dsum -= q[2]*q[0]*sin (arg);
+				}
+			}
+			double ta = pow (t, blk.alpha);
+			r[i]   += ta*sum;
+			r[i+3] += ta*dsum + (blk.alpha ? blk.alpha*pow (t, blk.alpha-1)*sum : 0.0);
+		}
+	}
+}
+
+static void EvalVector (const Series &s, double t, double *r)
+{
+	for (int i = 0; i < 3; i++) {
+		r[i] = r[i+3] = 0.0;
+		for (const Block &blk : s.coord[i]) {
+			int n = (int)blk.a.size();
+			double sum, dsum;
+			if (s.elp) {
+				const double *p[5] = {blk.p[0].data(), blk.p[1].data(), blk.p[2].data(), blk.p[3].data(), blk.p[4].data()};
+				TrigSumSinPoly4 (n, blk.a.data(), p, t, sum, dsum);
+			} else {
+				TrigSumCos (n, blk.a.data(), blk.b.data(), blk.c.data(), t, sum, dsum);
+			}
+			double ta = pow (t, blk.alpha);
+			r[i]   += ta*sum;
+			r[i+3] += ta*dsum + (blk.alpha ? blk.alpha*pow (t, blk.alpha-1)*sum : 0.0);
+		}
+	}
+}
+
+// EvalVector for the m times t[0..m-1], with the multi-epoch kernels;
+// the results for t[j] in r[6*j..6*j+5]
+static void EvalVectorN (const Series &s, int m, const double *t, double *r)
+{
+	vector<double> sum (m), dsum (m);
+	for (int j = 0; j < 6*m; j++) r[j] = 0.0;
+	for (int i = 0; i < 3; i++) {
+		for (const Block &blk : s.coord[i]) {
+			int n = (int)blk.a.size();
+			if (s.elp) {
+				const double *p[5] = {blk.p[0].data(), blk.p[1].data(), blk.p[2].data(), blk.p[3].data(), blk.p[4].data()};
+				TrigSumSinPoly4N (n, blk.a.data(), p, m, t, sum.data(), dsum.data());
+			} else {
+				TrigSumCosN (n, blk.a.data(), blk.b.data(), blk.c.data(), m, t, sum.data(), dsum.data());
+			}
+			for (int j = 0; j < m; j++) {
+				double ta = pow (t[j], blk.alpha);
+				r[6*j+i]   += ta*sum[j];
+				r[6*j+i+3] += ta*dsum[j] + (blk.alpha ? blk.alpha*pow (t[j], blk.alpha-1)*sum[j] : 0.0);
+			}
+		}
+	}
+}
+
+// Bound for the rounding error of the sums: each term is accurate to a few
+// ulp of its amplitude (or amplitude times argument, for the arguments'
+// own rounding error)
+static void ErrorScale (const Series &s, double t, double *e)
+{
+	for (int i = 0; i < 3; i++) {
+		e[i] = e[i+3] = 0.0;
+		for (const Block &blk : s.coord[i]) {
+			double ta = pow (fabs (t), blk.alpha);
+			for (size_t j = 0; j < blk.a.size(); j++) {
+				double y = (s.elp ? fabs (blk.p[0][j]) + fabs (blk.p[1][j]*t) : fabs (blk.b[j]) + fabs (blk.c[j]*t));
+				double f = (s.elp ? fabs (blk.p[1][j]) : fabs (blk.c[j]));
+				e[i]   += ta*fabs (blk.a[j])*(1.0 + y);
+				e[i+3] += ta*fabs (blk.a[j])*(1.0 + y)*(f + blk.alpha/std::max (fabs (t), 1e-3));
+			}
+		}
+	}
+}
+
+// =======================================================================
+
+// The vectorised kernels must reproduce the scalar sums to rounding error
+TEST_CASE("Vectorised and scalar series summation agree", "[TrigSeries]")
+{
+	vector<Series> series;
+	LoadAll (series);
+
+	for (const Series &s : series) {
+		INFO(s.name);
+		for (double t : {-0.31, 0.0, 0.0123, 0.24, 1.7}) {
+			double r0[6], r1[6], e[6];
+			EvalScalar (s, t, r0);
+			EvalVector (s, t, r1);
+			ErrorScale (s, t, e);
+			for (int i = 0; i < 6; i++)
+				REQUIRE(fabs (r1[i]-r0[i]) <= 1e-14*e[i]);
+		}
+	}
+}
+
+// The multi-epoch kernels must reproduce the single-epoch sums, also for
+// partial lane blocks
+TEST_CASE("Multi-epoch series summation", "[TrigSeries]")
+{
+	vector<Series> series;
+	LoadAll (series);
+
+	const int m = 2*TRIG_LANES+1;
+	double t[m], r[6*m];
+	for (int j = 0; j < m; j++) t[j] = -0.31 + 0.137*j;
+	for (const Series &s : series) {
+		INFO(s.name);
+		EvalVectorN (s, m, t, r);
+		for (int j = 0; j < m; j++) {
+			double r0[6], e[6];
+			EvalVector (s, t[j], r0);
+			ErrorScale (s, t[j], e);
+			for (int i = 0; i < 6; i++)
+				REQUIRE(fabs (r[6*j+i]-r0[i]) <= 1e-14*e[i]);
+		}
+	}
+}
+
+TEST_CASE("Trigonometric kernel accuracy", "[TrigSeries]")
+{
+	double err = 0.0;
+	unsigned int seed = 1;
+	for (int i = 0; i < 100000; i++) {
+		seed = seed * 1103515245 + 12345;
+		double x = ((seed >> 8) / 16777216.0 - 0.5) * (i % 2 ? 2e5 : 20.0);
+		double s, c;
+		TrigSinCos (x, s, c);
+		err = std::max (err, std::max (fabs (s - sin (x)), fabs (c - cos (x))));
+	}
+	REQUIRE(err <= 4.5e-16);
+}
+
+TEST_CASE("Series summation benchmark", "[.benchmark]")
+{
+	static volatile double sink;
+	vector<Series> series;
+	LoadAll (series);
+
+	printf ("\nFull series, %d lanes\n%-10s %8s %14s %14s %14s %8s\n", TRIG_LANES,
+		"Body", "Terms", "Scalar [1/s]", "Vector [1/s]", "Batch [1/s]", "Speedup");
+	for (const Series &s : series) {
+		double rate[3], r[6*16], t[16], chk = 0.0;
+		for (int v = 0; v < 3; v++) {
+			int n = 0;
+			auto t0 = std::chrono::steady_clock::now();
+			double wall;
+			do {
+				for (int k = 0; k < 16; k++) t[k] = 0.01 + 1e-6*(n+k);
+				if (v == 2) {
+					EvalVectorN (s, 16, t, r);
+					chk += r[0];
+				} else {
+					for (int k = 0; k < 16; k++) {
+						if (v) EvalVector (s, t[k], r);
+						else   EvalScalar (s, t[k], r);
+						chk += r[0];
+					}
+				}
+				n += 16;
+				wall = std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+			} while (wall < 0.25);
+			rate[v] = n/wall;
+		}
+		sink = chk; // keeps the evaluations from being optimised away
+		printf ("%-10s %8d %14.4g %14.4g %14.4g %8.2f\n", s.name, s.nterm, rate[0], rate[1], rate[2],
+			std::max (rate[1], rate[2])/rate[0]);
+	}
+	printf ("\n");
+}
@@ -0,0 +1,328 @@
+#include "Satsat.h"
+#include "Galsat.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+using std::vector;
+
+// Concurrent evaluation of the moon ephemerides (TASS1.7 for the eight
+// Saturnian moons, Lieske E5 for the four Galilean moons and the Jupiter
+// barycentre, ELP2000-82 for the Moon) from many threads at random epochs.
+// Each thread must reproduce the single-threaded results bit for bit,
+// independent of the order in which it visits the bodies and epochs.
+// The same is checked through the SATOBJ and GALOBJ instances of the moon
+// modules, loaded as Orbiter loads them.
+
+// ELP82 driver functions (Moon module)
+void ELP82_exit ();
+int  ELP82 (double mjd, double *r);
+
+static const int NEPOCH = 200;                    // random epochs
+static const int NSAT = 8;                        // Saturnian moons
+static const int NGAL = 5;                        // Jupiter barycentre and Galilean moons
+static const int NBODY = NSAT + NGAL + 1;         // ... and the Moon
+static const int NTHREAD = 16;
+
+// State vector of body k at mjd
+static void Evaluate (int k, double mjd, double *r)
+{
+	if (k < NSAT) {
+		posired (mjd+2400000.5, k, r, r+3);
+	} else if (k < NSAT+NGAL) {
+		double rorb[6];
+		galsat (r, rorb, mjd+2400000.5, k-NSAT, 2);
+	} else {
+		ELP82 (mjd, r);
+	}
+}
+
+// Evaluates all bodies at all epochs in a shuffled order, several times over
+static void EvaluateAll (const vector<double> &mjd, unsigned int seed, vector<double> &res)
+{
+	vector<int> job (NEPOCH*NBODY);
+	for (size_t i = 0; i < job.size(); i++) job[i] = (int)i;
+	std::mt19937 rng (seed);
+	res.assign (job.size()*6, 0.0);
+	for (int pass = 0; pass < 2; pass++) {
+		std::shuffle (job.begin(), job.end(), rng);
+		for (int j : job)
+			Evaluate (j % NBODY, mjd[j / NBODY], res.data() + j*6);
+	}
+}
+
+TEST_CASE("Concurrent moon ephemerides match serial results", "[Satsat][Galsat][ELP82]")
+{
+	ReadData ("Config\\Saturn\\Data\\tass17.dat", 0);
+	REQUIRE(cd2com ("Config\\Jupiter\\Data\\ephem_e15.dat") == 0);
+	chkgal ();
+
+	std::mt19937 rng (1234);
+	std::uniform_real_distribution<double> epoch (33000.0, 69800.0); // MJD, 1949-2050
+	vector<double> mjd (NEPOCH);
+	for (double &t : mjd) t = epoch (rng);
+
+	// The threads start before the ELP82 terms have been read, so the
+	// lazy initialisation is done concurrently as well
+	vector<vector<double>> res (NTHREAD);
+	vector<std::thread> thread;
+	for (int i = 0; i < NTHREAD; i++)
+		thread.emplace_back (EvaluateAll, std::cref(mjd), 100u+i, std::ref(res[i]));
+	for (auto &th : thread) th.join();
+
+	vector<double> ref;
+	EvaluateAll (mjd, 99u, ref);
+
+	// sanity check of the reference: Titan at about 8e-3 AU from Saturn
+	double rt = sqrt (ref[5*6]*ref[5*6] + ref[5*6+1]*ref[5*6+1] + ref[5*6+2]*ref[5*6+2]);
+	CHECK(rt > 7e-3);
+	CHECK(rt < 9e-3);
+
+	for (int i = 0; i < NTHREAD; i++) {
+		INFO("thread " << i);
+		int nmismatch = 0;
+		for (size_t j = 0; j < ref.size(); j++)
+			if (memcmp (&res[i][j], &ref[j], sizeof(double))) nmismatch++;
+		CHECK(nmismatch == 0);
+	}
+
+	ELP82_exit ();
+}
+
+// The batch form of the TASS1.7 solution sums the series for several
+// dates at once, in the same order as posired
+TEST_CASE("Batch TASS1.7 evaluation matches posired", "[Satsat]")
+{
+	ReadData ("Config\\Saturn\\Data\\tass17.dat", 0);
+
+	const int n = 45; // more than one chunk
+	double dj[n], xyz[3*n], vxyz[3*n];
+	for (int j = 0; j < n; j++) dj[j] = 2400000.5 + 33000.0 + 817.3*j;
+	for (int is = 0; is < NSAT; is++) {
+		INFO("satellite " << is);
+		posiredN (n, dj, is, xyz, vxyz);
+		int nmismatch = 0;
+		for (int j = 0; j < n; j++) {
+			double r[6];
+			posired (dj[j], is, r, r+3);
+			if (memcmp (r, xyz+3*j, 3*sizeof(double)) || memcmp (r+3, vxyz+3*j, 3*sizeof(double)))
+				nmismatch++;
+		}
+		CHECK(nmismatch == 0);
+	}
+}
+
+// =======================================================================
+// Module objects. Satsat and Galsat (series data, SATOBJ and GALOBJ) are
+// loaded and initialised first, so the moon modules which link to them
+// resolve against the loaded libraries. Each moon module creates its
+// CELBODY instance in InitInstance.
+
+static const char *moonname[] = {
+	"Mimas", "Enceladus", "Tethys", "Dione", "Rhea", "Titan", "Hyperion", "Iapetus", // SATOBJ
+	"Io", "Europa", "Ganymede", "Callisto"                                           // GALOBJ
+};
+static const int NMOON = sizeof(moonname)/sizeof(moonname[0]);
+
+struct MoonModule {
+	HMODULE hDLL;
+	CELBODY *(*InitInstance)(OBJHANDLE hBody);
+	void (*ExitInstance)(CELBODY *body);
+};
+
+static bool LoadMoonModules (vector<HMODULE> &base, vector<MoonModule> &mod)
+{
+	char path[256];
+	for (const char *name : {"Satsat", "Galsat"}) {
+		sprintf (path, "Modules\\%s.dll", name);
+		HMODULE hDLL = LoadLibrary (path);
+		if (!hDLL) return false;
+		base.push_back (hDLL);
+		void (*InitModule)(HINSTANCE) = (void(*)(HINSTANCE))GetProcAddress (hDLL, "InitModule");
+		if (!InitModule) return false;
+		InitModule (hDLL);
+	}
+	for (int k = 0; k < NMOON; k++) {
+		sprintf (path, "Modules\\Celbody\\%s.dll", moonname[k]);
+		MoonModule m;
+		if (!(m.hDLL = LoadLibrary (path))) return false;
+		m.InitInstance = (CELBODY*(*)(OBJHANDLE))GetProcAddress (m.hDLL, "InitInstance");
+		m.ExitInstance = (void(*)(CELBODY*))GetProcAddress (m.hDLL, "ExitInstance");
+		mod.push_back (m);
+		if (!m.InitInstance || !m.ExitInstance) return false;
+	}
+	return true;
+}
+
+static void FreeMoonModules (vector<HMODULE> &base, vector<MoonModule> &mod)
+{
+	for (auto it = mod.rbegin(); it != mod.rend(); it++) FreeLibrary (it->hDLL);
+	for (auto it = base.rbegin(); it != base.rend(); it++) FreeLibrary (*it);
+	mod.clear();
+	base.clear();
+}
+
+// Full ephemerides of all moons at all epochs through the shared module
+// instances, in a shuffled order
+static void EphemerisAll (const vector<CELBODY*> &body, const vector<double> &mjd, unsigned int seed,
+	vector<double> &res, int &nfail)
+{
+	vector<int> job (mjd.size()*NMOON);
+	for (size_t i = 0; i < job.size(); i++) job[i] = (int)i;
+	std::mt19937 rng (seed);
+	std::shuffle (job.begin(), job.end(), rng);
+	res.assign (job.size()*12, 0.0);
+	nfail = 0;
+	for (int j : job)
+		if (body[j % NMOON]->clbkEphemeris (mjd[j / NMOON], EPHEM_TRUEPOS|EPHEM_TRUEVEL, res.data() + j*12) != 0x1F)
+			nfail++;
+}
+
+// Interpolated ephemerides of all moons along a sequence of simulation
+// times. body holds the caller's own instances, since the interpolation
+// samples are instance state; the bodies are visited in a shuffled order
+// at each step.
+static void FastEphemerisAll (const vector<CELBODY*> &body, const vector<double> &simt, unsigned int seed,
+	vector<double> &res)
+{
+	vector<int> order (NMOON);
+	for (int k = 0; k < NMOON; k++) order[k] = k;
+	std::mt19937 rng (seed);
+	res.assign (simt.size()*NMOON*12, 0.0);
+	for (size_t i = 0; i < simt.size(); i++) {
+		std::shuffle (order.begin(), order.end(), rng);
+		for (int k : order)
+			body[k]->clbkFastEphemeris (simt[i], EPHEM_TRUEPOS|EPHEM_TRUEVEL, res.data() + (i*NMOON+k)*12);
+	}
+}
+
+static int Mismatch (const vector<double> &res, const vector<double> &ref)
+{
+	int nmismatch = 0;
+	for (size_t j = 0; j < ref.size(); j++)
+		if (memcmp (&res[j], &ref[j], sizeof(double))) nmismatch++;
+	return nmismatch;
+}
+
+TEST_CASE("Concurrent moon module ephemerides match serial results", "[Satsat][Galsat]")
+{
+	vector<HMODULE> base;
+	vector<MoonModule> mod;
+	REQUIRE(LoadMoonModules (base, mod));
+
+	vector<CELBODY*> body (NMOON);
+	for (int k = 0; k < NMOON; k++) {
+		body[k] = mod[k].InitInstance (NULL);
+		REQUIRE(body[k]);
+		CHECK(body[k]->bEphemeris());
+	}
+
+	SECTION("clbkEphemeris on shared instances") {
+		std::mt19937 rng (4321);
+		std::uniform_real_distribution<double> epoch (33000.0, 69800.0); // MJD, 1949-2050
+		vector<double> mjd (NEPOCH/2);
+		for (double &t : mjd) t = epoch (rng);
+
+		vector<vector<double>> res (NTHREAD);
+		vector<int> nfail (NTHREAD);
+		vector<std::thread> thread;
+		for (int i = 0; i < NTHREAD; i++)
+			thread.emplace_back (EphemerisAll, std::cref(body), std::cref(mjd), 200u+i, std::ref(res[i]), std::ref(nfail[i]));
+		for (auto &th : thread) th.join();
+
+		vector<double> ref;
+		int reffail;
+		EphemerisAll (body, mjd, 199u, ref, reffail);
+		CHECK(reffail == 0);
+
+		// sanity check of the reference: Titan at about 1.2e9 m from Saturn
+		double rt = sqrt (ref[5*12]*ref[5*12] + ref[5*12+1]*ref[5*12+1] + ref[5*12+2]*ref[5*12+2]);
+		CHECK(rt > 1.1e9);
+		CHECK(rt < 1.3e9);
+
+		for (int i = 0; i < NTHREAD; i++) {
+			INFO("thread " << i);
+			CHECK(nfail[i] == 0);
+			CHECK(Mismatch (res[i], ref) == 0);
+		}
+	}
+
+	SECTION("clbkEphemerisBatch on shared SATOBJ instances") {
+		const int n = 45; // more than one chunk
+		vector<double> mjd (n);
+		for (int j = 0; j < n; j++) mjd[j] = 33000.0 + 817.3*j;
+
+		vector<double> ref (NSAT*n*12);
+		for (int k = 0; k < NSAT; k++) {
+			REQUIRE(body[k]->Version() >= 3);
+			for (int j = 0; j < n; j++)
+				body[k]->clbkEphemeris (mjd[j], EPHEM_TRUEPOS|EPHEM_TRUEVEL, ref.data() + (k*n+j)*12);
+		}
+
+		vector<vector<double>> res (NTHREAD, vector<double> (ref.size()));
+		vector<std::thread> thread;
+		for (int i = 0; i < NTHREAD; i++)
+			thread.emplace_back ([&, i]() {
+				for (int k = 0; k < NSAT; k++) {
+					int kk = (k+i) % NSAT; // threads start on different moons
+					((CELBODY3*)body[kk])->clbkEphemerisBatch (n, mjd.data(), EPHEM_TRUEPOS|EPHEM_TRUEVEL, res[i].data() + kk*n*12);
+				}
+			});
+		for (auto &th : thread) th.join();
+
+		for (int i = 0; i < NTHREAD; i++) {
+			INFO("thread " << i);
+			CHECK(Mismatch (res[i], ref) == 0);
+		}
+	}
+
+	SECTION("clbkFastEphemeris on per-thread instances") {
+		// forward steps across several sample intervals, and a jump back
+		std::mt19937 rng (5678);
+		std::uniform_real_distribution<double> step (0.0, 60.0);
+		vector<double> simt (1000);
+		double t = 1e5;
+		for (size_t i = 0; i < simt.size(); i++) {
+			if (i == simt.size()/2) t -= 2e4;
+			simt[i] = (t += step (rng));
+		}
+
+		auto Instances = [&]() {
+			vector<CELBODY*> b (NMOON);
+			for (int k = 0; k < NMOON; k++) b[k] = mod[k].InitInstance (NULL);
+			return b;
+		};
+		auto Release = [&](vector<CELBODY*> &b) {
+			for (int k = 0; k < NMOON; k++) mod[k].ExitInstance (b[k]);
+		};
+
+		vector<vector<CELBODY*>> tbody (NTHREAD);
+		for (auto &b : tbody) b = Instances();
+		vector<vector<double>> res (NTHREAD);
+		vector<std::thread> thread;
+		for (int i = 0; i < NTHREAD; i++)
+			thread.emplace_back (FastEphemerisAll, std::cref(tbody[i]), std::cref(simt), 300u+i, std::ref(res[i]));
+		for (auto &th : thread) th.join();
+
+		vector<CELBODY*> rbody = Instances();
+		vector<double> ref;
+		FastEphemerisAll (rbody, simt, 299u, ref);
+
+		for (int i = 0; i < NTHREAD; i++) {
+			INFO("thread " << i);
+			CHECK(Mismatch (res[i], ref) == 0);
+			Release (tbody[i]);
+		}
+		Release (rbody);
+	}
+
+	for (int k = 0; k < NMOON; k++) mod[k].ExitInstance (body[k]);
+	FreeMoonModules (base, mod);
+}
@@ -0,0 +1,237 @@
+#include "TileLoadQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+// Request queue of the elevation tile prefetcher (TileLoadQueue): loading
+// on the I/O threads, de-duplication of pending requests, dropping of
+// requests beyond the queue limit, and Clear.
+
+using std::vector;
+typedef std::pair<TileLoadQueue::Key,TileLoadQueue::Tile> Loaded;
+
+// Blocks loads until opened, and counts the loads that have started
+class Gate {
+public:
+	void Open ()
+	{
+		{ std::lock_guard<std::mutex> lock(mtx); open = true; }
+		cv.notify_all();
+	}
+	void Pass ()
+	{
+		nstarted++;
+		std::unique_lock<std::mutex> lock(mtx);
+		cv.wait (lock, [this] { return open; });
+	}
+	bool WaitStarted (int n) const // wait until n loads have started (false on timeout)
+	{
+		for (int i = 0; i < 5000 && nstarted < n; i++)
+			std::this_thread::sleep_for (std::chrono::milliseconds(1));
+		return nstarted >= n;
+	}
+	std::atomic<int> nstarted{0};
+
+private:
+	std::mutex mtx;
+	std::condition_variable cv;
+	bool open = false;
+};
+
+// A tile whose data identify the key; keys with odd ilng have no data
+static TileLoadQueue::Tile MakeTile (const TileLoadQueue::Key &key)
+{
+	TileLoadQueue::Tile tile = {key.lvl, key.ilat, key.ilng, 0};
+	if (!(key.ilng & 1)) {
+		tile.data = new int16_t[3];
+		tile.data[0] = (int16_t)key.lvl, tile.data[1] = (int16_t)key.ilat, tile.data[2] = (int16_t)key.ilng;
+	}
+	return tile;
+}
+
+static TileLoadQueue::LoadFunc Loader (const TileLoadQueue::Key &key, Gate *gate = 0, std::atomic<int> *nload = 0)
+{
+	return [=]() {
+		if (gate) gate->Pass();
+		if (nload) (*nload)++;
+		return MakeTile (key);
+	};
+}
+
+// Collect until n tiles have arrived (or a timeout)
+static void CollectN (TileLoadQueue &q, size_t n, vector<Loaded> &ready)
+{
+	for (int i = 0; i < 5000 && ready.size() < n; i++) {
+		q.Collect (ready);
+		if (ready.size() < n) std::this_thread::sleep_for (std::chrono::milliseconds(1));
+	}
+}
+
+static void Release (vector<Loaded> &ready)
+{
+	for (auto &r : ready) delete []r.second.data;
+	ready.clear();
+}
+
+// =======================================================================
+
+TEST_CASE("Requested tiles are loaded and collected", "[TileLoadQueue]")
+{
+	TileLoadQueue q (4);
+	CHECK(q.nThread() == 4);
+	std::atomic<int> nload(0);
+	const int n = 200;
+	for (int i = 0; i < n; i++) {
+		TileLoadQueue::Key key = {1, 8, i, 2*i};
+		REQUIRE(q.Request (key, Loader (key, 0, &nload)));
+	}
+
+	vector<Loaded> ready;
+	CollectN (q, n, ready);
+	REQUIRE(ready.size() == n);
+	std::sort (ready.begin(), ready.end(), [](const Loaded &a, const Loaded &b) { return a.first.ilat < b.first.ilat; });
+	for (int i = 0; i < n; i++) {
+		const TileLoadQueue::Key &key = ready[i].first;
+		const TileLoadQueue::Tile &tile = ready[i].second;
+		CHECK(key.ilat == i);
+		CHECK((tile.lvl == 8 && tile.ilat == i && tile.ilng == 2*i));
+		CHECK((tile.data[0] == 8 && tile.data[1] == i && tile.data[2] == 2*i));
+	}
+	CHECK(nload == n);
+
+	TileLoadQueue::Stats stats = q.GetStats();
+	CHECK(stats.requested == n);
+	CHECK(stats.dropped == 0);
+	CHECK(stats.loaded == n);
+
+	// nothing left to collect
+	vector<Loaded> more;
+	q.Collect (more);
+	CHECK(more.empty());
+	Release (ready);
+}
+
+TEST_CASE("Pending requests are not repeated", "[TileLoadQueue]")
+{
+	Gate gate; // outlives the queue
+	TileLoadQueue q (1);
+	std::atomic<int> nload(0);
+	TileLoadQueue::Key key = {1, 10, 5, 6}, key2 = {2, 10, 5, 6};
+
+	// while the request is loading
+	REQUIRE(q.Request (key, Loader (key, &gate, &nload)));
+	REQUIRE(gate.WaitStarted (1));
+	CHECK_FALSE(q.Request (key, Loader (key, 0, &nload)));
+	CHECK(q.Request (key2, Loader (key2, 0, &nload))); // different source
+
+	// while it is queued
+	TileLoadQueue::Key key3 = {1, 10, 5, 8};
+	CHECK(q.Request (key3, Loader (key3, 0, &nload)));
+	CHECK_FALSE(q.Request (key3, Loader (key3, 0, &nload)));
+
+	// while it waits for Collect
+	gate.Open();
+	vector<Loaded> ready;
+	CollectN (q, 3, ready);
+	CHECK(ready.size() == 3);
+	CHECK(nload == 3);
+	CHECK(q.GetStats().requested == 3);
+
+	// collected tiles can be requested again
+	CHECK(q.Request (key, Loader (key, 0, &nload)));
+	CollectN (q, 4, ready);
+	CHECK(ready.size() == 4);
+	Release (ready);
+
+	// loads without data are not collected, and release the key at once
+	TileLoadQueue::Key none = {1, 10, 5, 7};
+	REQUIRE(q.Request (none, Loader (none, 0, &nload)));
+	for (int i = 0; i < 5000 && nload < 5; i++)
+		std::this_thread::sleep_for (std::chrono::milliseconds(1));
+	REQUIRE(nload == 5);
+	bool requeued = false;
+	for (int i = 0; i < 5000 && !(requeued = q.Request (none, Loader (none, 0, &nload))); i++)
+		std::this_thread::sleep_for (std::chrono::milliseconds(1));
+	CHECK(requeued);
+	q.Clear();
+	q.Collect (ready);
+	CHECK(ready.empty());
+	CHECK(q.GetStats().loaded == 4);
+}
+
+TEST_CASE("Requests beyond the queue limit are dropped", "[TileLoadQueue]")
+{
+	const size_t maxqueue = 4;
+	Gate gate;
+	TileLoadQueue q (1, maxqueue);
+	TileLoadQueue::Key key = {1, 10, 0, 0};
+	REQUIRE(q.Request (key, Loader (key, &gate)));
+	REQUIRE(gate.WaitStarted (1)); // the worker holds the first request
+
+	int naccept = 0;
+	for (int i = 1; i <= 6; i++) {
+		TileLoadQueue::Key k = {1, 10, 0, 2*i};
+		if (q.Request (k, Loader (k, &gate))) naccept++;
+	}
+	CHECK(naccept == maxqueue);
+	TileLoadQueue::Stats stats = q.GetStats();
+	CHECK(stats.requested == maxqueue+1);
+	CHECK(stats.dropped == 2);
+
+	// a dropped request is not pending, so it can be made again once there is room
+	gate.Open();
+	vector<Loaded> ready;
+	CollectN (q, maxqueue+1, ready);
+	CHECK(ready.size() == maxqueue+1);
+	TileLoadQueue::Key k = {1, 10, 0, 12};
+	CHECK(q.Request (k, Loader (k)));
+	CollectN (q, maxqueue+2, ready);
+	CHECK(ready.size() == maxqueue+2);
+	Release (ready);
+}
+
+TEST_CASE("Clear discards queued requests and waits for running loads", "[TileLoadQueue]")
+{
+	Gate gate;
+	TileLoadQueue q (2);
+	std::atomic<int> nload(0);
+	vector<TileLoadQueue::Key> keys;
+	for (int i = 0; i < 10; i++) {
+		TileLoadQueue::Key key = {3, 12, i, 0};
+		keys.push_back (key);
+		REQUIRE(q.Request (key, Loader (key, &gate, &nload)));
+	}
+	REQUIRE(gate.WaitStarted (2)); // both workers hold a request, 8 are queued
+
+	std::atomic<bool> cleared(false);
+	std::thread th ([&]() { q.Clear(); cleared = true; });
+	std::this_thread::sleep_for (std::chrono::milliseconds(50));
+	CHECK_FALSE(cleared); // still waiting for the running loads
+	gate.Open();
+	th.join();
+	CHECK(nload == 2);    // the queued requests never ran
+
+	// the tiles of the running loads are discarded
+	vector<Loaded> ready;
+	q.Collect (ready);
+	CHECK(ready.empty());
+	std::this_thread::sleep_for (std::chrono::milliseconds(20));
+	CHECK(nload == 2);
+	CHECK(q.GetStats().loaded == 0);
+
+	// all keys can be requested again
+	for (auto &key : keys)
+		CHECK(q.Request (key, Loader (key, 0, &nload)));
+	CollectN (q, keys.size(), ready);
+	CHECK(ready.size() == keys.size());
+	CHECK(nload == 12);
+	Release (ready);
+}
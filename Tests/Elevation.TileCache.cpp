@@ -0,0 +1,166 @@
+#include "ElevTileCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+// Shared elevation tile cache (ElevationTileCache): lookup, LRU eviction
+// under the memory budget, and concurrent use from several threads. The
+// "[.benchmark]" test case prints the lookup throughput for different
+// thread counts; run it explicitly with
+//    Elevation.TileCache [benchmark]
+
+static const size_t TILESIZE = 259*259*sizeof(int16_t);
+
+// A tile whose data identify its index
+static ElevTilePtr MakeTile (int lvl, int ilat, int ilng)
+{
+	int16_t *data = new int16_t[259*259];
+	data[0] = (int16_t)lvl;
+	data[1] = (int16_t)ilat;
+	data[2] = (int16_t)ilng;
+	return ElevTilePtr (data, std::default_delete<int16_t[]>());
+}
+
+// Look up a tile and insert it on a miss; tiles with odd ilng don't exist
+static ElevTilePtr Get (ElevationTileCache &cache, unsigned int src, int lvl, int ilat, int ilng)
+{
+	ElevTilePtr tile;
+	if (!cache.Find (src, lvl, ilat, ilng, tile))
+		tile = cache.Insert (src, lvl, ilat, ilng, ilng & 1 ? ElevTilePtr() : MakeTile (lvl, ilat, ilng), TILESIZE);
+	return tile;
+}
+
+static bool Matches (const ElevTilePtr &tile, int lvl, int ilat, int ilng)
+{
+	if (ilng & 1) return !tile;
+	return tile && tile.get()[0] == lvl && tile.get()[1] == ilat && tile.get()[2] == ilng;
+}
+
+// =======================================================================
+
+TEST_CASE("Tiles are cached per source and index", "[ElevTileCache]")
+{
+	ElevationTileCache cache (64 << 20);
+	unsigned int src1 = ElevationTileCache::NewSource(), src2 = ElevationTileCache::NewSource();
+	CHECK(src1 != src2);
+
+	ElevTilePtr tile;
+	CHECK_FALSE(cache.Find (src1, 5, 10, 20, tile));
+	ElevTilePtr t1 = Get (cache, src1, 5, 10, 20);
+	REQUIRE(cache.Find (src1, 5, 10, 20, tile));
+	CHECK(tile == t1);
+	CHECK_FALSE(cache.Find (src2, 5, 10, 20, tile));
+	CHECK_FALSE(cache.Find (src1, 6, 10, 20, tile));
+
+	// missing tiles are remembered as such
+	CHECK_FALSE(Get (cache, src1, 5, 10, 21));
+	CHECK(cache.Find (src1, 5, 10, 21, tile));
+	CHECK_FALSE(tile);
+
+	// a concurrent insertion of the same tile keeps the first copy
+	CHECK(cache.Insert (src1, 5, 10, 20, MakeTile (5, 10, 20), TILESIZE) == t1);
+
+	ElevationTileCache::Stats stats = cache.GetStats();
+	CHECK(stats.hits == 2);
+	CHECK(stats.misses == 5);
+	CHECK(stats.ntile == 2);
+
+	// dropping a source removes its tiles only
+	Get (cache, src2, 5, 10, 20);
+	cache.Drop (src1);
+	CHECK_FALSE(cache.Find (src1, 5, 10, 20, tile));
+	CHECK(cache.Find (src2, 5, 10, 20, tile));
+	CHECK(cache.GetStats().ntile == 1);
+}
+
+TEST_CASE("Least recently used tiles are evicted under the budget", "[ElevTileCache]")
+{
+	const size_t budget = 32 << 20; // about 15 tiles per shard
+	ElevationTileCache cache (budget);
+	unsigned int src = ElevationTileCache::NewSource();
+
+	// a frequently used tile survives a sweep over many others
+	ElevTilePtr hot = Get (cache, src, 8, 0, 0), tile;
+	for (int i = 1; i < 500; i++) {
+		Get (cache, src, 8, i, 2*i);
+		REQUIRE(cache.Find (src, 8, 0, 0, tile));
+	}
+	CHECK(tile == hot);
+
+	ElevationTileCache::Stats stats = cache.GetStats();
+	CHECK(stats.mem <= budget);
+	CHECK(stats.evictions > 0);
+	CHECK(stats.ntile + stats.evictions == 500);
+
+	// evicted tiles stay valid for callers which still hold them
+	ElevTilePtr t = Get (cache, src, 9, 1, 2);
+	for (int i = 1; i < 500; i++)
+		Get (cache, src, 10, i, 2*i);
+	CHECK_FALSE(cache.Find (src, 9, 1, 2, tile));
+	CHECK(Matches (t, 9, 1, 2));
+
+	// a smaller budget applies from the next insertions
+	cache.SetBudget (budget/4);
+	for (int i = 1; i < 100; i++)
+		Get (cache, src, 11, i, 2*i);
+	CHECK(cache.GetStats().mem <= budget/4);
+}
+
+TEST_CASE("Concurrent lookups return consistent tiles", "[ElevTileCache]")
+{
+	const int nthread = 8, nquery = 20000;
+	ElevationTileCache cache (8 << 20); // small enough to evict while the threads run
+	unsigned int src = ElevationTileCache::NewSource();
+	std::vector<int> nfail(nthread, 0);
+	std::vector<std::thread> thread;
+	for (int k = 0; k < nthread; k++) {
+		thread.emplace_back ([&, k]() {
+			std::mt19937 rng (k);
+			std::uniform_int_distribution<int> idx (0, 199);
+			for (int i = 0; i < nquery; i++) {
+				int ilat = idx(rng), ilng = idx(rng) % 12;
+				if (!Matches (Get (cache, src, 12, ilat, ilng), 12, ilat, ilng)) nfail[k]++;
+			}
+		});
+	}
+	for (auto &th : thread) th.join();
+	for (int k = 0; k < nthread; k++)
+		CHECK(nfail[k] == 0);
+	ElevationTileCache::Stats stats = cache.GetStats();
+	CHECK(stats.hits + stats.misses == (uint64_t)nthread*nquery);
+	CHECK(stats.mem <= (size_t)(8 << 20));
+}
+
+TEST_CASE("Elevation tile cache throughput", "[.benchmark]")
+{
+	// vessels spread over a few hundred tiles, all of which fit the budget
+	const int nquery = 1000000;
+	unsigned int nmax = std::max (8u, std::thread::hardware_concurrency());
+	printf ("\nElevation tile cache lookups\n%-8s %14s %10s\n", "Threads", "Lookups [1/s]", "Hit rate");
+	for (unsigned int nthread = 1; nthread <= nmax; nthread *= 2) {
+		ElevationTileCache cache (128 << 20);
+		unsigned int src = ElevationTileCache::NewSource();
+		auto t0 = std::chrono::steady_clock::now();
+		std::vector<std::thread> thread;
+		for (unsigned int k = 0; k < nthread; k++) {
+			thread.emplace_back ([&, k]() {
+				std::mt19937 rng (k);
+				std::uniform_int_distribution<int> idx (0, 19);
+				for (int i = 0; i < nquery/(int)nthread; i++)
+					Get (cache, src, 12, idx(rng), idx(rng));
+			});
+		}
+		for (auto &th : thread) th.join();
+		double rate = nquery / std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+		ElevationTileCache::Stats stats = cache.GetStats();
+		printf ("%-8u %14.4g %9.4f%%\n", nthread, rate, 100.0*stats.hits/(stats.hits+stats.misses));
+	}
+	printf ("\n");
+}
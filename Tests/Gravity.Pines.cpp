@@ -0,0 +1,360 @@
+#include "Vecmat.h"
+#include "PinesGrav.h"
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+// Pines spherical harmonics gravity model: scalar and batch evaluation,
+// concurrent use, the interpolation grid, the binary coefficient file and
+// truncation by distance. The "[.benchmark]" test cases compare the cost of
+// the alternatives; run them explicitly with
+//    Gravity.Pines [benchmark]
+
+using std::vector;
+using std::thread;
+
+static const int NPOS = 64;
+
+// Reproducible set of positions [km] in a shell between 10 and 500 km above the lunar surface
+static void MakePositions(vector<double>& x, vector<double>& y, vector<double>& z)
+{
+	x.resize(NPOS); y.resize(NPOS); z.resize(NPOS);
+	unsigned int seed = 1;
+	for (int i = 0; i < NPOS; i++) {
+		seed = seed * 1103515245 + 12345; double r = 1748.0 + (seed >> 16) % 490;
+		seed = seed * 1103515245 + 12345; double lat = ((seed >> 16) % 3141) * 1e-3 - Pi05;
+		seed = seed * 1103515245 + 12345; double lng = ((seed >> 16) % 6283) * 1e-3;
+		x[i] = r * cos(lat) * cos(lng);
+		y[i] = r * cos(lat) * sin(lng);
+		z[i] = r * sin(lat);
+	}
+}
+
+// Batch evaluation must reproduce the scalar path to rounding error
+TEST_CASE("Batch and scalar Pines gravity agree", "[PinesGrav]")
+{
+	PinesGravProp pines(nullptr);
+	int nloaded, nmodel;
+	char fname[] = "GravityModels\\jgl165p1.sha";
+	REQUIRE(pines.readGravModel(fname, 100, nloaded, nmodel) == 0);
+	int nmax = pines.GetCoeffCutoff();
+
+	vector<double> x, y, z;
+	MakePositions(x, y, z);
+	vector<double> gx(NPOS), gy(NPOS), gz(NPOS);
+
+	for (int order : { nmax, nmax / 2 }) {
+		pines.GetPinesGravBatch(NPOS, x.data(), y.data(), z.data(), gx.data(), gy.data(), gz.data(), nmax, order);
+		for (int i = 0; i < NPOS; i++) {
+			Vector g = pines.GetPinesGrav(Vector(x[i], y[i], z[i]), nmax, order);
+			Vector dg(gx[i] - g.x, gy[i] - g.y, gz[i] - g.z);
+			REQUIRE(dg.length() <= 1e-12 * g.length());
+		}
+	}
+
+	// degree above the cutoff and order above the degree are clamped
+	pines.GetPinesGravBatch(NPOS, x.data(), y.data(), z.data(), gx.data(), gy.data(), gz.data(), nmax + 20, nmax + 40);
+	for (int i = 0; i < NPOS; i++) {
+		Vector pos(x[i], y[i], z[i]);
+		Vector g = pines.GetPinesGrav(pos, nmax, nmax);
+		Vector gc = pines.GetPinesGrav(pos, nmax + 20, nmax + 40);
+		REQUIRE((gc.x == g.x && gc.y == g.y && gc.z == g.z));
+		Vector dg(gx[i] - g.x, gy[i] - g.y, gz[i] - g.z);
+		REQUIRE(dg.length() <= 1e-12 * g.length());
+		Vector g10 = pines.GetPinesGrav(pos, 10, 10);
+		Vector gc10 = pines.GetPinesGrav(pos, 10, 50);
+		REQUIRE((gc10.x == g10.x && gc10.y == g10.y && gc10.z == g10.z));
+	}
+}
+
+TEST_CASE("Batch and scalar Pines gravity throughput", "[.benchmark]")
+{
+	PinesGravProp pines(nullptr);
+	int nloaded, nmodel;
+	char fname[] = "GravityModels\\jgl165p1.sha";
+	REQUIRE(pines.readGravModel(fname, 100, nloaded, nmodel) == 0);
+	int nmax = pines.GetCoeffCutoff();
+
+	vector<double> x, y, z;
+	MakePositions(x, y, z);
+	vector<double> gx(NPOS), gy(NPOS), gz(NPOS);
+
+	BENCHMARK("Scalar, degree 100") {
+		Vector sum;
+		for (int i = 0; i < NPOS; i++)
+			sum += pines.GetPinesGrav(Vector(x[i], y[i], z[i]), nmax, nmax);
+		return sum.x;
+	};
+	BENCHMARK("Batch, degree 100") {
+		pines.GetPinesGravBatch(NPOS, x.data(), y.data(), z.data(), gx.data(), gy.data(), gz.data(), nmax, nmax);
+		return gx[0];
+	};
+}
+
+// The model is shared read-only between threads; concurrent evaluations must match the serial ones
+TEST_CASE("Concurrent Pines gravity evaluation", "[PinesGrav]")
+{
+	PinesGravProp pines(nullptr);
+	int nloaded, nmodel;
+	char fname[] = "GravityModels\\jgl165p1.sha";
+	REQUIRE(pines.readGravModel(fname, 60, nloaded, nmodel) == 0);
+	int nmax = pines.GetCoeffCutoff();
+
+	vector<double> x, y, z;
+	MakePositions(x, y, z);
+	vector<Vector> gref(NPOS);
+	for (int i = 0; i < NPOS; i++)
+		gref[i] = pines.GetPinesGrav(Vector(x[i], y[i], z[i]), nmax, nmax);
+
+	const int nthread = 8;
+	vector<int> nfail(nthread, 0);
+	vector<thread> threads;
+	for (int j = 0; j < nthread; j++) {
+		threads.emplace_back([&, j]() {
+			PinesGravWorkspace ws; // odd threads use their own workspace, even ones the thread-local default
+			for (int rep = 0; rep < 20; rep++) {
+				for (int i = 0; i < NPOS; i++) {
+					Vector pos(x[i], y[i], z[i]);
+					Vector g = (j & 1 ? pines.GetPinesGrav(pos, nmax, nmax, ws) : pines.GetPinesGrav(pos, nmax, nmax));
+					if (g.x != gref[i].x || g.y != gref[i].y || g.z != gref[i].z) nfail[j]++;
+				}
+			}
+		});
+	}
+	for (auto& th : threads) th.join();
+	for (int j = 0; j < nthread; j++)
+		REQUIRE(nfail[j] == 0);
+}
+
+// Grid interpolation close to the surface must stay within tolerance of the direct evaluation
+TEST_CASE("Interpolated Pines gravity grid", "[PinesGrav]")
+{
+	PinesGravProp pines(nullptr);
+	int nloaded, nmodel;
+	char fname[] = "GravityModels\\jgl165p1.sha";
+	REQUIRE(pines.readGravModel(fname, 60, nloaded, nmodel) == 0);
+	int nmax = pines.GetCoeffCutoff();
+
+	const double tol = 1e-4;
+	PinesGravGrid grid(pines, tol, (size_t)16 << 20);
+
+	// low orbit track segment 15-100 km above a small patch of the surface
+	vector<Vector> pos;
+	for (int i = 0; i < NPOS; i++) {
+		double r = 1753.0 + 85.0 * i / NPOS, lat = 0.2 + 0.002 * i, lng = 1.0 + 0.003 * i;
+		pos.push_back(Vector(r * cos(lat) * cos(lng), r * cos(lat) * sin(lng), r * sin(lat)));
+	}
+
+	double errmax = 0.0;
+	for (const Vector& p : pos) {
+		Vector gi, gd = pines.GetPinesGrav(p, nmax, nmax);
+		REQUIRE(grid.GetPinesGrav(p, gi));
+		errmax = std::max(errmax, (gi - gd).length() / gd.length());
+	}
+	REQUIRE(errmax < tol);
+	REQUIRE(grid.nTiles() > 0);
+
+	// outside the shell, the caller falls back to direct evaluation
+	Vector g;
+	REQUIRE_FALSE(grid.GetPinesGrav(Vector(0, 0, 3000.0), g));
+}
+
+TEST_CASE("Interpolated Pines gravity grid throughput", "[.benchmark]")
+{
+	PinesGravProp pines(nullptr);
+	int nloaded, nmodel;
+	char fname[] = "GravityModels\\jgl165p1.sha";
+	REQUIRE(pines.readGravModel(fname, 60, nloaded, nmodel) == 0);
+	int nmax = pines.GetCoeffCutoff();
+	PinesGravGrid grid(pines, 1e-4, (size_t)16 << 20);
+
+	vector<Vector> pos;
+	for (int i = 0; i < NPOS; i++) {
+		double r = 1753.0 + 85.0 * i / NPOS, lat = 0.2 + 0.002 * i, lng = 1.0 + 0.003 * i;
+		pos.push_back(Vector(r * cos(lat) * cos(lng), r * cos(lat) * sin(lng), r * sin(lat)));
+	}
+	Vector g;
+	for (const Vector& p : pos) grid.GetPinesGrav(p, g); // build the tiles first
+
+	BENCHMARK("Direct, degree 60") {
+		Vector sum;
+		for (const Vector& p : pos) sum += pines.GetPinesGrav(p, nmax, nmax);
+		return sum.x;
+	};
+	BENCHMARK("Grid, degree 60") {
+		Vector sum, gi;
+		for (const Vector& p : pos) { grid.GetPinesGrav(p, gi); sum += gi; }
+		return sum.x;
+	};
+}
+
+// The tile cache must respect its memory budget
+TEST_CASE("Pines gravity grid eviction", "[PinesGrav]")
+{
+	PinesGravProp pines(nullptr);
+	int nloaded, nmodel;
+	char fname[] = "GravityModels\\jgl165p1.sha";
+	REQUIRE(pines.readGravModel(fname, 20, nloaded, nmodel) == 0);
+
+	const size_t budget = 64 << 10;
+	PinesGravGrid grid(pines, 1e-4, budget);
+	Vector g;
+	for (int i = 0; i < 200; i++) {
+		double lng = i * 0.031, r = 1760.0;
+		REQUIRE(grid.GetPinesGrav(Vector(r * cos(lng), r * sin(lng), 0.0), g));
+		REQUIRE(grid.MemUsage() <= budget);
+	}
+}
+
+// The binary coefficient file must reproduce the text model exactly, at any cutoff
+TEST_CASE("Binary gravity model file", "[PinesGrav]")
+{
+	const char* txtname = "GravityModels\\jgl165p1.sha";
+	const char* binname = "jgl165p1.pgb";
+	int nmax;
+	REQUIRE(PinesGravProp::ConvertGravModel(txtname, binname, nmax) == 0);
+	REQUIRE(nmax == 165);
+
+	vector<double> x, y, z;
+	MakePositions(x, y, z);
+
+	for (int cutoff : { 40, 165, 200 }) {
+		PinesGravProp ptxt(nullptr), pbin(nullptr);
+		int nl1, nm1, nl2, nm2;
+		REQUIRE(ptxt.readGravModelText(txtname, cutoff, nl1, nm1) == 0);
+		REQUIRE(pbin.readGravModelBin(binname, cutoff, nl2, nm2) == 0);
+		REQUIRE(nl1 == nl2);
+		REQUIRE(nm1 == nm2);
+		REQUIRE(ptxt.GetCoeffCutoff() == pbin.GetCoeffCutoff());
+		int n = pbin.GetCoeffCutoff();
+		for (int i = 0; i < NPOS; i++) {
+			Vector pos(x[i], y[i], z[i]);
+			Vector g1 = ptxt.GetPinesGrav(pos, n, n), g2 = pbin.GetPinesGrav(pos, n, n);
+			REQUIRE((g1.x == g2.x && g1.y == g2.y && g1.z == g2.z));
+		}
+	}
+
+	PinesGravProp pbad(nullptr);
+	int nl, nm;
+	REQUIRE(pbad.readGravModelBin(txtname, 10, nl, nm) == 3);
+	remove(binname);
+}
+
+// The binary file is only used in place of the text file it was converted from
+TEST_CASE("Stale binary gravity model file", "[PinesGrav]")
+{
+	namespace fs = std::filesystem;
+	const char* txtname = "pgb.test/jgl165p1"; // no extension, '.' in the directory name
+	const char* binname = "pgb.test/jgl165p1.pgb";
+	fs::create_directories("pgb.test");
+	fs::copy_file("GravityModels\\jgl165p1.sha", txtname, fs::copy_options::overwrite_existing);
+	int nmax;
+	REQUIRE(PinesGravProp::ConvertGravModel(txtname, binname, nmax) == 0);
+	fs::file_time_type tbin = fs::last_write_time(binname);
+	REQUIRE(PinesGravProp::IsGravModelBinCurrent(binname, txtname));
+
+	// replace the text file with an unreadable one of the same size, so only the
+	// binary file can be loaded
+	uintmax_t size = fs::file_size(txtname);
+	auto WriteText = [&](uintmax_t n) {
+		FILE* f = fopen(txtname, "wb");
+		REQUIRE(f);
+		for (uintmax_t i = 0; i < n; i++) fputc(i % 80 == 79 ? '\n' : 'x', f);
+		fclose(f);
+	};
+	WriteText(size);
+	char fname[64];
+	strcpy(fname, txtname);
+	int nl, nm;
+
+	fs::last_write_time(txtname, tbin - std::chrono::hours(1));
+	CHECK(PinesGravProp::IsGravModelBinCurrent(binname, txtname));
+	CHECK(PinesGravProp(nullptr).readGravModel(fname, 20, nl, nm) == 0);
+
+	// newer text file
+	fs::last_write_time(txtname, tbin + std::chrono::hours(1));
+	CHECK_FALSE(PinesGravProp::IsGravModelBinCurrent(binname, txtname));
+	CHECK(PinesGravProp(nullptr).readGravModel(fname, 20, nl, nm) == 3);
+
+	// text file of different size
+	WriteText(size + 1);
+	fs::last_write_time(txtname, tbin - std::chrono::hours(1));
+	CHECK_FALSE(PinesGravProp::IsGravModelBinCurrent(binname, txtname));
+	CHECK(PinesGravProp(nullptr).readGravModel(fname, 20, nl, nm) == 3);
+
+	fs::remove_all("pgb.test");
+}
+
+TEST_CASE("Binary gravity model load time", "[.benchmark]")
+{
+	const char* txtname = "GravityModels\\jgl165p1.sha";
+	const char* binname = "jgl165p1.pgb";
+	int nmax, nl, nm;
+	REQUIRE(PinesGravProp::ConvertGravModel(txtname, binname, nmax) == 0);
+
+	BENCHMARK("Load text model, degree 165") {
+		PinesGravProp p(nullptr);
+		return p.readGravModelText(txtname, 165, nl, nm);
+	};
+	BENCHMARK("Load binary model, degree 165") {
+		PinesGravProp p(nullptr);
+		return p.readGravModelBin(binname, 165, nl, nm);
+	};
+	remove(binname);
+}
+
+// Truncating the series by distance must stay close to the tolerance and drop terms far out
+TEST_CASE("Pines gravity truncation degree", "[PinesGrav]")
+{
+	PinesGravProp pines(nullptr);
+	int nloaded, nmodel;
+	char fname[] = "GravityModels\\jgl165p1.sha";
+	REQUIRE(pines.readGravModel(fname, 100, nloaded, nmodel) == 0);
+	int nmax = pines.GetCoeffCutoff();
+	const double tol = 1e-9; // [km/s^2]
+
+	int nprev = nmax;
+	for (double alt : { 20.0, 100.0, 500.0, 2000.0, 10000.0, 60000.0 }) {
+		double r = pines.GetRefRad() + alt;
+		int n = pines.GetTruncationDegree(r, tol);
+		REQUIRE(n <= nprev);
+		nprev = n;
+
+		double errmax = 0.0;
+		for (int i = 0; i < 32; i++) {
+			double lat = -1.5 + 0.0967 * i, lng = 0.2 * i;
+			Vector pos(r * cos(lat) * cos(lng), r * cos(lat) * sin(lng), r * sin(lat));
+			Vector g = pines.GetPinesGrav(pos, nmax, nmax);
+			Vector gt = (n ? pines.GetPinesGrav(pos, n, n) : Vector());
+			errmax = std::max(errmax, (g - gt).length());
+		}
+		REQUIRE(errmax < 5.0 * tol);
+	}
+	REQUIRE(pines.GetTruncationDegree(pines.GetRefRad() + 60000.0, tol) < 5);
+}
+
+TEST_CASE("Pines gravity truncation throughput", "[.benchmark]")
+{
+	PinesGravProp pines(nullptr);
+	int nloaded, nmodel;
+	char fname[] = "GravityModels\\jgl165p1.sha";
+	REQUIRE(pines.readGravModel(fname, 100, nloaded, nmodel) == 0);
+	int nmax = pines.GetCoeffCutoff();
+	const double tol = 1e-9; // [km/s^2]
+
+	Vector pos(pines.GetRefRad() + 2000.0, 0, 0);
+	BENCHMARK("Full degree at 2000 km") {
+		return pines.GetPinesGrav(pos, nmax, nmax).x;
+	};
+	BENCHMARK("Truncated degree at 2000 km") {
+		int n = pines.GetTruncationDegree(pos.length(), tol);
+		return pines.GetPinesGrav(pos, n, n).x;
+	};
+}
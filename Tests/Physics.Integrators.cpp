@@ -0,0 +1,489 @@
+#include "Vecmat.h"
+#include "PinesGrav.h"
+#include "PhysicsCore.h"
+#include "PropHarness.h"
+#include "LinAngIntegrators.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+using std::vector;
+
+// Accuracy and cost of the RigidBody propagators (PROP_RK2 ... PROP_RKF78)
+// on canonical cases. The schemes are those of LinAngIntegrators.h, which
+// RigidBody shares with the propagation harness (PropHarness.h) used here.
+// The harness evaluates its own simplified force model (static bodies, no
+// third-body treatment), so these tests validate the integration schemes,
+// not the simulation's force model.
+// The "[.benchmark]" test case prints a table for tuning the propagation
+// levels (PropTTgt/PropATgt) and the adaptive tolerance. It runs the frame
+// update of RigidBody::Update, with frames of FRAME_SUBSTEPS substeps of the
+// length in the step column (for DP5 and RKF78, the step column sets the
+// frame length and angle step target in the same way); run it with
+//    Physics.Integrators [benchmark]
+
+static const double G = 6.67259e-11;
+static const double M_EARTH = 5.973698968e24, R_EARTH = 6.37101e6;
+static const double M_MOON = 7.347673176382784e22, R_MOON = 1.738e6;
+static const double J2_EARTH = 1.0826267e-3;
+static const char *J2_MODEL = "Physics.Integrators.J2.tab";
+static const char *METHOD_NAME[NPROP_METHOD] = {"RK2","RK4","RK5","RK6","RK7","RK8","SY2","SY4","SY6","SY8","DP5","RKF78"};
+
+// Earth J2-only gravity model in the text model format (normalised C20)
+static void WriteJ2Model ()
+{
+	FILE *f = fopen (J2_MODEL, "wt");
+	REQUIRE(f);
+	fprintf (f, "%.16e, %.16e, 0.0, 2, 2, 1, 0.0, 0.0\n", R_EARTH*1e-3, G*M_EARTH*1e-9);
+	fprintf (f, "1, 0, 0.0, 0.0, 0.0, 0.0\n");
+	fprintf (f, "1, 1, 0.0, 0.0, 0.0, 0.0\n");
+	fprintf (f, "2, 0, %.16e, 0.0, 0.0, 0.0\n", -J2_EARTH/sqrt(5.0));
+	fprintf (f, "2, 1, 0.0, 0.0, 0.0, 0.0\n");
+	fprintf (f, "2, 2, 0.0, 0.0, 0.0, 0.0\n");
+	fclose (f);
+}
+
+// =======================================================================
+// Test cases
+
+struct BenchCase {
+	const char *name;
+	HarnessSystem sys;
+	HarnessState s0;
+	Vector pmi;              // principal moments of inertia for attitude cases, or 0
+	double T;                // propagation interval [s]
+	vector<double> steps;    // step lengths to test [s]
+	std::function<double(const HarnessState&)> energy; // conserved quantity, or empty
+};
+
+static double OrbitEnergy (const HarnessState &s, double mu, double R, double J2)
+{
+	// specific orbital energy in the field of an oblate body with its
+	// rotation axis along the global y axis
+	double r = s.pos.length(), sinphi = s.pos.y/r;
+	double u = -mu/r + mu*R*R*J2*(1.5*sinphi*sinphi-0.5)/(r*r*r);
+	return 0.5*dotp (s.vel, s.vel) + u;
+}
+
+static double RotEnergy (const HarnessState &s, const Vector &pmi)
+{
+	return 0.5*(pmi.x*s.omega.x*s.omega.x + pmi.y*s.omega.y*s.omega.y + pmi.z*s.omega.z*s.omega.z);
+}
+
+static void InitOrbit (BenchCase &bc, double mu, double a, double e, double i)
+{
+	bc.s0.t = 0.0;
+	KeplerState (mu, a, e, i, 0.3, 1.1, 0.0, 0.0, bc.s0.pos, bc.s0.vel);
+	bc.T = Pi2*sqrt (a*a*a/mu);
+}
+
+// LEO (400 km, 51.6 deg) with Earth J2
+static void MakeLEO (BenchCase &bc, PinesGravProp &j2)
+{
+	bc.name = "LEO + J2";
+	HarnessBody earth;
+	earth.Mass = M_EARTH, earth.Size = R_EARTH;
+	earth.rot_T = 86164.10132;
+	earth.pines = &j2;
+	earth.Setup (51544.5);
+	bc.sys.AddBody (earth);
+	double mu = G*M_EARTH;
+	InitOrbit (bc, mu, R_EARTH+4e5, 1e-3, Rad(51.6));
+	bc.steps = {2.0, 20.0, 200.0};
+	bc.energy = [=](const HarnessState &s) { return OrbitEnergy (s, mu, R_EARTH, J2_EARTH); };
+}
+
+// Low lunar polar orbit (100 km) with the degree 50 Pines field
+static void MakeLunar (BenchCase &bc, PinesGravProp &lp)
+{
+	bc.name = "LLO + Pines 50";
+	HarnessBody moon;
+	moon.Mass = M_MOON, moon.Size = R_MOON;
+	moon.rot_T = 2360588.15;
+	moon.pines = &lp;
+	moon.Setup (51544.5);
+	bc.sys.AddBody (moon);
+	InitOrbit (bc, G*M_MOON, R_MOON+1e5, 1e-3, Rad(90.0));
+	bc.steps = {2.0, 20.0, 200.0};
+}
+
+// Geostationary transfer orbit (perigee 200 km, e=0.73), point mass
+static void MakeGTO (BenchCase &bc)
+{
+	bc.name = "GTO";
+	HarnessBody earth;
+	earth.Mass = M_EARTH, earth.Size = R_EARTH;
+	earth.Setup (51544.5);
+	bc.sys.AddBody (earth);
+	double mu = G*M_EARTH, rp = R_EARTH+2e5, ra = 42164e3;
+	InitOrbit (bc, mu, 0.5*(rp+ra), (ra-rp)/(ra+rp), Rad(28.5));
+	bc.steps = {2.0, 20.0, 200.0};
+	bc.energy = [=](const HarnessState &s) { return OrbitEnergy (s, mu, R_EARTH, 0.0); };
+}
+
+// Torque-free body tumbling about its intermediate axis in LEO
+static void MakeTumbler (BenchCase &bc)
+{
+	bc.name = "Tumbling";
+	HarnessBody earth;
+	earth.Mass = M_EARTH, earth.Size = R_EARTH;
+	earth.Setup (51544.5);
+	bc.sys.AddBody (earth);
+	InitOrbit (bc, G*M_EARTH, R_EARTH+4e5, 1e-3, Rad(51.6));
+	bc.pmi = Vector (2.0, 5.0, 7.0);
+	bc.s0.omega = Vector (0.02, 1.0, 0.02);
+	bc.T = 60.0;
+	double w = bc.s0.omega.length();
+	for (double a : {0.2, 2.0, 5.0, 20.0}) // PropATgt defaults [deg]
+		bc.steps.push_back (Rad(a)/w);
+	Vector pmi = bc.pmi;
+	bc.energy = [=](const HarnessState &s) { return RotEnergy (s, pmi); };
+}
+
+// =======================================================================
+// Propagation and error measures
+
+struct BenchResult {
+	double stepsPerSec;  // propagator steps per second of wall time
+	long long nstep;     // propagator steps
+	long long neval;     // right hand side (acceleration) evaluations
+	double dE;           // relative error of the conserved quantity
+	double dpos;         // position error [m]
+	double datt;         // orientation error [rad]
+};
+
+static HarnessState Propagate (const BenchCase &bc, int method, double h, long long &neval, double tol = 0.0)
+{
+	// h: step length, or frame length for the adaptive methods
+	HarnessPropagator prop (bc.sys);
+	prop.SetInertia (bc.pmi);
+	HarnessState s = bc.s0;
+	prop.Init (s);
+	int nstep = (int)ceil (bc.T/h - 1e-9);
+	h = bc.T/nstep;
+	neval = 1;
+	double hadapt = 0.0;
+	for (int i = 0; i < nstep; i++)
+		if (PROP_ISADAPTIVE(method)) neval += prop.PropagateAdaptive (s, h, method, tol, hadapt);
+		else                         neval += prop.Step (s, h, method);
+	return s;
+}
+
+static BenchResult Run (const BenchCase &bc, const HarnessState &ref, int method, double h, double tol = 0.0)
+{
+	BenchResult res;
+	auto t0 = std::chrono::steady_clock::now();
+	HarnessState s = Propagate (bc, method, h, res.neval, tol);
+	double wall = std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+	res.nstep = (long long)ceil (bc.T/h - 1e-9);
+	res.stepsPerSec = res.nstep / std::max (wall, 1e-9);
+	res.dpos = (s.pos-ref.pos).length();
+	res.datt = (bc.pmi.x ? angle (s.Q, ref.Q) : 0.0); // limited by the first-order Quaternion::Rotate update
+	if (bc.energy) {
+		double E0 = bc.energy (bc.s0);
+		res.dE = fabs ((bc.energy (s)-E0)/E0);
+	} else res.dE = -1.0;
+	return res;
+}
+
+// -----------------------------------------------------------------------
+// Production propagation path: the dynamic branch of RigidBody::Update,
+// for a body whose GetIntermediateMoments returns the gravitational
+// acceleration of the case and no torque
+
+static const int FRAME_SUBSTEPS = 10;
+
+// RigidBody::MomentModel
+struct FrameModel {
+	const HarnessSystem &sys;
+	Vector pmi;
+	double t0, T;      // frame start and length [s]
+	long long neval;
+
+	void Moments (const StateVectors &s, double t, double h, Vector &acc, Vector &arot)
+	{
+		double tfrac = t/T; // GetIntermediateMoments time argument
+		acc = sys.Gacc (s.pos, t0 + tfrac*T);
+		Vector tau;
+		arot = Vector ( // RigidBody::EulerInv_full
+			(tau.x - (pmi.y-pmi.z)*s.omega.y*s.omega.z) / pmi.x,
+			(tau.y - (pmi.z-pmi.x)*s.omega.z*s.omega.x) / pmi.y,
+			(tau.z - (pmi.x-pmi.y)*s.omega.x*s.omega.y) / pmi.z);
+		neval++;
+	}
+};
+
+static HarnessState PropagateFrames (const BenchCase &bc, int method, double h, long long &nstep, long long &neval, double tol = 0.0)
+{
+	// h: substep length target (PropTTgt, and PropATgt relative to the
+	// initial angular velocity)
+	int nframe = (int)ceil (bc.T/(FRAME_SUBSTEPS*h) - 1e-9);
+	double T = bc.T/nframe;
+	double w0 = bc.s0.omega.length();
+	double ttgt = h, atgt = (w0 ? w0*h : 1e10);
+	FrameModel m = {bc.sys, (bc.pmi.x ? bc.pmi : Vector (1,1,1)), bc.s0.t, T, 0};
+
+	LinAngState x;
+	x.pos0 = bc.s0.pos, x.vel0 = bc.s0.vel;
+	x.Q = bc.s0.Q, x.omega = bc.s0.omega;
+	StateVectors s0;
+	s0.Set (x.Vel(), x.Pos(), x.omega, x.Q);
+	m.Moments (s0, 0.0, 0.0, x.acc, x.arot);
+	double hAdapt = 0.0;
+	Vector r0 = (bc.sys.nBody() ? bc.sys.Body(0).pos : Vector());
+	nstep = 0;
+
+	for (int f = 0; f < nframe; f++) {
+		m.t0 = bc.s0.t + f*T;
+		if (PROP_ISADAPTIVE(method)) {
+			nstep += RKadapt_LinAng (m, x, method, 0.0, T, tol, (x.Pos()-r0).length(), x.Vel().length(), atgt, hAdapt);
+		} else {
+			// RigidBody::SetPropagator
+			int nsub = (int)ceil (std::max (T/ttgt, x.omega.length()*T/atgt));
+			double dt = T/nsub;
+			for (int i = 0; i < nsub; i++)
+				Step_LinAng (m, x, method, i*dt, dt);
+			nstep += nsub;
+		}
+		if (f % 1000 == 999) { // flush increments
+			x.pos0 += x.dpos, x.dpos = Vector();
+			x.vel0 += x.dvel, x.dvel = Vector();
+		}
+	}
+	neval = m.neval;
+
+	HarnessState s = bc.s0;
+	s.pos = x.Pos(), s.vel = x.Vel();
+	s.Q = x.Q, s.omega = x.omega;
+	s.t = bc.s0.t + bc.T;
+	return s;
+}
+
+static BenchResult RunFrames (const BenchCase &bc, const HarnessState &ref, int method, double h, double tol = 0.0)
+{
+	BenchResult res;
+	long long nstep;
+	auto t0 = std::chrono::steady_clock::now();
+	HarnessState s = PropagateFrames (bc, method, h, nstep, res.neval, tol);
+	double wall = std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+	res.stepsPerSec = nstep / std::max (wall, 1e-9);
+	res.nstep = nstep;
+	res.dpos = (s.pos-ref.pos).length();
+	res.datt = (bc.pmi.x ? angle (s.Q, ref.Q) : 0.0);
+	if (bc.energy) {
+		double E0 = bc.energy (bc.s0);
+		res.dE = fabs ((bc.energy (s)-E0)/E0);
+	} else res.dE = -1.0;
+	return res;
+}
+
+static HarnessState Reference (const BenchCase &bc)
+{
+	// RK8 at an eighth of the smallest tested step
+	long long neval;
+	return Propagate (bc, PROP_RK8, bc.steps[0]/8.0, neval);
+}
+
+// =======================================================================
+
+TEST_CASE("Propagator convergence", "[Integrators]")
+{
+	BenchCase bc;
+	MakeGTO (bc);
+	bc.steps = {200.0, 100.0};
+
+	// analytic solution after one period is the initial state
+	for (int method : {PROP_RK4, PROP_RK6, PROP_RK8, PROP_SY4}) {
+		BenchResult r1 = Run (bc, bc.s0, method, bc.steps[0]);
+		BenchResult r2 = Run (bc, bc.s0, method, bc.steps[1]);
+		INFO(METHOD_NAME[method] << ": " << r1.dpos << " m -> " << r2.dpos << " m");
+		REQUIRE(r2.dpos < r1.dpos * 0.2); // at least 4th order convergence (minus perigee transients)
+	}
+	BenchResult r = Run (bc, bc.s0, PROP_RK8, 10.0);
+	REQUIRE(r.dpos < 1.0);
+	REQUIRE(r.dE < 1e-10);
+
+	// symplectic schemes keep the energy error bounded over many orbits
+	bc.T *= 10.0;
+	BenchResult sy = Run (bc, bc.s0, PROP_SY4, 60.0);
+	REQUIRE(sy.dE < 1e-5);
+}
+
+TEST_CASE("Adaptive propagators", "[Integrators]")
+{
+	// GTO at high time acceleration (600 s frames): error control must beat
+	// the fixed substep scheme (RK8, 10 substeps per frame) in cost at
+	// comparable accuracy
+	BenchCase bc;
+	MakeGTO (bc);
+	long long nfixed;
+	Propagate (bc, PROP_RK8, 60.0, nfixed);
+	for (int method : {PROP_DP5, PROP_RKF78}) {
+		BenchResult r = Run (bc, bc.s0, method, 600.0, 1e-12);
+		INFO(METHOD_NAME[method] << ": " << r.neval << " evaluations, " << r.dpos << " m");
+		REQUIRE(r.dpos < 1e-2);
+		REQUIRE(r.dE < 1e-11);
+		REQUIRE(r.neval < nfixed/2);
+	}
+
+	// tolerance steers accuracy
+	BenchResult r1 = Run (bc, bc.s0, PROP_RKF78, 600.0, 1e-8);
+	BenchResult r2 = Run (bc, bc.s0, PROP_RKF78, 600.0, 1e-12);
+	REQUIRE(r2.dpos < r1.dpos * 0.01);
+	REQUIRE(r2.neval > r1.neval);
+
+	// attitude is integrated with error control as well
+	BenchCase tb;
+	MakeTumbler (tb);
+	BenchResult rt = Run (tb, tb.s0, PROP_DP5, 1.0, 1e-10);
+	REQUIRE(rt.dE < 1e-8);
+}
+
+// uniform field, for which all schemes are exact
+struct ConstantAcc {
+	Vector g;
+	void Moments (const StateVectors &s, double t, double h, Vector &acc, Vector &arot)
+	{
+		acc = g;
+		arot = Vector();
+	}
+};
+
+TEST_CASE("Adaptive propagator interval end", "[Integrators]")
+{
+	// a remainder of the interval shorter than the minimum substep must be
+	// covered exactly, not with a full minimum substep
+	ConstantAcc m = {Vector (0.0, -9.81, 0.0)};
+	Vector p0 (1.0, 2.0, 3.0), v0 (100.0, 50.0, -20.0);
+	double T = 10.0;
+	for (int method : {PROP_DP5, PROP_RKF78}) {
+		LinAngState x;
+		x.pos0 = p0, x.vel0 = v0, x.acc = m.g;
+		double h = T*(1.0 - 0.4/RKADAPT_MAXSTEP);
+		int nstep = RKadapt_LinAng (m, x, method, 0.0, T, 1e-12, p0.length(), v0.length(), 0.0, h);
+		INFO(METHOD_NAME[method]);
+		REQUIRE(nstep == 2);
+		REQUIRE((x.Pos() - (p0 + v0*T + m.g*(0.5*T*T))).length() < 1e-9);
+		REQUIRE((x.Vel() - (v0 + m.g*T)).length() < 1e-12);
+	}
+}
+
+TEST_CASE("Propagator conserved quantities", "[Integrators]")
+{
+	// J2 energy is conserved for an axisymmetric body; this also checks the
+	// frame conversions of the harmonics perturbation
+	WriteJ2Model ();
+	PinesGravProp j2 (nullptr);
+	int nloaded, nmodel;
+	REQUIRE(j2.readGravModel ((char*)J2_MODEL, 2, nloaded, nmodel) == 0);
+	remove (J2_MODEL);
+
+	BenchCase leo;
+	MakeLEO (leo, j2);
+	BenchResult r = Run (leo, leo.s0, PROP_RK8, 20.0);
+	REQUIRE(r.dE < 1e-11);
+
+	// torque-free rotation: kinetic energy and global angular momentum
+	BenchCase tb;
+	MakeTumbler (tb);
+	for (int method : {PROP_RK4, PROP_RK8}) {
+		long long neval;
+		HarnessState s = Propagate (tb, method, tb.steps[0], neval);
+		Vector L0 = mul (tb.s0.Q, Vector (tb.pmi.x*tb.s0.omega.x, tb.pmi.y*tb.s0.omega.y, tb.pmi.z*tb.s0.omega.z));
+		Vector L1 = mul (s.Q, Vector (tb.pmi.x*s.omega.x, tb.pmi.y*s.omega.y, tb.pmi.z*s.omega.z));
+		INFO(METHOD_NAME[method]);
+		REQUIRE(fabs (RotEnergy (s, tb.pmi) / RotEnergy (tb.s0, tb.pmi) - 1.0) < 1e-8);
+		REQUIRE((L1-L0).length() < 1e-4 * L0.length());
+	}
+}
+
+TEST_CASE("Secular drift", "[Integrators]")
+{
+	// The averaged J2 rates used for fast-forward propagation must reproduce
+	// the nodal regression and apsidal advance of a numerically integrated
+	// orbit. Only orientations are compared: the along-track position
+	// depends on the difference between osculating and mean elements.
+	WriteJ2Model ();
+	PinesGravProp j2 (nullptr);
+	int nloaded, nmodel;
+	REQUIRE(j2.readGravModel ((char*)J2_MODEL, 2, nloaded, nmodel) == 0);
+	remove (J2_MODEL);
+
+	BenchCase bc;
+	MakeLEO (bc, j2);
+	double mu = G*M_EARTH;
+	KeplerState (mu, R_EARTH+1e6, 0.1, Rad(51.6), 0.3, 1.1, 0.0, 0.0, bc.s0.pos, bc.s0.vel);
+	bc.T = 5.0*86400.0;
+	long long neval;
+	HarnessState s = Propagate (bc, PROP_RK8, 20.0, neval);
+
+	SecularDrift drift;
+	drift.AddOblateness (mu, bc.s0.pos, bc.s0.vel, J2_EARTH, R_EARTH, Vector (0,1,0));
+	Vector pos = bc.s0.pos, vel = bc.s0.vel;
+	drift.Apply (bc.T, pos, vel);
+
+	auto nml = [](const Vector &p, const Vector &v) { return crossp (v, p).unit(); };
+	auto ecc = [=](const Vector &p, const Vector &v) {
+		double r = p.length(), a = 1.0 / (2.0/r - dotp (v, v)/mu);
+		return (p * (1.0/r - 1.0/a) - v * (dotp (p, v)/mu)).unit();
+	};
+	auto ang = [](const Vector &a, const Vector &b) { return acos (std::min (1.0, dotp (a, b))); };
+
+	double dnml = ang (nml (bc.s0.pos, bc.s0.vel), nml (s.pos, s.vel));
+	double decc = ang (ecc (bc.s0.pos, bc.s0.vel), ecc (s.pos, s.vel));
+	INFO("plane: " << Deg(dnml) << " deg, apse line: " << Deg(decc) << " deg");
+	REQUIRE(dnml > Rad(1.0)); // make sure there is something to compare
+	REQUIRE(decc > Rad(1.0));
+	REQUIRE(ang (nml (pos, vel), nml (s.pos, s.vel)) < 0.02*dnml);
+	REQUIRE(ang (ecc (pos, vel), ecc (s.pos, s.vel)) < 0.05*decc);
+}
+
+TEST_CASE("Propagator benchmark", "[.benchmark]")
+{
+	WriteJ2Model ();
+	PinesGravProp j2 (nullptr), lp (nullptr);
+	int nloaded, nmodel;
+	REQUIRE(j2.readGravModel ((char*)J2_MODEL, 2, nloaded, nmodel) == 0);
+	remove (J2_MODEL);
+	char lpname[] = "GravityModels\\jgl165p1.sha";
+	REQUIRE(lp.readGravModel (lpname, 50, nloaded, nmodel) == 0);
+
+	vector<BenchCase> cases(4);
+	MakeLEO (cases[0], j2);
+	MakeLunar (cases[1], lp);
+	MakeGTO (cases[2]);
+	MakeTumbler (cases[3]);
+
+	printf ("\n%-16s %-11s %10s %12s %10s %10s %12s %10s\n",
+		"Case", "Prop", "Step [s]", "Steps/s", "RHS evals", "RHS/step", "|dE/E|", "Error");
+	for (const BenchCase &bc : cases) {
+		HarnessState ref = Reference (bc);
+		for (double h : bc.steps) {
+			for (int k = 0; k < PROP_DP5+4; k++) {
+				// fixed-step methods, then the adaptive ones at two tolerances
+				int method = (k < PROP_DP5 ? k : PROP_DP5 + (k-PROP_DP5)/2);
+				double tol = (PROP_ISADAPTIVE(method) ? ((k-PROP_DP5)%2 ? 1e-12 : 1e-9) : 0.0);
+				char name[32];
+				if (tol) sprintf (name, "%s/%g", METHOD_NAME[method], tol);
+				else     sprintf (name, "%s", METHOD_NAME[method]);
+				BenchResult r = RunFrames (bc, ref, method, h, tol);
+				char dE[32] = "-", err[32] = "diverged";
+				if (std::isfinite (r.dpos) && std::isfinite (r.datt) && std::isfinite (r.dE)) {
+					if (r.dE >= 0.0) sprintf (dE, "%.3e", r.dE);
+					if (bc.pmi.x) sprintf (err, "%.2e rad", r.datt);
+					else          sprintf (err, "%.2e m", r.dpos);
+				}
+				printf ("%-16s %-11s %10.4g %12.4g %10lld %10.1f %12s %s\n", bc.name, name, h,
+					r.stepsPerSec, r.neval, (double)r.neval / r.nstep, dE, err);
+			}
+		}
+		printf ("\n");
+	}
+}
@@ -0,0 +1,203 @@
+#include "Vecmat.h"
+#include "PhysicsCore.h"
+#include "PropHarness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+using std::vector;
+
+// Positions of the celestial bodies at fractional steps n of a time step,
+// as required by the intermediate stages of the propagators. Compares the
+// cubic Hermite interpolant (StepInterpolant) with the iterative bisection
+// previously used by CelestialBody::InterpolatePosition, against the exact
+// Kepler orbits (KeplerState of the propagation harness, PropHarness.h).
+// The "[.benchmark]" test case prints the cost of both; run it explicitly
+// with
+//    Physics.Interpolation [benchmark]
+
+static const double G = 6.67259e-11;
+static const double AU = 1.49597870691e11;
+
+// A body on a Kepler orbit around its reference body (the sun at the origin
+// for ref < 0)
+struct Orbit {
+	const char *name;
+	int ref;
+	double mu;                          // G(M+m) of the pair [m^3/s^2]
+	double a, e, i, theta, omegab, L;   // elements as for KeplerState
+};
+
+static const Orbit orbit[] = {
+	{"Earth",  -1, G*1.989e30, 1.0000*AU, 0.0167, 0.0,    0.0,  1.80,  1.75},
+	{"Moon",    0, G*6.05e24,  3.844e8,   0.0549, 0.0898, 2.1,  0.6,   4.0 },
+	{"Mars",   -1, G*1.989e30, 1.5237*AU, 0.0934, 0.0323, 0.86, 5.87,  0.62},
+	{"Phobos",  2, G*6.417e23, 9.376e6,   0.0151, 0.0188, 0.3,  2.5,   1.2 }
+};
+static const int NORBIT = sizeof(orbit)/sizeof(Orbit);
+
+// Global states of all bodies at time t
+static void GlobalState (double t, Vector *pos, Vector *vel)
+{
+	for (int k = 0; k < NORBIT; k++) {
+		const Orbit &o = orbit[k];
+		KeplerState (o.mu, o.a, o.e, o.i, o.theta, o.omegab, o.L, t, pos[k], vel[k]);
+		if (o.ref >= 0) pos[k] += pos[o.ref], vel[k] += vel[o.ref];
+	}
+}
+
+// The previous interpolation: bisection of the arc relative to the reference
+// body, then linear interpolation of direction and radius
+static Vector Bisection (int k, const Vector *p0, const Vector *p1, double n)
+{
+	if      (n == 0)   return p0[k];
+	else if (n == 1.0) return p1[k];
+
+	Vector refp0, refp1, refpm;
+	int ref = orbit[k].ref;
+	if (ref >= 0) {
+		refp0 = p0[ref];
+		refp1 = p1[ref];
+		refpm = Bisection (ref, p0, p1, n);
+	}
+
+	const double eps = 1e-2;
+	Vector rp0 (p0[k]-refp0);
+	Vector rp1 (p1[k]-refp1);
+	double rd0 = rp0.length();
+	double rd1 = rp1.length();
+	double n0 = 0.0;
+	double n1 = 1.0;
+	double nm = 0.5, d = 0.5;
+	double rdm = (rd0+rd1)*0.5;
+	Vector rpm = (rp0+rp1).unit()*rdm;
+	while (fabs (nm-n) > eps && d > eps) {
+		d *= 0.5;
+		if (nm < n) {
+			rp0 = rpm;
+			rd0 = rdm;
+			n0  = nm;
+			nm += d;
+		} else {
+			rp1 = rpm;
+			rd1 = rdm;
+			n1  = nm;
+			nm -= d;
+		}
+		rdm = (rd0+rd1)*0.5;
+		rpm = (rp0+rp1).unit()*rdm;
+	}
+	if (fabs (nm-n) > 1e-10) {
+		double scale = (n-n0)/(n1-n0);
+		rdm = rd0 + (rd1-rd0)*scale;
+		rpm = (rp0 + (rp1-rp0)*scale).unit() * rdm;
+	}
+	return rpm + refpm;
+}
+
+// Stage fractions of the RK4, RK8 and SY4 propagators, plus a uniform grid
+static vector<double> StageFractions ()
+{
+	vector<double> f = {0.5, 1.0/3.0, 2.0/3.0, 0.1, 0.9, 0.3, 0.7, 0.6756035959798289, 0.1756035959798289, 0.8243964040201711};
+	for (int j = 1; j < 20; j++) f.push_back (j/20.0);
+	return f;
+}
+
+// Maximum position error [m] of the Hermite interpolant (eh) and of the
+// bisection (eb) of body k over one step of length dt starting at t0
+static void StepError (int k, double t0, double dt, double &eh, double &eb)
+{
+	Vector p0[NORBIT], v0[NORBIT], p1[NORBIT], v1[NORBIT], p[NORBIT], v[NORBIT];
+	GlobalState (t0, p0, v0);
+	GlobalState (t0+dt, p1, v1);
+	StepInterpolant ip;
+	ip.Setup (p0[k], v0[k], p1[k], v1[k], dt);
+	eh = eb = 0.0;
+	for (double n : StageFractions()) {
+		GlobalState (t0+n*dt, p, v);
+		eh = std::max (eh, (ip.Pos (n) - p[k]).length());
+		eb = std::max (eb, (Bisection (k, p0, p1, n) - p[k]).length());
+	}
+}
+
+// =======================================================================
+
+TEST_CASE("Interpolant reproduces the step end states", "[Interpolation]")
+{
+	Vector p0[NORBIT], v0[NORBIT], p1[NORBIT], v1[NORBIT];
+	const double dt = 600.0;
+	GlobalState (0.0, p0, v0);
+	GlobalState (dt, p1, v1);
+	for (int k = 0; k < NORBIT; k++) {
+		INFO(orbit[k].name);
+		StepInterpolant ip;
+		ip.Setup (p0[k], v0[k], p1[k], v1[k], dt);
+		CHECK((ip.Pos (0.0) - p0[k]).length() <= 1e-15*p0[k].length());
+		CHECK((ip.Pos (1.0) - p1[k]).length() <= 1e-15*p1[k].length());
+		CHECK((ip.Vel (0.0) - v0[k]).length() <= 1e-9*v0[k].length());
+		CHECK((ip.Vel (1.0) - v1[k]).length() <= 1e-9*v1[k].length());
+	}
+}
+
+TEST_CASE("Hermite interpolation is more accurate than bisection", "[Interpolation]")
+{
+	for (double dt : {1.0, 20.0, 300.0, 3600.0}) {
+		for (int k = 0; k < NORBIT; k++) {
+			INFO(orbit[k].name << ", dt=" << dt);
+			double eh, eb;
+			StepError (k, 1e5, dt, eh, eb);
+			// rounding error of the global positions (including the Kepler
+			// solutions of the reference)
+			double eps = 1e-14*(orbit[k].ref < 0 ? orbit[k].a : orbit[orbit[k].ref].a);
+			CHECK(eh <= std::max (eb, eps));
+			// 4th order error bound of the cubic Hermite interpolant of an
+			// orbit with radius a and maximum angular rate w
+			const Orbit &o = orbit[k];
+			double w = sqrt (o.mu/(o.a*o.a*o.a))*pow (1.0+o.e, 2)/pow (1.0-o.e*o.e, 1.5);
+			double bound = o.a*pow (w*dt, 4)/384.0;
+			CHECK(eh <= 2.0*bound + eps);
+		}
+	}
+}
+
+TEST_CASE("Position interpolation benchmark", "[.benchmark]")
+{
+	static volatile double sink;
+	Vector p0[NORBIT], v0[NORBIT], p1[NORBIT], v1[NORBIT];
+	vector<double> frac = StageFractions();
+
+	printf ("\nPosition interpolation\n%-8s %9s %14s %14s %14s %14s\n",
+		"Body", "dt [s]", "Bisection [m]", "Hermite [m]", "Bisect. [1/s]", "Hermite [1/s]");
+	for (int k = 0; k < NORBIT; k++) {
+		for (double dt : {20.0, 600.0, 3600.0}) {
+			double eh, eb, rate[2], chk = 0.0;
+			StepError (k, 1e5, dt, eh, eb);
+			GlobalState (1e5, p0, v0);
+			GlobalState (1e5+dt, p1, v1);
+			StepInterpolant ip;
+			ip.Setup (p0[k], v0[k], p1[k], v1[k], dt);
+			for (int v = 0; v < 2; v++) {
+				int n = 0;
+				auto t0 = std::chrono::steady_clock::now();
+				double wall;
+				do {
+					for (double f : frac) {
+						chk += (v ? ip.Pos (f) : Bisection (k, p0, p1, f)).x;
+						n++;
+					}
+					wall = std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+				} while (wall < 0.1);
+				rate[v] = n/wall;
+			}
+			sink = chk; // keeps the evaluations from being optimised away
+			printf ("%-8s %9.0f %14.4g %14.4g %14.4g %14.4g\n", orbit[k].name, dt, eb, eh, rate[0], rate[1]);
+		}
+	}
+	printf ("\n");
+}
@@ -0,0 +1,140 @@
+#include "Vecmat.h"
+#include "PinesGrav.h"
+#include "WorkerPool.h"
+#include "LinAngIntegrators.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+using std::string;
+using std::vector;
+
+// Concurrent propagation of a vessel fleet on a WorkerPool, with the
+// propagation schemes RigidBody uses (LinAngIntegrators.h) and a Pines field
+// shared by all threads. The simulation entry points (Vessel::CanPropagateConcurrently,
+// PropagateVesselsConcurrent) are covered by the Scenario.Propagation.Serial/
+// Concurrent tests, which compare the final vessel states of a serial and a
+// concurrent run of the same scenario.
+// The "[.benchmark]" test case measures the scaling with fleet size and
+// thread count; run it with
+//    Physics.ParallelUpdate [benchmark]
+
+static const double GM_MOON = 4902.801056; // [km^3/s^2]
+static const int FRAME_SUBSTEPS = 4;
+
+// Point mass + Pines perturbation, torque-free rotation
+struct LunarModel {
+	const PinesGravProp &pines;
+
+	void Moments (const StateVectors &s, double t, double h, Vector &acc, Vector &arot)
+	{
+		double r = s.pos.length();
+		acc = s.pos * (-GM_MOON / (r*r*r)) + pines.GetPinesGrav (s.pos, 20, 20);
+		arot = Vector();
+	}
+};
+
+static void InitState (LunarModel &m, LinAngState &x, const Vector &pos, const Vector &vel)
+{
+	x.pos0 = pos, x.vel0 = vel;
+	x.dpos = x.dvel = Vector();
+	x.Q = Quaternion();
+	x.omega = Vector (0, 0, 0.01);
+	StateVectors s;
+	s.Set (x.Vel(), x.Pos(), x.omega, x.Q);
+	m.Moments (s, 0.0, 0.0, x.acc, x.arot);
+}
+
+// One frame of length dt, as in RigidBody::Update
+static void PropagateVessel (LunarModel &m, LinAngState &x, double dt)
+{
+	double h = dt / FRAME_SUBSTEPS;
+	for (int i = 0; i < FRAME_SUBSTEPS; i++)
+		Step_LinAng (m, x, PROP_RK4, i*h, h);
+}
+
+static vector<LinAngState> MakeFleet (LunarModel &m, int n)
+{
+	vector<LinAngState> fleet(n);
+	for (int i = 0; i < n; i++) {
+		double r = 1738.0 + 50.0 + 2.0*i;
+		double inc = 0.01*i, lng = 0.1*i;
+		double v = sqrt (GM_MOON / r);
+		InitState (m, fleet[i], Vector (r*cos(lng), r*sin(lng), 0.0),
+			Vector (-v*sin(lng)*cos(inc), v*cos(lng)*cos(inc), v*sin(inc)));
+	}
+	return fleet;
+}
+
+static void LoadModel (PinesGravProp &pines)
+{
+	int nloaded, nmodel;
+	char fname[] = "GravityModels\\jgl165p1.sha";
+	REQUIRE(pines.readGravModel (fname, 20, nloaded, nmodel) == 0);
+}
+
+TEST_CASE("WorkerPool visits every index once", "[WorkerPool]")
+{
+	for (int nthread : { 0, 1, 3, 8 }) {
+		WorkerPool pool(nthread);
+		for (size_t n : { (size_t)1, (size_t)7, (size_t)1000 }) {
+			vector<int> count(n, 0);
+			pool.ParallelFor (n, [&](size_t i) { count[i]++; });
+			for (size_t i = 0; i < n; i++)
+				REQUIRE(count[i] == 1);
+		}
+	}
+}
+
+// Concurrent propagation must give bit-identical states to the serial loop
+TEST_CASE("Concurrent vessel propagation", "[WorkerPool]")
+{
+	PinesGravProp pines(nullptr);
+	LoadModel (pines);
+	LunarModel m = {pines};
+
+	vector<LinAngState> serial = MakeFleet (m, 64);
+	vector<LinAngState> parallel = serial;
+	WorkerPool pool(4);
+	for (int step = 0; step < 5; step++) {
+		for (auto &x : serial) PropagateVessel (m, x, 10.0);
+		pool.ParallelFor (parallel.size(), [&](size_t i) { PropagateVessel (m, parallel[i], 10.0); });
+	}
+	for (size_t i = 0; i < serial.size(); i++) {
+		Vector ps = serial[i].Pos(), pp = parallel[i].Pos();
+		Vector vs = serial[i].Vel(), vp = parallel[i].Vel();
+		REQUIRE(ps.x == pp.x);
+		REQUIRE(ps.y == pp.y);
+		REQUIRE(ps.z == pp.z);
+		REQUIRE(vs.x == vp.x);
+		REQUIRE(vs.y == vp.y);
+		REQUIRE(vs.z == vp.z);
+		REQUIRE(serial[i].Q.qvx == parallel[i].Q.qvx);
+		REQUIRE(serial[i].omega.z == parallel[i].omega.z);
+	}
+}
+
+// Scaling: one simulation step for a growing fleet and thread count
+TEST_CASE("Concurrent vessel propagation scaling", "[.benchmark]")
+{
+	PinesGravProp pines(nullptr);
+	LoadModel (pines);
+	LunarModel m = {pines};
+
+	unsigned int ncore = std::max (1u, std::thread::hardware_concurrency());
+	for (int nvessel : { 50, 200, 800 }) {
+		for (unsigned int nthread = 0; nthread < ncore; nthread = (nthread ? nthread*2 : 1)) {
+			WorkerPool bpool(nthread);
+			vector<LinAngState> fleet = MakeFleet (m, nvessel);
+			BENCHMARK(string("Step ") + std::to_string(nvessel) + " vessels, " + std::to_string(nthread+1) + " threads") {
+				bpool.ParallelFor (fleet.size(), [&](size_t i) { PropagateVessel (m, fleet[i], 10.0); });
+				return fleet[0].dpos.x;
+			};
+		}
+	}
+}
@@ -0,0 +1,131 @@
+#include "NameIndex.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+// Name lookup index of the planetary system (NameIndex): registration,
+// removal, clearing, and case-sensitive, case-insensitive and typed
+// lookups by name.
+
+// A named object with a type, like the bodies indexed by PlanetarySystem
+struct Obj {
+	Obj (const char *_name, int _type = 0): name(_name), type(_type) {}
+	const char *Name () const { return name.c_str(); }
+	std::string name;
+	int type;
+};
+
+static bool IsType1 (const Obj *obj) { return obj->type == 1; }
+
+// =======================================================================
+
+TEST_CASE("Objects are found by name", "[NameIndex]")
+{
+	NameIndex<Obj> index;
+	Obj earth ("Earth", 1), moon ("Moon", 1), iss ("ISS");
+	index.Add (&earth);
+	index.Add (&moon);
+	index.Add (&iss);
+	CHECK(index.size() == 3);
+
+	CHECK(index.Find ("Earth", false) == &earth);
+	CHECK(index.Find ("Moon", false) == &moon);
+	CHECK(index.Find ("ISS", false) == &iss);
+	CHECK(index.Find ("Mars", false) == 0);
+	CHECK(index.Find ("", false) == 0);
+
+	// case
+	CHECK(index.Find ("earth", false) == 0);
+	CHECK(index.Find ("earth", true) == &earth);
+	CHECK(index.Find ("iSs", true) == &iss);
+	CHECK(index.Find ("Eart", true) == 0);
+
+	// typed lookup
+	CHECK(index.Find ("Earth", false, IsType1) == &earth);
+	CHECK(index.Find ("ISS", false, IsType1) == 0);
+	CHECK(index.Find ("iss", true, IsType1) == 0);
+}
+
+TEST_CASE("Objects sharing a name are found in order of registration", "[NameIndex]")
+{
+	NameIndex<Obj> index;
+	Obj a ("Probe"), b ("PROBE", 1), c ("probe"), d ("Probe", 1);
+	for (Obj *obj : {&a, &b, &c, &d}) index.Add (obj);
+	CHECK(index.size() == 4);
+
+	CHECK(index.Find ("probe", true) == &a);           // first registered under the key
+	CHECK(index.Find ("Probe", false) == &a);          // first exact match
+	CHECK(index.Find ("PROBE", false) == &b);
+	CHECK(index.Find ("probe", false) == &c);
+	CHECK(index.Find ("pRobe", false) == 0);
+	CHECK(index.Find ("Probe", false, IsType1) == &d); // first exact match of the type
+	CHECK(index.Find ("probe", true, IsType1) == &b);
+
+	// removing the first one exposes the next
+	REQUIRE(index.Remove (&a));
+	CHECK(index.Find ("probe", true) == &b);
+	CHECK(index.Find ("Probe", false) == &d);
+	CHECK(index.size() == 3);
+}
+
+TEST_CASE("Removed objects are no longer found", "[NameIndex]")
+{
+	NameIndex<Obj> index;
+	Obj v1 ("GL-01"), v2 ("GL-02"), other ("GL-01");
+	index.Add (&v1);
+	index.Add (&v2);
+
+	REQUIRE(index.Remove (&v1));
+	CHECK(index.Find ("GL-01", false) == 0);
+	CHECK(index.Find ("gl-01", true) == 0);
+	CHECK(index.Find ("GL-02", false) == &v2);
+	CHECK(index.size() == 1);
+
+	// objects which are not registered (even under a registered name)
+	CHECK_FALSE(index.Remove (&v1));
+	CHECK_FALSE(index.Remove (&other));
+	CHECK(index.size() == 1);
+
+	// an object of the same name can be registered again
+	index.Add (&other);
+	CHECK(index.Find ("GL-01", false) == &other);
+	REQUIRE(index.Remove (&v2));
+	REQUIRE(index.Remove (&other));
+	CHECK(index.size() == 0);
+	CHECK(index.Find ("GL-02", true) == 0);
+}
+
+TEST_CASE("Clear removes all objects", "[NameIndex]")
+{
+	NameIndex<Obj> index;
+	std::vector<std::unique_ptr<Obj> > obj;
+	char name[32];
+	for (int i = 0; i < 1000; i++) {
+		sprintf (name, "Vessel-%d", i);
+		obj.emplace_back (new Obj (name, i & 1));
+		index.Add (obj.back().get());
+	}
+	CHECK(index.size() == 1000);
+	int nfound = 0;
+	for (int i = 0; i < 1000; i++) {
+		sprintf (name, "VESSEL-%d", i);
+		if (index.Find (name, true) == obj[i].get()) nfound++;
+	}
+	CHECK(nfound == 1000);
+
+	index.Clear();
+	CHECK(index.size() == 0);
+	CHECK(index.Find ("Vessel-0", false) == 0);
+	CHECK(index.Find ("vessel-999", true) == 0);
+	CHECK_FALSE(index.Remove (obj[5].get()));
+
+	// the index can be refilled
+	index.Add (obj[5].get());
+	CHECK(index.Find ("Vessel-5", false) == obj[5].get());
+	CHECK(index.Find ("Vessel-5", false, IsType1) == obj[5].get());
+}
@@ -0,0 +1,438 @@
+#include "ZTreeMgr.h"
+#include "zlib.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+// Tile archive (.tree) reader: node lookup, zero-copy access to the
+// compressed data (or file reads where the archive isn't mapped),
+// decompression into pooled and caller-provided buffers, concurrent reads,
+// the node data codecs, and the tile index. Most tests
+// write a small archive with the two level-4 roots and the level-5
+// children of the first one. The "[.benchmark]" test cases print the
+// decompression rate and tile load rate of each codec for elevation
+// tiles, and the tile index lookup time; run them explicitly with
+//    Tiles.ZTree [benchmark]
+
+static const char *ROOT = "ztree_test";
+
+// Tile payload identifying the tile; n bytes
+static std::vector<BYTE> Payload (int lvl, int ilat, int ilng, size_t n)
+{
+	std::vector<BYTE> data(n);
+	for (size_t i = 0; i < n; i++)
+		data[i] = (BYTE)(lvl*31 + ilat*7 + ilng*3 + i);
+	return data;
+}
+
+struct Tile {
+	int lvl, ilat, ilng;
+	std::vector<BYTE> data; // empty for a node without data
+};
+
+// Write an archive for the given layer in the format texpack produces
+static void WriteArchive (const char *layer, const std::vector<Tile> &tile, int codec)
+{
+	const DWORD NONE = (DWORD)-1;
+	const DWORD ntile = (DWORD)tile.size();
+	std::map<std::tuple<int,int,int>, DWORD> index;
+	for (DWORD i = 0; i < ntile; i++)
+		index[std::make_tuple (tile[i].lvl, tile[i].ilat, tile[i].ilng)] = i;
+	auto Find = [&](int lvl, int ilat, int ilng) {
+		auto it = index.find (std::make_tuple (lvl, ilat, ilng));
+		return (it != index.end() ? it->second : NONE);
+	};
+
+	std::vector<TreeNode> toc(ntile);
+	std::vector<BYTE> zdata;
+	for (DWORD i = 0; i < ntile; i++) {
+		const Tile &t = tile[i];
+		toc[i].pos = (__int64)zdata.size();
+		toc[i].size = (DWORD)t.data.size();
+		if (t.data.size()) {
+			std::vector<BYTE> zbuf(TreeCodecBound (codec, (uint32_t)t.data.size()));
+			uint32_t zsize = TreeDeflate (codec, t.data.data(), (uint32_t)t.data.size(), zbuf.data(), (uint32_t)zbuf.size());
+			REQUIRE(zsize);
+			zdata.insert (zdata.end(), zbuf.begin(), zbuf.begin()+zsize);
+		}
+		if (t.lvl >= 4)
+			for (int c = 0; c < 4; c++)
+				toc[i].child[c] = Find (t.lvl+1, t.ilat*2 + c/2, t.ilng*2 + c%2);
+	}
+
+	// header layout as TreeFileHeader
+	struct {
+		BYTE magic[4];
+		DWORD size, flags, dataOfs;
+		__int64 dataLength;
+		DWORD nodeCount, rootPos1, rootPos2, rootPos3, rootPos4[2];
+	} hdr = {{'T','X',TREEFILE_VERSION_ZLIB,0}, sizeof(hdr), TREEFILE_DEFLATE, (DWORD)(sizeof(hdr) + ntile*sizeof(TreeNode)),
+		(__int64)zdata.size(), ntile, Find (1,0,0), Find (2,0,0), Find (3,0,0), {Find (4,0,0), Find (4,0,1)}};
+	if (codec != TREECODEC_ZLIB) {
+		hdr.magic[2] = TREEFILE_VERSION_CODEC;
+		hdr.flags |= (DWORD)codec << TREEFILE_CODEC_SHIFT;
+	}
+
+	std::string dir = std::string(ROOT) + "\\Archive";
+	std::filesystem::create_directories (dir);
+	FILE *f = fopen ((dir + "\\" + layer + ".tree").c_str(), "wb");
+	REQUIRE(f);
+	fwrite (&hdr, sizeof(hdr), 1, f);
+	fwrite (toc.data(), sizeof(TreeNode), ntile, f);
+	fwrite (zdata.data(), 1, zdata.size(), f);
+	fclose (f);
+}
+
+// Write the test archive for the given layer. Level-5 tile (1,1) has no
+// data of its own.
+static void WriteArchive (const char *layer, int codec = TREECODEC_ZLIB)
+{
+	const int idx[6][4] = {{4,0,0,1000}, {4,0,1,200}, {5,0,0,3000}, {5,0,1,4000}, {5,1,0,5000}, {5,1,1,0}};
+	std::vector<Tile> tile;
+	for (int i = 0; i < 6; i++)
+		tile.push_back ({idx[i][0], idx[i][1], idx[i][2], Payload (idx[i][0], idx[i][1], idx[i][2], idx[i][3])});
+	WriteArchive (layer, tile, codec);
+}
+
+// A sparse tree of the given depth: a pseudo-random selection of tiles at
+// each level with data (of n bytes), and their ancestors without data
+// where they weren't selected themselves
+static std::vector<Tile> SparseTree (int maxlvl, int nsel, size_t n)
+{
+	std::map<std::tuple<int,int,int>, bool> node;
+	unsigned int seed = 1;
+	for (int lvl = 5; lvl <= maxlvl; lvl++)
+		for (int k = 0; k < nsel; k++) {
+			seed = seed*1103515245 + 12345;
+			int ilat = (int)((seed >> 8) % (1u << (lvl-4)));
+			seed = seed*1103515245 + 12345;
+			int ilng = (int)((seed >> 8) % (2u << (lvl-4)));
+			node[std::make_tuple (lvl, ilat, ilng)] = true;
+			for (int l = lvl-1; l >= 4; l--) {
+				ilat /= 2, ilng /= 2;
+				node.emplace (std::make_tuple (l, ilat, ilng), false);
+			}
+		}
+	std::vector<Tile> tile;
+	for (auto &nd : node) {
+		int lvl = std::get<0>(nd.first), ilat = std::get<1>(nd.first), ilng = std::get<2>(nd.first);
+		tile.push_back ({lvl, ilat, ilng, nd.second ? Payload (lvl, ilat, ilng, n) : std::vector<BYTE>()});
+	}
+	return tile;
+}
+
+// Tile lookup by walking the TOC from the level-4 roots
+static DWORD WalkIdx (const ZTreeMgr *mgr, int lvl, int ilat, int ilng)
+{
+	if (lvl == 4) return mgr->Idx (4, 0, ilng);
+	DWORD pidx = WalkIdx (mgr, lvl-1, ilat/2, ilng/2);
+	if (pidx == (DWORD)-1) return pidx;
+	return mgr->TOC()[pidx].child[((ilat&1) << 1) + (ilng&1)];
+}
+
+// =======================================================================
+
+TEST_CASE("Tiles are located in the tree", "[ZTree]")
+{
+	WriteArchive ("Elev");
+	ZTreeMgr *mgr = ZTreeMgr::CreateFromFile (ROOT, ZTreeMgr::LAYER_ELEV);
+	REQUIRE(mgr);
+	CHECK(mgr->TOC().size() == 6);
+	CHECK(mgr->Idx (4, 0, 0) == 0);
+	CHECK(mgr->Idx (4, 0, 1) == 1);
+	CHECK(mgr->Idx (5, 1, 0) == 4);
+	CHECK(mgr->Idx (5, 0, 2) == (DWORD)-1);
+	CHECK(mgr->Idx (6, 2, 2) == (DWORD)-1);
+	CHECK(mgr->Idx (3, 0, 0) == (DWORD)-1);
+	delete mgr;
+
+	// missing or damaged archives are rejected
+	CHECK_FALSE(ZTreeMgr::CreateFromFile (ROOT, ZTreeMgr::LAYER_CLOUD));
+	std::filesystem::resize_file (std::string(ROOT) + "\\Archive\\Elev.tree", 500);
+	CHECK_FALSE(ZTreeMgr::CreateFromFile (ROOT, ZTreeMgr::LAYER_ELEV));
+	CHECK_FALSE(ZTreeMgr::CreateFromFile (ROOT, ZTreeMgr::LAYER_ELEV, false));
+}
+
+TEST_CASE("Node data are read without copies or with pooled buffers", "[ZTree]")
+{
+	WriteArchive ("Elev");
+	std::vector<BYTE> ref = Payload (5, 0, 1, 4000);
+
+	// mapped archive, and file reads as used by 32-bit builds
+	for (bool map : { true, false }) {
+		ZTreeMgr *mgr = ZTreeMgr::CreateFromFile (ROOT, ZTreeMgr::LAYER_ELEV, map);
+		REQUIRE(mgr);
+		CHECK(mgr->IsMapped() == map);
+
+		// compressed data straight from the mapping, or read into the scratch buffer
+		const BYTE *zdata;
+		std::vector<BYTE> zbuf;
+		DWORD idx = mgr->Idx (5, 0, 1);
+		DWORD zsize = mgr->NodeData (idx, &zdata, zbuf);
+		REQUIRE(zsize == mgr->NodeSizeDeflated (idx));
+		CHECK((zdata == zbuf.data()) == !map);
+		std::vector<BYTE> buf(4000);
+		uLongf n = (uLongf)buf.size();
+		REQUIRE(uncompress (buf.data(), &n, zdata, zsize) == Z_OK);
+		CHECK(buf == ref);
+		CHECK(mgr->NodeData (mgr->Idx (5, 1, 1), &zdata, zbuf) == 0); // node without data
+
+		// caller-provided buffer
+		std::fill (buf.begin(), buf.end(), 0);
+		CHECK(mgr->ReadData (idx, buf.data(), 3999) == 0);
+		CHECK(mgr->ReadData (idx, buf.data(), 4000) == 4000);
+		CHECK(buf == ref);
+
+		// pooled buffers are zero-terminated and reused
+		BYTE *data;
+		REQUIRE(mgr->ReadData (5, 0, 1, &data) == 4000);
+		CHECK(std::equal (ref.begin(), ref.end(), data));
+		CHECK(data[4000] == 0);
+		mgr->ReleaseData (data);
+		BYTE *data2;
+		REQUIRE(mgr->ReadData (5, 0, 0, &data2) == 3000);
+		CHECK(data2 == data);
+		CHECK(data2[3000] == 0);
+		mgr->ReleaseData (data2);
+		CHECK(mgr->ReadData (5, 1, 1, &data) == 0);
+		CHECK(mgr->ReadData (5, -1, 0, &data) == 0);
+		delete mgr;
+	}
+}
+
+TEST_CASE("Concurrent reads return consistent data", "[ZTree]")
+{
+	WriteArchive ("Surf");
+	for (bool map : { true, false }) {
+		ZTreeMgr *mgr = ZTreeMgr::CreateFromFile (ROOT, ZTreeMgr::LAYER_SURF, map);
+		REQUIRE(mgr);
+		const int nthread = 8, nread = 2000;
+		std::vector<int> nfail(nthread, 0);
+		std::vector<std::thread> thread;
+		for (int k = 0; k < nthread; k++) {
+			thread.emplace_back ([&, k]() {
+				for (int i = 0; i < nread; i++) {
+					int ilat = (i+k)/2 & 1, ilng = (i+k) & 1;
+					if (ilat && ilng) continue;
+					std::vector<BYTE> ref = Payload (5, ilat, ilng, 3000 + 1000*(2*ilat+ilng));
+					BYTE *data = 0;
+					DWORD n = mgr->ReadData (5, ilat, ilng, &data);
+					if (n != ref.size() || !std::equal (ref.begin(), ref.end(), data)) nfail[k]++;
+					mgr->ReleaseData (data);
+				}
+			});
+		}
+		for (auto &th : thread) th.join();
+		for (int k = 0; k < nthread; k++)
+			CHECK(nfail[k] == 0);
+		delete mgr;
+	}
+}
+
+TEST_CASE("Archives are read with each codec", "[ZTree]")
+{
+	for (int codec = 0; codec < TREECODEC_COUNT; codec++) {
+		INFO("codec " << TreeCodecName (codec));
+		WriteArchive ("Mask", codec);
+		ZTreeMgr *mgr = ZTreeMgr::CreateFromFile (ROOT, ZTreeMgr::LAYER_MASK);
+		REQUIRE(mgr);
+		CHECK(mgr->Codec() == codec);
+		const int size[4] = {3000, 4000, 5000, 0};
+		for (int i = 0; i < 4; i++) {
+			BYTE *data = 0;
+			DWORD n = mgr->ReadData (5, i/2, i%2, &data);
+			REQUIRE(n == (DWORD)size[i]);
+			std::vector<BYTE> ref = Payload (5, i/2, i%2, size[i]);
+			CHECK(std::equal (ref.begin(), ref.end(), data));
+			mgr->ReleaseData (data);
+		}
+		delete mgr;
+	}
+
+	// unknown codecs and format versions are rejected
+	std::string fname = std::string(ROOT) + "\\Archive\\Mask.tree";
+	for (int k = 0; k < 2; k++) {
+		WriteArchive ("Mask", TREECODEC_ZSTD);
+		FILE *f = fopen (fname.c_str(), "r+b");
+		REQUIRE(f);
+		BYTE b;
+		if (k == 0) { fseek (f, 8, SEEK_SET); b = (BYTE)(TREEFILE_DEFLATE | 0xF << TREEFILE_CODEC_SHIFT); } // flags
+		else        { fseek (f, 2, SEEK_SET); b = 3; } // version
+		fwrite (&b, 1, 1, f);
+		fclose (f);
+		CHECK_FALSE(ZTreeMgr::CreateFromFile (ROOT, ZTreeMgr::LAYER_MASK));
+	}
+	CHECK(TreeCodecFromName ("ZSTD") == TREECODEC_ZSTD);
+	CHECK(TreeCodecFromName ("lz") == -1);
+}
+
+// An elevation tile as stored in the archive: header and 259x259 values
+// of smooth terrain with some noise
+static std::vector<BYTE> ElevationTile (int lvl, int ilat, int ilng)
+{
+	const int n = 259, hdrsize = 100;
+	std::vector<BYTE> data(hdrsize + n*n*sizeof(int16_t), 0);
+	int16_t *e = (int16_t*)(data.data() + hdrsize);
+	unsigned int seed = lvl*7919 + ilat*104729 + ilng;
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++) {
+			seed = seed*1103515245 + 12345;
+			double h = 1500.0*sin (0.02*i + ilng) * cos (0.015*j + ilat) + 300.0*sin (0.11*(i+j) + lvl);
+			e[i*n+j] = (int16_t)(h + (int)((seed >> 16) % 7) - 3);
+		}
+	return data;
+}
+
+TEST_CASE("Tile archive codec throughput", "[.benchmark]")
+{
+	// elevation tiles of levels 4 to 6
+	std::vector<Tile> tile;
+	size_t rawsize = 0;
+	for (int lvl = 4; lvl <= 6; lvl++)
+		for (int ilat = 0; ilat < (1 << (lvl-4)); ilat++)
+			for (int ilng = 0; ilng < (2 << (lvl-4)); ilng++) {
+				tile.push_back ({lvl, ilat, ilng, ElevationTile (lvl, ilat, ilng)});
+				rawsize += tile.back().data.size();
+			}
+
+	printf ("\nElevation tile archive (%d tiles, %.1f MB)\n%-6s %8s %16s %16s\n", (int)tile.size(), rawsize*1e-6,
+		"Codec", "Ratio", "Inflate [MB/s]", "Loads [1/s]");
+	for (int codec = 0; codec < TREECODEC_COUNT; codec++) {
+		WriteArchive ("Elev", tile, codec);
+		ZTreeMgr *mgr = ZTreeMgr::CreateFromFile (ROOT, ZTreeMgr::LAYER_ELEV);
+		REQUIRE(mgr);
+		size_t zsize = 0;
+		for (DWORD idx = 0; idx < mgr->TOC().size(); idx++)
+			zsize += mgr->NodeSizeDeflated (idx);
+
+		// decompression only, from the mapping into a caller buffer
+		std::vector<BYTE> buf(tile[0].data.size());
+		int nrep = 0;
+		auto t0 = std::chrono::steady_clock::now();
+		double dt;
+		do {
+			for (DWORD idx = 0; idx < mgr->TOC().size(); idx++)
+				REQUIRE(mgr->ReadData (idx, buf.data(), (DWORD)buf.size()));
+			nrep++;
+		} while ((dt = std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count()) < 0.5);
+		double inflaterate = nrep*rawsize*1e-6/dt;
+
+		// end-to-end tile loads: index lookup, decompression into pooled buffers
+		nrep = 0;
+		t0 = std::chrono::steady_clock::now();
+		do {
+			for (auto &t : tile) {
+				BYTE *data;
+				REQUIRE(mgr->ReadData (t.lvl, t.ilat, t.ilng, &data));
+				mgr->ReleaseData (data);
+			}
+			nrep++;
+		} while ((dt = std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count()) < 0.5);
+		double loadrate = nrep*tile.size()/dt;
+
+		printf ("%-6s %7.2f%% %16.1f %16.0f\n", TreeCodecName (codec), 100.0*zsize/rawsize, inflaterate, loadrate);
+		delete mgr;
+	}
+	printf ("\n");
+}
+
+TEST_CASE("The tile index finds every node of the tree", "[ZTree]")
+{
+	std::vector<Tile> tile = SparseTree (10, 200, 16);
+	WriteArchive ("Label", tile, TREECODEC_ZLIB);
+	ZTreeMgr *mgr = ZTreeMgr::CreateFromFile (ROOT, ZTreeMgr::LAYER_LABEL);
+	REQUIRE(mgr);
+	CHECK(mgr->IndexSize() > 0);
+
+	std::map<std::tuple<int,int,int>, DWORD> index;
+	for (DWORD i = 0; i < tile.size(); i++)
+		index[std::make_tuple (tile[i].lvl, tile[i].ilat, tile[i].ilng)] = i;
+	int nfail = 0, nfound = 0;
+	for (int lvl = 4; lvl <= 11; lvl++)
+		for (int ilat = 0; ilat < (1 << (lvl-4)); ilat++)
+			for (int ilng = 0; ilng < (2 << (lvl-4)); ilng++) {
+				auto it = index.find (std::make_tuple (lvl, ilat, ilng));
+				DWORD idx = (it != index.end() ? it->second : (DWORD)-1);
+				if (mgr->Idx (lvl, ilat, ilng) != idx) nfail++;
+				if (mgr->HasTile (lvl, ilat, ilng)) nfound++;
+			}
+	CHECK(nfail == 0);
+	CHECK(nfound == (int)tile.size());
+
+	// indices outside the level's range
+	CHECK(mgr->Idx (6, 4, 0) == (DWORD)-1);
+	CHECK(mgr->Idx (6, 0, 8) == (DWORD)-1);
+	CHECK(mgr->Idx (6, -1, 0) == (DWORD)-1);
+	CHECK(mgr->Idx (4, 0, 2) == (DWORD)-1);
+	CHECK(mgr->Idx (0, 0, 0) == (DWORD)-1);
+	CHECK(mgr->Idx (40, 0, 0) == (DWORD)-1);
+	delete mgr;
+}
+
+TEST_CASE("Archives whose TOC links a node twice are rejected", "[ZTree]")
+{
+	// link a child of the test archive to the given node
+	auto Relink = [](DWORD node, int child, DWORD target) {
+		WriteArchive ("Surf");
+		FILE *f = fopen ((std::string(ROOT) + "\\Archive\\Surf.tree").c_str(), "r+b");
+		REQUIRE(f);
+		fseek (f, (long)(sizeof(TreeFileHeader) + node*sizeof(TreeNode) + offsetof(TreeNode, child) + child*sizeof(DWORD)), SEEK_SET);
+		fwrite (&target, sizeof(DWORD), 1, f);
+		fclose (f);
+		return ZTreeMgr::CreateFromFile (ROOT, ZTreeMgr::LAYER_SURF);
+	};
+
+	// a cycle from level-5 tile (0,0) back to its level-4 root
+	CHECK_FALSE(Relink (2, 0, 0));
+	// level-5 tile (1,1) linked as child of (0,0) as well
+	CHECK_FALSE(Relink (2, 3, 5));
+	// the second level-4 root linked as a child of the first
+	CHECK_FALSE(Relink (0, 1, 1));
+
+	// the unmodified archive
+	ZTreeMgr *mgr = Relink (2, 0, (DWORD)-1);
+	REQUIRE(mgr);
+	CHECK(mgr->Idx (5, 0, 0) == 2);
+	delete mgr;
+}
+
+TEST_CASE("Tile index lookup time", "[.benchmark]")
+{
+	// queries for existing tiles down to level 20, as issued by the surface
+	// and elevation managers
+	const int maxlvl = 20, nquery = 2000000;
+	std::vector<Tile> tile = SparseTree (maxlvl, 2000, 16);
+	WriteArchive ("Label", tile, TREECODEC_ZLIB);
+	ZTreeMgr *mgr = ZTreeMgr::CreateFromFile (ROOT, ZTreeMgr::LAYER_LABEL);
+	REQUIRE(mgr);
+	std::vector<const Tile*> deep;
+	for (auto &t : tile)
+		if (t.lvl >= maxlvl-2) deep.push_back (&t);
+
+	printf ("\nTile index (%d nodes, index %.1f KB), lookups of level %d-%d tiles\n%-10s %14s\n",
+		(int)tile.size(), mgr->IndexSize()/1024.0, maxlvl-2, maxlvl, "Method", "Lookup [ns]");
+	for (int method = 0; method < 2; method++) {
+		DWORD sum = 0;
+		auto t0 = std::chrono::steady_clock::now();
+		for (int i = 0; i < nquery; i++) {
+			const Tile *t = deep[(size_t)i*7919 % deep.size()];
+			sum += (method ? mgr->Idx (t->lvl, t->ilat, t->ilng) : WalkIdx (mgr, t->lvl, t->ilat, t->ilng));
+		}
+		double dt = std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+		static volatile DWORD sink;
+		sink = sum; // keep the lookups
+		printf ("%-10s %14.1f\n", method ? "Index" : "TOC walk", dt*1e9/nquery);
+	}
+	printf ("\n");
+	delete mgr;
+}
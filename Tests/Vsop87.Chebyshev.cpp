@@ -0,0 +1,163 @@
+#include "ChebyCache.h"
+
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+// Truncated Earth heliocentric series (VSOP87B leading terms): longitude and
+// latitude [rad], radius [AU] and their rates per day, at t days from J2000
+static void EarthSeries (void *context, double t, double *ret)
+{
+	const double Tc = 365250.0; // days per millennium
+	double T = t/Tc;
+	if (context) ++*(int*)context;
+	ret[0] = 1.75347045673 + 6283.0758499914*T
+		+ 0.03341656453*cos (4.66925680415 + 6283.0758499914*T)
+		+ 0.00034894275*cos (4.62610242189 + 12566.1516999828*T)
+		+ 0.00003497056*cos (2.74411783405 + 5753.3848848968*T)
+		+ 0.00000204000*cos (1.00000000000 + 77713.7714681205*T);
+	ret[1] = 0.00000279620*cos (3.19870156017 + 84334.6615813083*T);
+	ret[2] = 1.00013988784
+		+ 0.01670699632*cos (3.09846350258 + 6283.0758499914*T)
+		+ 0.00013956024*cos (3.05524609456 + 12566.1516999828*T);
+	ret[3] = (6283.0758499914
+		- 0.03341656453*6283.0758499914*sin (4.66925680415 + 6283.0758499914*T)
+		- 0.00034894275*12566.1516999828*sin (4.62610242189 + 12566.1516999828*T)
+		- 0.00003497056*5753.3848848968*sin (2.74411783405 + 5753.3848848968*T)
+		- 0.00000204000*77713.7714681205*sin (1.00000000000 + 77713.7714681205*T))/Tc;
+	ret[4] = -0.00000279620*84334.6615813083*sin (3.19870156017 + 84334.6615813083*T)/Tc;
+	ret[5] = (-0.01670699632*6283.0758499914*sin (3.09846350258 + 6283.0758499914*T)
+		- 0.00013956024*12566.1516999828*sin (3.05524609456 + 12566.1516999828*T))/Tc;
+}
+
+// Interpolated positions and rates must stay within the fit tolerance of the series
+TEST_CASE("Chebyshev cache reproduces the series", "[ChebyCache]")
+{
+	const double tol[3] = {1e-12, 1e-12, 1e-12};
+	ChebyCache cache;
+	cache.Setup (EarthSeries, 0, 365.25/16.0, tol);
+
+	double a[6], b[6], dp = 0.0, dv = 0.0, vmax = 0.0;
+	for (double t = -2000.0; t < 2000.0; t += 0.37) {
+		cache.Eval (t, a);
+		EarthSeries (0, t, b);
+		for (int i = 0; i < 3; i++) {
+			dp = std::max (dp, fabs (a[i]-b[i]));
+			dv = std::max (dv, fabs (a[i+3]-b[i+3]));
+			vmax = std::max (vmax, fabs (b[i+3]));
+		}
+	}
+	REQUIRE(dp < 1e-11);
+	REQUIRE(dv < 1e-9*vmax);
+}
+
+// Adjacent granules share their boundary node, so there is no position jump
+TEST_CASE("Chebyshev granules join continuously", "[ChebyCache]")
+{
+	const double tol[3] = {1e-10, 1e-10, 1e-10};
+	ChebyCache cache;
+	cache.Setup (EarthSeries, 0, 365.25/16.0, tol);
+
+	double len = cache.Length();
+	for (int k = -5; k <= 5; k++) {
+		double a[6], b[6];
+		double tb = k*len;
+		cache.Eval (tb - 1e-9*len, a);
+		cache.Eval (tb, b);
+		for (int i = 0; i < 3; i++) {
+			REQUIRE(fabs (a[i]-b[i]) < 1e-14 + 1e-9*len*fabs (b[i+3]) * 2.0);
+			REQUIRE(fabs (a[i+3]-b[i+3]) <= tol[i]*CHEBY_DEGREE*CHEBY_DEGREE/len * 4.0);
+		}
+	}
+}
+
+// A granule that can't meet the tolerance is split; cached granules are reused
+TEST_CASE("Chebyshev granule halving and reuse", "[ChebyCache]")
+{
+	const double tol[3] = {1e-13, 1e-13, 1e-13};
+	int ncall = 0;
+	ChebyCache cache;
+	cache.Setup (EarthSeries, &ncall, 365.25, tol, 8);
+	double a[6], b[6];
+	cache.Eval (100.0, a);
+	REQUIRE(cache.Length() < 365.25);
+	EarthSeries (0, 100.0, b);
+	for (int i = 0; i < 3; i++)
+		REQUIRE(fabs (a[i]-b[i]) < 1e-12);
+
+	// revisiting epochs in cached granules must not evaluate the series again
+	cache.Eval (100.0 + 0.1*cache.Length(), a);
+	int nfit = cache.nFit(), n = ncall;
+	for (int k = 0; k < 100; k++)
+		cache.Eval (100.0 + 0.001*k*cache.Length(), a);
+	REQUIRE(cache.nFit() == nfit);
+	REQUIRE(ncall == n);
+
+	// filling more granules than slots replaces the least recently used one
+	double len = cache.Length();
+	for (int k = 1; k <= 8; k++)
+		cache.Eval (100.0 + k*len, a);
+	REQUIRE(cache.nFit() == nfit + 8);
+	cache.Eval (100.0 + 8.0*len, a);
+	REQUIRE(cache.nFit() == nfit + 8);
+}
+
+// Exported granule coefficients (as stored in binary ephemeris files) evaluate
+// to the same positions and rates as the cache itself
+TEST_CASE("Chebyshev granule export", "[ChebyCache]")
+{
+	const double tol[3] = {1e-12, 1e-12, 1e-12};
+	ChebyCache cache;
+	cache.Setup (EarthSeries, 0, 365.25/16.0, tol);
+
+	double c[3][CHEBY_NCOEFF], a[6], b[6];
+	for (double t = -700.0; t < 700.0; t += 13.1) {
+		int idx = cache.GetGranule (t, c);
+		double len = cache.Length();
+		REQUIRE(t >= idx*len);
+		REQUIRE(t < (idx+1)*len);
+		ChebyCache::EvalCoeff (c, 2.0*(t - idx*len)/len - 1.0, len, a);
+		cache.Eval (t, b);
+		for (int i = 0; i < 3; i++) {
+			REQUIRE(fabs (a[i]-b[i]) < 1e-14);
+			REQUIRE(fabs (a[i+3]-b[i+3]) < 1e-12*fabs (b[i+3]) + 1e-16);
+		}
+	}
+}
+
+// Concurrent lookups and fits return the same values as a serial evaluation.
+// Few slots, so that granules are replaced while other threads use them
+TEST_CASE("Chebyshev cache is shared by concurrent threads", "[ChebyCache]")
+{
+	const double tol[3] = {1e-10, 1e-10, 1e-10};
+	const int nthread = 8, nt = 4000;
+	ChebyCache ref, cache;
+	ref.Setup (EarthSeries, 0, 365.25/16.0, tol, 4);
+	cache.Setup (EarthSeries, 0, 365.25/16.0, tol, 4);
+	REQUIRE(ref.Length() == cache.Length());
+
+	auto Epoch = [](int k, int i) { return -3000.0 + ((i*7919 + k*104729) % nt)*1.53; };
+	std::vector<double> a(nthread*nt*6);
+	std::vector<std::thread> thread;
+	for (int k = 0; k < nthread; k++)
+		thread.emplace_back ([&, k]() {
+			for (int i = 0; i < nt; i++)
+				cache.Eval (Epoch (k, i), &a[(k*nt+i)*6]);
+		});
+	for (auto &th : thread) th.join();
+	REQUIRE(cache.Length() == 365.25/16.0); // no halving, so the granules are identical
+
+	int nfail = 0;
+	for (int k = 0; k < nthread; k++)
+		for (int i = 0; i < nt; i++) {
+			double b[6];
+			ref.Eval (Epoch (k, i), b);
+			for (int j = 0; j < 6; j++)
+				if (a[(k*nt+i)*6+j] != b[j]) nfail++;
+		}
+	REQUIRE(nfail == 0);
+}
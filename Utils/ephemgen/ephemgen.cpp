@@ -0,0 +1,357 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// ephemgen: precompute the analytic ephemerides of the solar system bodies
+// (VSOP87, ELP2000-82, Lieske E5, TASS1.7) as Chebyshev granules over a range
+// of dates, and write them to a binary ephemeris file (.epb) that the
+// EphemFile celestial body module maps at startup.
+// Must be run from the Orbiter root directory, so that the series data
+// files under Config are found.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "VsopSeries.h"
+#include "ChebyCache.h"
+#include "EphemFile.h"
+#include "Galsat.h"
+#include "Satsat.h"
+
+void ELP82_init ();
+void ELP82_exit ();
+int  ELP82_read (double prec);
+int  ELP82 (double mjd, double *r);
+
+static const double mjd2000 = 51544.5; // MJD date of epoch J2000
+static const double AU = 299792458.0 * 499.004783806; // 1 AU in meters
+
+// ===========================================================
+// Ephemeris functions in the format required by ChebyCache:
+// time t in days from J2000, position and rate per day
+// ===========================================================
+
+struct Source {
+	enum Type { VSOP, ELP, GAL, SATBARY } type;
+	const char *name;   // VSOP data directory (Config\<name>\Data)
+	char series;        // VSOP series
+	double a0;          // VSOP mean semi-major axis [AU]
+	int ksat;           // Lieske satellite index
+	VSOPSERIES vsop;
+};
+
+// Lieske E5: AU, AU/day; ecliptic xyz -> orbiter xzy (see GalEphem)
+static void GalState (int ksat, double t, double *ret)
+{
+	double r[6], rorb[6];
+	galsat (r, rorb, t + mjd2000 + 2400000.5, ksat, 2);
+	ret[0] = r[0]*AU, ret[1] = r[2]*AU, ret[2] = r[1]*AU;
+	ret[3] = r[3]*AU, ret[4] = r[5]*AU, ret[5] = r[4]*AU;
+}
+
+// TASS1.7: AU, AU/year; ecliptic xyz -> orbiter xzy (see SatEphem)
+static void SatState (int ksat, double t, double *ret)
+{
+	static const double AUy = AU/365.25;
+	double r[6];
+	posired (t + mjd2000 + 2400000.5, ksat, r, r+3);
+	ret[0] = r[0]*AU,  ret[1] = r[2]*AU,  ret[2] = r[1]*AU;
+	ret[3] = r[3]*AUy, ret[4] = r[5]*AUy, ret[5] = r[4]*AUy;
+}
+
+static void SourceFunc (void *context, double t, double *ret)
+{
+	Source *src = (Source*)context;
+	double r[6];
+	int i;
+
+	switch (src->type) {
+	case Source::VSOP:
+		src->vsop.Eval (t + mjd2000, ret);
+		for (i = 3; i < 6; i++) ret[i] *= 86400.0;
+		break;
+	case Source::ELP:
+		ELP82 (t + mjd2000, ret);
+		for (i = 3; i < 6; i++) ret[i] *= 86400.0;
+		break;
+	case Source::GAL:
+		GalState (src->ksat, t, ret);
+		break;
+	case Source::SATBARY: {
+		// Saturn offset from the system barycentre (see SaturnEphemeris)
+		static const double M_saturn = 5.6846272e+26;
+		for (i = 0; i < 6; i++) ret[i] = 0.0;
+		SatState (SAT_TITAN, t, r);
+		for (i = 0; i < 6; i++) ret[i] -= r[i]*(1.35e23/M_saturn);
+		SatState (SAT_IAPETUS, t, r);
+		for (i = 0; i < 6; i++) ret[i] -= r[i]*(1.6e21/M_saturn);
+		} break;
+	}
+}
+
+// ===========================================================
+// Body recipes, following the return conventions of the
+// Vsop87, Moon, Galsat and Satsat modules
+// ===========================================================
+
+struct BodySpec {
+	const char *name;
+	uint32_t flags, mode;
+	Source::Type type[2];  // channel sources (VSOP channels are always channel 0)
+	char series;
+	double a0;             // VSOP semi-major axis [AU]
+	int ksat;              // Galilean moon index
+	double len;            // initial granule length [days]
+};
+
+static const int nchannel_max = 2;
+#define NONE ((Source::Type)-1)
+
+static const BodySpec bodyspec[] = {
+	{"Sun",     EPHEM_TRUEPOS|EPHEM_TRUEVEL|EPHEM_BARYPOS|EPHEM_BARYVEL|EPHEM_PARENTBARY, EPHEM_MODE_BARY0,
+	                {Source::VSOP, NONE}, 'E', 1.0, 0, 64.0},
+	{"Mercury", EPHEM_TRUEPOS|EPHEM_TRUEVEL|EPHEM_BARYISTRUE|EPHEM_POLAR, EPHEM_MODE_DIRECT,
+	                {Source::VSOP, NONE}, 'B', 0.39, 0, 32.0},
+	{"Venus",   EPHEM_TRUEPOS|EPHEM_TRUEVEL|EPHEM_BARYISTRUE|EPHEM_POLAR, EPHEM_MODE_DIRECT,
+	                {Source::VSOP, NONE}, 'B', 0.72, 0, 64.0},
+	{"Earth",   EPHEM_TRUEPOS|EPHEM_TRUEVEL|EPHEM_POLAR, EPHEM_MODE_DIRECT,
+	                {Source::VSOP, NONE}, 'B', 1.0, 0, 64.0},
+	{"Mars",    EPHEM_BARYPOS|EPHEM_BARYVEL|EPHEM_POLAR, EPHEM_MODE_BARY,
+	                {Source::VSOP, NONE}, 'B', 1.5, 0, 128.0},
+	{"Jupiter", EPHEM_TRUEPOS|EPHEM_TRUEVEL|EPHEM_BARYPOS|EPHEM_BARYVEL, EPHEM_MODE_BARYOFS,
+	                {Source::VSOP, Source::GAL}, 'B', 5.2, GAL_BARYCENTRE, 4.0},
+	{"Saturn",  EPHEM_TRUEPOS|EPHEM_TRUEVEL|EPHEM_BARYPOS|EPHEM_BARYVEL, EPHEM_MODE_BARYOFS,
+	                {Source::VSOP, Source::SATBARY}, 'B', 9.6, 0, 16.0},
+	{"Uranus",  EPHEM_BARYPOS|EPHEM_BARYVEL|EPHEM_POLAR, EPHEM_MODE_BARY,
+	                {Source::VSOP, NONE}, 'B', 19.2, 0, 512.0},
+	{"Neptune", EPHEM_BARYPOS|EPHEM_BARYVEL|EPHEM_POLAR, EPHEM_MODE_BARY,
+	                {Source::VSOP, NONE}, 'B', 30.1, 0, 512.0},
+	{"Moon",    EPHEM_TRUEPOS|EPHEM_TRUEVEL|EPHEM_BARYISTRUE, EPHEM_MODE_DIRECT,
+	                {Source::ELP, NONE}, 0, 0.0, 0, 8.0},
+	{"Io",       0x1F, EPHEM_MODE_DIRECT, {Source::GAL, NONE}, 0, 0.0, GAL_IO, 1.0},
+	{"Europa",   0x1F, EPHEM_MODE_DIRECT, {Source::GAL, NONE}, 0, 0.0, GAL_EUROPA, 1.0},
+	{"Ganymede", 0x1F, EPHEM_MODE_DIRECT, {Source::GAL, NONE}, 0, 0.0, GAL_GANYMEDE, 2.0},
+	{"Callisto", 0x1F, EPHEM_MODE_DIRECT, {Source::GAL, NONE}, 0, 0.0, GAL_CALLISTO, 4.0}
+};
+static const int nbodyspec = sizeof(bodyspec)/sizeof(BodySpec);
+
+// Default body set: the Sun, the planets and the Moon. The Galilean moons
+// need short granules and are only included on request. The moons of Saturn
+// are not supported: the TASS1.7 velocities deviate from the derivatives of
+// the positions by up to 1e-5, so the granules would not pass the rate check
+// (the Saturn barycentre offset is scaled down enough by the mass ratios)
+static const int ndefault = 10;
+
+// ===========================================================
+
+struct BodyData {
+	EphemFileBody entry;
+	std::vector<double> coeff;
+};
+
+static bool InitSources (const BodySpec &spec, Source *src, double prec)
+{
+	static bool elp_init = false, gal_init = false, sat_init = false;
+	char path[256];
+
+	for (int ch = 0; ch < nchannel_max && spec.type[ch] != NONE; ch++) {
+		src[ch].type = spec.type[ch];
+		src[ch].name = spec.name;
+		src[ch].series = spec.series;
+		src[ch].a0 = spec.a0;
+		src[ch].ksat = spec.ksat;
+		switch (spec.type[ch]) {
+		case Source::VSOP:
+			sprintf (path, "Config\\%s\\Data\\Vsop87%c.dat", spec.name, spec.series);
+			if (src[ch].vsop.Read (path, spec.series, spec.a0, prec) < 0) {
+				std::cerr << "Error: could not read " << path << std::endl;
+				return false;
+			}
+			break;
+		case Source::ELP:
+			if (!elp_init) {
+				ELP82_init();
+				if (ELP82_read (prec)) {
+					std::cerr << "Error: could not read Config\\Moon\\Data\\ELP82.dat" << std::endl;
+					return false;
+				}
+				elp_init = true;
+			}
+			break;
+		case Source::GAL:
+			if (!gal_init) {
+				if (cd2com ("Config\\Jupiter\\Data\\ephem_e15.dat")) {
+					std::cerr << "Error: could not read Config\\Jupiter\\Data\\ephem_e15.dat" << std::endl;
+					return false;
+				}
+				chkgal();
+				gal_init = true;
+			}
+			break;
+		case Source::SATBARY:
+			if (!sat_init) {
+				ReadData ("Config\\Saturn\\Data\\tass17.dat", 0);
+				sat_init = true;
+			}
+			break;
+		}
+	}
+	return true;
+}
+
+// Fit all channels of a body over [t0,t1] days from J2000 with a common
+// granule length. Whenever a channel needs shorter granules, the fit is
+// restarted with the shorter length for all channels
+static bool FitBody (const BodySpec &spec, double t0, double t1, double tol, double prec, BodyData &bd)
+{
+	Source src[nchannel_max];
+	ChebyCache cheby[nchannel_max];
+	double c[3][CHEBY_NCOEFF];
+	int ch, nch, i, idx, idx0, idx1;
+
+	if (!InitSources (spec, src, prec)) return false;
+	for (nch = 0; nch < nchannel_max && spec.type[nch] != NONE; nch++);
+
+	double len = spec.len;
+	for (bool done = false; !done; ) {
+		for (ch = 0; ch < nch; ch++) {
+			// tolerances in the units of the channel: [rad, rad, AU] for
+			// VSOP spherical coordinates, [m] otherwise
+			double ctol[3];
+			if (src[ch].type == Source::VSOP && spec.series == 'B')
+				ctol[0] = ctol[1] = tol/(spec.a0*AU), ctol[2] = tol/AU;
+			else
+				ctol[0] = ctol[1] = ctol[2] = tol;
+			cheby[ch].Setup (SourceFunc, src+ch, len, ctol, 2);
+		}
+		idx0 = (int)floor (t0/len);
+		idx1 = (int)floor (t1/len);
+		bd.coeff.resize ((size_t)(idx1-idx0+1)*nch*EPHEM_GRANULE_SIZE);
+		done = true;
+		for (idx = idx0; idx <= idx1 && done; idx++) {
+			for (ch = 0; ch < nch; ch++) {
+				cheby[ch].GetGranule ((idx+0.5)*len, c);
+				if (cheby[ch].Length() < len) {
+					len = cheby[ch].Length();
+					if (len < spec.len/4096.0) {
+						std::cerr << "Error: tolerance not achievable" << std::endl;
+						return false;
+					}
+					done = false;
+					break;
+				}
+				double *g = bd.coeff.data() + ((size_t)(idx-idx0)*nch + ch)*EPHEM_GRANULE_SIZE;
+				for (i = 0; i < 3; i++)
+					memcpy (g + i*CHEBY_NCOEFF, c[i], CHEBY_NCOEFF*sizeof(double));
+			}
+		}
+	}
+
+	memset (&bd.entry, 0, sizeof(EphemFileBody));
+	strncpy (bd.entry.name, spec.name, sizeof(bd.entry.name)-1);
+	bd.entry.flags = spec.flags;
+	bd.entry.mode = spec.mode;
+	bd.entry.nchannel = nch;
+	bd.entry.ngranule = idx1-idx0+1;
+	bd.entry.idx0 = idx0;
+	bd.entry.len = len;
+	return true;
+}
+
+static uint64_t Align (uint64_t ofs)
+{
+	return (ofs + EPHEM_FILE_ALIGN-1) / EPHEM_FILE_ALIGN * EPHEM_FILE_ALIGN;
+}
+
+static bool WriteFile (const char *fname, double mjd0, double mjd1, std::vector<BodyData> &body)
+{
+	EphemFileHeader hdr;
+	memset (&hdr, 0, sizeof(hdr));
+	memcpy (hdr.magic, EPHEM_FILE_MAGIC, 8);
+	hdr.version = EPHEM_FILE_VERSION;
+	hdr.nbody = (uint32_t)body.size();
+	hdr.degree = CHEBY_DEGREE;
+	hdr.mjd0 = mjd0;
+	hdr.mjd1 = mjd1;
+
+	uint64_t ofs = sizeof(hdr) + body.size()*sizeof(EphemFileBody);
+	for (size_t i = 0; i < body.size(); i++) {
+		ofs = Align (ofs);
+		body[i].entry.ofs = ofs;
+		ofs += body[i].coeff.size()*sizeof(double);
+	}
+
+	std::ofstream ofs_ (fname, std::ios::binary);
+	if (!ofs_) return false;
+	ofs_.write ((const char*)&hdr, sizeof(hdr));
+	for (size_t i = 0; i < body.size(); i++)
+		ofs_.write ((const char*)&body[i].entry, sizeof(EphemFileBody));
+	static const char pad[EPHEM_FILE_ALIGN] = {0};
+	for (size_t i = 0; i < body.size(); i++) {
+		ofs_.write (pad, body[i].entry.ofs - (uint64_t)ofs_.tellp());
+		ofs_.write ((const char*)body[i].coeff.data(), body[i].coeff.size()*sizeof(double));
+	}
+	return ofs_.good();
+}
+
+int main (int narg, char *arg[])
+{
+	double mjd0 = 33282.0, mjd1 = 69807.0; // 1950-2050
+	double tol = 1.0, prec = 0.0;
+	const char *outfile = 0;
+	std::vector<int> sel;
+	int i, j;
+
+	for (i = 1; i < narg; i++) {
+		if      (!strcmp (arg[i], "-mjd0") && i+1 < narg) mjd0 = atof (arg[++i]);
+		else if (!strcmp (arg[i], "-mjd1") && i+1 < narg) mjd1 = atof (arg[++i]);
+		else if (!strcmp (arg[i], "-tol")  && i+1 < narg) tol  = atof (arg[++i]);
+		else if (!strcmp (arg[i], "-prec") && i+1 < narg) prec = atof (arg[++i]);
+		else if (!outfile) outfile = arg[i];
+		else {
+			for (j = 0; j < nbodyspec; j++)
+				if (!_stricmp (arg[i], bodyspec[j].name)) break;
+			if (j == nbodyspec) {
+				std::cerr << "Error: unknown body " << arg[i] << std::endl;
+				return 1;
+			}
+			sel.push_back (j);
+		}
+	}
+	if (!outfile || mjd1 <= mjd0 || tol <= 0.0) {
+		std::cerr << "\nephemgen: Orbiter binary ephemeris generator" << std::endl;
+		std::cerr << "  Tabulates the analytic ephemerides as Chebyshev granules" << std::endl;
+		std::cerr << "  for the EphemFile celestial body module." << std::endl;
+		std::cerr << "\nUsage: ephemgen [options] <Output-file> [<Body> ...]" << std::endl;
+		std::cerr << "\n<Body>: Sun, Mercury, ..., Neptune, Moon, Io, ..., Callisto" << std::endl;
+		std::cerr << "  Default: the Sun, the planets and the Moon" << std::endl;
+		std::cerr << "\nOptions:" << std::endl;
+		std::cerr << "  -mjd0 <MJD>   start of date range (default 33282 = 1950)" << std::endl;
+		std::cerr << "  -mjd1 <MJD>   end of date range (default 69807 = 2050)" << std::endl;
+		std::cerr << "  -tol <m>      max. position error of the fit (default 1)" << std::endl;
+		std::cerr << "  -prec <p>     VSOP87/ELP82 series truncation (default 0: all terms)" << std::endl;
+		std::cerr << "\nRun from the Orbiter root directory." << std::endl;
+		return 1;
+	}
+	if (!sel.size())
+		for (j = 0; j < ndefault; j++) sel.push_back (j);
+
+	std::vector<BodyData> body (sel.size());
+	double t0 = mjd0 - mjd2000, t1 = mjd1 - mjd2000;
+	for (i = 0; i < (int)sel.size(); i++) {
+		const BodySpec &spec = bodyspec[sel[i]];
+		std::cout << spec.name << ": " << std::flush;
+		if (!FitBody (spec, t0, t1, tol, prec, body[i])) return 1;
+		std::cout << body[i].entry.ngranule << " granules of " << body[i].entry.len << " days" << std::endl;
+	}
+
+	if (!WriteFile (outfile, mjd0, mjd1, body)) {
+		std::cerr << "Error: could not write " << outfile << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,59 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// gravconv: convert text gravity coefficient files (SHA/TAB) into the binary
+// .pgb format that Orbiter maps directly at startup.
+
+#include <iostream>
+#include <string>
+#include "Vecmat.h"
+#include "PinesGrav.h"
+
+int main(int narg, char *arg[])
+{
+	if (narg < 2) {
+		std::cerr << "\ngravconv: Orbiter gravity model conversion tool" << std::endl;
+		std::cerr << "  Converts spherical harmonics coefficient files from text" << std::endl;
+		std::cerr << "  (SHA/TAB) to binary format for fast loading." << std::endl;
+		std::cerr << "\nUsage: gravconv <Model-file> [<Output-file>]" << std::endl;
+		std::cerr << "\n<Model-file>:" << std::endl;
+		std::cerr << "  Text coefficient file, e.g." << std::endl;
+		std::cerr << "  c:\\Orbiter\\GravityModels\\jgl165p1.sha" << std::endl;
+		std::cerr << "\n<Output-file>:" << std::endl;
+		std::cerr << "  Binary file name. Default: model file name with extension .pgb" << std::endl;
+		std::cerr << "  Orbiter picks up the binary file automatically if it is placed" << std::endl;
+		std::cerr << "  next to the text file." << std::endl;
+		exit(1);
+	}
+
+	std::string src = arg[1];
+	std::string dst;
+	if (narg > 2) dst = arg[2];
+	else {
+		size_t ext = src.find_last_of('.');
+		size_t sep = src.find_last_of("\\/");
+		dst = (ext != std::string::npos && (sep == std::string::npos || ext > sep) ? src.substr(0, ext) : src) + ".pgb";
+	}
+
+	std::cout << "Converting " << src << " -> " << dst << std::endl;
+	int nmax = 0;
+	int res = PinesGravProp::ConvertGravModel(src.c_str(), dst.c_str(), nmax);
+	switch (res) {
+	case 0:
+		std::cout << "Degree/order: " << nmax << std::endl;
+		return 0;
+	case 1:
+		std::cerr << "Error: could not read " << src << " or write " << dst << std::endl;
+		break;
+	case 2:
+		std::cerr << "Error: out of memory" << std::endl;
+		break;
+	case 3:
+		std::cerr << "Error: bad header line format in " << src << std::endl;
+		break;
+	case 4:
+		std::cerr << "Error: bad coefficient line format in " << src << std::endl;
+		break;
+	}
+	return res;
+}
@@ -0,0 +1,306 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// propbatch: headless batch propagator
+// Reads the vessels of an Orbiter scenario and propagates them for a given
+// simulated duration with the standalone propagation harness (PropHarness.h:
+// point mass + spherical harmonics of each vessel's reference body, which is
+// kept static), as fast as the machine allows. Prints the final states in
+// scenario format together with throughput statistics.
+// Third-body perturbations, thrust, atmosphere and surface contact are not
+// modelled, so the results approximate, but don't reproduce, Orbiter's.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "PropHarness.h"
+#include "PinesGrav.h"
+#include "WorkerPool.h"
+
+using namespace std;
+
+static const double Ggrav = 6.67259e-11;
+
+struct Ship {
+	string name;             // name:class
+	string ref;              // reference body
+	HarnessState s;             // state relative to the reference body
+	double el[7];            // ELEMENTS entry, if the state is given as elements
+	bool hasElements = false;
+	bool valid = false;
+};
+
+struct RefBody {
+	HarnessSystem sys;
+	unique_ptr<PinesGravProp> pines;
+	int ncoeff = 0;
+};
+
+// ==============================================================
+// Simple reader for "Key = value ; comment" configuration files
+
+class CfgFile {
+public:
+	bool Load (const string &fname)
+	{
+		ifstream ifs (fname);
+		if (!ifs) return false;
+		string line;
+		while (getline (ifs, line)) {
+			size_t c = line.find (';');
+			if (c != string::npos) line.erase (c);
+			size_t eq = line.find ('=');
+			if (eq == string::npos) continue;
+			items[Trim (line.substr (0, eq))] = Trim (line.substr (eq+1));
+		}
+		return true;
+	}
+	bool Real (const char *key, double &val) const
+	{
+		auto it = items.find (key);
+		return it != items.end() && sscanf (it->second.c_str(), "%lf", &val) == 1;
+	}
+	bool Int (const char *key, int &val) const
+	{
+		auto it = items.find (key);
+		return it != items.end() && sscanf (it->second.c_str(), "%d", &val) == 1;
+	}
+	bool String (const char *key, string &val) const
+	{
+		auto it = items.find (key);
+		if (it == items.end()) return false;
+		val = it->second;
+		return true;
+	}
+private:
+	static string Trim (const string &s)
+	{
+		size_t a = s.find_first_not_of (" \t\r\n"), b = s.find_last_not_of (" \t\r\n");
+		return (a == string::npos ? string() : s.substr (a, b-a+1));
+	}
+	map<string,string> items;
+};
+
+// ==============================================================
+
+static bool LoadBody (const string &root, const string &name, double mjd, bool harmonics, RefBody &rb)
+{
+	CfgFile cfg;
+	if (!cfg.Load (root + "/Config/" + name + ".cfg")) {
+		cerr << "Error: no configuration file for " << name << endl;
+		return false;
+	}
+	HarnessBody b;
+	if (!cfg.Real ("Mass", b.Mass)) {
+		cerr << "Error: no mass defined for " << name << endl;
+		return false;
+	}
+	cfg.Real ("Size", b.Size);
+	cfg.Real ("SidRotPeriod", b.rot_T);
+	cfg.Real ("SidRotOffset", b.Dphi);
+	cfg.Real ("Obliquity", b.eps_rel);
+	cfg.Real ("LAN", b.Lrel0);
+	cfg.Real ("LAN_MJD", b.mjd_rel);
+	cfg.Real ("PrecessionPeriod", b.prec_T);
+	cfg.Real ("PrecessionObliquity", b.eps_ref);
+	cfg.Real ("PrecessionLAN", b.lan_ref);
+	cfg.Real ("GravAccTolerance", b.pinesTol);
+	double epoch = 2000.0;
+	cfg.Real ("Epoch", epoch);
+
+	string model;
+	int cutoff;
+	if (harmonics && cfg.String ("GravModelPath", model) && cfg.Int ("GravCoeffCutoff", cutoff)) {
+		string fname = root + "/GravityModels/" + model;
+		int nloaded, nmodel;
+		rb.pines.reset (new PinesGravProp (nullptr));
+		if (rb.pines->readGravModel ((char*)fname.c_str(), cutoff, nloaded, nmodel) == 0) {
+			b.pines = rb.pines.get();
+			rb.ncoeff = rb.pines->GetCoeffCutoff();
+		} else {
+			cerr << "Warning: could not load gravity model " << fname << endl;
+			rb.pines.reset();
+		}
+	}
+	b.Setup (mjd, (epoch-2000.0)*365.25 + 51544.5);
+	rb.sys.AddBody (b);
+	return true;
+}
+
+static bool ReadScenario (const string &fname, double &mjd, vector<Ship> &ships)
+{
+	ifstream ifs (fname);
+	if (!ifs) return false;
+	string line;
+	bool inShips = false;
+	Ship *cur = 0;
+	mjd = 51544.5;
+	while (getline (ifs, line)) {
+		istringstream ls (line);
+		string tok;
+		if (!(ls >> tok)) continue;
+		if (tok == "BEGIN_SHIPS") { inShips = true; continue; }
+		if (tok == "END_SHIPS") { inShips = false; continue; }
+		if (tok == "Date") {
+			string fmt;
+			ls >> fmt;
+			if (fmt == "MJD") ls >> mjd;
+			continue;
+		}
+		if (!inShips) continue;
+		if (!cur) {
+			ships.push_back (Ship());
+			cur = &ships.back();
+			cur->name = tok;
+			cur->s.t = 0.0;
+		} else if (tok == "END") {
+			cur = 0;
+		} else if (tok == "STATUS") {
+			string mode;
+			ls >> mode >> cur->ref;
+			cur->valid = (mode == "Orbiting");
+		} else if (tok == "RPOS") {
+			ls >> cur->s.pos.x >> cur->s.pos.y >> cur->s.pos.z;
+		} else if (tok == "RVEL") {
+			ls >> cur->s.vel.x >> cur->s.vel.y >> cur->s.vel.z;
+		} else if (tok == "ELEMENTS") {
+			// a e i theta omegab L epoch, angles in degrees. Converted once the
+			// reference body mass is known
+			for (int i = 0; i < 7; i++) ls >> cur->el[i];
+			cur->hasElements = true;
+		}
+	}
+	return true;
+}
+
+int main (int narg, char *arg[])
+{
+	string root = ".";
+	double duration = 0.0, dt = 1.0, tol = 1e-12;
+	int method = PROP_RK4, nsub = 1, nthread = 0;
+	bool harmonics = true;
+	const char *scn = 0;
+
+	for (int i = 1; i < narg; i++) {
+		if      (!strcmp (arg[i], "-r") && i+1 < narg) root = arg[++i];
+		else if (!strcmp (arg[i], "-t") && i+1 < narg) duration = atof (arg[++i]);
+		else if (!strcmp (arg[i], "-h") && i+1 < narg) dt = atof (arg[++i]);
+		else if (!strcmp (arg[i], "-m") && i+1 < narg) method = atoi (arg[++i]);
+		else if (!strcmp (arg[i], "-n") && i+1 < narg) nsub = atoi (arg[++i]);
+		else if (!strcmp (arg[i], "-e") && i+1 < narg) tol = atof (arg[++i]);
+		else if (!strcmp (arg[i], "-j") && i+1 < narg) nthread = atoi (arg[++i]);
+		else if (!strcmp (arg[i], "-s")) harmonics = false;
+		else scn = arg[i];
+	}
+	if (!scn || duration <= 0.0 || dt <= 0.0 || nsub < 1 || tol <= 0.0 || method < 0 || method >= NPROP_METHOD) {
+		cerr << "\npropbatch: Orbiter headless batch propagator" << endl;
+		cerr << "  Propagates the orbiting vessels of a scenario for a given" << endl;
+		cerr << "  simulated time and prints their final states." << endl;
+		cerr << "\nUsage: propbatch [<Flags>] -t <Duration> <Scenario>" << endl;
+		cerr << "\n<Flags>:" << endl;
+		cerr << "  -r <dir> : Orbiter root directory (Config, GravityModels). Default: ." << endl;
+		cerr << "  -t <s>   : simulated duration [s]" << endl;
+		cerr << "  -h <s>   : time step [s]. Default: 1" << endl;
+		cerr << "  -m <id>  : propagator 0-11 (RK2,RK4,RK5,RK6,RK7,RK8,SY2,SY4,SY6,SY8,DP5,RKF78). Default: 1" << endl;
+		cerr << "  -n <n>   : substeps per time step (fixed-step propagators). Default: 1" << endl;
+		cerr << "  -e <tol> : local error tolerance (adaptive propagators DP5, RKF78). Default: 1e-12" << endl;
+		cerr << "  -j <n>   : worker threads in addition to the main thread. Default: 0" << endl;
+		cerr << "  -s       : spherical bodies (ignore gravity models)" << endl;
+		return 1;
+	}
+
+	double mjd;
+	vector<Ship> ships;
+	if (!ReadScenario (scn, mjd, ships)) {
+		cerr << "Error: could not read scenario " << scn << endl;
+		return 1;
+	}
+
+	map<string, RefBody> bodies;
+	vector<Ship*> active;
+	for (Ship &sh : ships) {
+		if (!sh.valid) continue;
+		if (!bodies.count (sh.ref) && !LoadBody (root, sh.ref, mjd, harmonics, bodies[sh.ref])) {
+			bodies.erase (sh.ref);
+			return 1;
+		}
+		if (sh.hasElements) {
+			const HarnessBody &b = bodies[sh.ref].sys.Body (0);
+			KeplerState (Ggrav*b.Mass, sh.el[0], sh.el[1], Rad(sh.el[2]), Rad(sh.el[3]), Rad(sh.el[4]), Rad(sh.el[5]),
+				(mjd - sh.el[6])*86400.0, sh.s.pos, sh.s.vel);
+		}
+		active.push_back (&sh);
+	}
+	if (active.empty()) {
+		cerr << "Error: no orbiting vessels in " << scn << endl;
+		return 1;
+	}
+
+	// propagate each vessel independently over the full duration. The body
+	// map is only read from here on (the workers must not insert entries).
+	const map<string, RefBody> &refbodies = bodies;
+	bool adaptive = PROP_ISADAPTIVE(method);
+	int nstep = (int)ceil (duration/dt);
+	vector<long long> neval (active.size(), 0), nsubstep (active.size(), 0);
+	WorkerPool pool (nthread);
+	auto t0 = chrono::steady_clock::now();
+	pool.ParallelFor (active.size(), [&](size_t i) {
+		Ship &sh = *active[i];
+		HarnessPropagator prop (refbodies.at (sh.ref).sys);
+		prop.Init (sh.s);
+		double h = duration/nstep, hadapt = 0.0;
+		long long n = 1, ns = 0;
+		for (int k = 0; k < nstep; k++) {
+			if (adaptive) {
+				int nacc;
+				n += prop.PropagateAdaptive (sh.s, h, method, tol, hadapt, &nacc);
+				ns += nacc;
+			} else {
+				n += prop.Propagate (sh.s, h, method, nsub);
+				ns += nsub;
+			}
+		}
+		neval[i] = n;
+		nsubstep[i] = ns;
+	});
+	double wall = chrono::duration<double> (chrono::steady_clock::now() - t0).count();
+
+	long long nevaltot = 0, nsubtot = 0;
+	for (size_t i = 0; i < active.size(); i++) {
+		nevaltot += neval[i];
+		nsubtot += nsubstep[i];
+	}
+
+	cout.precision (10);
+	cout << "BEGIN_SHIPS" << endl;
+	for (Ship *sh : active) {
+		cout << sh->name << endl;
+		cout << "  STATUS Orbiting " << sh->ref << endl;
+		cout << "  RPOS " << sh->s.pos.x << ' ' << sh->s.pos.y << ' ' << sh->s.pos.z << endl;
+		cout << "  RVEL " << sh->s.vel.x << ' ' << sh->s.vel.y << ' ' << sh->s.vel.z << endl;
+		cout << "END" << endl;
+	}
+	cout << "END_SHIPS" << endl;
+
+	double nvstep = (double)nsubtot;
+	cerr << "Vessels:       " << active.size() << endl;
+	cerr << "Start MJD:     " << mjd << ", end MJD: " << mjd + duration/86400.0 << endl;
+	if (adaptive)
+		cerr << "Steps:         " << nstep << " x " << nvstep/((double)nstep*active.size()) << " substeps (average), propagator " << method << ", tolerance " << tol << endl;
+	else
+		cerr << "Steps:         " << nstep << " x " << nsub << " substeps, propagator " << method << endl;
+	for (auto &b : bodies)
+		cerr << "Body:          " << b.first << " (harmonics degree " << b.second.ncoeff << ")" << endl;
+	cerr << "Wall time:     " << wall << " s (" << pool.nThread()+1 << " threads)" << endl;
+	cerr << "Throughput:    " << nvstep/wall << " vessel steps/s, " << nevaltot/wall << " acc evaluations/s" << endl;
+	cerr << "Time ratio:    " << duration*active.size()/wall << " vessel-seconds per second" << endl;
+	return 0;
+}
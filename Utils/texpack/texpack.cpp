@@ -3,12 +3,11 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 #include <windows.h>
 #include <direct.h>
 #include <Shlwapi.h>
-#include <zlib.h>
-
-#define TREE_DEFLATE 1
+#include "TreeCodec.h"
 
 //==============================================================================
 // local prototypes
@@ -16,14 +15,17 @@
 // check if the file for a particular tile exists in the directory tree
 bool exist_file(const char *root, const char *layer, const char *ext, int lvl, int ilng, int ilat);
 
-// deflate a data block
+// deflate a data block with the given codec (TreeCodec)
 // this is assumed to work in a single step. output buffer "outp" of size "noutp" must be large
 // enough to hold the entire deflated data block
 // Returns deflated block size
-DWORD deflate_node_data(BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp);
+DWORD deflate_node_data(int codec, BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp);
 
 // inflate data block
-DWORD inflate_node_data(BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp);
+DWORD inflate_node_data(int codec, BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp);
+
+// codec for packing and transcoding (-c flag)
+int codec = TREECODEC_ZLIB;
 
 //==============================================================================
 // A single MemTree node
@@ -262,8 +264,12 @@ public:
 	size_t fread(FILE *f);
 	void WriteData(FILE *f);
 	void ExtractData(FILE *f, int maxlevel);
+	bool Transcode(FILE *fin, FILE *fout, int newcodec);
+	// false if a node can't be decoded or fout can't be written
+	int Codec() const; // codec of the node data (-1: unsupported)
 
 protected:
+	void SetCodec(int newcodec);
 	int AddSubtree(const MemTreeNode *node);
 	void WriteSubtreeData(const MemTreeNode *node, FILE *f);
 	void ExtractSubtreeData (DWORD idx, int lvl, int ilat, int ilng, FILE *f, int maxlevel);
@@ -315,11 +321,12 @@ TreeTOC::TreeTOC(const char *_root, const char *_layer, const MemTree *tree): mt
 
 	header.magic[0] = 'T';
 	header.magic[1] = 'X';
-	header.magic[2] = 1;
+	header.magic[2] = TREEFILE_VERSION_ZLIB;
 	header.magic[3] = 0;
 	header.size = sizeof(Header);
 	header.flags = 0;
-	if (deflateData) header.flags |= TREE_DEFLATE;
+	if (deflateData) header.flags |= TREEFILE_DEFLATE;
+	SetCodec(codec);
 	header.ntoc = 0;
 	header.totlength = 0;
 
@@ -358,11 +365,12 @@ TreeTOC::TreeTOC(const char *_root, const char *_layer): mtree(0)
 
 	header.magic[0] = 'T';
 	header.magic[1] = 'X';
-	header.magic[2] = 1;
+	header.magic[2] = TREEFILE_VERSION_ZLIB;
 	header.magic[3] = 0;
 	header.size = sizeof(Header);
 	header.flags = 0;
-	if (deflateData) header.flags |= TREE_DEFLATE;
+	if (deflateData) header.flags |= TREEFILE_DEFLATE;
+	SetCodec(codec);
 	header.ntoc = 0;
 	header.totlength = 0;
 
@@ -418,7 +426,7 @@ int TreeTOC::AddSubtree(const MemTreeNode *node)
 				exit(1);
 			}
 			if (deflateData) {
-				ndata = deflate_node_data(buf, sz.LowPart, zbuf, nzbuf);
+				ndata = deflate_node_data(codec, buf, sz.LowPart, zbuf, nzbuf);
 			} else {
 				ndata = sz.LowPart;
 			}
@@ -476,6 +484,28 @@ size_t TreeTOC::fread(FILE *f)
 
 // -----------------------------------------------------------------------------
 
+void TreeTOC::SetCodec(int newcodec)
+{
+	// zlib archives keep format version 1, so that older readers can use them
+	header.magic[2] = (newcodec == TREECODEC_ZLIB ? TREEFILE_VERSION_ZLIB : TREEFILE_VERSION_CODEC);
+	header.flags = (header.flags & ~TREEFILE_CODEC_MASK) |
+		(newcodec == TREECODEC_ZLIB ? 0 : (DWORD)newcodec << TREEFILE_CODEC_SHIFT);
+}
+
+// -----------------------------------------------------------------------------
+
+int TreeTOC::Codec() const
+{
+	if (header.magic[2] == TREEFILE_VERSION_ZLIB)
+		return TREECODEC_ZLIB;
+	if (header.magic[2] != TREEFILE_VERSION_CODEC)
+		return -1;
+	int c = (int)((header.flags & TREEFILE_CODEC_MASK) >> TREEFILE_CODEC_SHIFT);
+	return (c < TREECODEC_COUNT ? c : -1);
+}
+
+// -----------------------------------------------------------------------------
+
 void TreeTOC::WriteData(FILE *f)
 {
 	WriteSubtreeData(mtree->FindNode(1, 0, 0), f);
@@ -519,7 +549,7 @@ void TreeTOC::WriteSubtreeData(const MemTreeNode *node, FILE *f)
 				exit(1);
 			}
 			if (deflateData) {
-				ndata = deflate_node_data(buf, sz.LowPart, zbuf, nzbuf);
+				ndata = deflate_node_data(codec, buf, sz.LowPart, zbuf, nzbuf);
 				std::cout << "deflating " << path << " [" << (ndata * 100) / sz.LowPart << "%]" << std::endl;
 				::fwrite(zbuf, 1, ndata, f);
 			} else {
@@ -566,7 +596,7 @@ void TreeTOC::ExtractSubtreeData (DWORD idx, int lvl, int ilat, int ilng, FILE *
 	int nread = ::fread(zbuf, 1, zsize, f);
 
 	BYTE *ebuf = new BYTE[esize];
-	inflate_node_data(zbuf, zsize, ebuf, esize);
+	inflate_node_data(Codec(), zbuf, zsize, ebuf, esize);
 
 	char fname[256];
 	sprintf (fname, "%s\\%s", root, layer);
@@ -592,11 +622,45 @@ void TreeTOC::ExtractSubtreeData (DWORD idx, int lvl, int ilat, int ilng, FILE *
 	delete []ebuf;
 }
 
+// -----------------------------------------------------------------------------
+
+bool TreeTOC::Transcode(FILE *fin, FILE *fout, int newcodec)
+{
+	// node data are stored in TOC order, so the archive can be rewritten
+	// node by node; the TOC is written again with the new positions at the end
+	int oldcodec = Codec();
+	SetCodec(newcodec);
+	if (fwrite(fout) != header.ntoc+1) return false;
+
+	__int64 totlength = 0;
+	for (DWORD idx = 0; idx < header.ntoc; idx++) {
+		TOCEntry *entry = toc+idx;
+		DWORD esize = entry->size;
+		DWORD zsize = (DWORD)((idx < header.ntoc-1 ? toc[idx+1].pos : header.totlength) - entry->pos);
+		_fseeki64(fin, (__int64)header.dataOfs + entry->pos, SEEK_SET);
+		entry->pos = totlength;
+		if (!esize) continue; // node contains no data
+
+		std::vector<BYTE> zbuf(zsize), ebuf(esize), nbuf(TreeCodecBound(newcodec, esize));
+		if (::fread(zbuf.data(), 1, zsize, fin) < zsize || inflate_node_data(oldcodec, zbuf.data(), zsize, ebuf.data(), esize) != esize) {
+			std::cerr << "Corrupt node data (node " << idx << ")" << std::endl;
+			return false;
+		}
+		DWORD ndata = deflate_node_data(newcodec, ebuf.data(), esize, nbuf.data(), (DWORD)nbuf.size());
+		if (::fwrite(nbuf.data(), 1, ndata, fout) < ndata) return false;
+		totlength += ndata;
+	}
+	std::cout << "data size " << header.totlength << " -> " << totlength << " bytes" << std::endl;
+	header.totlength = totlength;
+	_fseeki64(fout, 0, SEEK_SET);
+	return fwrite(fout) == header.ntoc+1;
+}
+
 //==============================================================================
 
 int maxlevel = 0;
 enum OP_MODE {
-	OP_ARCHIVE, OP_EXTRACT
+	OP_ARCHIVE, OP_EXTRACT, OP_TRANSCODE
 } mode = OP_ARCHIVE;
 
 int main(int narg, char *arg[])
@@ -618,7 +682,10 @@ int main(int narg, char *arg[])
 		std::cerr << "  Label    pack surface label tiles" << std::endl;
 		std::cerr << "\n<Flags>:" << std::endl;
 		std::cerr << "  -e   : unpack compressed archive into individual tiles" << std::endl;
+		std::cerr << "  -t   : transcode an existing archive to the codec given by -c" << std::endl;
 		std::cerr << "  -L<x>: pack/unpack tiles up to maximum level <x>" << std::endl;
+		std::cerr << "  -c<x>: compress with codec <x>: zlib (default), zstd or lz4." << std::endl;
+		std::cerr << "         zstd and lz4 archives can't be read by older Orbiter versions." << std::endl;
 		exit(1);
 	}
 
@@ -631,13 +698,27 @@ int main(int narg, char *arg[])
 		case 'e':
 			mode = OP_EXTRACT;
 			break;
+		case 't':
+			mode = OP_TRANSCODE;
+			break;
 		case 'L':
-			if (sscanf(arg[i]+2, "%d", &maxlevel))
+			if (sscanf(arg[i]+2, "%d", &maxlevel) != 1 || maxlevel < 1) {
+				std::cerr << "Invalid max. level " << arg[i]+2 << std::endl;
+				exit(1);
+			}
+			break;
+		case 'c':
+			if ((codec = TreeCodecFromName(arg[i]+2)) < 0) {
+				std::cerr << "Unknown codec " << arg[i]+2 << std::endl;
+				exit(1);
+			}
 			break;
 		}
 	}
 
-	std::cout << (mode == OP_ARCHIVE ? "Packing " : "Unpacking ") << layer << " layer for " << root << std::endl;
+	std::cout << (mode == OP_ARCHIVE ? "Packing " : mode == OP_EXTRACT ? "Unpacking " : "Transcoding ") << layer << " layer for " << root << std::endl;
+	if (mode != OP_EXTRACT)
+		std::cout << "Codec: " << TreeCodecName(codec) << std::endl;
 	if (maxlevel)
 		std::cout << "Max. level: " << maxlevel << std::endl;
 	else
@@ -670,19 +751,56 @@ int main(int narg, char *arg[])
 		std::cout << toc.length() << " nodes" << std::endl;
 		std::cout << toc.DataSize() << " bytes of data" << std::endl;
 
-	} else {
+	} else if (mode == OP_EXTRACT) {
 
 		TreeTOC toc(root, layer);
 		char fname[256];
 		sprintf(fname, "%s\\Archive\\%s.tree", root, layer);
 		FILE *f = fopen(fname, "rb");
 		toc.fread(f);
+		if (toc.Codec() < 0) {
+			std::cerr << "Unsupported archive format " << fname << std::endl;
+			exit(1);
+		}
 		toc.ExtractData(f, maxlevel);
 		fclose(f);
 
 		std::cout << std::endl << "Quadtree data extracted from " << fname << std::endl;
 		std::cout << toc.length() << " nodes" << std::endl;
 
+	} else {
+
+		// write to a temporary file and replace the archive once complete
+		TreeTOC toc(root, layer);
+		char fname[256], tmpname[256];
+		sprintf(fname, "%s\\Archive\\%s.tree", root, layer);
+		sprintf(tmpname, "%s.tmp", fname);
+		FILE *f = fopen(fname, "rb");
+		if (!f || !toc.fread(f) || toc.Codec() < 0) {
+			std::cerr << "Can't read archive " << fname << std::endl;
+			exit(1);
+		}
+		FILE *fout = fopen(tmpname, "wb");
+		if (!fout) {
+			std::cerr << "Can't write " << tmpname << std::endl;
+			exit(1);
+		}
+		bool ok = toc.Transcode(f, fout, codec);
+		ok = (fclose(fout) == 0) && ok;
+		fclose(f);
+		if (!ok) {
+			remove(tmpname); // leave the original archive untouched
+			std::cerr << "Transcoding failed, " << fname << " not modified" << std::endl;
+			exit(1);
+		}
+		if (!MoveFileEx(tmpname, fname, MOVEFILE_REPLACE_EXISTING)) {
+			std::cerr << "Can't replace " << fname << std::endl;
+			exit(1);
+		}
+
+		std::cout << std::endl << "Quadtree data transcoded in " << fname << std::endl;
+		std::cout << toc.length() << " nodes" << std::endl;
+
 	}
 
 	return 0;
@@ -695,59 +813,17 @@ bool exist_file(const char *root, const char *layer, const char *ext, int lvl, i
 	return PathFileExists(path) == TRUE;
 }
 
-DWORD deflate_node_data(BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp)
+DWORD deflate_node_data(int codec, BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp)
 {
-	int ret, flush;
-	z_stream strm;
-	strm.zalloc = Z_NULL;
-	strm.zfree = Z_NULL;
-	strm.opaque = Z_NULL;
-	ret = deflateInit(&strm, Z_DEFAULT_COMPRESSION);
-
-	strm.avail_in = ninp;
-	flush = Z_FINISH;
-	strm.next_in = inp;
-
-	strm.avail_out = noutp;
-	strm.next_out = outp;
-	ret = deflate(&strm, flush);
-	if (ret != Z_STREAM_END) {
-		if (ret == Z_STREAM_ERROR) {
-		}
+	DWORD ndata = TreeDeflate(codec, inp, ninp, outp, noutp);
+	if (!ndata) {
+		std::cerr << "Compression failed" << std::endl;
 		exit(1);
 	}
-	if (strm.avail_in > 0) {
-		// problem - data left in input buffer
-		exit(1);
-	}
-	deflateEnd(&strm);
-	return strm.total_out;
+	return ndata;
 }
 
-DWORD inflate_node_data(BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp)
+DWORD inflate_node_data(int codec, BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp)
 {
-	DWORD ndata = noutp;
-	if (uncompress(outp, &ndata, inp, ninp) != Z_OK)
-		return 0;
-#ifdef UNDEF
-	int ret, ndata;
-	z_stream strm;
-	strm.zalloc = Z_NULL;
-	strm.zfree = Z_NULL;
-	strm.opaque = Z_NULL;
-	strm.avail_in = 0;
-	strm.next_in = Z_NULL;
-	ret = inflateInit(&strm);
-	if (ret != Z_OK) return 0;
-	strm.avail_in = ninp;
-	strm.next_in = inp;
-	strm.avail_out = noutp;
-	strm.next_out = outp;
-	ret = inflate(&strm, Z_FINISH);
-	ndata = noutp - strm.avail_out;
-	if (ret != Z_STREAM_END) // didn't process all input
-		return 0;
-	inflateEnd(&strm);
-#endif
-	return ndata;
-}
\ No newline at end of file
+	return TreeInflate(codec, inp, ninp, outp, noutp);
+}